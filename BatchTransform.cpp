@@ -0,0 +1,146 @@
+#include "BatchTransformKernel.h"
+#include "Common/MathHelper.h"
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+using namespace DirectX;
+
+// Scalar, SSE and the cpuid check live here,
+// the AVX2 instantiation in BatchTransformAVX2.cpp.
+
+namespace {
+
+// Lane wrapper of the kernel in BatchTransformKernel.h
+
+struct LanesSSE {
+	static const UINT WIDTH = 4;
+	typedef __m128 V;
+	static V Load(const float* p) { return _mm_load_ps(p); }
+	static void Store(float* p, V v) { _mm_store_ps(p, v); }
+	static V Set(float f) { return _mm_set1_ps(f); }
+	static V Add(V a, V b) { return _mm_add_ps(a, b); }
+	static V Sub(V a, V b) { return _mm_sub_ps(a, b); }
+	static V Mul(V a, V b) { return _mm_mul_ps(a, b); }
+	static V Div(V a, V b) { return _mm_div_ps(a, b); }
+	static V And(V a, V b) { return _mm_and_ps(a, b); }
+	static V Or(V a, V b) { return _mm_or_ps(a, b); }
+	static V AndNot(V a, V b) { return _mm_andnot_ps(a, b); }
+	static V CmpLE(V a, V b) { return _mm_cmple_ps(a, b); }
+	// Round to nearest even, the default rounding mode
+	static V Round(V a) { return _mm_cvtepi32_ps(_mm_cvtps_epi32(a)); }
+};
+
+void BuildLocalMatsScalar(
+	UINT count, const UINT* indices,
+	const XMFLOAT3* translations, const XMFLOAT3* rotations, const XMFLOAT3* scales,
+	XMFLOAT4X4* localMats, XMFLOAT4X4* localNormalMats
+) {
+	for (UINT i = 0; i < count; i++) {
+		UINT index = indices ? indices[i] : i;
+		const auto& s = scales[index];
+		const auto& r = rotations[index];
+		const auto& t = translations[index];
+		XMMATRIX mat = XMMatrixScaling(s.x, s.y, s.z);
+		mat *= XMMatrixRotationX(r.x);
+		mat *= XMMatrixRotationY(r.y);
+		mat *= XMMatrixRotationZ(r.z);
+		mat *= XMMatrixTranslation(t.x, t.y, t.z);
+		XMStoreFloat4x4(&localMats[i], mat);
+		if (localNormalMats)
+			XMStoreFloat4x4(&localNormalMats[i], MathHelper::GenNormalMat(mat));
+	}
+}
+
+#ifdef _MSC_VER
+void CpuId(int info[4], int leaf, int subLeaf) {
+	__cpuidex(info, leaf, subLeaf);
+}
+unsigned long long GetXCR0() {
+	return _xgetbv(0);
+}
+#else
+void CpuId(int info[4], int leaf, int subLeaf) {
+	unsigned int regs[4];
+	__cpuid_count(leaf, subLeaf, regs[0], regs[1], regs[2], regs[3]);
+	for (int i = 0; i < 4; i++)
+		info[i] = static_cast<int>(regs[i]);
+}
+unsigned long long GetXCR0() {
+	unsigned int lo, hi;
+	__asm__ volatile("xgetbv" : "=a"(lo), "=d"(hi) : "c"(0));
+	return (static_cast<unsigned long long>(hi) << 32) | lo;
+}
+#endif
+
+bool SupportAVX2() {
+	int info[4];
+	CpuId(info, 0, 0);
+	if (info[0] < 7)
+		return false;
+
+	// AVX and OSXSAVE
+	CpuId(info, 1, 0);
+	const int AVX_OSXSAVE = (1 << 28) | (1 << 27);
+	if ((info[2] & AVX_OSXSAVE) != AVX_OSXSAVE)
+		return false;
+	// OS saves YMM registers
+	if ((GetXCR0() & 0x6) != 0x6)
+		return false;
+
+	CpuId(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+}
+
+}
+
+BatchTransform::Path BatchTransform::GetBestPath()
+{
+	static const Path path = SupportAVX2() ? Path::AVX2 : Path::SSE;
+	return path;
+}
+
+const char* BatchTransform::GetPathName(Path path)
+{
+	switch (path) {
+	case Path::Scalar:
+		return "Scalar";
+	case Path::SSE:
+		return "SSE";
+	case Path::AVX2:
+		return "AVX2";
+	}
+	return "Unknown";
+}
+
+void BatchTransform::BuildLocalMats(
+	UINT count, const UINT* indices,
+	const XMFLOAT3* translations, const XMFLOAT3* rotations, const XMFLOAT3* scales,
+	XMFLOAT4X4* localMats, XMFLOAT4X4* localNormalMats
+) {
+	BuildLocalMats(GetBestPath(), count, indices, translations, rotations, scales, localMats, localNormalMats);
+}
+
+void BatchTransform::BuildLocalMats(
+	Path path,
+	UINT count, const UINT* indices,
+	const XMFLOAT3* translations, const XMFLOAT3* rotations, const XMFLOAT3* scales,
+	XMFLOAT4X4* localMats, XMFLOAT4X4* localNormalMats
+) {
+	if (count == 0)
+		return;
+
+	switch (path) {
+	case Path::Scalar:
+		BuildLocalMatsScalar(count, indices, translations, rotations, scales, localMats, localNormalMats);
+		break;
+	case Path::SSE:
+		BuildLocalMatsSIMD<LanesSSE>(count, indices, translations, rotations, scales, localMats, localNormalMats);
+		break;
+	case Path::AVX2:
+		BuildLocalMatsAVX2(count, indices, translations, rotations, scales, localMats, localNormalMats);
+		break;
+	}
+}
@@ -0,0 +1,59 @@
+#pragma once
+#include <DirectXMath.h>
+#include "PlatformTypes.h"
+
+// Batched construction of local model matrices.
+// Builds Scale * RotationX * RotationY * RotationZ * Translation
+// for 4 (SSE) or 8 (AVX2) objects per iteration in closed form,
+// together with the matching normal matrix (inverse-transpose of the upper 3x3).
+// The path is picked once at runtime from cpuid.
+// Both paths run the same operations lane by lane, including a shared sin/cos
+// polynomial, so their results are bit-identical to each other.
+class BatchTransform
+{
+public:
+	enum class Path {
+		Scalar,
+		SSE,
+		AVX2
+	};
+
+	// Build matrices for count objects.
+	// Input element i is read from indices[i], or from i if indices is nullptr.
+	// Output element i is written to localMats[i] and localNormalMats[i].
+	// localNormalMats can be nullptr.
+	static void BuildLocalMats(
+		UINT count, const UINT* indices,
+		const DirectX::XMFLOAT3* translations,
+		const DirectX::XMFLOAT3* rotations,
+		const DirectX::XMFLOAT3* scales,
+		DirectX::XMFLOAT4X4* localMats,
+		DirectX::XMFLOAT4X4* localNormalMats
+	);
+
+	// Same as above on a chosen path, for comparison.
+	// Scalar is the old per-object XMMatrix product, SSE and AVX2 must be supported.
+	static void BuildLocalMats(
+		Path path,
+		UINT count, const UINT* indices,
+		const DirectX::XMFLOAT3* translations,
+		const DirectX::XMFLOAT3* rotations,
+		const DirectX::XMFLOAT3* scales,
+		DirectX::XMFLOAT4X4* localMats,
+		DirectX::XMFLOAT4X4* localNormalMats
+	);
+
+	static Path GetBestPath();
+	static const char* GetPathName(Path path);
+
+private:
+	// In BatchTransformAVX2.cpp, the only file built with AVX2 enabled
+	static void BuildLocalMatsAVX2(
+		UINT count, const UINT* indices,
+		const DirectX::XMFLOAT3* translations,
+		const DirectX::XMFLOAT3* rotations,
+		const DirectX::XMFLOAT3* scales,
+		DirectX::XMFLOAT4X4* localMats,
+		DirectX::XMFLOAT4X4* localNormalMats
+	);
+};
@@ -0,0 +1,34 @@
+#include "BatchTransformKernel.h"
+
+// Built with AVX2 enabled, only called after GetBestPath checked cpuid.
+
+using namespace DirectX;
+
+namespace {
+
+struct LanesAVX2 {
+	static const UINT WIDTH = 8;
+	typedef __m256 V;
+	static V Load(const float* p) { return _mm256_load_ps(p); }
+	static void Store(float* p, V v) { _mm256_store_ps(p, v); }
+	static V Set(float f) { return _mm256_set1_ps(f); }
+	static V Add(V a, V b) { return _mm256_add_ps(a, b); }
+	static V Sub(V a, V b) { return _mm256_sub_ps(a, b); }
+	static V Mul(V a, V b) { return _mm256_mul_ps(a, b); }
+	static V Div(V a, V b) { return _mm256_div_ps(a, b); }
+	static V And(V a, V b) { return _mm256_and_ps(a, b); }
+	static V Or(V a, V b) { return _mm256_or_ps(a, b); }
+	static V AndNot(V a, V b) { return _mm256_andnot_ps(a, b); }
+	static V CmpLE(V a, V b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+	static V Round(V a) { return _mm256_cvtepi32_ps(_mm256_cvtps_epi32(a)); }
+};
+
+}
+
+void BatchTransform::BuildLocalMatsAVX2(
+	UINT count, const UINT* indices,
+	const XMFLOAT3* translations, const XMFLOAT3* rotations, const XMFLOAT3* scales,
+	XMFLOAT4X4* localMats, XMFLOAT4X4* localNormalMats
+) {
+	BuildLocalMatsSIMD<LanesAVX2>(count, indices, translations, rotations, scales, localMats, localNormalMats);
+}
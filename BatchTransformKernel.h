@@ -0,0 +1,146 @@
+#pragma once
+#include <immintrin.h>
+#include "BatchTransform.h"
+
+// SIMD kernel of BatchTransform, written once against a lane wrapper.
+// Included by BatchTransform.cpp (SSE) and BatchTransformAVX2.cpp (AVX2),
+// which may be compiled with different instruction set flags.
+// Everything here is in an anonymous namespace and calls no shared inline
+// function, so code built for AVX2 can't be picked by the linker for the SSE path.
+namespace {
+
+// a where mask is set, else b
+template<typename L>
+typename L::V Select(typename L::V mask, typename L::V a, typename L::V b) {
+	return L::Or(L::And(mask, a), L::AndNot(mask, b));
+}
+
+// Minimax sin/cos on [-pi/2, pi/2] after reduction,
+// same polynomials as XMScalarSinCos.
+template<typename L>
+void SinCos(typename L::V x, typename L::V& sinOut, typename L::V& cosOut) {
+	typedef typename L::V V;
+	const V signMask = L::Set(-0.0f);
+	const V one = L::Set(1.0f);
+
+	// Map x to [-pi, pi]
+	V quotient = L::Round(L::Mul(x, L::Set(1.0f / DirectX::XM_2PI)));
+	x = L::Sub(x, L::Mul(quotient, L::Set(DirectX::XM_2PI)));
+
+	// Map x to [-pi/2, pi/2], with sin(y) = sin(x) and cos(y) = sign * cos(x)
+	V sign = L::And(x, signMask);
+	V c = L::Or(L::Set(DirectX::XM_PI), sign);
+	V absX = L::AndNot(sign, x);
+	V reflectX = L::Sub(c, x);
+	V inRange = L::CmpLE(absX, L::Set(DirectX::XM_PIDIV2));
+	x = Select<L>(inRange, x, reflectX);
+	V cosSign = Select<L>(inRange, one, L::Set(-1.0f));
+
+	V x2 = L::Mul(x, x);
+
+	V s = L::Set(-2.3889859e-08f);
+	s = L::Add(L::Mul(s, x2), L::Set(2.7525562e-06f));
+	s = L::Add(L::Mul(s, x2), L::Set(-0.00019840874f));
+	s = L::Add(L::Mul(s, x2), L::Set(0.0083333310f));
+	s = L::Add(L::Mul(s, x2), L::Set(-0.16666667f));
+	s = L::Add(L::Mul(s, x2), one);
+	sinOut = L::Mul(s, x);
+
+	V k = L::Set(-2.6051615e-07f);
+	k = L::Add(L::Mul(k, x2), L::Set(2.4760495e-05f));
+	k = L::Add(L::Mul(k, x2), L::Set(-0.0013888378f));
+	k = L::Add(L::Mul(k, x2), L::Set(0.041666638f));
+	k = L::Add(L::Mul(k, x2), L::Set(-0.5f));
+	k = L::Add(L::Mul(k, x2), one);
+	cosOut = L::Mul(k, cosSign);
+}
+
+// Input channels
+enum { TX, TY, TZ, RX, RY, RZ, SX, SY, SZ, IN_NUM };
+// Output channels, rows of the 3x3 part plus translation
+enum { M00, M01, M02, M10, M11, M12, M20, M21, M22, N00, N01, N02, N10, N11, N12, N20, N21, N22, OUT_NUM };
+
+template<typename L>
+void BuildLanes(const float (*in)[L::WIDTH], float (*out)[L::WIDTH]) {
+	typedef typename L::V V;
+
+	V sa, ca, sb, cb, sg, cg;
+	SinCos<L>(L::Load(in[RX]), sa, ca);
+	SinCos<L>(L::Load(in[RY]), sb, cb);
+	SinCos<L>(L::Load(in[RZ]), sg, cg);
+
+	// Rows of RotationX * RotationY * RotationZ
+	V r[9];
+	r[0] = L::Mul(cb, cg);
+	r[1] = L::Mul(cb, sg);
+	r[2] = L::Sub(L::Set(0.0f), sb);
+	V sasb = L::Mul(sa, sb);
+	r[3] = L::Sub(L::Mul(sasb, cg), L::Mul(ca, sg));
+	r[4] = L::Add(L::Mul(sasb, sg), L::Mul(ca, cg));
+	r[5] = L::Mul(sa, cb);
+	V casb = L::Mul(ca, sb);
+	r[6] = L::Add(L::Mul(casb, cg), L::Mul(sa, sg));
+	r[7] = L::Sub(L::Mul(casb, sg), L::Mul(sa, cg));
+	r[8] = L::Mul(ca, cb);
+
+	// Scale * Rotation scales the rows,
+	// its inverse-transpose is the rotation with rows divided by the scale.
+	const V one = L::Set(1.0f);
+	for (UINT row = 0; row < 3; row++) {
+		V s = L::Load(in[SX + row]);
+		V invS = L::Div(one, s);
+		for (UINT col = 0; col < 3; col++) {
+			L::Store(out[M00 + row * 3 + col], L::Mul(r[row * 3 + col], s));
+			L::Store(out[N00 + row * 3 + col], L::Mul(r[row * 3 + col], invS));
+		}
+	}
+}
+
+template<typename L>
+void BuildLocalMatsSIMD(
+	UINT count, const UINT* indices,
+	const DirectX::XMFLOAT3* translations, const DirectX::XMFLOAT3* rotations, const DirectX::XMFLOAT3* scales,
+	DirectX::XMFLOAT4X4* localMats, DirectX::XMFLOAT4X4* localNormalMats
+) {
+	const UINT W = L::WIDTH;
+	alignas(32) float in[IN_NUM][W];
+	alignas(32) float out[OUT_NUM][W];
+
+	for (UINT base = 0; base < count; base += W) {
+		// Gather, the tail is padded with the last element
+		UINT laneNum = count - base < W ? count - base : W;
+		for (UINT lane = 0; lane < W; lane++) {
+			UINT i = base + (lane < laneNum ? lane : laneNum - 1);
+			UINT index = indices ? indices[i] : i;
+			in[TX][lane] = translations[index].x;
+			in[TY][lane] = translations[index].y;
+			in[TZ][lane] = translations[index].z;
+			in[RX][lane] = rotations[index].x;
+			in[RY][lane] = rotations[index].y;
+			in[RZ][lane] = rotations[index].z;
+			in[SX][lane] = scales[index].x;
+			in[SY][lane] = scales[index].y;
+			in[SZ][lane] = scales[index].z;
+		}
+
+		BuildLanes<L>(in, out);
+
+		// Scatter
+		for (UINT lane = 0; lane < laneNum; lane++) {
+			DirectX::XMFLOAT4X4& m = localMats[base + lane];
+			m._11 = out[M00][lane]; m._12 = out[M01][lane]; m._13 = out[M02][lane]; m._14 = 0.0f;
+			m._21 = out[M10][lane]; m._22 = out[M11][lane]; m._23 = out[M12][lane]; m._24 = 0.0f;
+			m._31 = out[M20][lane]; m._32 = out[M21][lane]; m._33 = out[M22][lane]; m._34 = 0.0f;
+			m._41 = in[TX][lane]; m._42 = in[TY][lane]; m._43 = in[TZ][lane]; m._44 = 1.0f;
+			if (!localNormalMats)
+				continue;
+			DirectX::XMFLOAT4X4& n = localNormalMats[base + lane];
+			n._11 = out[N00][lane]; n._12 = out[N01][lane]; n._13 = out[N02][lane]; n._14 = 0.0f;
+			n._21 = out[N10][lane]; n._22 = out[N11][lane]; n._23 = out[N12][lane]; n._24 = 0.0f;
+			n._31 = out[N20][lane]; n._32 = out[N21][lane]; n._33 = out[N22][lane]; n._34 = 0.0f;
+			n._41 = 0.0f; n._42 = 0.0f; n._43 = 0.0f; n._44 = 1.0f;
+		}
+	}
+}
+
+}
@@ -0,0 +1,434 @@
+#include "Bvh.h"
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cstring>
+#include <numeric>
+
+#include "Common/MathHelper.h"
+
+using namespace DirectX;
+
+namespace {
+	const UINT BIN_NUM = 16;
+	// Ranges this small always become leaves
+	const UINT MIN_LEAF_SIZE = 2;
+	// SAH may keep ranges up to this size as leaves
+	const UINT MAX_LEAF_SIZE = 8;
+	// Deeper ranges are split at the median, so queries never overflow their stack
+	const UINT MAX_SAH_DEPTH = 40;
+	const UINT NO_PARENT = -1;
+	// Bounds of leaf items whose object is gone
+	const BoundingBox EMPTY_BOUNDS(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(-1.0f, -1.0f, -1.0f));
+
+	XMVECTOR XM_CALLCONV GetMin(const BoundingBox& box) {
+		return XMVectorSubtract(XMLoadFloat3(&box.Center), XMLoadFloat3(&box.Extents));
+	}
+	XMVECTOR XM_CALLCONV GetMax(const BoundingBox& box) {
+		return XMVectorAdd(XMLoadFloat3(&box.Center), XMLoadFloat3(&box.Extents));
+	}
+	BoundingBox XM_CALLCONV MakeBox(FXMVECTOR vMin, FXMVECTOR vMax) {
+		BoundingBox box;
+		XMStoreFloat3(&box.Center, XMVectorScale(XMVectorAdd(vMin, vMax), 0.5f));
+		XMStoreFloat3(&box.Extents, XMVectorScale(XMVectorSubtract(vMax, vMin), 0.5f));
+		return box;
+	}
+	float XM_CALLCONV HalfArea(FXMVECTOR vMin, FXMVECTOR vMax) {
+		XMFLOAT3 d;
+		XMStoreFloat3(&d, XMVectorMax(XMVectorSubtract(vMax, vMin), XMVectorZero()));
+		return d.x * d.y + d.y * d.z + d.z * d.x;
+	}
+	float HalfArea(const BoundingBox& box) {
+		return HalfArea(GetMin(box), GetMax(box));
+	}
+	float GetAxis(const XMFLOAT3& v, UINT axis) {
+		return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+	}
+	bool SameBox(const BoundingBox& a, const BoundingBox& b) {
+		return memcmp(&a, &b, sizeof(BoundingBox)) == 0;
+	}
+}
+
+const UINT Bvh::INVALID_ITEM;
+
+Bvh::~Bvh()
+{
+	// Don't leave a build running on destroyed state
+	if (mRebuild.valid())
+		mRebuild.wait();
+}
+
+void Bvh::Build(const std::vector<UINT>& objectIDs, const std::vector<BoundingBox>& bounds)
+{
+	if (mRebuild.valid())
+		mRebuild.wait();
+	mRebuild = std::future<Tree>();
+
+	// Nothing to take over from the current tree
+	mNodes.clear();
+	mObjectIDs.clear();
+	mSlotItems.clear();
+	mPendingIDs.clear();
+	mPendingBounds.clear();
+	mSlotPendings.clear();
+	SetTree(BuildTree(objectIDs, bounds));
+}
+
+Bvh::Tree Bvh::BuildTree(std::vector<UINT> objectIDs, std::vector<BoundingBox> bounds)
+{
+	Tree tree;
+	UINT num = static_cast<UINT>(objectIDs.size());
+	if (num == 0)
+		return tree;
+
+	std::vector<XMFLOAT3> centroids(num);
+	for (UINT i = 0; i < num; i++)
+		centroids[i] = bounds[i].Center;
+	std::vector<UINT> order(num);
+	std::iota(order.begin(), order.end(), 0);
+
+	auto CalRangeBounds = [&](UINT first, UINT count) {
+		XMVECTOR vMin = XMVectorReplicate(+FLT_MAX);
+		XMVECTOR vMax = XMVectorReplicate(-FLT_MAX);
+		for (UINT i = first; i < first + count; i++) {
+			vMin = XMVectorMin(vMin, GetMin(bounds[order[i]]));
+			vMax = XMVectorMax(vMax, GetMax(bounds[order[i]]));
+		}
+		return MakeBox(vMin, vMax);
+	};
+
+	tree.Nodes.reserve(2 * num);
+	tree.Parents.reserve(2 * num);
+	tree.Nodes.push_back({ CalRangeBounds(0, num), 0, num });
+	tree.Parents.push_back(NO_PARENT);
+
+	struct Task { UINT Node; UINT Depth; };
+	std::vector<Task> tasks;
+	tasks.push_back({ 0, 0 });
+	while (!tasks.empty()) {
+		Task task = tasks.back();
+		tasks.pop_back();
+		UINT first = tree.Nodes[task.Node].First;
+		UINT count = tree.Nodes[task.Node].Count;
+		if (count <= MIN_LEAF_SIZE)
+			continue;
+
+		// Bounds of centroids decide the bins
+		XMVECTOR cMin = XMVectorReplicate(+FLT_MAX);
+		XMVECTOR cMax = XMVectorReplicate(-FLT_MAX);
+		for (UINT i = first; i < first + count; i++) {
+			XMVECTOR c = XMLoadFloat3(&centroids[order[i]]);
+			cMin = XMVectorMin(cMin, c);
+			cMax = XMVectorMax(cMax, c);
+		}
+		XMFLOAT3 cLow, cSize;
+		XMStoreFloat3(&cLow, cMin);
+		XMStoreFloat3(&cSize, XMVectorSubtract(cMax, cMin));
+		float low[3] = { cLow.x, cLow.y, cLow.z };
+		float size[3] = { cSize.x, cSize.y, cSize.z };
+
+		// Binned SAH over all three axes
+		UINT bestAxis = 0;
+		UINT bestSplit = 0;
+		float bestCost = FLT_MAX;
+		if (task.Depth < MAX_SAH_DEPTH) {
+			for (UINT axis = 0; axis < 3; axis++) {
+				if (size[axis] <= 0.0f)
+					continue;
+				float scale = BIN_NUM / size[axis];
+
+				UINT binCounts[BIN_NUM] = {};
+				XMVECTOR binMins[BIN_NUM];
+				XMVECTOR binMaxs[BIN_NUM];
+				for (UINT b = 0; b < BIN_NUM; b++) {
+					binMins[b] = XMVectorReplicate(+FLT_MAX);
+					binMaxs[b] = XMVectorReplicate(-FLT_MAX);
+				}
+				for (UINT i = first; i < first + count; i++) {
+					UINT item = order[i];
+					float c = GetAxis(centroids[item], axis);
+					UINT b = MathHelper::Min(static_cast<UINT>((c - low[axis]) * scale), BIN_NUM - 1);
+					binCounts[b]++;
+					binMins[b] = XMVectorMin(binMins[b], GetMin(bounds[item]));
+					binMaxs[b] = XMVectorMax(binMaxs[b], GetMax(bounds[item]));
+				}
+
+				// Sweep from the right, then from the left
+				float rightAreas[BIN_NUM];
+				UINT rightCounts[BIN_NUM];
+				XMVECTOR vMin = XMVectorReplicate(+FLT_MAX);
+				XMVECTOR vMax = XMVectorReplicate(-FLT_MAX);
+				UINT accum = 0;
+				for (UINT b = BIN_NUM - 1; b > 0; b--) {
+					vMin = XMVectorMin(vMin, binMins[b]);
+					vMax = XMVectorMax(vMax, binMaxs[b]);
+					accum += binCounts[b];
+					rightAreas[b] = HalfArea(vMin, vMax);
+					rightCounts[b] = accum;
+				}
+				vMin = XMVectorReplicate(+FLT_MAX);
+				vMax = XMVectorReplicate(-FLT_MAX);
+				accum = 0;
+				for (UINT b = 0; b + 1 < BIN_NUM; b++) {
+					vMin = XMVectorMin(vMin, binMins[b]);
+					vMax = XMVectorMax(vMax, binMaxs[b]);
+					accum += binCounts[b];
+					if (accum == 0 || rightCounts[b + 1] == 0)
+						continue;
+					float cost = HalfArea(vMin, vMax) * accum + rightAreas[b + 1] * rightCounts[b + 1];
+					if (cost < bestCost) {
+						bestCost = cost;
+						bestAxis = axis;
+						bestSplit = b + 1;
+					}
+				}
+			}
+		}
+
+		float nodeArea = HalfArea(tree.Nodes[task.Node].Bounds);
+		UINT mid;
+		if (bestCost < FLT_MAX && nodeArea + bestCost < nodeArea * count) {
+			// Split at the best bin boundary
+			float scale = BIN_NUM / size[bestAxis];
+			auto middle = std::partition(order.begin() + first, order.begin() + first + count,
+				[&](UINT item) {
+					float c = GetAxis(centroids[item], bestAxis);
+					return MathHelper::Min(static_cast<UINT>((c - low[bestAxis]) * scale), BIN_NUM - 1) < bestSplit;
+				});
+			mid = static_cast<UINT>(middle - order.begin());
+		}
+		else if (count <= MAX_LEAF_SIZE) {
+			// Splitting doesn't pay off
+			continue;
+		}
+		else {
+			// Median of the widest axis
+			UINT axis = size[0] >= size[1] ? (size[0] >= size[2] ? 0 : 2) : (size[1] >= size[2] ? 1 : 2);
+			mid = first + count / 2;
+			std::nth_element(order.begin() + first, order.begin() + mid, order.begin() + first + count,
+				[&](UINT a, UINT b) { return GetAxis(centroids[a], axis) < GetAxis(centroids[b], axis); });
+		}
+
+		UINT left = static_cast<UINT>(tree.Nodes.size());
+		tree.Nodes.push_back({ CalRangeBounds(first, mid - first), first, mid - first });
+		tree.Nodes.push_back({ CalRangeBounds(mid, first + count - mid), mid, first + count - mid });
+		tree.Parents.push_back(task.Node);
+		tree.Parents.push_back(task.Node);
+		tree.Nodes[task.Node].First = left;
+		tree.Nodes[task.Node].Count = 0;
+		tasks.push_back({ left, task.Depth + 1 });
+		tasks.push_back({ left + 1, task.Depth + 1 });
+	}
+
+	tree.ObjectIDs.resize(num);
+	tree.ItemBounds.resize(num);
+	for (UINT i = 0; i < num; i++) {
+		tree.ObjectIDs[i] = objectIDs[order[i]];
+		tree.ItemBounds[i] = bounds[order[i]];
+	}
+	return tree;
+}
+
+void Bvh::SetTree(Tree&& tree)
+{
+	mNodes.swap(tree.Nodes);
+	mParents.swap(tree.Parents);
+	mObjectIDs.swap(tree.ObjectIDs);
+	mItemBounds.swap(tree.ItemBounds);
+
+	// Index items by object and leaf
+	mSlotItems.clear();
+	mItemLeafs.resize(mObjectIDs.size());
+	for (UINT i = 0; i < mNodes.size(); i++) {
+		const Node& node = mNodes[i];
+		for (UINT j = node.First; j < node.First + node.Count; j++) {
+			UINT slot = SlotIndex(mObjectIDs[j]);
+			if (slot >= mSlotItems.size())
+				mSlotItems.resize(slot + 1, INVALID_ITEM);
+			mSlotItems[slot] = j;
+			mItemLeafs[j] = i;
+		}
+	}
+	mDirtyLeafs.clear();
+	mLeafDirty.assign(mNodes.size(), false);
+
+	// Objects that showed up while the rebuild was running keep waiting
+	for (UINT i = static_cast<UINT>(mPendingIDs.size()); i-- > 0;)
+		if (FindItem(mPendingIDs[i]) != INVALID_ITEM)
+			RemovePending(i);
+
+	RefitAll();
+	mBuildCost = mCost = CalCost();
+}
+
+float Bvh::CalNodeCost(UINT index)const
+{
+	const Node& node = mNodes[index];
+	return HalfArea(node.Bounds) * (node.Count ? node.Count : 1);
+}
+
+float Bvh::CalCost()const
+{
+	float cost = 0.0f;
+	for (UINT i = 0; i < mNodes.size(); i++)
+		cost += CalNodeCost(i);
+	return cost;
+}
+
+void Bvh::SetPendingBounds(UINT objectID, const BoundingBox& bounds)
+{
+	UINT pending = FindPending(objectID);
+	if (pending != INVALID_ITEM) {
+		mPendingBounds[pending] = bounds;
+		return;
+	}
+
+	// An item in the slot belongs to an object that is gone
+	UINT slot = SlotIndex(objectID);
+	if (slot < mSlotItems.size() && mSlotItems[slot] != INVALID_ITEM)
+		ClearItemBounds(mSlotItems[slot]);
+
+	if (slot >= mSlotPendings.size())
+		mSlotPendings.resize(slot + 1, INVALID_ITEM);
+	mSlotPendings[slot] = static_cast<UINT>(mPendingIDs.size());
+	mPendingIDs.push_back(objectID);
+	mPendingBounds.push_back(bounds);
+}
+
+void Bvh::RemovePending(UINT pending)
+{
+	// Move the last one into the hole
+	UINT last = static_cast<UINT>(mPendingIDs.size()) - 1;
+	mSlotPendings[SlotIndex(mPendingIDs[pending])] = INVALID_ITEM;
+	if (pending != last) {
+		mPendingIDs[pending] = mPendingIDs[last];
+		mPendingBounds[pending] = mPendingBounds[last];
+		mSlotPendings[SlotIndex(mPendingIDs[pending])] = pending;
+	}
+	mPendingIDs.pop_back();
+	mPendingBounds.pop_back();
+}
+
+void Bvh::SetItemBounds(UINT item, const BoundingBox& bounds)
+{
+	if (SameBox(bounds, mItemBounds[item]))
+		return;
+	mItemBounds[item] = bounds;
+	UINT leaf = mItemLeafs[item];
+	if (!mLeafDirty[leaf]) {
+		mLeafDirty[leaf] = true;
+		mDirtyLeafs.push_back(leaf);
+	}
+}
+
+void Bvh::ClearItemBounds(UINT item)
+{
+	// Empty bounds are skipped by refits and queries
+	SetItemBounds(item, EMPTY_BOUNDS);
+}
+
+void Bvh::RefitAll()
+{
+	// Children always come after their parent
+	for (UINT i = static_cast<UINT>(mNodes.size()); i-- > 0;) {
+		Node& node = mNodes[i];
+		XMVECTOR vMin = XMVectorReplicate(+FLT_MAX);
+		XMVECTOR vMax = XMVectorReplicate(-FLT_MAX);
+		if (node.Count) {
+			for (UINT j = node.First; j < node.First + node.Count; j++) {
+				if (mItemBounds[j].Extents.x < 0.0f)
+					continue;
+				vMin = XMVectorMin(vMin, GetMin(mItemBounds[j]));
+				vMax = XMVectorMax(vMax, GetMax(mItemBounds[j]));
+			}
+		}
+		else {
+			for (UINT j = node.First; j < node.First + 2; j++) {
+				vMin = XMVectorMin(vMin, GetMin(mNodes[j].Bounds));
+				vMax = XMVectorMax(vMax, GetMax(mNodes[j].Bounds));
+			}
+		}
+		node.Bounds = MakeBox(vMin, vMax);
+	}
+}
+
+void Bvh::RefitDirtyLeafs()
+{
+	// Refit the dirty leaves, and their ancestors until one doesn't change
+	for (UINT i : mDirtyLeafs) {
+		mLeafDirty[i] = false;
+		Node& leaf = mNodes[i];
+		XMVECTOR vMin = XMVectorReplicate(+FLT_MAX);
+		XMVECTOR vMax = XMVectorReplicate(-FLT_MAX);
+		for (UINT j = leaf.First; j < leaf.First + leaf.Count; j++) {
+			if (mItemBounds[j].Extents.x < 0.0f)
+				continue;
+			vMin = XMVectorMin(vMin, GetMin(mItemBounds[j]));
+			vMax = XMVectorMax(vMax, GetMax(mItemBounds[j]));
+		}
+		BoundingBox bounds = MakeBox(vMin, vMax);
+		if (SameBox(bounds, leaf.Bounds))
+			continue;
+		mCost -= CalNodeCost(i);
+		leaf.Bounds = bounds;
+		mCost += CalNodeCost(i);
+
+		for (UINT index = mParents[i]; index != NO_PARENT; index = mParents[index]) {
+			Node& node = mNodes[index];
+			const Node& left = mNodes[node.First];
+			const Node& right = mNodes[node.First + 1];
+			bounds = MakeBox(
+				XMVectorMin(GetMin(left.Bounds), GetMin(right.Bounds)),
+				XMVectorMax(GetMax(left.Bounds), GetMax(right.Bounds))
+			);
+			if (SameBox(bounds, node.Bounds))
+				break;
+			mCost -= CalNodeCost(index);
+			node.Bounds = bounds;
+			mCost += CalNodeCost(index);
+		}
+	}
+	mDirtyLeafs.clear();
+}
+
+void Bvh::SwapFinishedRebuild()
+{
+	if (!mRebuild.valid() || mRebuild.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		return;
+
+	// Objects may have moved while it was built, they keep their current bounds.
+	// Objects that were pending and no longer are gone.
+	Tree tree = mRebuild.get();
+	for (UINT i = 0; i < tree.ObjectIDs.size(); i++) {
+		UINT item = FindItem(tree.ObjectIDs[i]);
+		UINT pending = FindPending(tree.ObjectIDs[i]);
+		if (item != INVALID_ITEM)
+			tree.ItemBounds[i] = mItemBounds[item];
+		else if (pending != INVALID_ITEM)
+			tree.ItemBounds[i] = mPendingBounds[pending];
+		else
+			tree.ItemBounds[i] = EMPTY_BOUNDS;
+	}
+	SetTree(std::move(tree));
+	mRebuildNum++;
+}
+
+void Bvh::StartRebuildIfNeeded()
+{
+	// Rebuild from a copy of the current bounds in the background
+	if (mRebuild.valid() || (GetCostRatio() <= REBUILD_COST_RATIO && mPendingIDs.empty()))
+		return;
+	std::vector<UINT> ids;
+	std::vector<BoundingBox> bounds;
+	ids.reserve(mObjectIDs.size() + mPendingIDs.size());
+	bounds.reserve(mObjectIDs.size() + mPendingIDs.size());
+	for (UINT i = 0; i < mObjectIDs.size(); i++) {
+		if (mItemBounds[i].Extents.x < 0.0f)
+			continue;
+		ids.push_back(mObjectIDs[i]);
+		bounds.push_back(mItemBounds[i]);
+	}
+	ids.insert(ids.end(), mPendingIDs.begin(), mPendingIDs.end());
+	bounds.insert(bounds.end(), mPendingBounds.begin(), mPendingBounds.end());
+	mRebuild = std::async(std::launch::async, &Bvh::BuildTree, std::move(ids), std::move(bounds));
+}
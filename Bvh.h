@@ -0,0 +1,174 @@
+#pragma once
+#include <future>
+#include <vector>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+
+#include "PlatformTypes.h"
+#include "SlotMap.h"
+#include "Frustum.h"
+
+// Bounding volume hierarchy over the world bounds of objects.
+// Built top-down with binned SAH, refit bottom-up when objects move,
+// and rebuilt on a background thread once refitting has made it too loose.
+// Objects are referred to by their IDs, the bounds are handed in by the caller.
+// Objects first seen by Update are tested one by one until a background rebuild
+// inserts them.
+// Queries report object IDs, callers map them to what the objects draw.
+class Bvh
+{
+public:
+	struct Node {
+		DirectX::BoundingBox Bounds;
+		UINT First; // first leaf item, or left child for interior nodes (right child is First + 1)
+		UINT Count; // number of leaf items, 0 for interior nodes
+	};
+
+	~Bvh();
+
+	// Build synchronously, bounds[i] are the world bounds of objectIDs[i]
+	void Build(const std::vector<UINT>& objectIDs, const std::vector<DirectX::BoundingBox>& bounds);
+
+	// Refit the leaves of the given objects and their ancestors, the rest of the tree isn't touched.
+	// getBounds(UINT objectID, BoundingBox& bounds) returns false for objects that are gone
+	// or have no bounds, which are skipped from then on.
+	// Objects not in the tree wait for the next rebuild.
+	// Start a background rebuild when the tree has degraded or objects wait,
+	// and swap it in once it is finished.
+	template<typename GetBounds>
+	void Update(const std::vector<UINT>& objectIDs, GetBounds&& getBounds) {
+		SwapFinishedRebuild();
+		DirectX::BoundingBox bounds;
+		for (UINT id : objectIDs) {
+			bool hasBounds = getBounds(id, bounds);
+			UINT item = FindItem(id);
+			if (item != INVALID_ITEM) {
+				if (hasBounds)
+					SetItemBounds(item, bounds);
+				else
+					ClearItemBounds(item);
+				continue;
+			}
+			UINT pending = FindPending(id);
+			if (hasBounds)
+				SetPendingBounds(id, bounds);
+			else if (pending != INVALID_ITEM)
+				RemovePending(pending);
+		}
+		RefitDirtyLeafs();
+		StartRebuildIfNeeded();
+	}
+
+	// visitor(UINT objectID) for every object whose bounds intersect
+	template<typename Visitor>
+	void QueryFrustum(const Frustum& frustum, Visitor&& visitor)const {
+		Query([&frustum](const DirectX::BoundingBox& box) { return frustum.Intersects(box); }, visitor);
+	}
+	template<typename Visitor>
+	void QuerySphere(const DirectX::BoundingSphere& sphere, Visitor&& visitor)const {
+		Query([&sphere](const DirectX::BoundingBox& box) { return sphere.Intersects(box); }, visitor);
+	}
+	// direction must be normalized
+	template<typename Visitor>
+	void XM_CALLCONV QueryRay(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR direction, float maxDist, Visitor&& visitor)const {
+		Query([origin, direction, maxDist](const DirectX::BoundingBox& box) {
+			float dist;
+			return box.Intersects(origin, direction, dist) && dist <= maxDist;
+		}, visitor);
+	}
+
+	UINT GetObjectNum()const { return static_cast<UINT>(mObjectIDs.size()); }
+	// Objects waiting to be inserted by a rebuild
+	UINT GetPendingNum()const { return static_cast<UINT>(mPendingIDs.size()); }
+	UINT GetNodeNum()const { return static_cast<UINT>(mNodes.size()); }
+	UINT GetRebuildNum()const { return mRebuildNum; }
+	// SAH cost relative to the cost right after the last build
+	float GetCostRatio()const { return mBuildCost > 0.0f ? mCost / mBuildCost : 1.0f; }
+
+private:
+	// Rebuild once refitting has made the tree this much more expensive
+	static constexpr float REBUILD_COST_RATIO = 1.5f;
+	static const UINT INVALID_ITEM = -1;
+
+	// Leaves and nodes of a tree, built without touching any Bvh state
+	struct Tree {
+		std::vector<Node> Nodes;
+		std::vector<UINT> Parents;
+		std::vector<UINT> ObjectIDs; // leaf items
+		std::vector<DirectX::BoundingBox> ItemBounds;
+	};
+	static Tree BuildTree(std::vector<UINT> objectIDs, std::vector<DirectX::BoundingBox> bounds);
+
+	// Swap in a tree and index its items
+	void SetTree(Tree&& tree);
+	void SwapFinishedRebuild();
+	void StartRebuildIfNeeded();
+
+	UINT FindItem(UINT objectID)const {
+		UINT slot = SlotIndex(objectID);
+		if (slot >= mSlotItems.size())
+			return INVALID_ITEM;
+		UINT item = mSlotItems[slot];
+		return item != INVALID_ITEM && mObjectIDs[item] == objectID ? item : INVALID_ITEM;
+	}
+	UINT FindPending(UINT objectID)const {
+		UINT slot = SlotIndex(objectID);
+		if (slot >= mSlotPendings.size())
+			return INVALID_ITEM;
+		UINT pending = mSlotPendings[slot];
+		return pending != INVALID_ITEM && mPendingIDs[pending] == objectID ? pending : INVALID_ITEM;
+	}
+	void SetPendingBounds(UINT objectID, const DirectX::BoundingBox& bounds);
+	void RemovePending(UINT pending);
+	void SetItemBounds(UINT item, const DirectX::BoundingBox& bounds);
+	void ClearItemBounds(UINT item);
+	void RefitDirtyLeafs();
+	void RefitAll();
+	float CalCost()const;
+	float CalNodeCost(UINT index)const;
+
+	template<typename Test, typename Visitor>
+	void Query(Test&& test, Visitor&& visitor)const {
+		for (UINT i = 0; i < mPendingIDs.size(); i++)
+			if (test(mPendingBounds[i]))
+				visitor(mPendingIDs[i]);
+
+		if (mNodes.empty())
+			return;
+		UINT stack[64];
+		UINT stackSize = 0;
+		stack[stackSize++] = 0;
+		while (stackSize) {
+			const Node& node = mNodes[stack[--stackSize]];
+			if (!test(node.Bounds))
+				continue;
+			if (node.Count) {
+				for (UINT i = node.First; i < node.First + node.Count; i++)
+					if (mItemBounds[i].Extents.x >= 0.0f && test(mItemBounds[i]))
+						visitor(mObjectIDs[i]);
+				continue;
+			}
+			stack[stackSize++] = node.First + 1;
+			stack[stackSize++] = node.First;
+		}
+	}
+	std::vector<Node> mNodes;
+	std::vector<UINT> mParents;
+	std::vector<UINT> mObjectIDs;
+	std::vector<DirectX::BoundingBox> mItemBounds; // world bounds of leaf items as of the last refit
+	std::vector<UINT> mItemLeafs; // leaf node of each item
+	std::vector<UINT> mSlotItems; // item of each object slot index, INVALID_ITEM if not in the tree
+	std::vector<UINT> mDirtyLeafs; // leafs with items changed by this update
+	std::vector<bool> mLeafDirty; // per node
+
+	// Objects not in the tree, in no particular order
+	std::vector<UINT> mPendingIDs;
+	std::vector<DirectX::BoundingBox> mPendingBounds;
+	std::vector<UINT> mSlotPendings; // pending index of each object slot index, INVALID_ITEM if not pending
+
+	float mBuildCost = 0.0f;
+	float mCost = 0.0f;
+
+	std::future<Tree> mRebuild;
+	UINT mRebuildNum = 0;
+};
@@ -0,0 +1,52 @@
+#pragma once
+#include "Common/d3dUtil.h"
+
+// Slots of a GPU buffer whose CPU value changed but not every copy of the buffer has it yet.
+// With copyNum copies, one per frame in flight, a slot changing in a frame is written
+// into the copy of that frame and of the next copyNum - 1 frames.
+// Pending slots are handed out as runs of consecutive slots, so each run is one memcpy.
+class ChangeList
+{
+public:
+	explicit ChangeList(UINT copyNum = 1)
+		: mCopyNum(copyNum) {
+	}
+
+	void MarkChanged(UINT slot) {
+		if (slot >= mRemainings.size())
+			mRemainings.resize(slot + 1, 0);
+		if (mRemainings[slot] == 0)
+			mPendings.push_back(slot);
+		mRemainings[slot] = static_cast<UINT8>(mCopyNum);
+	}
+
+	// Call writeRange(first, count) for every run of pending slots, to write them
+	// into the copy of this frame. Return the number of slots written.
+	template<typename WriteRange>
+	UINT Flush(WriteRange&& writeRange) {
+		std::sort(mPendings.begin(), mPendings.end());
+		UINT writtenNum = static_cast<UINT>(mPendings.size());
+		for (size_t i = 0; i < mPendings.size();) {
+			size_t j = i + 1;
+			while (j < mPendings.size() && mPendings[j] == mPendings[j - 1] + 1)
+				j++;
+			writeRange(mPendings[i], static_cast<UINT>(j - i));
+			i = j;
+		}
+
+		// Slots stay pending until every copy has them
+		size_t keptNum = 0;
+		for (UINT slot : mPendings)
+			if (--mRemainings[slot] > 0)
+				mPendings[keptNum++] = slot;
+		mPendings.resize(keptNum);
+		return writtenNum;
+	}
+
+	UINT GetPendingNum()const { return static_cast<UINT>(mPendings.size()); }
+
+private:
+	UINT mCopyNum;
+	std::vector<UINT8> mRemainings; // by slot, copies still missing the latest value
+	std::vector<UINT> mPendings; // slots with remaining copies
+};
@@ -0,0 +1,153 @@
+#pragma once
+#include <array>
+
+#include "PlatformTypes.h"
+
+// Root parameters whose arguments are remembered, higher ones are always forwarded
+const UINT ENCODER_ROOT_PARAM_NUM = 16;
+
+// Forwards state setting calls to a command list, dropping the ones setting
+// what is already set. Api names the command list and the types its calls take,
+// D3D12EncoderApi in D3D12CommandEncoder.h, or a mock counting calls in the tests:
+//   CommandList, PipelineState, RootSignature, VertexBufferView, IndexBufferView,
+//   PrimitiveTopology, GpuVirtualAddress and the PrimitiveTopology UNDEFINED_TOPOLOGY.
+// State set on the command list directly is unknown to the encoder,
+// call Invalidate afterwards.
+template <class Api>
+class CommandEncoder
+{
+public:
+	typedef typename Api::CommandList CommandList;
+	typedef typename Api::PipelineState PipelineState;
+	typedef typename Api::RootSignature RootSignature;
+	typedef typename Api::VertexBufferView VertexBufferView;
+	typedef typename Api::IndexBufferView IndexBufferView;
+	typedef typename Api::PrimitiveTopology PrimitiveTopology;
+	typedef typename Api::GpuVirtualAddress GpuVirtualAddress;
+
+	explicit CommandEncoder(CommandList* commandList)
+		: mCommandList(commandList), mVertexBuffer(), mIndexBuffer() {
+		Invalidate();
+	}
+
+	// Forget all state, the next set of everything is forwarded
+	void Invalidate() {
+		mPSO = nullptr;
+		mRootSign = nullptr;
+		mHasVertexBuffer = false;
+		mHasIndexBuffer = false;
+		mTopology = Api::UNDEFINED_TOPOLOGY;
+		InvalidateRootArgs();
+	}
+
+	void SetPipelineState(PipelineState* pso) {
+		if (Skip(pso == mPSO))
+			return;
+		mPSO = pso;
+		mCommandList->SetPipelineState(pso);
+	}
+	// Root arguments are undefined after changing the root signature
+	void SetGraphicsRootSignature(RootSignature* rootSign) {
+		if (Skip(rootSign == mRootSign))
+			return;
+		mRootSign = rootSign;
+		InvalidateRootArgs();
+		mCommandList->SetGraphicsRootSignature(rootSign);
+	}
+
+	// Slot 0 only
+	void IASetVertexBuffer(const VertexBufferView& view) {
+		if (Skip(mHasVertexBuffer
+			&& view.BufferLocation == mVertexBuffer.BufferLocation
+			&& view.SizeInBytes == mVertexBuffer.SizeInBytes
+			&& view.StrideInBytes == mVertexBuffer.StrideInBytes))
+			return;
+		mHasVertexBuffer = true;
+		mVertexBuffer = view;
+		mCommandList->IASetVertexBuffers(0, 1, &view);
+	}
+	void IASetIndexBuffer(const IndexBufferView& view) {
+		if (Skip(mHasIndexBuffer
+			&& view.BufferLocation == mIndexBuffer.BufferLocation
+			&& view.SizeInBytes == mIndexBuffer.SizeInBytes
+			&& view.Format == mIndexBuffer.Format))
+			return;
+		mHasIndexBuffer = true;
+		mIndexBuffer = view;
+		mCommandList->IASetIndexBuffer(&view);
+	}
+	void IASetPrimitiveTopology(PrimitiveTopology topology) {
+		if (Skip(topology == mTopology))
+			return;
+		mTopology = topology;
+		mCommandList->IASetPrimitiveTopology(topology);
+	}
+
+	void SetGraphicsRootConstantBufferView(UINT index, GpuVirtualAddress addr) {
+		if (Skip(SameRootArg(index, addr)))
+			return;
+		mCommandList->SetGraphicsRootConstantBufferView(index, addr);
+	}
+	void SetGraphicsRootShaderResourceView(UINT index, GpuVirtualAddress addr) {
+		if (Skip(SameRootArg(index, addr)))
+			return;
+		mCommandList->SetGraphicsRootShaderResourceView(index, addr);
+	}
+	// Only constants at offset 0 are remembered
+	void SetGraphicsRoot32BitConstant(UINT index, UINT value, UINT offset) {
+		if (offset != 0) {
+			if (index < ENCODER_ROOT_PARAM_NUM)
+				mRootArgValids[index] = false;
+			mIssuedNum++;
+		}
+		else if (Skip(SameRootArg(index, value)))
+			return;
+		mCommandList->SetGraphicsRoot32BitConstant(index, value, offset);
+	}
+
+	void DrawIndexedInstanced(UINT indexCount, UINT instanceCount, UINT startIndex, INT baseVertex, UINT startInstance) {
+		mIssuedNum++;
+		mCommandList->DrawIndexedInstanced(indexCount, instanceCount, startIndex, baseVertex, startInstance);
+	}
+
+	CommandList* GetCommandList()const { return mCommandList; }
+	// Calls forwarded to the command list, and calls dropped as redundant
+	UINT GetIssuedNum()const { return mIssuedNum; }
+	UINT GetSkippedNum()const { return mSkippedNum; }
+
+private:
+	bool Skip(bool redundant) {
+		if (redundant)
+			mSkippedNum++;
+		else
+			mIssuedNum++;
+		return redundant;
+	}
+	void InvalidateRootArgs() {
+		mRootArgValids.fill(false);
+	}
+	// Whether index already holds arg, which it holds afterwards
+	bool SameRootArg(UINT index, UINT64 arg) {
+		if (index >= ENCODER_ROOT_PARAM_NUM)
+			return false;
+		bool same = mRootArgValids[index] && mRootArgs[index] == arg;
+		mRootArgs[index] = arg;
+		mRootArgValids[index] = true;
+		return same;
+	}
+
+	CommandList* mCommandList;
+
+	PipelineState* mPSO;
+	RootSignature* mRootSign;
+	bool mHasVertexBuffer;
+	VertexBufferView mVertexBuffer;
+	bool mHasIndexBuffer;
+	IndexBufferView mIndexBuffer;
+	PrimitiveTopology mTopology;
+	std::array<UINT64, ENCODER_ROOT_PARAM_NUM> mRootArgs;
+	std::array<bool, ENCODER_ROOT_PARAM_NUM> mRootArgValids;
+
+	UINT mIssuedNum = 0;
+	UINT mSkippedNum = 0;
+};
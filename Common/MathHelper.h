@@ -6,9 +6,13 @@
 
 #pragma once
 
+#ifdef _WIN32
 #include <Windows.h>
+#endif
 #include <DirectXMath.h>
 #include <cstdint>
+#include <cstdlib>
+#include <cmath>
 
 class MathHelper
 {
@@ -89,9 +93,9 @@ public:
 		// Inverse-transpose is just applied to normals.  So zero out 
 		// translation row so that it doesn't get into our inverse-transpose
 		// calculation--we don't want the inverse-transpose of the translation.
-		A.r[0].m128_f32[3] = 0.0f;
-		A.r[1].m128_f32[3] = 0.0f;
-		A.r[2].m128_f32[3] = 0.0f;
+		A.r[0] = DirectX::XMVectorSetW(A.r[0], 0.0f);
+		A.r[1] = DirectX::XMVectorSetW(A.r[1], 0.0f);
+		A.r[2] = DirectX::XMVectorSetW(A.r[2], 0.0f);
         A.r[3] = DirectX::XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f);
 		return MathHelper::InverseTranspose(A);
 	}
@@ -55,6 +55,18 @@ public:
         memcpy(&mMappedData[elementIndex*mElementByteSize], &data, sizeof(T));
     }
 
+    // Copy count consecutive elements, in one memcpy unless elements are padded
+    void CopyData(int firstElement, const T* data, UINT count)
+    {
+        if(mElementByteSize == sizeof(T))
+        {
+            memcpy(&mMappedData[firstElement*mElementByteSize], data, sizeof(T)*count);
+            return;
+        }
+        for(UINT i = 0; i < count; ++i)
+            CopyData(firstElement + i, data[i]);
+    }
+
     UINT getElementByteSize()const { return mElementByteSize; }
 
 private:
@@ -507,7 +507,8 @@ void D3DApp::CalculateFrameStats()
 
         wstring windowText = mMainWndCaption +
             L"    fps: " + fpsStr +
-            L"   mspf: " + mspfStr;
+            L"   mspf: " + mspfStr +
+            GetFrameStatsText();
 
         SetWindowText(mhMainWnd, windowText.c_str());
 		
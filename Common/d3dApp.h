@@ -67,6 +67,8 @@ protected:
 	void FlushCommandQueue();
 
 	void CalculateFrameStats();
+	// Extra per-frame stats appended to the window caption.
+	virtual std::wstring GetFrameStatsText() { return L""; }
 
     void LogAdapters();
     void LogAdapterOutputs(IDXGIAdapter* adapter);
@@ -0,0 +1,17 @@
+#pragma once
+#include "Common/d3dUtil.h"
+#include "CommandEncoder.h"
+
+// CommandEncoder over a D3D12 graphics command list
+struct D3D12EncoderApi {
+	typedef ID3D12GraphicsCommandList CommandList;
+	typedef ID3D12PipelineState PipelineState;
+	typedef ID3D12RootSignature RootSignature;
+	typedef D3D12_VERTEX_BUFFER_VIEW VertexBufferView;
+	typedef D3D12_INDEX_BUFFER_VIEW IndexBufferView;
+	typedef D3D_PRIMITIVE_TOPOLOGY PrimitiveTopology;
+	typedef D3D12_GPU_VIRTUAL_ADDRESS GpuVirtualAddress;
+	static const D3D_PRIMITIVE_TOPOLOGY UNDEFINED_TOPOLOGY = D3D_PRIMITIVE_TOPOLOGY_UNDEFINED;
+};
+
+using GraphicsCommandEncoder = CommandEncoder<D3D12EncoderApi>;
@@ -0,0 +1,42 @@
+#pragma once
+#include "Common/d3dUtil.h"
+#include "FrameRing.h"
+
+// Fence signaled by a command queue
+class D3D12FrameFence : public FrameFence
+{
+public:
+	D3D12FrameFence(ID3D12Device* device, ID3D12CommandQueue* commandQueue)
+		: mCommandQueue(commandQueue) {
+		ThrowIfFailed(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&mFence)));
+		mEvent = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
+		if (!mEvent)
+			throw "Fail to create fence event.";
+	}
+	D3D12FrameFence(const D3D12FrameFence&) = delete;
+	D3D12FrameFence& operator=(const D3D12FrameFence&) = delete;
+	~D3D12FrameFence() {
+		CloseHandle(mEvent);
+	}
+
+	UINT64 Signal() override {
+		mValue++;
+		ThrowIfFailed(mCommandQueue->Signal(mFence.Get(), mValue));
+		return mValue;
+	}
+	UINT64 GetCompletedValue()const override {
+		return mFence->GetCompletedValue();
+	}
+	void WaitFor(UINT64 value) override {
+		if (mFence->GetCompletedValue() >= value)
+			return;
+		ThrowIfFailed(mFence->SetEventOnCompletion(value, mEvent));
+		WaitForSingleObject(mEvent, INFINITE);
+	}
+
+private:
+	ID3D12CommandQueue* mCommandQueue;
+	Microsoft::WRL::ComPtr<ID3D12Fence> mFence;
+	HANDLE mEvent;
+	UINT64 mValue = 0;
+};
@@ -0,0 +1,61 @@
+#pragma once
+#include "Common/d3dUtil.h"
+#include "D3D12CommandEncoder.h"
+#include "PassRecorder.h"
+
+using GraphicsPassRecorder = PassRecorder<D3D12EncoderApi>;
+
+// Graphics command lists submitted to a direct queue.
+// Allocators belong to the frame resource being recorded, one per list.
+class D3D12CommandListProvider : public CommandListProvider<ID3D12GraphicsCommandList>
+{
+public:
+	D3D12CommandListProvider(ID3D12Device* device, ID3D12CommandQueue* commandQueue, UINT maxListNum)
+		: mCommandQueue(commandQueue) {
+		// Lists are created with a throwaway allocator and closed, BeginList resets them
+		Microsoft::WRL::ComPtr<ID3D12CommandAllocator> allocator;
+		ThrowIfFailed(device->CreateCommandAllocator(
+			D3D12_COMMAND_LIST_TYPE_DIRECT,
+			IID_PPV_ARGS(allocator.GetAddressOf())
+		));
+		mCommandLists.resize(maxListNum);
+		for (auto& commandList : mCommandLists) {
+			ThrowIfFailed(device->CreateCommandList(
+				0, D3D12_COMMAND_LIST_TYPE_DIRECT,
+				allocator.Get(), nullptr,
+				IID_PPV_ARGS(commandList.GetAddressOf())
+			));
+			ThrowIfFailed(commandList->Close());
+		}
+	}
+
+	// Allocators to record the next lists with, at least GetMaxListNum of them
+	void SetAllocators(const std::vector<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>>* allocators) {
+		if (allocators->size() < mCommandLists.size())
+			throw "Allocators too few.";
+		mAllocators = allocators;
+	}
+
+	UINT GetMaxListNum()const override { return static_cast<UINT>(mCommandLists.size()); }
+	ID3D12GraphicsCommandList* BeginList(UINT index) override {
+		// The frame ring made sure the GPU is done with the allocator
+		ID3D12CommandAllocator* allocator = (*mAllocators)[index].Get();
+		ID3D12GraphicsCommandList* commandList = mCommandLists[index].Get();
+		ThrowIfFailed(allocator->Reset());
+		ThrowIfFailed(commandList->Reset(allocator, nullptr));
+		return commandList;
+	}
+	void EndList(ID3D12GraphicsCommandList* commandList) override {
+		ThrowIfFailed(commandList->Close());
+	}
+	void Submit(ID3D12GraphicsCommandList* const* commandLists, UINT num) override {
+		mSubmitLists.assign(commandLists, commandLists + num);
+		mCommandQueue->ExecuteCommandLists(num, mSubmitLists.data());
+	}
+
+private:
+	ID3D12CommandQueue* mCommandQueue;
+	std::vector<Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList>> mCommandLists;
+	const std::vector<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>>* mAllocators = nullptr;
+	std::vector<ID3D12CommandList*> mSubmitLists;
+};
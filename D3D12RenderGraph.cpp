@@ -0,0 +1,51 @@
+#include "D3D12RenderGraph.h"
+
+// GraphState is cast to D3D12_RESOURCE_STATES
+static_assert(GRAPH_STATE_RENDER_TARGET == D3D12_RESOURCE_STATE_RENDER_TARGET, "");
+static_assert(GRAPH_STATE_UNORDERED_ACCESS == D3D12_RESOURCE_STATE_UNORDERED_ACCESS, "");
+static_assert(GRAPH_STATE_DEPTH_WRITE == D3D12_RESOURCE_STATE_DEPTH_WRITE, "");
+static_assert(GRAPH_STATE_DEPTH_READ == D3D12_RESOURCE_STATE_DEPTH_READ, "");
+static_assert(GRAPH_STATE_NON_PIXEL_SHADER_RESOURCE == D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, "");
+static_assert(GRAPH_STATE_PIXEL_SHADER_RESOURCE == D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, "");
+static_assert(GRAPH_STATE_COPY_DEST == D3D12_RESOURCE_STATE_COPY_DEST, "");
+static_assert(GRAPH_STATE_COPY_SOURCE == D3D12_RESOURCE_STATE_COPY_SOURCE, "");
+static_assert(GRAPH_STATE_RESOLVE_DEST == D3D12_RESOURCE_STATE_RESOLVE_DEST, "");
+static_assert(GRAPH_STATE_RESOLVE_SOURCE == D3D12_RESOURCE_STATE_RESOLVE_SOURCE, "");
+static_assert(GRAPH_STATE_PRESENT == D3D12_RESOURCE_STATE_PRESENT, "");
+
+void D3D12RenderGraph::RecordBarriers(ID3D12GraphicsCommandList* commandList, Span<const GraphBarrier> barriers)const
+{
+	// Converted in chunks on the stack, one call unless there are many.
+	// Resources activated by aliasing barriers are discarded before the transitions after them.
+	const UINT CHUNK_SIZE = 16;
+	D3D12_RESOURCE_BARRIER chunk[CHUNK_SIZE];
+	UINT num = 0;
+	size_t discardBegin = 0; // aliasing barriers in the chunk
+	size_t discardEnd = 0;
+	auto flush = [&]() {
+		if (num)
+			commandList->ResourceBarrier(num, chunk);
+		num = 0;
+		for (size_t i = discardBegin; i < discardEnd; i++)
+			commandList->DiscardResource(mD3DResources[barriers[i].Resource], nullptr);
+		discardBegin = discardEnd;
+	};
+
+	for (size_t i = 0; i < barriers.size(); i++) {
+		const GraphBarrier& barrier = barriers[i];
+		bool discardPending = discardBegin < discardEnd;
+		if (num == CHUNK_SIZE || (discardPending && !barrier.Aliasing))
+			flush();
+
+		ID3D12Resource* resource = mD3DResources[barrier.Resource];
+		if (barrier.Aliasing) {
+			chunk[num++] = CD3DX12_RESOURCE_BARRIER::Aliasing(nullptr, resource);
+			if (discardBegin == discardEnd)
+				discardBegin = i;
+			discardEnd = i + 1;
+		}
+		else
+			chunk[num++] = CD3DX12_RESOURCE_BARRIER::Transition(resource, ToD3D12State(barrier.Before), ToD3D12State(barrier.After));
+	}
+	flush();
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "Common/d3dUtil.h"
+#include "RenderGraph.h"
+
+// Render graph over D3D12 resources.
+// Resources are imported with the D3D12 resource of their id,
+// the compiled barriers are recorded into a command list.
+class D3D12RenderGraph : public RenderGraph
+{
+public:
+	void Clear() {
+		RenderGraph::Clear();
+		mD3DResources.clear();
+	}
+
+	UINT ImportResource(ID3D12Resource* resource, GraphState restState) {
+		UINT id = RenderGraph::ImportResource(restState);
+		mD3DResources.push_back(resource);
+		return id;
+	}
+	UINT ImportTransient(ID3D12Resource* resource, GraphState restState) {
+		UINT id = RenderGraph::ImportTransient(restState);
+		mD3DResources.push_back(resource);
+		return id;
+	}
+	ID3D12Resource* GetResource(UINT resource)const { return mD3DResources[resource]; }
+
+	// Record barriers into commandList in one call, and discard the resources
+	// aliasing barriers activate
+	void RecordBarriers(ID3D12GraphicsCommandList* commandList, Span<const GraphBarrier> barriers)const;
+
+private:
+	std::vector<ID3D12Resource*> mD3DResources; // by resource id
+};
+
+inline D3D12_RESOURCE_STATES ToD3D12State(GraphState state)
+{
+	return static_cast<D3D12_RESOURCE_STATES>(state);
+}
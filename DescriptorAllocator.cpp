@@ -0,0 +1,109 @@
+#include "DescriptorAllocator.h"
+
+#include <algorithm>
+
+DescriptorFreeList::DescriptorFreeList(UINT start, UINT num)
+	:mStart(start), mNum(num), mFreeNum(num)
+{
+	if (num > 0)
+		mRanges.push_back({ start, num });
+}
+
+UINT DescriptorFreeList::Alloc(UINT num)
+{
+	if (num == 0)
+		throw "Invalid descriptor num.";
+	for (UINT i = 0; i < mRanges.size(); i++) {
+		Range& range = mRanges[i];
+		if (range.Num < num)
+			continue;
+		UINT start = range.Start;
+		range.Start += num;
+		range.Num -= num;
+		if (range.Num == 0)
+			mRanges.erase(mRanges.begin() + i);
+		mFreeNum -= num;
+		return start;
+	}
+	throw "No enough space in DescriptorHeap";
+}
+
+void DescriptorFreeList::Free(UINT start, UINT num)
+{
+	if (num == 0)
+		return;
+	if (start < mStart || start + num > mStart + mNum)
+		throw "Descriptor range out of heap.";
+
+	// First free range after the freed one
+	auto next = std::lower_bound(mRanges.begin(), mRanges.end(), start,
+		[](const Range& range, UINT value) { return range.Start < value; });
+	if (next != mRanges.end() && start + num > next->Start)
+		throw "Descriptor range freed twice.";
+	if (next != mRanges.begin()) {
+		auto prev = next - 1;
+		if (prev->Start + prev->Num > start)
+			throw "Descriptor range freed twice.";
+
+		// Merge into the previous range, and the next one if they now touch
+		if (prev->Start + prev->Num == start) {
+			prev->Num += num;
+			if (next != mRanges.end() && prev->Start + prev->Num == next->Start) {
+				prev->Num += next->Num;
+				mRanges.erase(next);
+			}
+			mFreeNum += num;
+			return;
+		}
+	}
+	if (next != mRanges.end() && start + num == next->Start) {
+		next->Start = start;
+		next->Num += num;
+	}
+	else
+		mRanges.insert(next, { start, num });
+	mFreeNum += num;
+}
+
+UINT DescriptorFreeList::GetLargestFreeNum()const
+{
+	UINT largest = 0;
+	for (const Range& range : mRanges)
+		largest = std::max(largest, range.Num);
+	return largest;
+}
+
+DescriptorRing::DescriptorRing(UINT start, UINT num, UINT frameNum)
+	:mStart(start), mNum(num), mFrameEnds(frameNum, 0)
+{
+}
+
+void DescriptorRing::BeginFrame(UINT frameIndex)
+{
+	if (frameIndex >= mFrameEnds.size())
+		throw "Invalid frame index.";
+	if (mFrameIndex != UINT_MAX)
+		mFrameEnds[mFrameIndex] = mHead;
+
+	// The GPU finished the last frame recorded into this frame resource,
+	// and frames complete in order, so everything allocated up to its end is free
+	mTail = std::max(mTail, mFrameEnds[frameIndex]);
+	mFrameIndex = frameIndex;
+}
+
+UINT DescriptorRing::Alloc(UINT num)
+{
+	if (num == 0 || num > mNum)
+		throw "Invalid descriptor num.";
+
+	// Ranges are contiguous, skip the slots left at the end of the ring
+	UINT64 head = mHead;
+	UINT offset = static_cast<UINT>(head % mNum);
+	if (offset + num > mNum)
+		head += mNum - offset;
+	if (head + num - mTail > mNum)
+		throw "No enough space in DescriptorRing";
+
+	mHead = head + num;
+	return mStart + static_cast<UINT>(head % mNum);
+}
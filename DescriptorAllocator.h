@@ -0,0 +1,66 @@
+#pragma once
+#include <climits>
+#include <vector>
+
+#include "PlatformTypes.h"
+
+// Allocators of descriptor indices. They only hand out ranges of indices,
+// so they work without a device; DescriptorHeap maps the indices to handles.
+
+// Long-lived descriptors, freed when the view goes away.
+// Free ranges are kept sorted by start and merged with their neighbours,
+// allocation takes the first range large enough.
+class DescriptorFreeList
+{
+public:
+	DescriptorFreeList(UINT start, UINT num);
+
+	// Start index of num contiguous descriptors, throws when no range fits
+	UINT Alloc(UINT num = 1);
+	// Return a range given by Alloc. Freeing a range twice throws.
+	void Free(UINT start, UINT num = 1);
+
+	UINT GetFreeNum()const { return mFreeNum; }
+	// Largest num Alloc can succeed with
+	UINT GetLargestFreeNum()const;
+	UINT GetFreeRangeNum()const { return static_cast<UINT>(mRanges.size()); }
+
+private:
+	struct Range {
+		UINT Start;
+		UINT Num;
+	};
+
+	UINT mStart;
+	UINT mNum;
+	UINT mFreeNum;
+	std::vector<Range> mRanges; // free ranges, by start
+};
+
+// Descriptors living for one frame, recorded into a ring.
+// The descriptors allocated during a frame are released when its frame
+// resource is begun again, which FrameRing only does once the GPU finished it.
+class DescriptorRing
+{
+public:
+	DescriptorRing(UINT start, UINT num, UINT frameNum);
+
+	// Call after FrameRing::BeginFrame with the index it returned
+	void BeginFrame(UINT frameIndex);
+	// Start index of num contiguous descriptors valid until the frame
+	// resource is reused, throws when the frames in flight hold too many
+	UINT Alloc(UINT num = 1);
+
+	UINT GetUsedNum()const { return static_cast<UINT>(mHead - mTail); }
+	UINT GetNum()const { return mNum; }
+
+private:
+	UINT mStart;
+	UINT mNum;
+	// Descriptors allocated and released since creation, wrapped slots included.
+	// The ring offset of the head is mHead % mNum.
+	UINT64 mHead = 0;
+	UINT64 mTail = 0;
+	std::vector<UINT64> mFrameEnds; // head when each frame resource was last left, by frame resource
+	UINT mFrameIndex = UINT_MAX;
+};
@@ -0,0 +1,90 @@
+#pragma once
+#include "Common/d3dUtil.h"
+#include "DescriptorAllocator.h"
+
+// Descriptor heap split in two regions.
+// The persistent region, at the start, holds long-lived views: Alloc and Free them.
+// The ring region, after it, holds descriptors for one frame: AllocTransient
+// them between BeginFrame calls, they are released with their frame resource.
+class DescriptorHeap {
+public:
+	// desc.NumDescriptors counts both regions, the last ringNum descriptors are the ring
+	DescriptorHeap(
+		Microsoft::WRL::ComPtr<ID3D12Device> device,
+		const D3D12_DESCRIPTOR_HEAP_DESC& desc,
+		UINT ringNum = 0,
+		UINT frameNum = 1
+		)
+		:heapDesc(desc),
+		persistent(0, GetPersistentNum(desc.NumDescriptors, ringNum)),
+		ring(GetPersistentNum(desc.NumDescriptors, ringNum), ringNum, frameNum)
+	{
+		ThrowIfFailed(device->CreateDescriptorHeap(
+			&desc,
+			IID_PPV_ARGS(&heap)
+		));
+		descSize = device->GetDescriptorHandleIncrementSize(desc.Type);
+	}
+
+	// Persistent region
+	UINT Alloc(UINT num=1) {
+		return persistent.Alloc(num);
+	}
+	void Free(UINT index, UINT num=1) {
+		persistent.Free(index, num);
+	}
+
+	// Ring region
+	void BeginFrame(UINT frameIndex) {
+		if (ring.GetNum() > 0)
+			ring.BeginFrame(frameIndex);
+	}
+	UINT AllocTransient(UINT num=1) {
+		return ring.Alloc(num);
+	}
+
+	auto GetCPUHandle(UINT index)const {
+		return CD3DX12_CPU_DESCRIPTOR_HANDLE(
+			heap->GetCPUDescriptorHandleForHeapStart(),
+			descSize * index
+		);
+	}
+
+	auto GetGPUHandle(UINT index)const {
+		return CD3DX12_GPU_DESCRIPTOR_HANDLE(
+			heap->GetGPUDescriptorHandleForHeapStart(),
+			descSize * index
+		);
+	}
+
+	UINT GetDescriptorIncrementSize()const {
+		return descSize;
+	}
+
+	ID3D12DescriptorHeap* GetHeap()const {
+		return heap.Get();
+	}
+
+	const DescriptorFreeList& GetPersistent()const {
+		return persistent;
+	}
+	const DescriptorRing& GetRing()const {
+		return ring;
+	}
+
+private:
+	// Checked before the regions are built from it, the subtraction would wrap
+	static UINT GetPersistentNum(UINT totalNum, UINT ringNum) {
+		if (ringNum > totalNum)
+			throw "Invalid descriptor ring size.";
+		return totalNum - ringNum;
+	}
+
+	Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> heap;
+
+	D3D12_DESCRIPTOR_HEAP_DESC heapDesc;
+	UINT descSize;
+
+	DescriptorFreeList persistent;
+	DescriptorRing ring;
+};
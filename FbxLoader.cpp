@@ -56,7 +56,7 @@ std::shared_ptr<Material> FbxLoader::LoadMaterial(FbxNode * node, FbxSurfaceMate
 			return;
 		FbxFileTexture* tex = prop.GetSrcObject<FbxFileTexture>(0);
 		auto nTex = LoadTexture(tex);
-		*dest = nTex->GetID();
+		*dest = nTex->GetSlotIndex();
 	};
 
 	// Property Names
@@ -98,8 +98,8 @@ std::shared_ptr<Material> FbxLoader::LoadMaterial(FbxNode * node, FbxSurfaceMate
 		nMtl->mRoughness = 1.0f - nMtl->mRoughness;
 
 	// DEBUG set some not included properties
-	nMtl->mLTCAmpTexID = Texture::FindByName("ggx_ltc_amp")->GetID();
-	nMtl->mLTCMatTexID = Texture::FindByName("ggx_ltc_mat")->GetID();
+	nMtl->mLTCAmpTexID = Texture::FindByName("ggx_ltc_amp")->GetSlotIndex();
+	nMtl->mLTCMatTexID = Texture::FindByName("ggx_ltc_mat")->GetSlotIndex();
 
 	return nMtl;
 }
@@ -273,6 +273,8 @@ std::shared_ptr<Mesh> XM_CALLCONV FbxLoader::LoadMesh(
 
 	// Pass verts and indices into mesh
 	nMesh->SetBuffer(verts, indices, DXGI_FORMAT_R32_UINT);
+	nMesh->CalBounds();
+	nMesh->BuildLods();
 
 	return nMesh;
 }
@@ -0,0 +1,38 @@
+#pragma once
+#include "Common/d3dUtil.h"
+#include "Common/UploadBuffer.h"
+#include "UploadRing.h"
+#include "Constants.h"
+#include "Object.h"
+
+// Everything the CPU writes for a frame while the GPU may still read earlier frames.
+// Buffers are created by the app as their sizes become known.
+class FrameResource
+{
+public:
+	FrameResource(ID3D12Device* device, UINT cmdListNum) {
+		CmdListAllocs.resize(cmdListNum);
+		for (auto& cmdListAlloc : CmdListAllocs)
+			ThrowIfFailed(device->CreateCommandAllocator(
+				D3D12_COMMAND_LIST_TYPE_DIRECT,
+				IID_PPV_ARGS(cmdListAlloc.GetAddressOf())
+			));
+	}
+	FrameResource(const FrameResource&) = delete;
+	FrameResource& operator=(const FrameResource&) = delete;
+
+	// One per command list, as lists are recorded on different threads.
+	// Reset only once the GPU finished the frame last recorded with them.
+	std::vector<Microsoft::WRL::ComPtr<ID3D12CommandAllocator>> CmdListAllocs;
+
+	// Kept across frames, only changed objects are uploaded
+	std::unique_ptr<UploadBuffer<Object::Content>> ObjectConstantsBuffer; // structured, by object slot
+	UINT ObjectSlotNum = 0; // elements of ObjectConstantsBuffer
+
+	// Allocated from the upload ring every frame, sized for that frame
+	UploadArray<PassConstants::Content> PassConstantsBuffer;
+	UploadArray<ShadowPassConstants::Content> ShadowPassConstantsBuffer;
+	UploadArray<UINT> InstanceBuffer; // object slots of the instances
+	UploadArray<HbaoConstants::Content> HbaoConstantsBuffer;
+	UploadArray<FxaaConstants::Content> FxaaConstantsBuffer;
+};
@@ -0,0 +1,61 @@
+#pragma once
+#include <climits>
+#include <vector>
+
+#include "PlatformTypes.h"
+
+// Fence the frame ring waits on. Values increase by one with every signal.
+class FrameFence
+{
+public:
+	virtual ~FrameFence() = default;
+
+	// Signal the next value once the work submitted so far completes, return the value
+	virtual UINT64 Signal() = 0;
+	virtual UINT64 GetCompletedValue()const = 0;
+	// Block until value is completed
+	virtual void WaitFor(UINT64 value) = 0;
+};
+
+// Cycle through frameNum frame resources, so the CPU records a frame while
+// the GPU still executes up to frameNum - 1 earlier ones.
+// A frame resource is reused once the GPU finished the frame that last used it,
+// the CPU waits only when it laps the GPU.
+class FrameRing
+{
+public:
+	FrameRing(FrameFence* fence, UINT frameNum)
+		: mFence(fence), mFenceValues(frameNum, 0) {
+		if (frameNum == 0)
+			throw "Frame ring needs at least one frame.";
+	}
+
+	// Move to the next frame resource, waiting for the GPU if it still uses it.
+	// Return the index of the frame resource.
+	UINT BeginFrame() {
+		mFrameIndex = (mFrameIndex + 1) % GetFrameNum();
+		UINT64 value = mFenceValues[mFrameIndex];
+		if (value != 0 && mFence->GetCompletedValue() < value) {
+			mFence->WaitFor(value);
+			mWaitNum++;
+		}
+		return mFrameIndex;
+	}
+	// Call after the commands of the frame are submitted
+	void EndFrame() {
+		mFenceValues[mFrameIndex] = mFence->Signal();
+	}
+
+	UINT GetFrameIndex()const { return mFrameIndex; }
+	UINT GetFrameNum()const { return static_cast<UINT>(mFenceValues.size()); }
+	// Fence value completing the last frame recorded into a frame resource, 0 if never used
+	UINT64 GetFenceValue(UINT frameIndex)const { return mFenceValues[frameIndex]; }
+	// Times BeginFrame had to wait for the GPU
+	UINT GetWaitNum()const { return mWaitNum; }
+
+private:
+	FrameFence* mFence;
+	std::vector<UINT64> mFenceValues; // by frame resource
+	UINT mFrameIndex = UINT_MAX; // the first BeginFrame moves to 0
+	UINT mWaitNum = 0;
+};
@@ -0,0 +1,39 @@
+#include "Frustum.h"
+
+using namespace DirectX;
+
+Frustum::Frustum()
+	: Frustum(XMMatrixIdentity())
+{
+}
+
+Frustum::Frustum(FXMMATRIX viewProj)
+{
+	// Clip planes are sums of the matrix columns (Gribb & Hartmann),
+	// D3D clip space has 0 <= z <= w.
+	XMMATRIX cols = XMMatrixTranspose(viewProj);
+	XMVECTOR planes[6] = {
+		XMVectorAdd(cols.r[3], cols.r[0]),
+		XMVectorSubtract(cols.r[3], cols.r[0]),
+		XMVectorAdd(cols.r[3], cols.r[1]),
+		XMVectorSubtract(cols.r[3], cols.r[1]),
+		cols.r[2],
+		XMVectorSubtract(cols.r[3], cols.r[2]),
+	};
+
+	XMFLOAT4 p[8];
+	for (int i = 0; i < 6; i++)
+		XMStoreFloat4(&p[i], XMPlaneNormalize(planes[i]));
+	p[6] = p[7] = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
+
+	for (int g = 0; g < 2; g++) {
+		const XMFLOAT4* q = p + g * 4;
+		mPlaneX[g] = XMFLOAT4(q[0].x, q[1].x, q[2].x, q[3].x);
+		mPlaneY[g] = XMFLOAT4(q[0].y, q[1].y, q[2].y, q[3].y);
+		mPlaneZ[g] = XMFLOAT4(q[0].z, q[1].z, q[2].z, q[3].z);
+		mPlaneW[g] = XMFLOAT4(q[0].w, q[1].w, q[2].w, q[3].w);
+		XMStoreFloat4(&mAbsPlaneX[g], XMVectorAbs(XMLoadFloat4(&mPlaneX[g])));
+		XMStoreFloat4(&mAbsPlaneY[g], XMVectorAbs(XMLoadFloat4(&mPlaneY[g])));
+		XMStoreFloat4(&mAbsPlaneZ[g], XMVectorAbs(XMLoadFloat4(&mPlaneZ[g])));
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+
+// Clip planes of a view volume.
+// Planes are kept component-major in two groups of four,
+// so a box is tested against all of them with a handful of SIMD operations.
+class Frustum
+{
+public:
+	Frustum();
+	// viewProj maps world space to D3D clip space, planes face inward
+	explicit Frustum(DirectX::FXMMATRIX viewProj);
+
+	// False if the box lies completely outside one of the planes
+	bool Intersects(const DirectX::BoundingBox& box)const {
+		using namespace DirectX;
+		XMVECTOR cx = XMVectorReplicate(box.Center.x);
+		XMVECTOR cy = XMVectorReplicate(box.Center.y);
+		XMVECTOR cz = XMVectorReplicate(box.Center.z);
+		XMVECTOR ex = XMVectorReplicate(box.Extents.x);
+		XMVECTOR ey = XMVectorReplicate(box.Extents.y);
+		XMVECTOR ez = XMVectorReplicate(box.Extents.z);
+		for (int g = 0; g < 2; g++) {
+			// Signed distance of the center plus the box's extent along the plane normal
+			XMVECTOR dist = XMVectorMultiplyAdd(cx, XMLoadFloat4(&mPlaneX[g]),
+				XMVectorMultiplyAdd(cy, XMLoadFloat4(&mPlaneY[g]),
+				XMVectorMultiplyAdd(cz, XMLoadFloat4(&mPlaneZ[g]), XMLoadFloat4(&mPlaneW[g]))));
+			XMVECTOR radius = XMVectorMultiplyAdd(ex, XMLoadFloat4(&mAbsPlaneX[g]),
+				XMVectorMultiplyAdd(ey, XMLoadFloat4(&mAbsPlaneY[g]),
+				XMVectorMultiply(ez, XMLoadFloat4(&mAbsPlaneZ[g]))));
+			if (!XMVector4GreaterOrEqual(XMVectorAdd(dist, radius), XMVectorZero()))
+				return false;
+		}
+		return true;
+	}
+
+	// False if the sphere lies completely outside one of the planes
+	bool Intersects(const DirectX::BoundingSphere& sphere)const {
+		using namespace DirectX;
+		XMVECTOR cx = XMVectorReplicate(sphere.Center.x);
+		XMVECTOR cy = XMVectorReplicate(sphere.Center.y);
+		XMVECTOR cz = XMVectorReplicate(sphere.Center.z);
+		XMVECTOR radius = XMVectorReplicate(sphere.Radius);
+		for (int g = 0; g < 2; g++) {
+			XMVECTOR dist = XMVectorMultiplyAdd(cx, XMLoadFloat4(&mPlaneX[g]),
+				XMVectorMultiplyAdd(cy, XMLoadFloat4(&mPlaneY[g]),
+				XMVectorMultiplyAdd(cz, XMLoadFloat4(&mPlaneZ[g]), XMLoadFloat4(&mPlaneW[g]))));
+			if (!XMVector4GreaterOrEqual(XMVectorAdd(dist, radius), XMVectorZero()))
+				return false;
+		}
+		return true;
+	}
+
+private:
+	// Left, right, bottom, top, near, far, then two planes everything is inside
+	DirectX::XMFLOAT4 mPlaneX[2];
+	DirectX::XMFLOAT4 mPlaneY[2];
+	DirectX::XMFLOAT4 mPlaneZ[2];
+	DirectX::XMFLOAT4 mPlaneW[2];
+	DirectX::XMFLOAT4 mAbsPlaneX[2];
+	DirectX::XMFLOAT4 mAbsPlaneY[2];
+	DirectX::XMFLOAT4 mAbsPlaneZ[2];
+};
@@ -1,5 +1,38 @@
 #ifndef HEADER_H
 #define HEADER_H
+
+// Object data, shared by every vertex shader.
+// The shadow shaders have their own pass constants, they define
+// OBJECT_DATA_ONLY before including this file to get only this part.
+// 3x4 affine model matrix, the last column (0, 0, 0, 1) is dropped
+struct ObjectData
+{
+    float4x3 modelMat;
+};
+
+// Object data by slot, and the object slot of every instance
+StructuredBuffer<ObjectData> gObjects : register(t0, space4);
+StructuredBuffer<uint> gInstanceObjects : register(t1, space4);
+
+// Transform a normal by the inverse-transpose of the upper 3x3 of modelMat.
+// The cofactor matrix is the inverse-transpose scaled by the determinant,
+// its sign keeps normals of mirrored objects facing out. Normalize afterwards.
+float3 TransformNormal(float3 normalL, float4x3 modelMat)
+{
+    float3x3 cofactor = float3x3(
+        cross(modelMat[1], modelMat[2]),
+        cross(modelMat[2], modelMat[0]),
+        cross(modelMat[0], modelMat[1]));
+    float det = dot(modelMat[0], cofactor[0]);
+    return mul(normalL, cofactor) * (det < 0.0 ? -1.0 : 1.0);
+}
+
+cbuffer cbPerDraw : register(b0)
+{
+    uint gInstanceBase;
+};
+
+#ifndef OBJECT_DATA_ONLY
 #include "Predefine.hlsli"
 
 struct DirLight
@@ -82,12 +115,6 @@ struct RenderParams
 
 #define NUM_CONTROL_POINTS 3
 
-cbuffer cbPerObject: register(b0)
-{
-    float4x4 gModelMat;
-    float4x4 gNormalModelMat;
-};
-
 cbuffer cbPerMaterial : register(b1)
 {
     float4 gBaseColor;
@@ -147,4 +174,5 @@ RWTexture2D<uint> uabNCount : register(u0);
 SamplerState bilinearWrap : register(s0);
 SamplerState nearestBorder : register(s1);
 
+#endif//OBJECT_DATA_ONLY
 #endif//HEADER_H
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include "HeapPacker.h"
+
+#include <algorithm>
+
+void HeapPacker::Clear()
+{
+	mResources.clear();
+	mHeapSize = 0;
+}
+
+UINT HeapPacker::AddResource(UINT64 size, UINT64 alignment, UINT firstPass, UINT lastPass)
+{
+	if (alignment == 0)
+		throw "Invalid alignment.";
+	Resource res;
+	res.Size = size;
+	res.Alignment = alignment;
+	res.FirstPass = firstPass;
+	res.LastPass = lastPass;
+	res.Offset = 0;
+	mResources.push_back(res);
+	return static_cast<UINT>(mResources.size() - 1);
+}
+
+bool HeapPacker::Overlap(const Resource& a, const Resource& b)const
+{
+	if (a.LastPass < a.FirstPass || b.LastPass < b.FirstPass)
+		return false;
+	return a.FirstPass <= b.LastPass && b.FirstPass <= a.LastPass;
+}
+
+UINT64 HeapPacker::Pack()
+{
+	// Largest first, ties in the order added so packing is deterministic
+	UINT num = static_cast<UINT>(mResources.size());
+	mOrder.resize(num);
+	for (UINT i = 0; i < num; i++)
+		mOrder[i] = i;
+	std::stable_sort(mOrder.begin(), mOrder.end(), [this](UINT a, UINT b) {
+		return mResources[a].Size > mResources[b].Size;
+	});
+
+	mHeapSize = 0;
+	mPlaced.assign(num, false);
+	for (UINT i : mOrder) {
+		Resource& res = mResources[i];
+
+		// Memory of placed resources alive at the same time, by offset
+		mTaken.clear();
+		for (UINT j = 0; j < num; j++)
+			if (mPlaced[j] && Overlap(res, mResources[j]))
+				mTaken.push_back({ mResources[j].Offset, mResources[j].Offset + mResources[j].Size });
+		std::sort(mTaken.begin(), mTaken.end(), [](const Range& a, const Range& b) {
+			return a.Begin < b.Begin;
+		});
+
+		// First gap it fits in
+		UINT64 offset = 0;
+		for (const Range& range : mTaken) {
+			if (AlignUp(offset, res.Alignment) + res.Size <= range.Begin)
+				break;
+			offset = std::max(offset, range.End);
+		}
+		res.Offset = AlignUp(offset, res.Alignment);
+		mPlaced[i] = true;
+		mHeapSize = std::max(mHeapSize, res.Offset + res.Size);
+	}
+	return mHeapSize;
+}
+
+UINT64 HeapPacker::GetUnaliasedSize()const
+{
+	UINT64 size = 0;
+	for (const Resource& res : mResources)
+		size = AlignUp(size, res.Alignment) + res.Size;
+	return size;
+}
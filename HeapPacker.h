@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+#include "PlatformTypes.h"
+
+// Place resources in one heap so that resources alive at the same time never
+// share memory, while resources with disjoint lifetimes may.
+// Lifetimes are inclusive ranges of pass indices, a resource with
+// lastPass < firstPass is never used and may share memory with any other.
+// Resources are placed largest first, each at the lowest aligned offset not
+// taken by a placed resource whose lifetime overlaps its own.
+class HeapPacker
+{
+public:
+	void Clear();
+	UINT AddResource(UINT64 size, UINT64 alignment, UINT firstPass, UINT lastPass);
+
+	// Assign offsets, return the heap size
+	UINT64 Pack();
+
+	UINT64 GetOffset(UINT resource)const { return mResources[resource].Offset; }
+	UINT64 GetHeapSize()const { return mHeapSize; }
+	// Heap size if every resource had memory of its own
+	UINT64 GetUnaliasedSize()const;
+
+private:
+	struct Resource {
+		UINT64 Size;
+		UINT64 Alignment;
+		UINT FirstPass;
+		UINT LastPass;
+		UINT64 Offset;
+	};
+	struct Range {
+		UINT64 Begin;
+		UINT64 End;
+	};
+
+	static UINT64 AlignUp(UINT64 value, UINT64 alignment) {
+		return (value + alignment - 1) / alignment * alignment;
+	}
+	bool Overlap(const Resource& a, const Resource& b)const;
+
+	std::vector<Resource> mResources;
+	UINT64 mHeapSize = 0;
+
+	// Scratch, kept to avoid allocating every pack
+	std::vector<UINT> mOrder;
+	std::vector<bool> mPlaced;
+	std::vector<Range> mTaken;
+};
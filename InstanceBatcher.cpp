@@ -0,0 +1,55 @@
+#include "InstanceBatcher.h"
+
+namespace {
+	const UINT EMPTY_BATCH = -1;
+	const UINT MIN_TABLE_SIZE = 16;
+}
+
+void InstanceBatcher::BeginBatch(UINT itemNum, std::vector<InstanceBatch>& batches)
+{
+	batches.clear();
+	// Every item can start a batch
+	UINT tableSize = MIN_TABLE_SIZE;
+	while (tableSize < itemNum * 2)
+		tableSize *= 2;
+	mBatchTable.assign(tableSize, EMPTY_BATCH);
+	mItemBatches.resize(itemNum);
+	mItemSlots.resize(itemNum);
+}
+
+void InstanceBatcher::AddItem(UINT i, const Key& key, UINT objectSlot, std::vector<InstanceBatch>& batches)
+{
+	UINT mask = static_cast<UINT>(mBatchTable.size()) - 1;
+	UINT pos = key.Hash() & mask;
+	while (mBatchTable[pos] != EMPTY_BATCH && !(key == batches[mBatchTable[pos]]))
+		pos = (pos + 1) & mask;
+	if (mBatchTable[pos] == EMPTY_BATCH) {
+		mBatchTable[pos] = static_cast<UINT>(batches.size());
+		InstanceBatch batch;
+		batch.MeshID = key.MeshID;
+		batch.SubMeshID = key.SubMeshID;
+		batch.Lod = key.Lod;
+		batch.MaterialID = key.MaterialID;
+		batch.InstanceBase = 0;
+		batch.InstanceNum = 0;
+		batches.push_back(batch);
+	}
+	mItemBatches[i] = mBatchTable[pos];
+	mItemSlots[i] = objectSlot;
+	batches[mItemBatches[i]].InstanceNum++;
+}
+
+void InstanceBatcher::EndBatch(std::vector<InstanceBatch>& batches)
+{
+	// Give every batch its range, then fill the ranges in queue order
+	UINT base = static_cast<UINT>(mInstances.size());
+	mBatchCursors.resize(batches.size());
+	for (UINT b = 0; b < batches.size(); b++) {
+		batches[b].InstanceBase = base;
+		mBatchCursors[b] = base;
+		base += batches[b].InstanceNum;
+	}
+	mInstances.resize(base);
+	for (UINT i = 0; i < mItemBatches.size(); i++)
+		mInstances[mBatchCursors[mItemBatches[i]]++] = mItemSlots[i];
+}
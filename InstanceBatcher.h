@@ -0,0 +1,89 @@
+#pragma once
+#include <memory>
+#include <vector>
+
+#include "PlatformTypes.h"
+#include "SlotMap.h"
+
+// One instanced draw, every instance draws the same submesh with the same material
+struct InstanceBatch {
+	UINT MeshID;
+	UINT SubMeshID;
+	UINT Lod; // the batch is drawn at
+	UINT MaterialID;
+	UINT InstanceBase; // first instance in the instance buffer
+	UINT InstanceNum;
+};
+
+// Groups render items sharing mesh, submesh, LOD and material into instanced draws.
+// The instances of a batch are consecutive object slot indices, the vertex shader
+// finds its object data through the one at InstanceBase + SV_InstanceID.
+// Instances of every queue batched in a frame are packed into one array,
+// which is copied to the GPU once all queues are batched.
+class InstanceBatcher
+{
+public:
+	// Drop the instances of the last frame
+	void Clear() { mInstances.clear(); }
+	// Replace batches with the batches of queue, in the order their first item appears.
+	// Items have MeshID, SubMeshID, Lod, MaterialID and ObjectID, like RenderItem.
+	// lodBias is added to the LOD of every item, which is then clamped to
+	// getLodNum(UINT meshID) - 1. getLodNum returns 0 for unknown meshes.
+	template<typename Item, typename GetLodNum>
+	void Batch(
+		const std::vector<std::shared_ptr<Item>>& queue, UINT lodBias, GetLodNum&& getLodNum,
+		std::vector<InstanceBatch>& batches)
+	{
+		BeginBatch(static_cast<UINT>(queue.size()), batches);
+		for (UINT i = 0; i < queue.size(); i++) {
+			const Item& item = *queue[i];
+			UINT lodNum = getLodNum(item.MeshID);
+			if (lodNum == 0)
+				throw "Invalid mesh id";
+			// Saturate instead of wrapping around
+			UINT lod = item.Lod + lodBias;
+			if (lod < item.Lod || lod >= lodNum)
+				lod = lodNum - 1;
+			AddItem(i, { item.MeshID, item.SubMeshID, lod, item.MaterialID }, SlotIndex(item.ObjectID), batches);
+		}
+		EndBatch(batches);
+	}
+
+	const std::vector<UINT>& GetInstances()const { return mInstances; }
+
+private:
+	struct Key {
+		UINT MeshID;
+		UINT SubMeshID;
+		UINT Lod;
+		UINT MaterialID;
+		bool operator==(const InstanceBatch& batch)const {
+			return MeshID == batch.MeshID && SubMeshID == batch.SubMeshID
+				&& Lod == batch.Lod && MaterialID == batch.MaterialID;
+		}
+		UINT Hash()const {
+			UINT hash = MeshID;
+			hash = hash * 31 + SubMeshID;
+			hash = hash * 31 + Lod;
+			hash = hash * 31 + MaterialID;
+			// Mix high bits down, the table is indexed by the low ones
+			return hash ^ (hash >> 15);
+		}
+	};
+
+	void BeginBatch(UINT itemNum, std::vector<InstanceBatch>& batches);
+	// Find or start the batch of item i and count it
+	void AddItem(UINT i, const Key& key, UINT objectSlot, std::vector<InstanceBatch>& batches);
+	// Give every batch its instance range and fill it in queue order
+	void EndBatch(std::vector<InstanceBatch>& batches);
+
+	std::vector<UINT> mInstances;
+
+	// Scratch, kept to avoid allocating every frame.
+	// Open-addressed table of batch indices, keys are compared against the batch,
+	// at most half full.
+	std::vector<UINT> mBatchTable;
+	std::vector<UINT> mItemBatches;
+	std::vector<UINT> mItemSlots;
+	std::vector<UINT> mBatchCursors;
+};
@@ -0,0 +1,121 @@
+#include "JobSystem.h"
+#include <algorithm>
+
+JobSystem::JobSystem(UINT workerNum)
+	: mPendingNum(0)
+{
+	if (workerNum == 0)
+		workerNum = std::max(std::thread::hardware_concurrency(), 1u);
+
+	for (UINT i = 0; i < workerNum; i++)
+		mQueues.push_back(std::make_unique<JobQueue>());
+	for (UINT i = 1; i < workerNum; i++)
+		mThreads.emplace_back(&JobSystem::WorkerLoop, this, i);
+}
+
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(mWakeMutex);
+		mQuit = true;
+	}
+	mWakeCond.notify_all();
+	for (auto& thread : mThreads)
+		thread.join();
+}
+
+void JobSystem::ParallelFor(UINT count, UINT grainSize, const std::function<void(UINT, UINT)>& func)
+{
+	if (count == 0)
+		return;
+	grainSize = std::max(grainSize, 1u);
+	UINT jobNum = (count + grainSize - 1) / grainSize;
+
+	// Not worth waking anyone
+	if (jobNum == 1 || mThreads.empty()) {
+		func(0, count);
+		return;
+	}
+
+	// Count before pushing so that mPendingNum never underflows
+	{
+		std::lock_guard<std::mutex> lock(mWakeMutex);
+		mPendingNum += jobNum;
+	}
+
+	// Deal chunks out to all queues
+	std::atomic<UINT> remainNum(jobNum);
+	UINT queueNum = static_cast<UINT>(mQueues.size());
+	for (UINT i = 0; i < jobNum; i++) {
+		Job job;
+		job.Func = &func;
+		job.Begin = i * grainSize;
+		job.End = std::min(job.Begin + grainSize, count);
+		job.RemainNum = &remainNum;
+
+		auto& queue = *mQueues[i % queueNum];
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		queue.Jobs.push_back(job);
+	}
+	mWakeCond.notify_all();
+
+	// Help until our own chunks are done.
+	// The jobs found here may belong to other loops, which is fine.
+	Job job;
+	while (remainNum.load(std::memory_order_acquire) > 0) {
+		if (FindJob(0, job))
+			ExecuteJob(job);
+		else
+			std::this_thread::yield();
+	}
+}
+
+bool JobSystem::PopJob(UINT queueIndex, Job& job)
+{
+	auto& queue = *mQueues[queueIndex];
+	std::lock_guard<std::mutex> lock(queue.Mutex);
+	if (queue.Jobs.empty())
+		return false;
+	job = queue.Jobs.back();
+	queue.Jobs.pop_back();
+	mPendingNum--;
+	return true;
+}
+
+bool JobSystem::StealJob(UINT queueIndex, Job& job)
+{
+	UINT queueNum = static_cast<UINT>(mQueues.size());
+	for (UINT i = 1; i < queueNum; i++) {
+		auto& queue = *mQueues[(queueIndex + i) % queueNum];
+		std::lock_guard<std::mutex> lock(queue.Mutex);
+		if (queue.Jobs.empty())
+			continue;
+		job = queue.Jobs.front();
+		queue.Jobs.pop_front();
+		mPendingNum--;
+		return true;
+	}
+	return false;
+}
+
+void JobSystem::ExecuteJob(const Job& job)
+{
+	(*job.Func)(job.Begin, job.End);
+	job.RemainNum->fetch_sub(1, std::memory_order_release);
+}
+
+void JobSystem::WorkerLoop(UINT queueIndex)
+{
+	Job job;
+	while (true) {
+		if (FindJob(queueIndex, job)) {
+			ExecuteJob(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(mWakeMutex);
+		mWakeCond.wait(lock, [this]() { return mQuit || mPendingNum.load() > 0; });
+		if (mQuit)
+			return;
+	}
+}
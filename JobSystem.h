@@ -0,0 +1,64 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "PlatformTypes.h"
+
+// Work-stealing thread pool.
+// Every worker owns a job queue. Workers pop from the back of their own queue
+// and steal from the front of others when it runs dry.
+// The thread that calls ParallelFor also executes jobs until its loop is done.
+class JobSystem
+{
+public:
+	// Use all hardware threads when workerNum is 0.
+	// The calling thread counts as one of them.
+	JobSystem(UINT workerNum = 0);
+	~JobSystem();
+
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	// Worker threads plus the calling thread
+	UINT GetThreadNum()const { return static_cast<UINT>(mThreads.size()) + 1; }
+
+	// Call func(begin, end) on chunks of [0, count) and wait for all of them.
+	// Chunks hold at most grainSize elements and never overlap.
+	void ParallelFor(UINT count, UINT grainSize, const std::function<void(UINT, UINT)>& func);
+
+private:
+	struct Job {
+		const std::function<void(UINT, UINT)>* Func;
+		UINT Begin;
+		UINT End;
+		std::atomic<UINT>* RemainNum;
+	};
+	struct JobQueue {
+		std::mutex Mutex;
+		std::deque<Job> Jobs;
+	};
+
+	bool PopJob(UINT queueIndex, Job& job);
+	bool StealJob(UINT queueIndex, Job& job);
+	bool FindJob(UINT queueIndex, Job& job) {
+		return PopJob(queueIndex, job) || StealJob(queueIndex, job);
+	}
+	void ExecuteJob(const Job& job);
+	void WorkerLoop(UINT queueIndex);
+
+	// Queue 0 is fed by threads outside the pool,
+	// queue i + 1 belongs to mThreads[i]
+	std::vector<std::unique_ptr<JobQueue>> mQueues;
+	std::vector<std::thread> mThreads;
+
+	std::atomic<UINT> mPendingNum;
+	std::mutex mWakeMutex;
+	std::condition_variable mWakeCond;
+	bool mQuit = false;
+};
@@ -1,8 +1,10 @@
 #pragma once
 #include "Common/d3dUtil.h"
 #include "RenderTarget.h"
+#include "InstanceBatcher.h"
 
 class ShadowPassConstants;
+class RenderItem;
 
 class Light {
 public:
@@ -134,6 +136,8 @@ public:
 	std::unique_ptr<SingleRenderTarget> ShadowRT = nullptr;
 	UINT ShadowSRVID = -1;
 	std::unique_ptr<ShadowPassConstants> PassConstants = nullptr;
+	std::vector<std::shared_ptr<RenderItem>> ShadowCasters; // culled every frame
+	std::vector<InstanceBatch> ShadowBatches; // of ShadowCasters
 };
 
 class PointLight : public Light {
@@ -200,6 +204,10 @@ public:
 			DistMin, DistMax
 		);
 	}
+	// Attenuation is below 1% beyond DistMax
+	DirectX::BoundingSphere CalBoundingSphere()const {
+		return DirectX::BoundingSphere(Position, DistMax);
+	}
 	
 	DirectX::XMFLOAT3 Position = { 0.0f, 0.0f, 0.0f };
 	FLOAT DistMin;
@@ -208,6 +216,9 @@ public:
 	std::unique_ptr<CubeRenderTarget> ShadowRT = nullptr;
 	UINT ShadowSRVID = -1;
 	std::array<std::unique_ptr<ShadowPassConstants>, 6> PassConstantsArray;
+	std::array<std::vector<std::shared_ptr<RenderItem>>, 6> ShadowCastersArray; // culled every frame
+	std::array<std::vector<InstanceBatch>, 6> ShadowBatchesArray; // of ShadowCastersArray
+	bool Visible = true; // lit volume touches the camera frustum
 };
 
 class SpotLight : public Light {
@@ -283,6 +294,25 @@ public:
 			DistMin, DistMax
 		);
 	}
+	// Smallest sphere around the cone of half angle Umbra, cut off at DistMax
+	DirectX::BoundingSphere CalBoundingSphere()const {
+		float angle = MathHelper::AngleToRadius(Umbra);
+		DirectX::XMVECTOR dir = DirectX::XMVector3Normalize(DirectX::XMLoadFloat3(&Direction));
+		float offset, radius;
+		if (angle > DirectX::XM_PIDIV4) {
+			offset = DistMax * cos(angle);
+			radius = DistMax * sin(angle);
+		}
+		else {
+			offset = radius = DistMax / (2.0f * cos(angle));
+		}
+		DirectX::BoundingSphere sphere;
+		DirectX::XMStoreFloat3(&sphere.Center, DirectX::XMVectorAdd(
+			DirectX::XMLoadFloat3(&Position), DirectX::XMVectorScale(dir, offset)
+		));
+		sphere.Radius = radius;
+		return sphere;
+	}
 
 	DirectX::XMFLOAT3 Position = { 0.0f, 0.0f, 0.0f };
 	DirectX::XMFLOAT3 Direction = { 0.0f, 0.0f, 1.0f };
@@ -294,6 +324,9 @@ public:
 	std::unique_ptr<SingleRenderTarget> ShadowRT = nullptr;
 	UINT ShadowSRVID = -1;
 	std::unique_ptr<ShadowPassConstants> PassConstants = nullptr;
+	std::vector<std::shared_ptr<RenderItem>> ShadowCasters; // culled every frame
+	std::vector<InstanceBatch> ShadowBatches; // of ShadowCasters
+	bool Visible = true; // lit volume touches the camera frustum
 };
 
 
@@ -1,5 +1,4 @@
 #include "Material.h"
 
-UINT Material::sIDCount = 0;
-std::vector<Material*> Material::sIDMap;
+SlotMap<Material*> Material::sRegistry;
 UINT Material::sDefaultMtlID = 0;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Common/d3dUtil.h"
+#include "SlotMap.h"
 #include "Predefine.h"
 
 class Material
@@ -9,22 +10,24 @@ public:
 	Material(const std::string& name)
 		: mName(name)
 	{
-		mID = sIDCount;
-		sIDCount++;
-		sIDMap.push_back(this);
+		mID = sRegistry.Insert(this);
 	}
 	~Material() {
-		sIDMap[mID] = nullptr;
+		sRegistry.Erase(mID);
 	}
 	
 	UINT GetID()const { return mID; }
-	static UINT GetTotalNum() { return sIDCount; }
+	// Index of constant buffer element
+	UINT GetSlotIndex()const { return SlotIndex(mID); }
+	// Upper bound of slot indices
+	static UINT GetTotalNum() { return sRegistry.Capacity(); }
 	static Material* FindObjectByID(UINT id) {
-		if (id >= sIDMap.size())
-			return nullptr;
-		return sIDMap[id];
+		auto item = sRegistry.Find(id);
+		return item ? *item : nullptr;
 	}
 
+	static const SlotMap<Material*>& GetRegistry() { return sRegistry; }
+
 	static UINT GetDefaultMaterialID() { return sDefaultMtlID; }
 	static void SetDefaultMaterialID(UINT id) { sDefaultMtlID = id; }
 
@@ -74,8 +77,7 @@ public:
 
 private:
 	UINT mID;
-	static UINT sIDCount;
-	static std::vector<Material*> sIDMap;
+	static SlotMap<Material*> sRegistry;
 	static UINT sDefaultMtlID;
 
 	std::string mName;
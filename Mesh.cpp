@@ -1,10 +1,33 @@
 #include "Mesh.h"
+#include "MeshSimplifier.h"
 
-UINT Mesh::sIDCount = 0;
-std::vector<Mesh*> Mesh::sIDMap;
+SlotMap<Mesh*> Mesh::sRegistry;
 
+// Levels that keep more of the level before are not worth drawing
+const float LOD_MAX_INDEX_RATIO = 0.75f;
+// Levels moving vertices further than this part of the submesh radius lost the shape
+const float LOD_MAX_ERROR_RATIO = 0.1f;
+
+using namespace DirectX;
 using Microsoft::WRL::ComPtr;
 
+void Mesh::SetBufferView(
+	const void* verts, UINT vertByteSize, UINT vertByteStride,
+	const void* indices, UINT indexByteSize, DXGI_FORMAT indexFormat,
+	std::shared_ptr<const void> keepAlive)
+{
+	mVertexByteStride = vertByteStride;
+	mVertexBufferByteSize = vertByteSize;
+	mIndexFormat = indexFormat;
+	mIndexBufferByteSize = indexByteSize;
+
+	mVertexBufferCPU = nullptr;
+	mIndexBufferCPU = nullptr;
+	mVertexData = verts;
+	mIndexData = indices;
+	mDataKeepAlive = keepAlive;
+}
+
 void Mesh::UploadBuffer(ComPtr<ID3D12Device> device, ComPtr<ID3D12GraphicsCommandList> commandList)
 {
 	if (mVertexBufferGPU) // uploaded
@@ -12,18 +35,141 @@ void Mesh::UploadBuffer(ComPtr<ID3D12Device> device, ComPtr<ID3D12GraphicsComman
 
 	mVertexBufferGPU = d3dUtil::CreateDefaultBuffer(
 		device.Get(), commandList.Get(),
-		mVertexBufferCPU->GetBufferPointer(),
+		mVertexData,
 		mVertexBufferByteSize,
 		mVertexBufferUpload
 	);
 	mIndexBufferGPU = d3dUtil::CreateDefaultBuffer(
 		device.Get(), commandList.Get(),
-		mIndexBufferCPU->GetBufferPointer(),
+		mIndexData,
 		mIndexBufferByteSize,
 		mIndexBufferUpload
 	);
 }
 
+void Mesh::CalBounds()
+{
+	const BYTE* verts = static_cast<const BYTE*>(mVertexData);
+	auto GetPos = [this, verts](const SubMesh& submesh, UINT i) {
+		UINT index = mIndexFormat == DXGI_FORMAT_R16_UINT
+			? static_cast<const UINT16*>(mIndexData)[submesh.startIndexLoc + i]
+			: static_cast<const UINT32*>(mIndexData)[submesh.startIndexLoc + i];
+		index += submesh.baseVertexLoc;
+		return XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(verts + index * mVertexByteStride));
+	};
+
+	for (auto& submesh : mSubMeshs) {
+		if (submesh.indexCount == 0) {
+			submesh.bounds = BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(0.0f, 0.0f, 0.0f));
+			submesh.boundingSphere = BoundingSphere(XMFLOAT3(0.0f, 0.0f, 0.0f), 0.0f);
+			continue;
+		}
+
+		XMVECTOR vMin = XMVectorReplicate(+FLT_MAX);
+		XMVECTOR vMax = XMVectorReplicate(-FLT_MAX);
+		for (UINT i = 0; i < submesh.indexCount; i++) {
+			XMVECTOR pos = GetPos(submesh, i);
+			vMin = XMVectorMin(vMin, pos);
+			vMax = XMVectorMax(vMax, pos);
+		}
+		XMVECTOR center = XMVectorScale(XMVectorAdd(vMin, vMax), 0.5f);
+		XMStoreFloat3(&submesh.bounds.Center, center);
+		XMStoreFloat3(&submesh.bounds.Extents, XMVectorScale(XMVectorSubtract(vMax, vMin), 0.5f));
+
+		// Sphere around the box center, tighter than the box's circumsphere
+		XMVECTOR maxLengthSq = XMVectorZero();
+		for (UINT i = 0; i < submesh.indexCount; i++) {
+			XMVECTOR offset = XMVectorSubtract(GetPos(submesh, i), center);
+			maxLengthSq = XMVectorMax(maxLengthSq, XMVector3LengthSq(offset));
+		}
+		submesh.boundingSphere.Center = submesh.bounds.Center;
+		submesh.boundingSphere.Radius = XMVectorGetX(XMVectorSqrt(maxLengthSq));
+	}
+}
+
+void Mesh::BuildLods(UINT lodNum)
+{
+	if (mVertexBufferGPU)
+		throw "LODs must be built before uploading";
+	mLods.clear();
+	if (!mVertexData || !mIndexData || !mVertexByteStride)
+		return;
+
+	// Indices of all levels, the full resolution ones first
+	bool index16 = mIndexFormat == DXGI_FORMAT_R16_UINT;
+	UINT indexSize = index16 ? sizeof(UINT16) : sizeof(UINT32);
+	UINT fullIndexNum = 0;
+	for (auto& submesh : mSubMeshs)
+		fullIndexNum = MathHelper::Max(fullIndexNum, submesh.startIndexLoc + submesh.indexCount);
+	std::vector<UINT> indices(MathHelper::Min(fullIndexNum, mIndexBufferByteSize / indexSize));
+	for (UINT i = 0; i < indices.size(); i++)
+		indices[i] = index16
+			? static_cast<const UINT16*>(mIndexData)[i]
+			: static_cast<const UINT32*>(mIndexData)[i];
+	UINT vertNum = mVertexBufferByteSize / mVertexByteStride;
+	const BYTE* verts = static_cast<const BYTE*>(mVertexData);
+
+	UINT prevIndexNum = 0;
+	for (auto& submesh : mSubMeshs)
+		prevIndexNum += submesh.indexCount;
+
+	for (UINT level = 1; level < lodNum; level++) {
+		MeshLod lod;
+		bool broken = false;
+		UINT levelBegin = static_cast<UINT>(indices.size());
+		UINT indexNum = 0;
+		for (auto& submesh : mSubMeshs) {
+			SubMesh lodSubMesh = submesh;
+			if (submesh.primitiveTopology == D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST && submesh.indexCount) {
+				// Always simplify from the full resolution, errors don't add up
+				std::vector<UINT> submeshIndices(
+					indices.begin() + submesh.startIndexLoc,
+					indices.begin() + submesh.startIndexLoc + submesh.indexCount
+				);
+				UINT submeshVertNum = *std::max_element(submeshIndices.begin(), submeshIndices.end()) + 1;
+				if (submesh.baseVertexLoc + submeshVertNum > vertNum)
+					throw "Index out of vertex buffer";
+				float error;
+				std::vector<UINT> lodIndices = MeshSimplifier::Simplify(
+					verts + static_cast<size_t>(submesh.baseVertexLoc) * mVertexByteStride,
+					submeshVertNum, mVertexByteStride,
+					submeshIndices, submesh.indexCount >> level, &error
+				);
+				lodSubMesh.startIndexLoc = static_cast<UINT>(indices.size());
+				lodSubMesh.indexCount = static_cast<UINT>(lodIndices.size());
+				indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+				lod.Error = MathHelper::Max(lod.Error, error);
+				if (error > submesh.boundingSphere.Radius * LOD_MAX_ERROR_RATIO)
+					broken = true;
+			}
+			indexNum += lodSubMesh.indexCount;
+			lod.SubMeshs.push_back(lodSubMesh);
+		}
+
+		if (broken || indexNum > prevIndexNum * LOD_MAX_INDEX_RATIO) {
+			indices.resize(levelBegin);
+			break;
+		}
+		mLods.push_back(lod);
+		prevIndexNum = indexNum;
+	}
+	if (mLods.empty())
+		return;
+
+	// Own a new index buffer holding every level
+	mIndexBufferByteSize = static_cast<UINT>(indices.size()) * indexSize;
+	ThrowIfFailed(D3DCreateBlob(mIndexBufferByteSize,
+		mIndexBufferCPU.ReleaseAndGetAddressOf()));
+	BYTE* dst = static_cast<BYTE*>(mIndexBufferCPU->GetBufferPointer());
+	for (UINT i = 0; i < indices.size(); i++) {
+		if (index16)
+			reinterpret_cast<UINT16*>(dst)[i] = static_cast<UINT16>(indices[i]);
+		else
+			reinterpret_cast<UINT32*>(dst)[i] = indices[i];
+	}
+	mIndexData = dst;
+}
+
 void Mesh::DisposeUploaders()
 {
 	mVertexBufferUpload = nullptr;
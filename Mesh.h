@@ -1,5 +1,6 @@
 #pragma once
 #include "Common/d3dUtil.h"
+#include "SlotMap.h"
 #include "Predefine.h"
 
 class SubMesh
@@ -10,6 +11,20 @@ public:
 	UINT baseVertexLoc = 0;
 	D3D_PRIMITIVE_TOPOLOGY primitiveTopology = D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST;
 	UINT materialID = -1;
+
+	// In mesh space
+	DirectX::BoundingBox bounds;
+	DirectX::BoundingSphere boundingSphere;
+};
+
+// Levels of detail a mesh may have, including the full resolution
+const UINT MAX_LOD_NUM = 4;
+
+// Simplified version of every submesh of a mesh.
+// LODs share the vertex buffer, their indices follow the full resolution ones.
+struct MeshLod {
+	std::vector<SubMesh> SubMeshs;
+	float Error = 0.0f; // largest distance a vertex was moved from the surface, in mesh space
 };
 
 class Mesh
@@ -18,24 +33,22 @@ public:
 	Mesh(const std::string& name)
 		: mName(name)
 	{
-		mID = sIDCount;
-		sIDCount++;
-		sIDMap.push_back(this);
+		mID = sRegistry.Insert(this);
 	}
 	~Mesh() {
-		sIDMap[mID] = nullptr;
+		sRegistry.Erase(mID);
 	}
 
 	std::string GetName()const { return mName; }
 	UINT GetID()const { return mID; }
-	static UINT GetTotalNum() { return sIDCount; }
+	// Upper bound of slot indices
+	static UINT GetTotalNum() { return sRegistry.Capacity(); }
 	static Mesh* FindObjectByID(UINT id) {
-		if (id >= sIDMap.size())
-			return nullptr;
-		return sIDMap[id];
+		auto item = sRegistry.Find(id);
+		return item ? *item : nullptr;
 	}
 	static Mesh* FindMeshByName(std::string name) {
-		for (Mesh* mesh : sIDMap) {
+		for (Mesh* mesh : sRegistry) {
 			if (mesh->GetName() == name)
 				return mesh;
 		}
@@ -44,12 +57,43 @@ public:
 	
 	template<class T, class U>
 	void SetBuffer(std::vector<T> verts, std::vector<U> indices, DXGI_FORMAT indexFormat);
+	// Reference vertex and index data owned by someone else, e.g. a mapped snapshot.
+	// keepAlive holds the owner as long as the mesh, the CPU data stays readable
+	// after upload, e.g. for the occlusion rasterizer and snapshot saving.
+	void SetBufferView(
+		const void* verts, UINT vertByteSize, UINT vertByteStride,
+		const void* indices, UINT indexByteSize, DXGI_FORMAT indexFormat,
+		std::shared_ptr<const void> keepAlive);
 	void UploadBuffer(Microsoft::WRL::ComPtr<ID3D12Device> device, Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> commandList);
 	void DisposeUploaders(); // TODO actually, we have never called this function.
 
 	D3D12_VERTEX_BUFFER_VIEW GetVertexBufferView()const;
 	D3D12_INDEX_BUFFER_VIEW GetIndexBufferView()const;
 
+	const void* GetVertexData()const { return mVertexData; }
+	const void* GetIndexData()const { return mIndexData; }
+	UINT GetVertexByteStride()const { return mVertexByteStride; }
+	UINT GetVertexBufferByteSize()const { return mVertexBufferByteSize; }
+	DXGI_FORMAT GetIndexFormat()const { return mIndexFormat; }
+	UINT GetIndexBufferByteSize()const { return mIndexBufferByteSize; }
+
+	// Fit the bounds of every submesh to the vertices it references.
+	// Positions must be the first member of the vertex, as XMFLOAT3.
+	void CalBounds();
+
+	// Append up to lodNum - 1 simplified levels to the index buffer, each with
+	// about half the triangles of the one before. Stops early once simplification stalls
+	// or starts to lose the shape.
+	// Must be called after CalBounds and before UploadBuffer.
+	void BuildLods(UINT lodNum = MAX_LOD_NUM);
+	// Restore a level whose indices are already in the index buffer
+	void AddLod(const MeshLod& lod) {
+		mLods.push_back(lod);
+	}
+	// Level 0 is the full resolution
+	UINT GetLodNum()const { return static_cast<UINT>(mLods.size()) + 1; }
+	float GetLodError(UINT lod)const { return lod == 0 ? 0.0f : mLods[lod - 1].Error; }
+
 	void AddSubMesh(const SubMesh& submesh) {
 		mSubMeshs.push_back(submesh);
 	}
@@ -58,13 +102,21 @@ public:
 			throw "Out of bound";
 		return mSubMeshs[i];
 	}
+	// Levels beyond the coarsest one give the coarsest
+	SubMesh GetSubMesh(UINT i, UINT lod) {
+		if (lod == 0 || mLods.empty())
+			return GetSubMesh(i);
+		const auto& submeshs = mLods[MathHelper::Min(lod, static_cast<UINT>(mLods.size())) - 1].SubMeshs;
+		if (i >= static_cast<UINT>(submeshs.size()))
+			throw "Out of bound";
+		return submeshs[i];
+	}
 	UINT GetSubMeshNum() { return static_cast<UINT>(mSubMeshs.size()); }
 
 private:
 	// Note: We left UINT32_MAX as an invalid ID.
 	UINT mID;
-	static UINT sIDCount;
-	static std::vector<Mesh*> sIDMap;
+	static SlotMap<Mesh*> sRegistry;
 
 	std::string mName;
 
@@ -77,12 +129,18 @@ private:
 	Microsoft::WRL::ComPtr<ID3DBlob> mVertexBufferCPU = nullptr;
 	Microsoft::WRL::ComPtr<ID3DBlob> mIndexBufferCPU = nullptr;
 
+	// Point to the CPU blobs or to external memory
+	const void* mVertexData = nullptr;
+	const void* mIndexData = nullptr;
+	std::shared_ptr<const void> mDataKeepAlive = nullptr;
+
 	UINT mVertexByteStride = 0;
 	UINT mVertexBufferByteSize = 0;
 	DXGI_FORMAT mIndexFormat = DXGI_FORMAT_R16_UINT;
 	UINT mIndexBufferByteSize = 0;
 
 	std::vector<SubMesh> mSubMeshs;
+	std::vector<MeshLod> mLods; // from level 1
 };
 
 
@@ -109,4 +167,8 @@ void Mesh::SetBuffer(
 	CopyMemory(mIndexBufferCPU->GetBufferPointer(), 
 		indices.data(), 
 		mIndexBufferByteSize);
+
+	mVertexData = mVertexBufferCPU->GetBufferPointer();
+	mIndexData = mIndexBufferCPU->GetBufferPointer();
+	mDataKeepAlive = nullptr;
 }
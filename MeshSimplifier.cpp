@@ -0,0 +1,283 @@
+#include "MeshSimplifier.h"
+#include <array>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <queue>
+#include <unordered_map>
+#include <DirectXMath.h>
+
+#include "Common/MathHelper.h"
+
+using namespace DirectX;
+
+namespace {
+	// Collapses that bend an adjacent triangle's normal further are rejected
+	const float MIN_NORMAL_COS = 0.2f;
+
+	// Symmetric 4x4 matrix, sum of area-weighted squared plane distances
+	struct Quadric {
+		double A[10] = {};
+		double Weight = 0.0;
+
+		void AddPlane(double a, double b, double c, double d, double weight) {
+			A[0] += weight * a * a; A[1] += weight * a * b; A[2] += weight * a * c; A[3] += weight * a * d;
+			A[4] += weight * b * b; A[5] += weight * b * c; A[6] += weight * b * d;
+			A[7] += weight * c * c; A[8] += weight * c * d;
+			A[9] += weight * d * d;
+			Weight += weight;
+		}
+		void Add(const Quadric& q) {
+			for (int i = 0; i < 10; i++)
+				A[i] += q.A[i];
+			Weight += q.Weight;
+		}
+		double Eval(const XMFLOAT3& p)const {
+			double x = p.x, y = p.y, z = p.z;
+			return A[0] * x * x + 2 * A[1] * x * y + 2 * A[2] * x * z + 2 * A[3] * x
+				+ A[4] * y * y + 2 * A[5] * y * z + 2 * A[6] * y
+				+ A[7] * z * z + 2 * A[8] * z
+				+ A[9];
+		}
+	};
+
+	struct Collapse {
+		float Cost;
+		UINT From;
+		UINT To;
+		UINT FromVersion;
+		UINT ToVersion;
+		bool operator>(const Collapse& other)const { return Cost > other.Cost; }
+	};
+
+	// FNV-1a
+	size_t HashBytes(const BYTE* data, UINT size) {
+		UINT64 hash = 14695981039346656037ull;
+		for (UINT i = 0; i < size; i++) {
+			hash ^= data[i];
+			hash *= 1099511628211ull;
+		}
+		return static_cast<size_t>(hash);
+	}
+
+	// Map every vertex to the first one with the same leading size bytes
+	std::vector<UINT> Weld(const BYTE* verts, UINT vertNum, UINT stride, UINT size) {
+		std::vector<UINT> remap(vertNum);
+		std::unordered_multimap<size_t, UINT> firsts;
+		firsts.reserve(vertNum);
+		for (UINT v = 0; v < vertNum; v++) {
+			const BYTE* data = verts + static_cast<size_t>(v) * stride;
+			size_t hash = HashBytes(data, size);
+			remap[v] = v;
+			auto range = firsts.equal_range(hash);
+			for (auto it = range.first; it != range.second; ++it) {
+				if (memcmp(verts + static_cast<size_t>(it->second) * stride, data, size) == 0) {
+					remap[v] = it->second;
+					break;
+				}
+			}
+			if (remap[v] == v)
+				firsts.emplace(hash, v);
+		}
+		return remap;
+	}
+
+	XMVECTOR XM_CALLCONV CalNormal(const XMFLOAT3& p0, const XMFLOAT3& p1, const XMFLOAT3& p2) {
+		XMVECTOR v0 = XMLoadFloat3(&p0);
+		return XMVector3Cross(
+			XMVectorSubtract(XMLoadFloat3(&p1), v0),
+			XMVectorSubtract(XMLoadFloat3(&p2), v0)
+		);
+	}
+}
+
+std::vector<UINT> MeshSimplifier::Simplify(
+	const BYTE* verts, UINT vertNum, UINT stride,
+	const std::vector<UINT>& indices, UINT targetIndexCount,
+	float* maxError)
+{
+	if (maxError)
+		*maxError = 0.0f;
+
+	auto GetPos = [verts, stride](UINT v) -> const XMFLOAT3& {
+		return *reinterpret_cast<const XMFLOAT3*>(verts + static_cast<size_t>(v) * stride);
+	};
+
+	// Weld identical vertices, then find positions shared by different vertices
+	std::vector<UINT> remap = Weld(verts, vertNum, stride, stride);
+	std::vector<UINT> posRemap = Weld(verts, vertNum, stride, sizeof(XMFLOAT3));
+	std::vector<bool> locked(vertNum, false);
+	{
+		std::vector<UINT> firstAtPos(vertNum, UINT_MAX);
+		for (UINT index : indices) {
+			UINT v = remap[index];
+			UINT& first = firstAtPos[posRemap[v]];
+			if (first == UINT_MAX)
+				first = v;
+			else if (first != v)
+				locked[first] = locked[v] = true;
+		}
+	}
+
+	// Triangles over welded vertices, degenerate ones are dropped
+	std::vector<std::array<UINT, 3>> tris;
+	tris.reserve(indices.size() / 3);
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+		std::array<UINT, 3> tri = { remap[indices[i]], remap[indices[i + 1]], remap[indices[i + 2]] };
+		if (tri[0] == tri[1] || tri[1] == tri[2] || tri[2] == tri[0])
+			continue;
+		tris.push_back(tri);
+	}
+
+	// Vertices of edges used by one triangle lie on a border
+	{
+		std::unordered_map<UINT64, UINT> edgeUses;
+		edgeUses.reserve(tris.size() * 3);
+		for (auto& tri : tris) {
+			for (UINT i = 0; i < 3; i++) {
+				UINT a = tri[i], b = tri[(i + 1) % 3];
+				edgeUses[(static_cast<UINT64>(MathHelper::Min(a, b)) << 32) | MathHelper::Max(a, b)]++;
+			}
+		}
+		for (auto& edge : edgeUses) {
+			if (edge.second == 1) {
+				locked[static_cast<UINT>(edge.first >> 32)] = true;
+				locked[static_cast<UINT>(edge.first & 0xFFFFFFFF)] = true;
+			}
+		}
+	}
+
+	// Plane quadrics and triangle adjacency
+	std::vector<Quadric> quadrics(vertNum);
+	std::vector<std::vector<UINT>> vertTris(vertNum);
+	for (UINT t = 0; t < tris.size(); t++) {
+		const auto& tri = tris[t];
+		XMVECTOR normal = CalNormal(GetPos(tri[0]), GetPos(tri[1]), GetPos(tri[2]));
+		float length = XMVectorGetX(XMVector3Length(normal));
+		if (length > 0.0f) {
+			XMFLOAT3 n;
+			XMStoreFloat3(&n, XMVectorScale(normal, 1.0f / length));
+			const XMFLOAT3& p = GetPos(tri[0]);
+			double d = -(static_cast<double>(n.x) * p.x + static_cast<double>(n.y) * p.y + static_cast<double>(n.z) * p.z);
+			for (UINT v : tri)
+				quadrics[v].AddPlane(n.x, n.y, n.z, d, length * 0.5);
+		}
+		for (UINT v : tri)
+			vertTris[v].push_back(t);
+	}
+
+	std::vector<bool> triAlive(tris.size(), true);
+	std::vector<UINT> versions(vertNum, 0);
+	UINT aliveTriNum = static_cast<UINT>(tris.size());
+	UINT targetTriNum = targetIndexCount / 3;
+
+	std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> heap;
+	auto PushCollapse = [&](UINT from, UINT to) {
+		if (locked[from])
+			return;
+		Quadric q = quadrics[from];
+		q.Add(quadrics[to]);
+		float cost = static_cast<float>(MathHelper::Max(q.Eval(GetPos(to)), 0.0));
+		heap.push({ cost, from, to, versions[from], versions[to] });
+	};
+	auto ForEachNeighbour = [&](UINT v, auto&& func) {
+		for (UINT t : vertTris[v]) {
+			if (!triAlive[t])
+				continue;
+			for (UINT u : tris[t])
+				if (u != v)
+					func(u);
+		}
+	};
+	for (auto& tri : tris) {
+		for (UINT i = 0; i < 3; i++) {
+			PushCollapse(tri[i], tri[(i + 1) % 3]);
+			PushCollapse(tri[(i + 1) % 3], tri[i]);
+		}
+	}
+
+	std::vector<UINT> marks(vertNum, 0);
+	UINT mark = 0;
+	while (aliveTriNum > targetTriNum && !heap.empty()) {
+		Collapse collapse = heap.top();
+		heap.pop();
+		UINT from = collapse.From;
+		UINT to = collapse.To;
+		if (collapse.FromVersion != versions[from] || collapse.ToVersion != versions[to])
+			continue;
+
+		// Keep the surface manifold, an edge may only be shared by two triangles' apexes
+		mark++;
+		ForEachNeighbour(from, [&](UINT u) { marks[u] = mark; });
+		if (marks[to] != mark)
+			continue;
+		UINT commonNum = 0;
+		ForEachNeighbour(to, [&](UINT u) {
+			if (marks[u] == mark) {
+				marks[u] = 0;
+				commonNum++;
+			}
+		});
+		if (commonNum > 2)
+			continue;
+
+		// Reject collapses that flip or squash triangles
+		bool valid = true;
+		for (UINT t : vertTris[from]) {
+			const auto& tri = tris[t];
+			if (!triAlive[t] || tri[0] == to || tri[1] == to || tri[2] == to)
+				continue;
+			XMFLOAT3 p[3], q[3];
+			for (UINT i = 0; i < 3; i++) {
+				p[i] = GetPos(tri[i]);
+				q[i] = GetPos(tri[i] == from ? to : tri[i]);
+			}
+			XMVECTOR oldNormal = XMVector3Normalize(CalNormal(p[0], p[1], p[2]));
+			XMVECTOR newNormal = CalNormal(q[0], q[1], q[2]);
+			float newLength = XMVectorGetX(XMVector3Length(newNormal));
+			if (newLength <= 0.0f
+				|| XMVectorGetX(XMVector3Dot(oldNormal, newNormal)) < MIN_NORMAL_COS * newLength) {
+				valid = false;
+				break;
+			}
+		}
+		if (!valid)
+			continue;
+
+		// Move from's triangles to to, the ones on the edge disappear
+		for (UINT t : vertTris[from]) {
+			if (!triAlive[t])
+				continue;
+			auto& tri = tris[t];
+			if (tri[0] == to || tri[1] == to || tri[2] == to) {
+				triAlive[t] = false;
+				aliveTriNum--;
+				continue;
+			}
+			for (UINT& v : tri)
+				if (v == from)
+					v = to;
+			vertTris[to].push_back(t);
+		}
+		vertTris[from].clear();
+		quadrics[to].Add(quadrics[from]);
+		versions[from]++;
+		versions[to]++;
+
+		if (maxError && quadrics[to].Weight > 0.0)
+			*maxError = MathHelper::Max(*maxError, sqrtf(collapse.Cost / static_cast<float>(quadrics[to].Weight)));
+
+		// Costs around to have changed
+		ForEachNeighbour(to, [&](UINT u) {
+			PushCollapse(to, u);
+			PushCollapse(u, to);
+		});
+	}
+
+	std::vector<UINT> result;
+	result.reserve(aliveTriNum * 3);
+	for (UINT t = 0; t < tris.size(); t++)
+		if (triAlive[t])
+			result.insert(result.end(), tris[t].begin(), tris[t].end());
+	return result;
+}
@@ -0,0 +1,22 @@
+#pragma once
+#include <vector>
+
+#include "PlatformTypes.h"
+
+// Quadric error metric simplification of a triangle list by half-edge collapses.
+// A vertex is only ever collapsed onto one of its neighbours, so the result
+// indexes the original vertices and no vertex data has to be written.
+// Vertices with identical data are welded first. Vertices on open borders and
+// vertices sharing their position with other attributes (UV seams, hard edges)
+// are locked, so borders, seams and submesh boundaries keep their shape.
+class MeshSimplifier
+{
+public:
+	// verts holds vertNum vertices stride bytes apart, each starting with an XMFLOAT3 position.
+	// Collapse until at most targetIndexCount indices are left, or nothing more can go.
+	// maxError receives the largest RMS distance of a collapsed vertex to the planes it stood for.
+	static std::vector<UINT> Simplify(
+		const BYTE* verts, UINT vertNum, UINT stride,
+		const std::vector<UINT>& indices, UINT targetIndexCount,
+		float* maxError = nullptr);
+};
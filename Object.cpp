@@ -1,4 +1,5 @@
 #include "Object.h"
 
-UINT Object::sIDCount = 0;
-std::vector<Object*> Object::sIDMap;
\ No newline at end of file
+SlotMap<Object*> Object::sRegistry;
+TransformStore Object::sTransforms;
+std::vector<UINT> Object::sNodeObjects;
\ No newline at end of file
@@ -1,7 +1,19 @@
 #pragma once
 #include "Common/d3dUtil.h"
+#include "SlotMap.h"
 #include "Predefine.h"
 #include "RenderItem.h"
+#include "Mesh.h"
+#include "TransformStore.h"
+#include "ObjectContent.h"
+#include "Span.h"
+
+// What a traversal does after visiting an object
+enum class VisitResult {
+	Continue,
+	SkipChildren,
+	Stop
+};
 
 class Object
 {
@@ -10,6 +22,7 @@ public:
 	{
 		if (child->mParent)
 			return false;
+		sTransforms.SetParent(child->mNode, parent->mNode);
 		parent->mChilds.push_back(child);
 		child->mParent = parent;
 		return true;
@@ -21,6 +34,13 @@ public:
 			return false;
 		obj->mRenderItems.push_back(item);
 		item->ObjectID = obj->mID;
+
+		// Object bounds cover all its render items
+		Mesh* mesh = Mesh::FindObjectByID(item->MeshID);
+		if (mesh) {
+			SubMesh submesh = mesh->GetSubMesh(item->SubMeshID);
+			sTransforms.MergeLocalBounds(obj->mNode, submesh.bounds, submesh.boundingSphere);
+		}
 		return true;
 	}
 
@@ -28,100 +48,117 @@ public:
 	Object(const std::string& name)
 		: mName(name)
 	{
-		mID = sIDCount; 
-		sIDCount++;
-		sIDMap.push_back(this);
+		mID = sRegistry.Insert(this);
+
+		mNode = sTransforms.CreateNode();
+		if (mNode >= sNodeObjects.size())
+			sNodeObjects.resize(mNode + 1, INVALID_OBJECT_ID);
+		sNodeObjects[mNode] = mID;
 	}
 	~Object() {
-		sIDMap[mID] = nullptr;
+		sRegistry.Erase(mID);
+		sNodeObjects[mNode] = INVALID_OBJECT_ID;
+		sTransforms.DestroyNode(mNode);
 	}
 
+	std::string GetName()const { return mName; }
 	UINT GetID()const { return mID; }
-	static UINT GetTotalNum() { return sIDCount; }
+	// Index of constant buffer element
+	UINT GetSlotIndex()const { return SlotIndex(mID); }
+	// Upper bound of slot indices
+	static UINT GetTotalNum() { return sRegistry.Capacity(); }
 	static Object* FindObjectByID(UINT id) {
-		if (id >= sIDMap.size())
-			return nullptr;
-		return sIDMap[id];
+		auto item = sRegistry.Find(id);
+		return item ? *item : nullptr;
 	}
 
-	struct Content {
-		DirectX::XMFLOAT4X4 ModelMat = MathHelper::Identity4x4();
-		DirectX::XMFLOAT4X4 NormalModelMat = MathHelper::Identity4x4();
-	};
+	typedef ObjectContent Content;
+	// ModelMat is kept up to date by the transform store
 	Content ToContent()const {
-		Content content;
-
-		// cal ModelMat
-		DirectX::XMMATRIX mat = GetGlobalModelMat();
-
-		// cal NormalModelMat
-		DirectX::XMMATRIX normalMat = MathHelper::GenNormalMat(mat);
-
-		// HLSL use column-major
-		DirectX::XMStoreFloat4x4(
-			&content.ModelMat,
-			DirectX::XMMatrixTranspose(mat)
-		);
-		DirectX::XMStoreFloat4x4(
-			&content.NormalModelMat,
-			DirectX::XMMatrixTranspose(normalMat)
-		);
-
-		return content;
+		return PackObjectContent(GetGlobalModelMat());
 	}
 
 	void SetTranslation(float x, float y, float z) {
-		mTranslation = { x, y, z };
+		sTransforms.SetTranslation(mNode, x, y, z);
 	}
 	void SetRotation(float x, float y, float z) {
-		mRotation = { x, y, z };
+		sTransforms.SetRotation(mNode, x, y, z);
 	}
 	void SetRotation_Degree(float x, float y, float z) {
-		mRotation = { MathHelper::AngleToRadius(x), MathHelper::AngleToRadius(y), MathHelper::AngleToRadius(z) };
+		sTransforms.SetRotation(mNode, MathHelper::AngleToRadius(x), MathHelper::AngleToRadius(y), MathHelper::AngleToRadius(z));
 	}
 	void SetScale(float x, float y, float z) {
-		mScale = { x, y, z };
+		sTransforms.SetScale(mNode, x, y, z);
 	}
 
+	DirectX::XMFLOAT3 GetTranslation()const { return sTransforms.GetTranslation(mNode); }
+	// In radians
+	DirectX::XMFLOAT3 GetRotation()const { return sTransforms.GetRotation(mNode); }
+	DirectX::XMFLOAT3 GetScale()const { return sTransforms.GetScale(mNode); }
+
 	DirectX::XMMATRIX CalLocalModelMat()const {
-		DirectX::XMMATRIX mat = DirectX::XMMatrixScaling(mScale.x, mScale.y, mScale.z);
-		mat *= DirectX::XMMatrixRotationX(mRotation.x);
-		mat *= DirectX::XMMatrixRotationY(mRotation.y);
-		mat *= DirectX::XMMatrixRotationZ(mRotation.z);
-		mat *= DirectX::XMMatrixTranslation(
-			mTranslation.x,
-			mTranslation.y,
-			mTranslation.z);
-		return mat;
+		return sTransforms.CalLocalMat(mNode);
 	}
 
-	void UpdateGlobalModelMatRecursively() {
-		auto globalMat = CalLocalModelMat();
-		DirectX::XMStoreFloat4x4(&mGlobalModelMat, globalMat);
-
-		for (auto& child : mChilds)
-			child->UpdateGlobalModelMatRecursively(globalMat);
+	// Global model matrices of all objects are updated at once
+	static void UpdateGlobalModelMats(JobSystem* jobSystem = nullptr) {
+		sTransforms.Update(jobSystem);
 	}
-	void XM_CALLCONV UpdateGlobalModelMatRecursively(DirectX::CXMMATRIX parentMat) {
-		auto localMat = CalLocalModelMat();
-		auto globalMat = localMat * parentMat;
-		DirectX::XMStoreFloat4x4(&mGlobalModelMat, globalMat);
-
-		for (auto& child : mChilds)
-			child->UpdateGlobalModelMatRecursively(globalMat);
+	// Append the IDs of objects whose global model matrix the last update recomputed
+	static void GetRecomputedObjects(std::vector<UINT>& objectIDs) {
+		for (UINT node : sTransforms.GetRecomputedNodes()) {
+			UINT id = sNodeObjects[node];
+			if (id != INVALID_OBJECT_ID)
+				objectIDs.push_back(id);
+		}
 	}
 	DirectX::XMMATRIX GetGlobalModelMat()const {
-		return DirectX::XMLoadFloat4x4(&mGlobalModelMat);
+		return sTransforms.GetWorldMat(mNode);
+	}
+
+	static TransformStore& GetTransformStore() { return sTransforms; }
+
+	// Objects without render items have no bounds
+	bool HasBounds()const { return sTransforms.HasBounds(mNode); }
+	const DirectX::BoundingBox& GetWorldBounds()const {
+		return sTransforms.GetWorldBounds(mNode);
+	}
+	const DirectX::BoundingSphere& GetWorldBoundingSphere()const {
+		return sTransforms.GetWorldBoundingSphere(mNode);
 	}
 
-	std::vector<std::shared_ptr<Object>> GetChilds() { return mChilds; }
-	std::vector<std::shared_ptr<RenderItem>> GetRenderItems() { return mRenderItems; }
+	Span<const std::shared_ptr<Object>> GetChilds()const { return mChilds; }
+	Span<const std::shared_ptr<RenderItem>> GetRenderItems()const { return mRenderItems; }
+
+	// Depth-first traversal of this subtree without allocating.
+	// preVisitor(Object&) runs before children, postVisitor(Object&) after them,
+	// both return a VisitResult. SkipChildren from postVisitor is the same as Continue.
+	// Return false if the traversal was stopped.
+	template<typename PreVisitor, typename PostVisitor>
+	bool Traverse(PreVisitor&& preVisitor, PostVisitor&& postVisitor) {
+		VisitResult result = preVisitor(*this);
+		if (result == VisitResult::Stop)
+			return false;
+		if (result == VisitResult::Continue) {
+			for (auto& child : mChilds)
+				if (!child->Traverse(preVisitor, postVisitor))
+					return false;
+		}
+		return postVisitor(*this) != VisitResult::Stop;
+	}
+	template<typename PreVisitor>
+	bool Traverse(PreVisitor&& preVisitor) {
+		return Traverse(preVisitor, [](Object&) { return VisitResult::Continue; });
+	}
+	template<typename PostVisitor>
+	bool TraversePostOrder(PostVisitor&& postVisitor) {
+		return Traverse([](Object&) { return VisitResult::Continue; }, postVisitor);
+	}
 
 private:
 	// Note: We left UINT32_MAX as an invalid ID.
 	UINT mID;
-	static UINT sIDCount;
-	static std::vector<Object*> sIDMap;
+	static SlotMap<Object*> sRegistry;
 
 	std::string mName;
 
@@ -129,8 +166,8 @@ private:
 	std::vector<std::shared_ptr<Object>> mChilds;
 	std::vector<std::shared_ptr<RenderItem>> mRenderItems;
 
-	DirectX::XMFLOAT3 mTranslation = { 0.0f, 0.0f, 0.0f };
-	DirectX::XMFLOAT3 mRotation = { 0.0f, 0.0f, 0.0f };;
-	DirectX::XMFLOAT3 mScale = { 1.0f, 1.0f, 1.0f };;
-	DirectX::XMFLOAT4X4 mGlobalModelMat;
+	// Transform data lives in the flat store
+	UINT mNode;
+	static TransformStore sTransforms;
+	static std::vector<UINT> sNodeObjects; // object ID by node handle
 };
@@ -0,0 +1,22 @@
+#pragma once
+#include <DirectXMath.h>
+
+// Per-object element of the object structured buffer, ObjectData in Header.hlsli.
+// 3x4 affine model matrix, 48 bytes per object.
+// The normal matrix is derived from it in the vertex shader.
+struct ObjectContent {
+	DirectX::XMFLOAT3X4 ModelMat = DirectX::XMFLOAT3X4(
+		1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f
+	);
+};
+static_assert(sizeof(ObjectContent) == 48, "ObjectData in Header.hlsli is a float4x3");
+
+// Stored transposed, the last column of an affine matrix is dropped
+inline ObjectContent XM_CALLCONV PackObjectContent(DirectX::FXMMATRIX modelMat)
+{
+	ObjectContent content;
+	DirectX::XMStoreFloat3x4(&content.ModelMat, modelMat);
+	return content;
+}
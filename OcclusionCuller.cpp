@@ -0,0 +1,259 @@
+#include "OcclusionCuller.h"
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <immintrin.h>
+
+#include "Common/MathHelper.h"
+
+using namespace DirectX;
+
+namespace {
+	const UINT TILE_PIXEL_NUM = OCCLUSION_TILE_SIZE * OCCLUSION_TILE_SIZE;
+	// Tiles handed to a job at once
+	const UINT TILE_GRAIN_SIZE = 8;
+	// Triangles thinner than this cover no pixel center worth testing
+	const float MIN_TRIANGLE_AREA = 1e-6f;
+
+	float Min3(float a, float b, float c) { return MathHelper::Min(a, MathHelper::Min(b, c)); }
+	float Max3(float a, float b, float c) { return MathHelper::Max(a, MathHelper::Max(b, c)); }
+
+	// Tile range [begin, end) covering the pixel range [low, high]
+	void CalTileRange(float low, float high, UINT tileNum, UINT& begin, UINT& end) {
+		float size = static_cast<float>(OCCLUSION_TILE_SIZE);
+		float first = MathHelper::Max(floorf(low / size), 0.0f);
+		float last = MathHelper::Min(floorf(high / size), static_cast<float>(tileNum) - 1.0f);
+		begin = static_cast<UINT>(first);
+		end = last < first ? begin : static_cast<UINT>(last) + 1;
+	}
+}
+
+OcclusionCuller::OcclusionCuller(UINT width, UINT height)
+{
+	mTileNumX = MathHelper::Max((width + OCCLUSION_TILE_SIZE - 1) / OCCLUSION_TILE_SIZE, 1u);
+	mTileNumY = MathHelper::Max((height + OCCLUSION_TILE_SIZE - 1) / OCCLUSION_TILE_SIZE, 1u);
+	mDepth.resize(mTileNumX * mTileNumY * TILE_PIXEL_NUM, 1.0f);
+	mTileMaxDepth.resize(mTileNumX * mTileNumY, 1.0f);
+	mTileBins.resize(mTileNumX * mTileNumY);
+	XMStoreFloat4x4(&mViewProj, XMMatrixIdentity());
+}
+
+void XM_CALLCONV OcclusionCuller::Begin(FXMMATRIX viewProj)
+{
+	XMStoreFloat4x4(&mViewProj, viewProj);
+	mTriangles.clear();
+	for (auto& bin : mTileBins)
+		bin.clear();
+	std::fill(mDepth.begin(), mDepth.end(), 1.0f);
+	std::fill(mTileMaxDepth.begin(), mTileMaxDepth.end(), 1.0f);
+}
+
+void XM_CALLCONV OcclusionCuller::AddOccluder(Span<const BYTE> vertices, UINT vertexStride,
+	Span<const UINT16> indices, UINT baseVertexLoc, FXMMATRIX world)
+{
+	AddTriangles(vertices, vertexStride, indices, baseVertexLoc, world);
+}
+
+void XM_CALLCONV OcclusionCuller::AddOccluder(Span<const BYTE> vertices, UINT vertexStride,
+	Span<const UINT32> indices, UINT baseVertexLoc, FXMMATRIX world)
+{
+	AddTriangles(vertices, vertexStride, indices, baseVertexLoc, world);
+}
+
+template<typename Index>
+void XM_CALLCONV OcclusionCuller::AddTriangles(Span<const BYTE> vertices, UINT vertexStride,
+	Span<const Index> indices, UINT baseVertexLoc, FXMMATRIX world)
+{
+	if (vertices.size() < sizeof(XMFLOAT3) || vertexStride == 0)
+		return;
+	// Vertices whose position lies inside the span
+	UINT64 vertNum = (vertices.size() - sizeof(XMFLOAT3)) / vertexStride + 1;
+
+	XMMATRIX mat = XMMatrixMultiply(world, XMLoadFloat4x4(&mViewProj));
+	float width = static_cast<float>(GetWidth());
+	float height = static_cast<float>(GetHeight());
+
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+		Triangle tri;
+		bool clipped = false;
+		for (UINT j = 0; j < 3; j++) {
+			UINT64 index = static_cast<UINT64>(indices[i + j]) + baseVertexLoc;
+			if (index >= vertNum) {
+				clipped = true;
+				break;
+			}
+
+			XMVECTOR pos = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(vertices.data() + index * vertexStride));
+			XMFLOAT4 clip;
+			XMStoreFloat4(&clip, XMVector3Transform(pos, mat));
+			if (clip.w <= 0.0f || clip.z < 0.0f) {
+				clipped = true;
+				break;
+			}
+
+			// NDC to pixels, y goes down
+			float invW = 1.0f / clip.w;
+			tri.V[j].x = (clip.x * invW * 0.5f + 0.5f) * width;
+			tri.V[j].y = (0.5f - clip.y * invW * 0.5f) * height;
+			tri.V[j].z = clip.z * invW;
+		}
+		if (clipped)
+			continue;
+
+		// Bin into every tile the screen rect touches
+		UINT tileX0, tileX1, tileY0, tileY1;
+		CalTileRange(Min3(tri.V[0].x, tri.V[1].x, tri.V[2].x), Max3(tri.V[0].x, tri.V[1].x, tri.V[2].x), mTileNumX, tileX0, tileX1);
+		CalTileRange(Min3(tri.V[0].y, tri.V[1].y, tri.V[2].y), Max3(tri.V[0].y, tri.V[1].y, tri.V[2].y), mTileNumY, tileY0, tileY1);
+		if (tileX0 == tileX1 || tileY0 == tileY1)
+			continue;
+
+		UINT triIndex = static_cast<UINT>(mTriangles.size());
+		mTriangles.push_back(tri);
+		for (UINT ty = tileY0; ty < tileY1; ty++)
+			for (UINT tx = tileX0; tx < tileX1; tx++)
+				mTileBins[ty * mTileNumX + tx].push_back(triIndex);
+	}
+}
+
+void OcclusionCuller::Rasterize(JobSystem* jobSystem)
+{
+	UINT tileNum = mTileNumX * mTileNumY;
+	if (jobSystem) {
+		jobSystem->ParallelFor(tileNum, TILE_GRAIN_SIZE, [this](UINT begin, UINT end) {
+			for (UINT tile = begin; tile < end; tile++)
+				RasterizeTile(tile);
+		});
+	}
+	else {
+		for (UINT tile = 0; tile < tileNum; tile++)
+			RasterizeTile(tile);
+	}
+}
+
+void OcclusionCuller::RasterizeTile(UINT tile)
+{
+	const auto& bin = mTileBins[tile];
+	if (bin.empty())
+		return;
+
+	float* depth = &mDepth[tile * TILE_PIXEL_NUM];
+	float tileX = static_cast<float>((tile % mTileNumX) * OCCLUSION_TILE_SIZE);
+	float tileY = static_cast<float>((tile / mTileNumX) * OCCLUSION_TILE_SIZE);
+	const __m128 laneOffsets = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+	const __m128 zero = _mm_setzero_ps();
+
+	for (UINT triIndex : bin) {
+		Triangle tri = mTriangles[triIndex];
+		float area = (tri.V[1].x - tri.V[0].x) * (tri.V[2].y - tri.V[0].y)
+			- (tri.V[2].x - tri.V[0].x) * (tri.V[1].y - tri.V[0].y);
+		if (fabsf(area) < MIN_TRIANGLE_AREA)
+			continue;
+		// Occluders are double sided, flip to a positive area
+		if (area < 0.0f) {
+			std::swap(tri.V[1], tri.V[2]);
+			area = -area;
+		}
+
+		// Edge functions e = a * x + b * y + c, positive inside.
+		// Edge i is opposite to vertex i, so e[i] / area is the weight of vertex i.
+		float a[3], b[3], c[3];
+		for (UINT i = 0; i < 3; i++) {
+			const XMFLOAT3& v0 = tri.V[(i + 1) % 3];
+			const XMFLOAT3& v1 = tri.V[(i + 2) % 3];
+			a[i] = v0.y - v1.y;
+			b[i] = v1.x - v0.x;
+			c[i] = v0.x * v1.y - v0.y * v1.x;
+		}
+		// Depth is linear in screen space
+		float invArea = 1.0f / area;
+		float za = (a[0] * tri.V[0].z + a[1] * tri.V[1].z + a[2] * tri.V[2].z) * invArea;
+		float zb = (b[0] * tri.V[0].z + b[1] * tri.V[1].z + b[2] * tri.V[2].z) * invArea;
+		float zc = (c[0] * tri.V[0].z + c[1] * tri.V[1].z + c[2] * tri.V[2].z) * invArea;
+
+		// Rows of the tile the triangle can cover
+		float minY = Min3(tri.V[0].y, tri.V[1].y, tri.V[2].y) - tileY;
+		float maxY = Max3(tri.V[0].y, tri.V[1].y, tri.V[2].y) - tileY;
+		UINT row0 = static_cast<UINT>(MathHelper::Clamp(floorf(minY), 0.0f, static_cast<float>(OCCLUSION_TILE_SIZE)));
+		UINT row1 = static_cast<UINT>(MathHelper::Clamp(ceilf(maxY), 0.0f, static_cast<float>(OCCLUSION_TILE_SIZE)));
+
+		for (UINT row = row0; row < row1; row++) {
+			__m128 y = _mm_set1_ps(tileY + row + 0.5f);
+			for (UINT col = 0; col < OCCLUSION_TILE_SIZE; col += 4) {
+				__m128 x = _mm_add_ps(_mm_set1_ps(tileX + col), laneOffsets);
+				__m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[0]), x), _mm_mul_ps(_mm_set1_ps(b[0]), y)), _mm_set1_ps(c[0])), zero);
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[1]), x), _mm_mul_ps(_mm_set1_ps(b[1]), y)), _mm_set1_ps(c[1])), zero));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(a[2]), x), _mm_mul_ps(_mm_set1_ps(b[2]), y)), _mm_set1_ps(c[2])), zero));
+				if (!_mm_movemask_ps(inside))
+					continue;
+
+				float* dst = depth + row * OCCLUSION_TILE_SIZE + col;
+				__m128 z = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(za), x), _mm_mul_ps(_mm_set1_ps(zb), y)), _mm_set1_ps(zc));
+				__m128 old = _mm_loadu_ps(dst);
+				__m128 closer = _mm_min_ps(old, z);
+				_mm_storeu_ps(dst, _mm_or_ps(_mm_and_ps(inside, closer), _mm_andnot_ps(inside, old)));
+			}
+		}
+	}
+
+	// Farthest depth of the tile
+	__m128 maxDepth = _mm_loadu_ps(depth);
+	for (UINT i = 4; i < TILE_PIXEL_NUM; i += 4)
+		maxDepth = _mm_max_ps(maxDepth, _mm_loadu_ps(depth + i));
+	maxDepth = _mm_max_ps(maxDepth, _mm_shuffle_ps(maxDepth, maxDepth, _MM_SHUFFLE(1, 0, 3, 2)));
+	maxDepth = _mm_max_ps(maxDepth, _mm_shuffle_ps(maxDepth, maxDepth, _MM_SHUFFLE(2, 3, 0, 1)));
+	mTileMaxDepth[tile] = _mm_cvtss_f32(maxDepth);
+}
+
+bool OcclusionCuller::IsVisible(const BoundingBox& worldBox)const
+{
+	XMFLOAT3 corners[BoundingBox::CORNER_COUNT];
+	worldBox.GetCorners(corners);
+
+	XMMATRIX viewProj = XMLoadFloat4x4(&mViewProj);
+	float width = static_cast<float>(GetWidth());
+	float height = static_cast<float>(GetHeight());
+	float minX = FLT_MAX, minY = FLT_MAX, minZ = FLT_MAX;
+	float maxX = -FLT_MAX, maxY = -FLT_MAX;
+	for (UINT i = 0; i < BoundingBox::CORNER_COUNT; i++) {
+		XMFLOAT4 clip;
+		XMStoreFloat4(&clip, XMVector3Transform(XMLoadFloat3(&corners[i]), viewProj));
+		if (clip.w <= 0.0f || clip.z < 0.0f)
+			return true;
+		float invW = 1.0f / clip.w;
+		float x = (clip.x * invW * 0.5f + 0.5f) * width;
+		float y = (0.5f - clip.y * invW * 0.5f) * height;
+		minX = MathHelper::Min(minX, x);
+		maxX = MathHelper::Max(maxX, x);
+		minY = MathHelper::Min(minY, y);
+		maxY = MathHelper::Max(maxY, y);
+		minZ = MathHelper::Min(minZ, clip.z * invW);
+	}
+
+	// Pixels whose center may lie inside the rect, off-screen boxes cover none
+	float x0 = MathHelper::Max(floorf(minX), 0.0f);
+	float y0 = MathHelper::Max(floorf(minY), 0.0f);
+	float x1 = MathHelper::Min(floorf(maxX) + 1.0f, width);
+	float y1 = MathHelper::Min(floorf(maxY) + 1.0f, height);
+	if (x0 >= x1 || y0 >= y1)
+		return false;
+	UINT pixelX0 = static_cast<UINT>(x0), pixelX1 = static_cast<UINT>(x1);
+	UINT pixelY0 = static_cast<UINT>(y0), pixelY1 = static_cast<UINT>(y1);
+
+	for (UINT ty = pixelY0 / OCCLUSION_TILE_SIZE; ty <= (pixelY1 - 1) / OCCLUSION_TILE_SIZE; ty++) {
+		for (UINT tx = pixelX0 / OCCLUSION_TILE_SIZE; tx <= (pixelX1 - 1) / OCCLUSION_TILE_SIZE; tx++) {
+			// Whole tile is in front of the box
+			if (mTileMaxDepth[ty * mTileNumX + tx] < minZ)
+				continue;
+
+			UINT px0 = MathHelper::Max(pixelX0, tx * OCCLUSION_TILE_SIZE);
+			UINT px1 = MathHelper::Min(pixelX1, (tx + 1) * OCCLUSION_TILE_SIZE);
+			UINT py0 = MathHelper::Max(pixelY0, ty * OCCLUSION_TILE_SIZE);
+			UINT py1 = MathHelper::Min(pixelY1, (ty + 1) * OCCLUSION_TILE_SIZE);
+			for (UINT y = py0; y < py1; y++)
+				for (UINT x = px0; x < px1; x++)
+					if (mDepth[GetPixelIndex(x, y)] >= minZ)
+						return true;
+		}
+	}
+	return false;
+}
@@ -0,0 +1,75 @@
+#pragma once
+#include <vector>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+
+#include "PlatformTypes.h"
+#include "Span.h"
+#include "JobSystem.h"
+
+// Side of the square pixel tiles of the occlusion depth buffer
+const UINT OCCLUSION_TILE_SIZE = 8;
+
+// Low resolution depth buffer of occluders, rasterized on the CPU.
+// Occluder triangles are binned into tiles, then every tile is rasterized
+// on its own, four pixels at a time with SSE, so tiles can run in parallel.
+// Each tile keeps the farthest depth of its pixels, which accepts or rejects
+// most occludees without touching single pixels.
+// Depth follows D3D: 0 on the near plane, 1 on the far plane.
+class OcclusionCuller
+{
+public:
+	// Width and height are rounded up to whole tiles
+	OcclusionCuller(UINT width = 256, UINT height = 128);
+
+	// Clear the depth buffer and drop the occluders of the last frame.
+	// viewProj maps world space to D3D clip space.
+	void XM_CALLCONV Begin(DirectX::FXMMATRIX viewProj);
+	// Add a triangle list, positions are the first member of vertices vertexStride bytes apart.
+	// indices are the ones of the submesh only, baseVertexLoc is added to each of them.
+	// Triangles crossing the near plane or with indices outside of vertices are dropped,
+	// that only shrinks the occluders.
+	void XM_CALLCONV AddOccluder(Span<const BYTE> vertices, UINT vertexStride,
+		Span<const UINT16> indices, UINT baseVertexLoc, DirectX::FXMMATRIX world);
+	void XM_CALLCONV AddOccluder(Span<const BYTE> vertices, UINT vertexStride,
+		Span<const UINT32> indices, UINT baseVertexLoc, DirectX::FXMMATRIX world);
+	// Rasterize all added occluders, on jobSystem if it isn't nullptr
+	void Rasterize(JobSystem* jobSystem = nullptr);
+
+	// False if the box is hidden behind the rasterized occluders.
+	// Boxes crossing the near plane are always visible.
+	// Doesn't modify anything, so it can be called from several threads.
+	bool IsVisible(const DirectX::BoundingBox& worldBox)const;
+
+	UINT GetWidth()const { return mTileNumX * OCCLUSION_TILE_SIZE; }
+	UINT GetHeight()const { return mTileNumY * OCCLUSION_TILE_SIZE; }
+	float GetDepth(UINT x, UINT y)const { return mDepth[GetPixelIndex(x, y)]; }
+	UINT GetTriangleNum()const { return static_cast<UINT>(mTriangles.size()); }
+
+private:
+	// In pixels, with depth in z
+	struct Triangle {
+		DirectX::XMFLOAT3 V[3];
+	};
+
+	// Pixels are stored tile by tile, row by row inside a tile
+	UINT GetPixelIndex(UINT x, UINT y)const {
+		UINT tile = (y / OCCLUSION_TILE_SIZE) * mTileNumX + x / OCCLUSION_TILE_SIZE;
+		return tile * OCCLUSION_TILE_SIZE * OCCLUSION_TILE_SIZE
+			+ (y % OCCLUSION_TILE_SIZE) * OCCLUSION_TILE_SIZE + x % OCCLUSION_TILE_SIZE;
+	}
+	template<typename Index>
+	void XM_CALLCONV AddTriangles(Span<const BYTE> vertices, UINT vertexStride,
+		Span<const Index> indices, UINT baseVertexLoc, DirectX::FXMMATRIX world);
+	void RasterizeTile(UINT tile);
+
+	UINT mTileNumX;
+	UINT mTileNumY;
+	DirectX::XMFLOAT4X4 mViewProj;
+
+	std::vector<float> mDepth;
+	std::vector<float> mTileMaxDepth;
+
+	std::vector<Triangle> mTriangles;
+	std::vector<std::vector<UINT>> mTileBins; // triangles overlapping each tile
+};
@@ -0,0 +1,137 @@
+#pragma once
+#include <algorithm>
+#include <functional>
+#include <vector>
+
+#include "PlatformTypes.h"
+#include "CommandEncoder.h"
+#include "JobSystem.h"
+
+// Command lists a pass recorder records into, and the queue they are submitted to
+template <class CommandList>
+class CommandListProvider
+{
+public:
+	virtual ~CommandListProvider() = default;
+
+	virtual UINT GetMaxListNum()const = 0;
+	// Reset list index for recording and return it. Called from worker threads,
+	// a list is only touched by one thread at a time.
+	virtual CommandList* BeginList(UINT index) = 0;
+	virtual void EndList(CommandList* commandList) = 0;
+	// Execute lists in order, in one submission
+	virtual void Submit(CommandList* const* commandLists, UINT num) = 0;
+};
+
+// Record passes into several command lists in parallel, and submit the lists
+// in the order the passes were added.
+// Passes are split into contiguous groups of about equal cost, one list per group,
+// so the GPU sees the same order as with a single list.
+// Passes in a list share its encoder, every pass sets the state it depends on.
+// Api is the command list API of CommandEncoder.
+template <class Api>
+class PassRecorder
+{
+public:
+	using CommandList = typename Api::CommandList;
+	using Encoder = CommandEncoder<Api>;
+	using RecordFunc = std::function<void(Encoder&)>;
+
+	PassRecorder(CommandListProvider<CommandList>* provider, JobSystem* jobSystem = nullptr)
+		: mProvider(provider), mJobSystem(jobSystem) {
+	}
+
+	// cost is any measure of recording time, like the number of draws
+	void AddPass(RecordFunc record, UINT cost = 1) {
+		mPasses.push_back(std::move(record));
+		mCosts.push_back(cost);
+	}
+
+	// Record all added passes into at most maxListNum lists and submit them.
+	// Return the number of lists.
+	UINT Execute(UINT maxListNum) {
+		UINT passNum = static_cast<UINT>(mPasses.size());
+		UINT listNum = std::min(passNum, std::min(maxListNum, mProvider->GetMaxListNum()));
+		if (listNum == 0) {
+			mIssuedNum = mSkippedNum = 0;
+			return 0;
+		}
+
+		Partition(mCosts, listNum, mGroupStarts);
+		mLists.assign(listNum, nullptr);
+		mListIssuedNums.assign(listNum, 0);
+		mListSkippedNums.assign(listNum, 0);
+		auto recordLists = [this](UINT begin, UINT end) {
+			for (UINT l = begin; l < end; l++) {
+				CommandList* commandList = mProvider->BeginList(l);
+				Encoder encoder(commandList);
+				for (UINT p = mGroupStarts[l]; p < mGroupStarts[l + 1]; p++)
+					mPasses[p](encoder);
+				mProvider->EndList(commandList);
+				mLists[l] = commandList;
+				mListIssuedNums[l] = encoder.GetIssuedNum();
+				mListSkippedNums[l] = encoder.GetSkippedNum();
+			}
+		};
+		if (mJobSystem && listNum > 1)
+			mJobSystem->ParallelFor(listNum, 1, recordLists);
+		else
+			recordLists(0, listNum);
+
+		mProvider->Submit(mLists.data(), listNum);
+
+		mIssuedNum = mSkippedNum = 0;
+		for (UINT l = 0; l < listNum; l++) {
+			mIssuedNum += mListIssuedNums[l];
+			mSkippedNum += mListSkippedNums[l];
+		}
+		mPasses.clear();
+		mCosts.clear();
+		return listNum;
+	}
+
+	// Split passes into groupNum contiguous groups of about equal total cost.
+	// Group g holds passes [groupStarts[g], groupStarts[g + 1]), no group is empty.
+	static void Partition(const std::vector<UINT>& costs, UINT groupNum, std::vector<UINT>& groupStarts) {
+		UINT passNum = static_cast<UINT>(costs.size());
+		if (groupNum == 0 || groupNum > passNum)
+			throw "Invalid group num.";
+
+		UINT64 totalCost = 0;
+		for (UINT cost : costs)
+			totalCost += cost;
+
+		groupStarts.assign(1, 0);
+		UINT64 accCost = 0;
+		for (UINT p = 0; p < passNum && groupStarts.size() < groupNum; p++) {
+			accCost += costs[p];
+			UINT g = static_cast<UINT>(groupStarts.size());
+			// Close the group once it reaches its share, leaving a pass for every later group
+			bool reachShare = accCost * groupNum >= totalCost * g;
+			bool mustClose = passNum - (p + 1) == groupNum - g;
+			if (reachShare || mustClose)
+				groupStarts.push_back(p + 1);
+		}
+		groupStarts.push_back(passNum);
+	}
+
+	// Calls of the last Execute forwarded to the lists, and dropped as redundant
+	UINT GetIssuedNum()const { return mIssuedNum; }
+	UINT GetSkippedNum()const { return mSkippedNum; }
+
+private:
+	CommandListProvider<CommandList>* mProvider;
+	JobSystem* mJobSystem;
+
+	std::vector<RecordFunc> mPasses;
+	std::vector<UINT> mCosts;
+
+	// Scratch, kept to avoid allocating every frame
+	std::vector<UINT> mGroupStarts;
+	std::vector<CommandList*> mLists;
+	std::vector<UINT> mListIssuedNums;
+	std::vector<UINT> mListSkippedNums;
+
+	UINT mIssuedNum = 0;
+	UINT mSkippedNum = 0;
+};
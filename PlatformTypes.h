@@ -0,0 +1,14 @@
+#pragma once
+#include <cstdint>
+
+// Integer types of the Windows headers, for CPU-only code that must also
+// build without them, e.g. in the tests.
+// They are the same types windows.h declares, so including both is fine.
+typedef unsigned char BYTE;
+typedef int INT;
+typedef unsigned int UINT;
+typedef float FLOAT;
+typedef uint8_t UINT8;
+typedef uint16_t UINT16;
+typedef uint32_t UINT32;
+typedef uint64_t UINT64;
@@ -0,0 +1,48 @@
+#include "RadixSort.h"
+#include <cstddef>
+
+void RadixSort(
+	std::vector<UINT64>& keys, std::vector<UINT>& values,
+	std::vector<UINT>& counts, std::vector<UINT64>& tempKeys, std::vector<UINT>& tempValues)
+{
+	const UINT RADIX_BITS = 8;
+	const UINT RADIX_SIZE = 1 << RADIX_BITS;
+	const UINT RADIX_PASS_NUM = 64 / RADIX_BITS;
+
+	size_t num = keys.size();
+	if (values.size() != num)
+		throw "Size does not match.";
+	if (num < 2)
+		return;
+
+	// Histograms of all passes in one read
+	counts.assign(RADIX_PASS_NUM * RADIX_SIZE, 0);
+	for (UINT64 key : keys)
+		for (UINT pass = 0; pass < RADIX_PASS_NUM; pass++)
+			counts[pass * RADIX_SIZE + ((key >> (pass * RADIX_BITS)) & (RADIX_SIZE - 1))]++;
+
+	tempKeys.resize(num);
+	tempValues.resize(num);
+	for (UINT pass = 0; pass < RADIX_PASS_NUM; pass++) {
+		UINT* count = &counts[pass * RADIX_SIZE];
+		UINT shift = pass * RADIX_BITS;
+
+		// Every key has the same digit, the order doesn't change
+		if (count[(keys[0] >> shift) & (RADIX_SIZE - 1)] == num)
+			continue;
+
+		UINT offset = 0;
+		for (UINT digit = 0; digit < RADIX_SIZE; digit++) {
+			UINT digitNum = count[digit];
+			count[digit] = offset;
+			offset += digitNum;
+		}
+		for (size_t i = 0; i < num; i++) {
+			UINT dst = count[(keys[i] >> shift) & (RADIX_SIZE - 1)]++;
+			tempKeys[dst] = keys[i];
+			tempValues[dst] = values[i];
+		}
+		keys.swap(tempKeys);
+		values.swap(tempValues);
+	}
+}
@@ -0,0 +1,12 @@
+#pragma once
+#include <vector>
+
+#include "PlatformTypes.h"
+
+// LSD radix sort of 64-bit keys in place, values are moved along with them.
+// Byte passes all keys agree on are skipped.
+// counts, tempKeys and tempValues are scratch, passing the same ones every call
+// keeps the sort from allocating once they have grown.
+void RadixSort(
+	std::vector<UINT64>& keys, std::vector<UINT>& values,
+	std::vector<UINT>& counts, std::vector<UINT64>& tempKeys, std::vector<UINT>& tempValues);
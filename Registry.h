@@ -0,0 +1,85 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "PlatformTypes.h"
+
+// Handle checks, on in debug builds
+#if defined(DEBUG) || defined(_DEBUG)
+#define REGISTRY_CHECKS
+#endif
+
+const UINT INVALID_REGISTRY_HANDLE = -1;
+
+// Values added by name at build time and reached by dense handle on hot paths.
+// A name is resolved to its handle once, indexing by handle is an array access.
+// Unlike operator[] of a map, looking a name up never adds it: an unknown
+// name always throws. With REGISTRY_CHECKS an invalid handle throws too.
+// Handles stay valid when the value of a name is replaced.
+template <class T>
+class Registry
+{
+public:
+	// Value of name, added default constructed if new
+	T& Add(const std::string& name) {
+		auto it = mHandles.find(name);
+		if (it != mHandles.end())
+			return mValues[it->second];
+		mHandles.emplace(name, static_cast<UINT>(mValues.size()));
+		mNames.push_back(name);
+		mValues.emplace_back();
+		return mValues.back();
+	}
+
+	// Handle of name, INVALID_REGISTRY_HANDLE if unknown
+	UINT Find(const std::string& name)const {
+		auto it = mHandles.find(name);
+		return it == mHandles.end() ? INVALID_REGISTRY_HANDLE : it->second;
+	}
+	// Handle of name, which must have been added.
+	// Names are resolved at build time, so this is checked in every build.
+	UINT GetHandle(const std::string& name)const {
+		UINT handle = Find(name);
+		if (handle == INVALID_REGISTRY_HANDLE)
+			throw "Unknown registry name.";
+		return handle;
+	}
+
+	T& operator[](UINT handle) {
+		CheckHandle(handle);
+		return mValues[handle];
+	}
+	const T& operator[](UINT handle)const {
+		CheckHandle(handle);
+		return mValues[handle];
+	}
+
+	// By name, for build time code. Resolves the name on every call.
+	T& Get(const std::string& name) { return (*this)[GetHandle(name)]; }
+	const T& Get(const std::string& name)const { return (*this)[GetHandle(name)]; }
+	// Value of name, fallback if unknown
+	T GetOr(const std::string& name, const T& fallback)const {
+		UINT handle = Find(name);
+		return handle == INVALID_REGISTRY_HANDLE ? fallback : mValues[handle];
+	}
+
+	// Handles are 0 to GetNum() - 1, in the order names were added
+	UINT GetNum()const { return static_cast<UINT>(mValues.size()); }
+	const std::string& GetName(UINT handle)const {
+		CheckHandle(handle);
+		return mNames[handle];
+	}
+
+private:
+	void CheckHandle(UINT handle)const {
+#ifdef REGISTRY_CHECKS
+		if (handle >= mValues.size())
+			throw "Invalid registry handle.";
+#endif
+	}
+
+	std::unordered_map<std::string, UINT> mHandles;
+	std::vector<std::string> mNames; // by handle
+	std::vector<T> mValues; // by handle
+};
@@ -0,0 +1,242 @@
+#include "RenderGraph.h"
+
+void RenderGraph::Clear()
+{
+	mResources.clear();
+	mTransients.clear();
+	mPasses.clear();
+	mAccesses.clear();
+	mBarriers.clear();
+	mFirstFinalBarrier = 0;
+}
+
+UINT RenderGraph::ImportResource(GraphState restState)
+{
+	Resource res;
+	res.RestState = restState;
+	res.Output = false;
+	res.Transient = false;
+	res.FirstPass = INVALID_GRAPH_ID;
+	res.LastPass = INVALID_GRAPH_ID;
+	mResources.push_back(res);
+	return static_cast<UINT>(mResources.size() - 1);
+}
+
+UINT RenderGraph::ImportTransient(GraphState restState)
+{
+	UINT id = ImportResource(restState);
+	mResources[id].Transient = true;
+	mTransients.push_back(id);
+	return id;
+}
+
+void RenderGraph::MarkOutput(UINT resource)
+{
+	mResources[resource].Output = true;
+}
+
+UINT RenderGraph::AddPass(const char* name)
+{
+	Pass pass;
+	pass.Name = name;
+	pass.FirstAccess = static_cast<UINT>(mAccesses.size());
+	pass.AccessNum = 0;
+	pass.FirstBarrier = 0;
+	pass.BarrierNum = 0;
+	pass.Culled = false;
+	mPasses.push_back(pass);
+	return static_cast<UINT>(mPasses.size() - 1);
+}
+
+void RenderGraph::Read(UINT resource, GraphState state)
+{
+	AddAccess(resource, state, false);
+}
+
+void RenderGraph::Write(UINT resource, GraphState state)
+{
+	AddAccess(resource, state, true);
+}
+
+void RenderGraph::AddAccess(UINT resource, GraphState state, bool write)
+{
+	if (mPasses.empty())
+		throw "Add a pass before its accesses.";
+	if (resource >= mResources.size())
+		throw "Invalid resource id.";
+	Pass& pass = mPasses.back();
+
+	// One access per resource in a pass, reads in different states are combined
+	for (UINT a = pass.FirstAccess; a < pass.FirstAccess + pass.AccessNum; a++) {
+		Access& access = mAccesses[a];
+		if (access.Resource != resource)
+			continue;
+		if (!write && IsReadOnly(access))
+			access.State |= state;
+		else if (access.State == state) {
+			access.Read |= !write;
+			access.Write |= write;
+		}
+		else
+			throw "Conflicting states of a resource in one pass.";
+		return;
+	}
+
+	Access access;
+	access.Resource = resource;
+	access.State = state;
+	access.Read = !write;
+	access.Write = write;
+	mAccesses.push_back(access);
+	pass.AccessNum++;
+}
+
+void RenderGraph::Compile()
+{
+	CullPasses();
+	MergeReads();
+	ComputeLifetimes();
+	DeriveBarriers();
+}
+
+void RenderGraph::DeriveBarriers()
+{
+	// Transition every resource to the state of each access, from where it rests
+	mStates.resize(mResources.size());
+	mStateReads.assign(mResources.size(), 0);
+	for (UINT r = 0; r < mResources.size(); r++)
+		mStates[r] = mResources[r].RestState;
+
+	mBarriers.clear();
+	for (UINT p = 0; p < mPasses.size(); p++) {
+		Pass& pass = mPasses[p];
+		pass.FirstBarrier = static_cast<UINT>(mBarriers.size());
+		if (!pass.Culled) {
+			// Transient resources done with go back to rest while their memory is intact,
+			// then the ones starting here take theirs over
+			for (UINT r : mTransients) {
+				const Resource& res = mResources[r];
+				if (res.LastPass < p && mStates[r] != res.RestState) {
+					mBarriers.push_back({ r, mStates[r], res.RestState, false });
+					mStates[r] = res.RestState;
+				}
+			}
+			for (UINT r : mTransients)
+				if (mResources[r].FirstPass == p)
+					mBarriers.push_back({ r, mStates[r], mStates[r], true });
+
+			for (UINT a = pass.FirstAccess; a < pass.FirstAccess + pass.AccessNum; a++) {
+				const Access& access = mAccesses[a];
+				bool readOnly = IsReadOnly(access);
+				GraphState state = readOnly ? mReadStates[a] : access.State;
+				GraphState& nowState = mStates[access.Resource];
+				// Later reads of a run are covered by the combined state
+				bool covered = readOnly && mStateReads[access.Resource] && (nowState & state) == state;
+				if (nowState != state && !covered) {
+					mBarriers.push_back({ access.Resource, nowState, state, false });
+					nowState = state;
+				}
+				mStateReads[access.Resource] = readOnly;
+			}
+		}
+		pass.BarrierNum = static_cast<UINT>(mBarriers.size()) - pass.FirstBarrier;
+	}
+
+	// Back to rest
+	mFirstFinalBarrier = static_cast<UINT>(mBarriers.size());
+	for (UINT r = 0; r < mResources.size(); r++)
+		if (mStates[r] != mResources[r].RestState)
+			mBarriers.push_back({ r, mStates[r], mResources[r].RestState, false });
+}
+
+void RenderGraph::CullPasses()
+{
+	// Walk backwards, a pass is needed when a later needed pass or the frame output reads what it writes
+	mNeeds.resize(mResources.size());
+	for (UINT r = 0; r < mResources.size(); r++)
+		mNeeds[r] = mResources[r].Output;
+
+	for (UINT p = static_cast<UINT>(mPasses.size()); p-- > 0;) {
+		Pass& pass = mPasses[p];
+		bool hasWrite = false;
+		bool needed = false;
+		for (UINT a = pass.FirstAccess; a < pass.FirstAccess + pass.AccessNum; a++) {
+			const Access& access = mAccesses[a];
+			hasWrite |= access.Write;
+			needed |= access.Write && mNeeds[access.Resource];
+		}
+		// Passes writing nothing are kept for their side effects
+		pass.Culled = hasWrite && !needed;
+		if (pass.Culled)
+			continue;
+
+		for (UINT a = pass.FirstAccess; a < pass.FirstAccess + pass.AccessNum; a++) {
+			const Access& access = mAccesses[a];
+			if (access.Read)
+				mNeeds[access.Resource] = 1;
+			else if (access.Write)
+				mNeeds[access.Resource] = 0;
+		}
+	}
+}
+
+void RenderGraph::MergeReads()
+{
+	// Walk backwards, combining each read with the reads following it up to the next write
+	const GraphState NO_READ = GRAPH_STATE_COMMON;
+	mRunStates.assign(mResources.size(), NO_READ);
+	mReadStates.resize(mAccesses.size());
+	for (UINT p = static_cast<UINT>(mPasses.size()); p-- > 0;) {
+		const Pass& pass = mPasses[p];
+		if (pass.Culled)
+			continue;
+		for (UINT a = pass.FirstAccess; a < pass.FirstAccess + pass.AccessNum; a++) {
+			const Access& access = mAccesses[a];
+			if (!IsReadOnly(access)) {
+				mRunStates[access.Resource] = NO_READ;
+				continue;
+			}
+			mRunStates[access.Resource] |= access.State;
+			mReadStates[a] = mRunStates[access.Resource];
+		}
+	}
+}
+
+void RenderGraph::ComputeLifetimes()
+{
+	for (Resource& res : mResources)
+		res.FirstPass = res.LastPass = INVALID_GRAPH_ID;
+	for (UINT p = 0; p < mPasses.size(); p++) {
+		const Pass& pass = mPasses[p];
+		if (pass.Culled)
+			continue;
+		for (UINT a = pass.FirstAccess; a < pass.FirstAccess + pass.AccessNum; a++) {
+			Resource& res = mResources[mAccesses[a].Resource];
+			if (res.FirstPass == INVALID_GRAPH_ID)
+				res.FirstPass = p;
+			res.LastPass = p;
+		}
+	}
+}
+
+UINT RenderGraph::GetCulledNum()const
+{
+	UINT culledNum = 0;
+	for (const Pass& pass : mPasses)
+		culledNum += pass.Culled;
+	return culledNum;
+}
+
+Span<const GraphBarrier> RenderGraph::GetBarriers(UINT pass)const
+{
+	const Pass& p = mPasses[pass];
+	return Span<const GraphBarrier>(mBarriers.data() + p.FirstBarrier, p.BarrierNum);
+}
+
+Span<const GraphBarrier> RenderGraph::GetFinalBarriers()const
+{
+	return Span<const GraphBarrier>(
+		mBarriers.data() + mFirstFinalBarrier,
+		mBarriers.size() - mFirstFinalBarrier
+	);
+}
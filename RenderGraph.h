@@ -0,0 +1,134 @@
+#pragma once
+#include <vector>
+
+#include "PlatformTypes.h"
+#include "Span.h"
+
+const UINT INVALID_GRAPH_ID = -1;
+
+// Resource states a pass can use, a bit each except COMMON.
+// Values are those of D3D12_RESOURCE_STATES, D3D12RenderGraph casts them.
+enum GraphState : UINT {
+	GRAPH_STATE_COMMON = 0,
+	GRAPH_STATE_PRESENT = 0,
+	GRAPH_STATE_RENDER_TARGET = 0x4,
+	GRAPH_STATE_UNORDERED_ACCESS = 0x8,
+	GRAPH_STATE_DEPTH_WRITE = 0x10,
+	GRAPH_STATE_DEPTH_READ = 0x20,
+	GRAPH_STATE_NON_PIXEL_SHADER_RESOURCE = 0x40,
+	GRAPH_STATE_PIXEL_SHADER_RESOURCE = 0x80,
+	GRAPH_STATE_COPY_DEST = 0x400,
+	GRAPH_STATE_COPY_SOURCE = 0x800,
+	GRAPH_STATE_RESOLVE_DEST = 0x1000,
+	GRAPH_STATE_RESOLVE_SOURCE = 0x2000,
+};
+// Read states combine
+inline GraphState operator|(GraphState a, GraphState b) {
+	return static_cast<GraphState>(static_cast<UINT>(a) | static_cast<UINT>(b));
+}
+inline GraphState& operator|=(GraphState& a, GraphState b) {
+	return a = a | b;
+}
+
+struct GraphBarrier
+{
+	UINT Resource;
+	GraphState Before;
+	GraphState After;
+	bool Aliasing; // resource takes over memory it shares, states are unused
+};
+
+// Passes of a frame declare the resources they read and write,
+// compiling derives the transitions between them.
+// Imported resources rest in one state between frames: they are in it when
+// the frame starts and are put back at the end.
+// A write replaces the whole content of a resource, so a pass is culled when
+// nothing after it reads what it writes and none of it is an output.
+// Barriers of a pass boundary are merged into one list, consecutive reads of
+// a resource in different states share one transition to the combined state.
+// Transient resources only live within a frame and may share memory with
+// each other, see ImportTransient.
+// The graph only knows resources by id, D3D12RenderGraph binds them to
+// D3D12 resources and records the barriers.
+class RenderGraph
+{
+public:
+	// Forget passes and resources of the last frame, capacity is kept
+	void Clear();
+
+	// Resources
+	UINT ImportResource(GraphState restState);
+	// The content of resource does not outlive its last pass, its memory may be shared
+	// with transient resources used in other passes.
+	// Before its first pass it gets an aliasing barrier and is discarded, after its last
+	// pass it goes back to rest before any other can take the memory over.
+	// restState must be RENDER_TARGET or DEPTH_WRITE, where it can be discarded.
+	UINT ImportTransient(GraphState restState);
+	// The content of resource is used after the frame
+	void MarkOutput(UINT resource);
+	UINT GetResourceNum()const { return static_cast<UINT>(mResources.size()); }
+
+	// Passes, in execution order. Read and Write apply to the pass added last.
+	UINT AddPass(const char* name);
+	void Read(UINT resource, GraphState state);
+	void Write(UINT resource, GraphState state);
+
+	// Cull passes and derive barriers
+	void Compile();
+
+	bool IsCulled(UINT pass)const { return mPasses[pass].Culled; }
+	const char* GetPassName(UINT pass)const { return mPasses[pass].Name; }
+	UINT GetPassNum()const { return static_cast<UINT>(mPasses.size()); }
+	UINT GetCulledNum()const;
+	// First and last passes not culled using resource, INVALID_GRAPH_ID if none does
+	UINT GetFirstPass(UINT resource)const { return mResources[resource].FirstPass; }
+	UINT GetLastPass(UINT resource)const { return mResources[resource].LastPass; }
+	// Barriers before pass, and barriers after the last pass returning resources to rest
+	Span<const GraphBarrier> GetBarriers(UINT pass)const;
+	Span<const GraphBarrier> GetFinalBarriers()const;
+	UINT GetBarrierNum()const { return static_cast<UINT>(mBarriers.size()); }
+
+private:
+	struct Resource {
+		GraphState RestState;
+		bool Output;
+		bool Transient;
+		UINT FirstPass;
+		UINT LastPass;
+	};
+	struct Access {
+		UINT Resource;
+		GraphState State;
+		bool Read;
+		bool Write;
+	};
+	struct Pass {
+		const char* Name;
+		UINT FirstAccess;
+		UINT AccessNum;
+		UINT FirstBarrier;
+		UINT BarrierNum;
+		bool Culled;
+	};
+
+	void AddAccess(UINT resource, GraphState state, bool write);
+	bool IsReadOnly(const Access& access)const { return access.Read && !access.Write; }
+	void CullPasses();
+	void MergeReads();
+	void ComputeLifetimes();
+	void DeriveBarriers();
+
+	std::vector<Resource> mResources;
+	std::vector<UINT> mTransients;
+	std::vector<Pass> mPasses;
+	std::vector<Access> mAccesses; // by pass, one per resource a pass touches
+	std::vector<GraphBarrier> mBarriers; // by pass, final barriers last
+	UINT mFirstFinalBarrier = 0;
+
+	// Scratch, kept to avoid allocating every frame
+	std::vector<GraphState> mStates;
+	std::vector<UINT8> mStateReads; // whether mStates was entered for a run of reads
+	std::vector<GraphState> mReadStates; // by access, combined state of its run of reads
+	std::vector<GraphState> mRunStates;
+	std::vector<UINT8> mNeeds;
+};
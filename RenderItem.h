@@ -19,4 +19,13 @@ public:
 
 	// Object Constants concerned
 	UINT ObjectID = INVALID_OBJECT_ID;
+
+	// Drawn into the software depth buffer for occlusion culling
+	bool Occluder = false;
+
+	// Level of detail of the mesh, picked every frame from the size on screen
+	UINT Lod = 0;
+
+	// PSO, material and mesh fields of the sort key, set when queued
+	UINT64 SortState = 0;
 };
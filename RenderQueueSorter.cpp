@@ -0,0 +1,68 @@
+#include "RenderQueueSorter.h"
+#include "RadixSort.h"
+#include "Object.h"
+
+using namespace DirectX;
+
+UINT64 RenderQueueSorter::MakeStateKey(const RenderItem& renderItem)
+{
+	auto result = mPSOIndices.emplace(renderItem.PSO, static_cast<UINT>(mPSOIndices.size()));
+	UINT psoIndex = result.first->second;
+	return (Field(psoIndex, SORT_KEY_PSO_BITS) << (SORT_KEY_MATERIAL_BITS + SORT_KEY_MESH_BITS))
+		| (Field(SlotIndex(renderItem.MaterialID), SORT_KEY_MATERIAL_BITS) << SORT_KEY_MESH_BITS)
+		| Field(SlotIndex(renderItem.MeshID), SORT_KEY_MESH_BITS);
+}
+
+void XM_CALLCONV RenderQueueSorter::Sort(
+	std::vector<std::shared_ptr<RenderItem>>& queue,
+	FXMMATRIX view, UINT pass)
+{
+	UINT itemNum = static_cast<UINT>(queue.size());
+	if (itemNum < 2)
+		return;
+
+	// View depth of every item, items without bounds are in front
+	auto& depths = mDepths;
+	depths.resize(itemNum);
+	float minDepth = FLT_MAX;
+	float maxDepth = -FLT_MAX;
+	for (UINT i = 0; i < itemNum; i++) {
+		Object* obj = Object::FindObjectByID(queue[i]->ObjectID);
+		if (!obj || !obj->HasBounds()) {
+			depths[i] = -FLT_MAX;
+			continue;
+		}
+		XMFLOAT3 center = obj->GetWorldBoundingSphere().Center;
+		depths[i] = XMVectorGetZ(XMVector3TransformCoord(XMLoadFloat3(&center), view));
+		minDepth = MathHelper::Min(minDepth, depths[i]);
+		maxDepth = MathHelper::Max(maxDepth, depths[i]);
+	}
+
+	// Quantize over the depth range of the queue
+	float scale = maxDepth > minDepth ? SORT_KEY_DEPTH_MAX / (maxDepth - minDepth) : 0.0f;
+	mKeys.resize(itemNum);
+	mOrder.resize(itemNum);
+	for (UINT i = 0; i < itemNum; i++) {
+		UINT depth = depths[i] == -FLT_MAX ? 0 : static_cast<UINT>((depths[i] - minDepth) * scale);
+		mKeys[i] = MakeKey(pass, queue[i]->SortState, MathHelper::Min(depth, SORT_KEY_DEPTH_MAX));
+		mOrder[i] = i;
+	}
+	RadixSort(mKeys, mOrder, mRadixCounts, mRadixKeys, mRadixValues);
+
+	mSorted.resize(itemNum);
+	for (UINT i = 0; i < itemNum; i++)
+		mSorted[i] = std::move(queue[mOrder[i]]);
+	queue.swap(mSorted);
+}
+
+UINT RenderQueueSorter::CountStateChanges(const std::vector<std::shared_ptr<RenderItem>>& queue)
+{
+	UINT changeNum = 0;
+	for (size_t i = 1; i < queue.size(); i++) {
+		const RenderItem& prev = *queue[i - 1];
+		const RenderItem& now = *queue[i];
+		if (prev.PSO != now.PSO || prev.MaterialID != now.MaterialID || prev.MeshID != now.MeshID)
+			changeNum++;
+	}
+	return changeNum;
+}
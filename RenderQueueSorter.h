@@ -0,0 +1,64 @@
+#pragma once
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <DirectXMath.h>
+
+#include "PlatformTypes.h"
+
+class RenderItem;
+
+// Fields of a 64-bit sort key, in bits
+const UINT SORT_KEY_PASS_BITS = 4;
+const UINT SORT_KEY_PSO_BITS = 8;
+const UINT SORT_KEY_MATERIAL_BITS = 16;
+const UINT SORT_KEY_MESH_BITS = 16;
+const UINT SORT_KEY_DEPTH_BITS = 20;
+const UINT SORT_KEY_DEPTH_MAX = (1u << SORT_KEY_DEPTH_BITS) - 1;
+const UINT SORT_KEY_STATE_BITS = SORT_KEY_PSO_BITS + SORT_KEY_MATERIAL_BITS + SORT_KEY_MESH_BITS;
+
+// Passes, the most significant field of a key
+const UINT SORT_PASS_OPAQUE = 0;
+const UINT SORT_PASS_TRANSPARENT = 1;
+
+// Sort render queues by packed 64-bit keys with an LSD radix sort.
+// A key holds pass, PSO, material, mesh and the view depth quantized over the queue.
+// Opaque keys put depth last, so state changes are minimal and each state is drawn front to back.
+// Transparent keys put the inverted depth right after the pass, so they are drawn back to front.
+class RenderQueueSorter
+{
+public:
+	// PSO, material and mesh fields of the key of renderItem, which don't change once it is queued
+	UINT64 MakeStateKey(const RenderItem& renderItem);
+	static UINT64 MakeKey(UINT pass, UINT64 stateKey, UINT depth) {
+		UINT64 key = Field(pass, SORT_KEY_PASS_BITS) << (SORT_KEY_STATE_BITS + SORT_KEY_DEPTH_BITS);
+		if (pass == SORT_PASS_TRANSPARENT)
+			return key | (Field(SORT_KEY_DEPTH_MAX - depth, SORT_KEY_DEPTH_BITS) << SORT_KEY_STATE_BITS) | stateKey;
+		return key | (stateKey << SORT_KEY_DEPTH_BITS) | Field(depth, SORT_KEY_DEPTH_BITS);
+	}
+
+	// Sort queue by the keys of its items in this view
+	void XM_CALLCONV Sort(
+		std::vector<std::shared_ptr<RenderItem>>& queue,
+		DirectX::FXMMATRIX view, UINT pass = SORT_PASS_OPAQUE);
+
+	// Number of times PSO, material or mesh changes between neighbours of queue
+	static UINT CountStateChanges(const std::vector<std::shared_ptr<RenderItem>>& queue);
+
+private:
+	static UINT64 Field(UINT value, UINT bits) {
+		return static_cast<UINT64>(value) & ((1ull << bits) - 1);
+	}
+
+	std::unordered_map<std::string, UINT> mPSOIndices;
+
+	// Scratch, kept to avoid allocating every frame
+	std::vector<float> mDepths;
+	std::vector<UINT64> mKeys;
+	std::vector<UINT> mOrder;
+	std::vector<std::shared_ptr<RenderItem>> mSorted;
+	std::vector<UINT> mRadixCounts;
+	std::vector<UINT64> mRadixKeys;
+	std::vector<UINT> mRadixValues;
+};
@@ -60,10 +60,14 @@ public:
 
 	bool CheckHasDepthStencil() { return hasDepthStencil; }
 
+	// Resources are placed in heap at the offsets when heap is given, committed otherwise
 	void Resize(
 		Microsoft::WRL::ComPtr<ID3D12Device> device,
 		D3D12_RESOURCE_DESC* desc,
-		D3D12_RESOURCE_DESC* depthStencilDesc=nullptr
+		D3D12_RESOURCE_DESC* depthStencilDesc=nullptr,
+		ID3D12Heap* heap=nullptr,
+		UINT64 heapOffset=0,
+		UINT64 dsHeapOffset=0
 		) 
 	{
 		if (viewFormat != desc->Format)
@@ -79,16 +83,27 @@ public:
 		bool useMSAA = desc->SampleDesc.Count > 1;
 
 		// Build Resource
-		ThrowIfFailed(device->CreateCommittedResource(
-			&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-			D3D12_HEAP_FLAG_NONE,
-			desc,
-			D3D12_RESOURCE_STATE_RENDER_TARGET,
-			&CD3DX12_CLEAR_VALUE(
-				viewFormat, clearValue
-			),
-			IID_PPV_ARGS(resource.ReleaseAndGetAddressOf())
-		));
+		if (heap)
+			ThrowIfFailed(device->CreatePlacedResource(
+				heap, heapOffset,
+				desc,
+				D3D12_RESOURCE_STATE_RENDER_TARGET,
+				&CD3DX12_CLEAR_VALUE(
+					viewFormat, clearValue
+				),
+				IID_PPV_ARGS(resource.ReleaseAndGetAddressOf())
+			));
+		else
+			ThrowIfFailed(device->CreateCommittedResource(
+				&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+				D3D12_HEAP_FLAG_NONE,
+				desc,
+				D3D12_RESOURCE_STATE_RENDER_TARGET,
+				&CD3DX12_CLEAR_VALUE(
+					viewFormat, clearValue
+				),
+				IID_PPV_ARGS(resource.ReleaseAndGetAddressOf())
+			));
 		resource->SetName(name.c_str());
 
 		// Build RTV & SRV Descriptors
@@ -114,18 +129,31 @@ public:
 
 		// Build Depth Stencil Resource & Descriptor
 		if (hasDepthStencil) {
-			ThrowIfFailed(device->CreateCommittedResource(
-				&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
-				D3D12_HEAP_FLAG_NONE,
-				depthStencilDesc,
-				D3D12_RESOURCE_STATE_DEPTH_WRITE,
-				&CD3DX12_CLEAR_VALUE(
-					dsViewFormat,
-					depthClearValue,
-					stencilClearValue
-				),
-				IID_PPV_ARGS(dsResource.ReleaseAndGetAddressOf())
-			));
+			if (heap)
+				ThrowIfFailed(device->CreatePlacedResource(
+					heap, dsHeapOffset,
+					depthStencilDesc,
+					D3D12_RESOURCE_STATE_DEPTH_WRITE,
+					&CD3DX12_CLEAR_VALUE(
+						dsViewFormat,
+						depthClearValue,
+						stencilClearValue
+					),
+					IID_PPV_ARGS(dsResource.ReleaseAndGetAddressOf())
+				));
+			else
+				ThrowIfFailed(device->CreateCommittedResource(
+					&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT),
+					D3D12_HEAP_FLAG_NONE,
+					depthStencilDesc,
+					D3D12_RESOURCE_STATE_DEPTH_WRITE,
+					&CD3DX12_CLEAR_VALUE(
+						dsViewFormat,
+						depthClearValue,
+						stencilClearValue
+					),
+					IID_PPV_ARGS(dsResource.ReleaseAndGetAddressOf())
+				));
 			dsResource->SetName(dsName.c_str());
 
 			D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc = {};
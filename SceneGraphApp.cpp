@@ -10,10 +10,34 @@
 #include "Common/GeometryGenerator.h"
 #include "Predefine.h"
 #include "PIXHelper.h"
+#include "SceneSnapshot.h"
 
 using namespace DirectX;
 using Microsoft::WRL::ComPtr;
 
+// Frames the CPU may record ahead of the GPU
+const int gNumFrameResources = 3;
+// Command lists the passes of a frame are recorded into at most
+const UINT MAX_PASS_LIST_NUM = 8;
+// Initial size of the per-frame upload ring, it grows when the frames in flight fill it
+const UINT64 UPLOAD_RING_BYTE_SIZE = 1 << 20;
+// Shader visible descriptors the frames in flight may allocate for one frame
+const UINT TRANSIENT_DESCRIPTOR_NUM = 256;
+
+const char* SCENE_FBX_FILE = "bear.fbx";
+const char* SCENE_SNAPSHOT_FILE = "bear.sgsnap";
+// Objects at least this large relative to the largest one are occluders
+const float OCCLUDER_RADIUS_RATIO = 0.25f;
+// Render items tested for occlusion per job
+const UINT OCCLUSION_TEST_GRAIN_SIZE = 64;
+// Bounding sphere radius relative to half the screen height below which LOD 1 is used,
+// every further level halves it
+const float LOD_SCREEN_SIZE = 0.5f;
+// Relative band around every switch size, keeps items from flickering between levels
+const float LOD_HYSTERESIS = 0.1f;
+// Shadow maps are blurred by filtering, casters are drawn coarser than seen
+const UINT SHADOW_LOD_BIAS = 1;
+
 template <class T, class U>
 void FillBufferInfoAndUpload(
 		ComPtr<ID3D12Device> device, ComPtr<ID3D12GraphicsCommandList> commandList,
@@ -42,12 +66,15 @@ void FillBufferInfoAndUpload(
 }
 
 SceneGraphApp::SceneGraphApp(HINSTANCE hInstance)
-	: D3DApp(hInstance)
+	: D3DApp(hInstance), mObjectChanges(gNumFrameResources)
 {
 }
 
 SceneGraphApp::~SceneGraphApp()
 {
+	// Frame resources may still be read by the GPU
+	if (md3dDevice != nullptr)
+		FlushCommandQueue();
 }
 
 bool SceneGraphApp::Initialize()
@@ -58,6 +85,9 @@ bool SceneGraphApp::Initialize()
 	ThrowIfFailed(mDirectCmdListAlloc->Reset());
 	ThrowIfFailed(mCommandList->Reset(mDirectCmdListAlloc.Get(), nullptr));
 
+	mJobSystem = std::make_unique<JobSystem>();
+	BuildFrameResources();
+
 	bool fromFile = true;
 
 	// Init Scene
@@ -69,9 +99,10 @@ bool SceneGraphApp::Initialize()
 	else
 		BuildObjects();
 	BuildManualObjects();
-	BuildRenderItemQueueRecursively(mRootObject);
+	BuildRenderItemQueue(*mRootObject);
+	BuildSceneBvh();
+	BuildOccluders();
 	BuildLights();
-	BuildLightShadowConstantBuffers();
 
 	// Init DirectX
 	BuildUABs();
@@ -83,11 +114,11 @@ bool SceneGraphApp::Initialize()
 	BuildRootSignature();
 	BuildShaders();
 	BuildPSOs();
+	ResolveDrawHandles();
 	
 	// Init Scene Resources
 	LoadTextures();
 	BuildPassConstants();
-	BuildPassConstantBuffers();
 	UpdateLightsInPassConstantBuffers();
 	// BuildGeos();
 	BuildAndUpdateMaterialConstantBuffers();
@@ -113,6 +144,20 @@ bool SceneGraphApp::Initialize()
 	return true;
 }
 
+void SceneGraphApp::BuildFrameResources()
+{
+	mFrameFence = std::make_unique<D3D12FrameFence>(md3dDevice.Get(), mCommandQueue.Get());
+	mFrameRing = std::make_unique<FrameRing>(mFrameFence.get(), gNumFrameResources);
+	for (int i = 0; i < gNumFrameResources; i++)
+		mFrameResources.push_back(std::make_unique<FrameResource>(md3dDevice.Get(), MAX_PASS_LIST_NUM));
+	mUploadRing = std::make_unique<UploadRing>(md3dDevice.Get(), UPLOAD_RING_BYTE_SIZE, gNumFrameResources);
+
+	mCommandListProvider = std::make_unique<D3D12CommandListProvider>(
+		md3dDevice.Get(), mCommandQueue.Get(), MAX_PASS_LIST_NUM
+	);
+	mPassRecorder = std::make_unique<GraphicsPassRecorder>(mCommandListProvider.get(), mJobSystem.get());
+}
+
 void SceneGraphApp::BuildManualTextures()
 {
 	std::vector<std::shared_ptr<Texture>> texs;
@@ -166,6 +211,7 @@ void SceneGraphApp::BuildManualMeshs()
 
 		// Pass Vertex Data into Mesh
 		mesh->SetBuffer(verts, indices, DXGI_FORMAT_R32_UINT);
+		mesh->CalBounds();
 
 		// Upload mesh
 		mesh->UploadBuffer(md3dDevice, mCommandList);
@@ -174,11 +220,28 @@ void SceneGraphApp::BuildManualMeshs()
 
 void SceneGraphApp::LoadScene()
 {
-	FbxLoader loader;
-	mRootObject = loader.Load("bear.fbx");
-	auto meshs = loader.GetMeshs();
-	auto mtls = loader.GetMaterials();
-	auto texs = loader.GetTextures();
+	// Prefer the snapshot, fall back to FBX and refresh the snapshot
+	// if it is missing, stale or malformed. Tests/SceneLoadBench times both paths.
+	std::vector<std::shared_ptr<Mesh>> meshs;
+	std::vector<std::shared_ptr<Material>> mtls;
+	std::vector<std::shared_ptr<Texture>> texs;
+	SceneSnapshot snapshot;
+	mRootObject = snapshot.Load(SCENE_SNAPSHOT_FILE, SCENE_FBX_FILE);
+	bool fromSnapshot = mRootObject != nullptr;
+	if (fromSnapshot) {
+		meshs = snapshot.GetMeshs();
+		mtls = snapshot.GetMaterials();
+		texs = snapshot.GetTextures();
+	}
+	else {
+		FbxLoader loader;
+		mRootObject = loader.Load(SCENE_FBX_FILE);
+		meshs = loader.GetMeshs();
+		mtls = loader.GetMaterials();
+		texs = loader.GetTextures();
+		if (!SceneSnapshot::Save(SCENE_SNAPSHOT_FILE, SCENE_FBX_FILE, mRootObject, texs))
+			OutputDebugStringA("Failed to write scene snapshot.\n");
+	}
 
 	// Save & Upload meshs
 	for (auto mesh : meshs) {
@@ -310,17 +373,59 @@ void SceneGraphApp::BuildManualObjects()
 	}
 }
 
-void SceneGraphApp::BuildRenderItemQueueRecursively(std::shared_ptr<Object> root)
+void SceneGraphApp::BuildRenderItemQueue(Object& root)
 {
-	for (auto renderItem : root->GetRenderItems()) {
-		Mesh* mesh = Mesh::FindObjectByID(renderItem->MeshID);
-		if (mesh->GetName() == "background")
+	root.Traverse([this](Object& obj) {
+		for (auto& renderItem : obj.GetRenderItems()) {
+			Mesh* mesh = Mesh::FindObjectByID(renderItem->MeshID);
+			if (mesh->GetName() == "background")
+				continue;
+			// TODO now we just push all renderItems into opaqueQueue
+			renderItem->SortState = mQueueSorter.MakeStateKey(*renderItem);
+			mOpaqueRenderItemQueue.push_back(renderItem);
+		}
+		return VisitResult::Continue;
+	});
+}
+
+void SceneGraphApp::BuildSceneBvh()
+{
+	// World bounds must be valid before building
+	Object::UpdateGlobalModelMats(mJobSystem.get());
+
+	std::vector<UINT> objectIDs;
+	for (auto& renderItem : mOpaqueRenderItemQueue)
+		objectIDs.push_back(renderItem->ObjectID);
+	std::sort(objectIDs.begin(), objectIDs.end());
+	objectIDs.erase(std::unique(objectIDs.begin(), objectIDs.end()), objectIDs.end());
+
+	// Objects without bounds are left out
+	std::vector<UINT> boundedIDs;
+	std::vector<BoundingBox> bounds;
+	for (UINT id : objectIDs) {
+		Object* obj = Object::FindObjectByID(id);
+		if (!obj || !obj->HasBounds())
 			continue;
-		// TODO now we just push all renderItems into opaqueQueue
-		mOpaqueRenderItemQueue.push_back(renderItem);
+		boundedIDs.push_back(id);
+		bounds.push_back(obj->GetWorldBounds());
+	}
+	mSceneBvh.Build(boundedIDs, bounds);
+}
+
+void SceneGraphApp::BuildOccluders()
+{
+	// The largest objects hide the most, everything else only gets tested
+	float maxRadius = 0.0f;
+	for (auto& renderItem : mOpaqueRenderItemQueue) {
+		Object* obj = Object::FindObjectByID(renderItem->ObjectID);
+		if (obj && obj->HasBounds())
+			maxRadius = MathHelper::Max(maxRadius, obj->GetWorldBoundingSphere().Radius);
+	}
+	for (auto& renderItem : mOpaqueRenderItemQueue) {
+		Object* obj = Object::FindObjectByID(renderItem->ObjectID);
+		renderItem->Occluder = obj && obj->HasBounds()
+			&& obj->GetWorldBoundingSphere().Radius >= OCCLUDER_RADIUS_RATIO * maxRadius;
 	}
-	for (auto child : root->GetChilds())
-		BuildRenderItemQueueRecursively(child);
 }
 
 void SceneGraphApp::BuildLights()
@@ -393,15 +498,6 @@ void SceneGraphApp::BuildLights()
 	}
 }
 
-void SceneGraphApp::BuildLightShadowConstantBuffers()
-{
-	mShadowPassConstantsBuffers = std::make_unique<UploadBuffer<ShadowPassConstants::Content>>(
-		md3dDevice.Get(), 
-		max(ShadowPassConstants::getTotalNum(), 1), 
-		true
-	);
-}
-
 void SceneGraphApp::BuildUABs() 
 {
 	UINT zeroUINT[4];
@@ -415,7 +511,7 @@ void SceneGraphApp::BuildUABs()
 	zeroFLOAT[2] = 0.0f;
 	zeroFLOAT[3] = 0.0f;
 
-	mUABs["nCount"] = std::make_unique<UnorderedAccessBuffer>(
+	mUABs.Add("nCount") = std::make_unique<UnorderedAccessBuffer>(
 		L"nCount", DXGI_FORMAT_R32_UINT, (FLOAT*)zeroUINT
 		);
 }
@@ -434,23 +530,23 @@ void SceneGraphApp::BuildRenderTargets()
 	maxClearValue[3] = D3D12_FLOAT32_MAX;
 
 	// Build Single Render Targets
-	mRenderTargets["opaque"] = std::make_shared<SingleRenderTarget>(
+	mRenderTargets.Add("opaque") = std::make_shared<SingleRenderTarget>(
 		L"opaque", DXGI_FORMAT_R8G8B8A8_UNORM, whiteClearValue,
 		true, L"opaque depth", DXGI_FORMAT_R32_TYPELESS, DXGI_FORMAT_D32_FLOAT
 		);
 	/*
-	mRenderTargets["hbao"] = std::make_shared<SingleRenderTarget>(
+	mRenderTargets.Add("hbao") = std::make_shared<SingleRenderTarget>(
 		L"hbao", DXGI_FORMAT_R8G8B8A8_UNORM, whiteClearValue
 		);
-	mRenderTargets["trans"] = std::make_shared<SingleRenderTarget>(
+	mRenderTargets.Add("trans") = std::make_shared<SingleRenderTarget>(
 		L"transparent", DXGI_FORMAT_R32G32B32A32_FLOAT, whiteClearValue
 		);
-	mRenderTargets["transBlend"] = std::make_shared<SingleRenderTarget>(
+	mRenderTargets.Add("transBlend") = std::make_shared<SingleRenderTarget>(
 		L"transparent blend", DXGI_FORMAT_R8G8B8A8_UNORM, whiteClearValue);
 	*/
-	mRenderTargets["afterResolve"] = std::make_shared<SingleRenderTarget>(
+	mRenderTargets.Add("afterResolve") = std::make_shared<SingleRenderTarget>(
 		L"afterResolve", DXGI_FORMAT_R8G8B8A8_UNORM, whiteClearValue);
-	mRenderTargets["fxaa"] = std::make_shared<SingleRenderTarget>(
+	mRenderTargets.Add("fxaa") = std::make_shared<SingleRenderTarget>(
 		L"fxaa", DXGI_FORMAT_R8G8B8A8_UNORM, whiteClearValue,
 		true, L"fxaa depth"
 		);
@@ -530,12 +626,11 @@ void SceneGraphApp::BuildDescriptorHeaps()
 	// DSV
 	{
 		// Check who need DepthStencilView among RenderTargets
-		std::vector<std::string> renderTargetsNeedDS;
-		for (auto& pair : mRenderTargets) {
-			std::string name = pair.first;
-			auto& renderTarget = pair.second;
+		std::vector<UINT> renderTargetsNeedDS;
+		for (UINT i = 0; i < mRenderTargets.GetNum(); i++) {
+			auto& renderTarget = mRenderTargets[i];
 			if (renderTarget->CheckHasDepthStencil())
-				renderTargetsNeedDS.push_back(name);
+				renderTargetsNeedDS.push_back(i);
 		}
 
 		// Build Descriptor Heap
@@ -548,13 +643,13 @@ void SceneGraphApp::BuildDescriptorHeaps()
 		heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
 		heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
 		heapDesc.NodeMask = 0;
-		mDSVHeap = std::make_unique<StaticDescriptorHeap>(
+		mDSVHeap = std::make_unique<DescriptorHeap>(
 			md3dDevice, heapDesc
 		);
 
 		// Build Handle
-		for (std::string name : renderTargetsNeedDS) {
-			mRenderTargets[name]->SetDSVCPUHandle(mDSVHeap->GetCPUHandle(mDSVHeap->Alloc()));
+		for (UINT handle : renderTargetsNeedDS) {
+			mRenderTargets[handle]->SetDSVCPUHandle(mDSVHeap->GetCPUHandle(mDSVHeap->Alloc()));
 		}
 
 		for (auto& spotLight : mSpotLights)
@@ -570,7 +665,7 @@ void SceneGraphApp::BuildDescriptorHeaps()
 		// Build Descriptor Heap
 		D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
 		heapDesc.NumDescriptors = 
-			(UINT)mRenderTargets.size() 
+			mRenderTargets.GetNum() 
 			+ mSwapChain->GetSwapChainBufferCount() 
 			+ (UINT)mSpotLights.size()
 			+ (UINT)mDirLights.size()
@@ -578,13 +673,13 @@ void SceneGraphApp::BuildDescriptorHeaps()
 		heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
 		heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
 		heapDesc.NodeMask = 0;
-		mRTVHeap = std::make_unique<StaticDescriptorHeap>(
+		mRTVHeap = std::make_unique<DescriptorHeap>(
 			md3dDevice, heapDesc
 		);
 
 		// Build Handle
-		for (auto& pair : mRenderTargets) {
-			auto& renderTarget = pair.second;
+		for (UINT i = 0; i < mRenderTargets.GetNum(); i++) {
+			auto& renderTarget = mRenderTargets[i];
 			renderTarget->SetRTVCPUHandle(mRTVHeap->GetCPUHandle(mRTVHeap->Alloc()));
 		}
 		UINT index = mRTVHeap->Alloc(mSwapChain->GetSwapChainBufferCount());
@@ -605,23 +700,24 @@ void SceneGraphApp::BuildDescriptorHeaps()
 		D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
 		heapDesc.NumDescriptors = 
 			1
-			+ (UINT)mUABs.size()
-			+ (UINT)mRenderTargets.size() 
+			+ mUABs.GetNum()
+			+ mRenderTargets.GetNum() 
 			+ mSwapChain->GetSwapChainBufferCount() 
 			+ (UINT)mTextures.size() 
 			+ (UINT)mSpotLights.size()
 			+ (UINT)mDirLights.size()
-			+ (UINT)mPointLights.size();
+			+ (UINT)mPointLights.size()
+			+ TRANSIENT_DESCRIPTOR_NUM;
 		heapDesc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
 		heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
 		heapDesc.NodeMask = 0;
-		mCBVSRVUAVHeap = std::make_unique<StaticDescriptorHeap>(
-			md3dDevice, heapDesc
+		mCBVSRVUAVHeap = std::make_unique<DescriptorHeap>(
+			md3dDevice, heapDesc, TRANSIENT_DESCRIPTOR_NUM, gNumFrameResources
 		);
 
 		UINT index;
-		for (auto& pair : mRenderTargets) {
-			auto& renderTarget = pair.second;
+		for (UINT i = 0; i < mRenderTargets.GetNum(); i++) {
+			auto& renderTarget = mRenderTargets[i];
 			index = mCBVSRVUAVHeap->Alloc();
 			renderTarget->SetSRVCPUHandle(mCBVSRVUAVHeap->GetCPUHandle(index));
 			renderTarget->SetSRVGPUHandle(mCBVSRVUAVHeap->GetGPUHandle(index));
@@ -635,8 +731,8 @@ void SceneGraphApp::BuildDescriptorHeaps()
 		mZBufferSRVCPUHandle = mCBVSRVUAVHeap->GetCPUHandle(index);
 		mZBufferSRVGPUHandle = mCBVSRVUAVHeap->GetGPUHandle(index);
 
-		for (auto& pair : mUABs) {
-			auto& uab = pair.second;
+		for (UINT i = 0; i < mUABs.GetNum(); i++) {
+			auto& uab = mUABs[i];
 			index = mCBVSRVUAVHeap->Alloc();
 			uab->SetCPUHandle(mCBVSRVUAVHeap->GetCPUHandle(index));
 			uab->SetGPUHandle(mCBVSRVUAVHeap->GetGPUHandle(index));
@@ -667,13 +763,13 @@ void SceneGraphApp::BuildDescriptorHeaps()
 		heapDesc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
 		heapDesc.NodeMask = 0;
 
-		mCBVSRVUAVCPUHeap = std::make_unique<StaticDescriptorHeap>(
+		mCBVSRVUAVCPUHeap = std::make_unique<DescriptorHeap>(
 			md3dDevice, heapDesc
 		);
 
 		UINT index;
-		for (auto& pair : mUABs) {
-			auto& uab = pair.second;
+		for (UINT i = 0; i < mUABs.GetNum(); i++) {
+			auto& uab = mUABs[i];
 			index = mCBVSRVUAVCPUHeap->Alloc();
 			uab->SetCPUHandle_CPUHeap(mCBVSRVUAVCPUHeap->GetCPUHandle(index));
 		}
@@ -804,6 +900,16 @@ void SceneGraphApp::BuildRootSignature()
 		param.InitAsConstantBufferView(shaderRegister);
 		return param;
 	};
+	auto GetSRVParam = [](UINT shaderRegister, UINT registerSpace) {
+		CD3DX12_ROOT_PARAMETER param;
+		param.InitAsShaderResourceView(shaderRegister, registerSpace);
+		return param;
+	};
+	auto GetConstantsParam = [](UINT num32BitValues, UINT shaderRegister) {
+		CD3DX12_ROOT_PARAMETER param;
+		param.InitAsConstants(num32BitValues, shaderRegister);
+		return param;
+	};
 	auto GetTableParam = [](const std::vector<D3D12_DESCRIPTOR_RANGE>& ranges) {
 		CD3DX12_ROOT_PARAMETER param;
 		param.InitAsDescriptorTable(
@@ -818,17 +924,23 @@ void SceneGraphApp::BuildRootSignature()
 	// Shadow
 	{
 	/*
-		cb perObject;
+		c perDraw;
 		cb perPass;
+		srb objects;
+		srb instanceObjects;
 	*/
 		// Describe root parameters
 		UINT index = 0;
-		std::unordered_map<std::string, UINT> paramIndices;
+		Registry<UINT> paramIndices;
 		std::vector<CD3DX12_ROOT_PARAMETER> rootParams;
-		rootParams.push_back(GetCBVParam(0)); // 0
-		paramIndices["objectCB"] = index++;
+		rootParams.push_back(GetConstantsParam(1, 0)); // 0
+		paramIndices.Add("drawC") = index++;
 		rootParams.push_back(GetCBVParam(1)); // 1
-		paramIndices["passCB"] = index++;
+		paramIndices.Add("passCB") = index++;
+		rootParams.push_back(GetSRVParam(0, 4)); // 2
+		paramIndices.Add("objectSR") = index++;
+		rootParams.push_back(GetSRVParam(1, 4)); // 3
+		paramIndices.Add("instanceSR") = index++;
 
 		// Create desc for root signature
 		CD3DX12_ROOT_SIGNATURE_DESC rootSignDesc;
@@ -841,16 +953,18 @@ void SceneGraphApp::BuildRootSignature()
 		rootSignDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
 
 		// Serialize And Create RootSignature
-		mRootSigns["shadow"] = SerializeAndCreateRootSignature(md3dDevice, &rootSignDesc);
-		mRootSignParamIndices["shadow"] = paramIndices;
+		mRootSigns.Add("shadow") = SerializeAndCreateRootSignature(md3dDevice, &rootSignDesc);
+		mRootSignParamIndices.Add("shadow") = paramIndices;
 	}
 
 	// Standard
 	{
 	/*
-		cb perObject;
+		c perDraw;
 		cb perMaterial;
 		cb perPass;
+		srb objects;
+		srb instanceObjects;
 
 		uab<uint32> ncount;
 		srb zbuffer;
@@ -904,34 +1018,38 @@ void SceneGraphApp::BuildRootSignature()
 		}
 
 		UINT index = 0;
-		std::unordered_map<std::string, UINT> paramIndices;
+		Registry<UINT> paramIndices;
 		// Describe root parameters
 		std::vector<CD3DX12_ROOT_PARAMETER> rootParams;
-		rootParams.push_back(GetCBVParam(0)); // 0
-		paramIndices["objectCB"] = index++;
+		rootParams.push_back(GetConstantsParam(1, 0)); // 0
+		paramIndices.Add("drawC") = index++;
 		rootParams.push_back(GetCBVParam(1)); // 1
-		paramIndices["materialCB"] = index++;
+		paramIndices.Add("materialCB") = index++;
 		rootParams.push_back(GetCBVParam(2)); // 2
-		paramIndices["passCB"] = index++;
-		rootParams.push_back(GetTableParam(nCountUAVranges)); // 3
-		paramIndices["ncountUA"] = index++;
-		rootParams.push_back(GetTableParam(zbufferSRVranges)); // 5
-		paramIndices["zbufferSR"] = index++;
+		paramIndices.Add("passCB") = index++;
+		rootParams.push_back(GetSRVParam(0, 4)); // 3
+		paramIndices.Add("objectSR") = index++;
+		rootParams.push_back(GetSRVParam(1, 4)); // 4
+		paramIndices.Add("instanceSR") = index++;
+		rootParams.push_back(GetTableParam(nCountUAVranges)); // 5
+		paramIndices.Add("ncountUA") = index++;
+		rootParams.push_back(GetTableParam(zbufferSRVranges)); // 6
+		paramIndices.Add("zbufferSR") = index++;
 		if (texSRVranges.size()) {
-			rootParams.push_back(GetTableParam(texSRVranges)); // 5
-			paramIndices["texSR"] = index++;
+			rootParams.push_back(GetTableParam(texSRVranges)); // 7
+			paramIndices.Add("texSR") = index++;
 		}
 		if (spotShadowSRVranges.size()) {
-			rootParams.push_back(GetTableParam(spotShadowSRVranges)); // 6
-			paramIndices["spotShadowSR"] = index++;
+			rootParams.push_back(GetTableParam(spotShadowSRVranges)); // 8
+			paramIndices.Add("spotShadowSR") = index++;
 		}
 		if (dirShadowSRVranges.size()) {
-			rootParams.push_back(GetTableParam(dirShadowSRVranges)); // 7
-			paramIndices["dirShadowSR"] = index++;
+			rootParams.push_back(GetTableParam(dirShadowSRVranges)); // 9
+			paramIndices.Add("dirShadowSR") = index++;
 		}
 		if (pointShadowSRVranges.size()) {
-			rootParams.push_back(GetTableParam(pointShadowSRVranges)); // 8
-			paramIndices["pointShadowSR"] = index++;
+			rootParams.push_back(GetTableParam(pointShadowSRVranges)); // 10
+			paramIndices.Add("pointShadowSR") = index++;
 		}
 
 		// Create desc for root signature
@@ -945,8 +1063,8 @@ void SceneGraphApp::BuildRootSignature()
 		rootSignDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
 
 		// Serialize And Create RootSignature
-		mRootSigns["standard"] = SerializeAndCreateRootSignature(md3dDevice, &rootSignDesc);
-		mRootSignParamIndices["standard"] = paramIndices;
+		mRootSigns.Add("standard") = SerializeAndCreateRootSignature(md3dDevice, &rootSignDesc);
+		mRootSignParamIndices.Add("standard") = paramIndices;
 	}
 
 	/* Not using
@@ -967,14 +1085,14 @@ void SceneGraphApp::BuildRootSignature()
 
 		// Describe root parameters
 		UINT index = 0;
-		std::unordered_map<std::string, UINT> paramIndices;
+		Registry<UINT> paramIndices;
 		std::vector<CD3DX12_ROOT_PARAMETER> rootParams;
 		rootParams.push_back(GetCBVParam(0)); // 0
-		paramIndices["hbaoCB"] = index++;
+		paramIndices.Add("hbaoCB") = index++;
 		rootParams.push_back(GetTableParam(depthSRVranges)); // 3
-		paramIndices["depthSRV"] = index++;
+		paramIndices.Add("depthSRV") = index++;
 		rootParams.push_back(GetTableParam(colorSRVranges)); // 4
-		paramIndices["colorSRV"] = index++;
+		paramIndices.Add("colorSRV") = index++;
 
 		// Create desc for root signature
 		CD3DX12_ROOT_SIGNATURE_DESC rootSignDesc;
@@ -987,8 +1105,8 @@ void SceneGraphApp::BuildRootSignature()
 		rootSignDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
 
 		// Serialize And Create RootSignature
-		mRootSigns["hbao"] = SerializeAndCreateRootSignature(md3dDevice, &rootSignDesc);
-		mRootSignParamIndices["hbao"] = paramIndices;
+		mRootSigns.Add("hbao") = SerializeAndCreateRootSignature(md3dDevice, &rootSignDesc);
+		mRootSignParamIndices.Add("hbao") = paramIndices;
 	}
 	*/
 
@@ -1027,7 +1145,7 @@ void SceneGraphApp::BuildRootSignature()
 		rootSignDesc.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
 
 		// Serialize And Create RootSignature
-		mRootSigns["transBlend"] = SerializeAndCreateRootSignature(md3dDevice, &rootSignDesc);
+		mRootSigns.Add("transBlend") = SerializeAndCreateRootSignature(md3dDevice, &rootSignDesc);
 	}
 	*/
 
@@ -1047,12 +1165,12 @@ void SceneGraphApp::BuildRootSignature()
 
 		// Describe root parametes
 		int index = 0;
-		std::unordered_map<std::string, UINT> paramIndices;
+		Registry<UINT> paramIndices;
 		std::vector<D3D12_ROOT_PARAMETER> rootParams;
 		rootParams.push_back(GetCBVParam(0));
-		paramIndices["passCB"] = index++;
+		paramIndices.Add("passCB") = index++;
 		rootParams.push_back(GetTableParam(texSRVRanges));
-		paramIndices["texSR"] = index++;
+		paramIndices.Add("texSR") = index++;
 
 		// Create desc for root signature
 		CD3DX12_ROOT_SIGNATURE_DESC rootSignDesc;
@@ -1065,8 +1183,8 @@ void SceneGraphApp::BuildRootSignature()
 		);
 
 		// Serialize And Create RootSignature
-		mRootSigns["fxaa"] = SerializeAndCreateRootSignature(md3dDevice, &rootSignDesc);
-		mRootSignParamIndices["fxaa"] = paramIndices;
+		mRootSigns.Add("fxaa") = SerializeAndCreateRootSignature(md3dDevice, &rootSignDesc);
+		mRootSignParamIndices.Add("fxaa") = paramIndices;
 	}
 }
 
@@ -1155,7 +1273,7 @@ void SceneGraphApp::BuildPSOs()
 		mInputLayouts["standard"].data(),
 		(UINT)mInputLayouts["standard"].size() 
 	};
-	opaquePsoDesc.pRootSignature = mRootSigns["standard"].Get();
+	opaquePsoDesc.pRootSignature = mRootSigns.Get("standard").Get();
 	opaquePsoDesc.VS =
 	{
 		reinterpret_cast<BYTE*>(mShaders["vs"]->GetBufferPointer()),
@@ -1173,11 +1291,11 @@ void SceneGraphApp::BuildPSOs()
 	opaquePsoDesc.SampleMask = UINT_MAX;
 	opaquePsoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
 	opaquePsoDesc.NumRenderTargets = 1;
-	opaquePsoDesc.RTVFormats[0] = mRenderTargets["opaque"]->GetColorViewFormat();
+	opaquePsoDesc.RTVFormats[0] = mRenderTargets.Get("opaque")->GetColorViewFormat();
 	opaquePsoDesc.SampleDesc.Count = m4xMsaaState ? 4 : 1;
 	opaquePsoDesc.SampleDesc.Quality = m4xMsaaState ? (m4xMsaaQuality - 1) : 0;
-	opaquePsoDesc.DSVFormat = mRenderTargets["opaque"]->GetDepthStencilViewFormat();
-	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&opaquePsoDesc, IID_PPV_ARGS(&mPSOs["opaque"])));
+	opaquePsoDesc.DSVFormat = mRenderTargets.Get("opaque")->GetDepthStencilViewFormat();
+	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&opaquePsoDesc, IID_PPV_ARGS(&mPSOs.Add("opaque"))));
 
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC dispOpaquePsoDesc = opaquePsoDesc;
 	dispOpaquePsoDesc.HS =
@@ -1191,7 +1309,7 @@ void SceneGraphApp::BuildPSOs()
 		mShaders["dispDS"]->GetBufferSize()
 	};
 	dispOpaquePsoDesc.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_PATCH;
-	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&dispOpaquePsoDesc, IID_PPV_ARGS(&mPSOs["dispOpaque"])));
+	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&dispOpaquePsoDesc, IID_PPV_ARGS(&mPSOs.Add("dispOpaque"))));
 
 	/*
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC transPsoDesc = opaquePsoDesc;
@@ -1209,15 +1327,15 @@ void SceneGraphApp::BuildPSOs()
 	transPsoDesc.BlendState.RenderTarget[0].BlendOpAlpha = D3D12_BLEND_OP_ADD;
 	transPsoDesc.BlendState.RenderTarget[0].DestBlendAlpha = D3D12_BLEND_DEST_ALPHA;
 	transPsoDesc.BlendState.RenderTarget[0].SrcBlendAlpha = D3D12_BLEND_SRC_ALPHA;
-	transPsoDesc.RTVFormats[0] = mRenderTargets["trans"]->GetColorViewFormat();
-	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&transPsoDesc, IID_PPV_ARGS(&mPSOs["trans"])));
+	transPsoDesc.RTVFormats[0] = mRenderTargets.Get("trans")->GetColorViewFormat();
+	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&transPsoDesc, IID_PPV_ARGS(&mPSOs.Add("trans"))));
 
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC transBlendPsoDesc = opaquePsoDesc;
 	transBlendPsoDesc.InputLayout = { 
 		mInputLayouts["onlyPos"].data(), 
 		(UINT)mInputLayouts["onlyPos"].size() 
 	};
-	transBlendPsoDesc.pRootSignature = mRootSigns["transBlend"].Get();
+	transBlendPsoDesc.pRootSignature = mRootSigns.Get("transBlend").Get();
 	transBlendPsoDesc.VS =
 	{
 		reinterpret_cast<BYTE*>(mShaders["simpleVS"]->GetBufferPointer()),
@@ -1229,18 +1347,18 @@ void SceneGraphApp::BuildPSOs()
 		mShaders["transBlendPS"]->GetBufferSize()
 	};
 	transBlendPsoDesc.DepthStencilState.DepthEnable = false;
-	transBlendPsoDesc.RTVFormats[0] = mRenderTargets["transBlend"]->GetColorViewFormat();
-	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&transBlendPsoDesc, IID_PPV_ARGS(&mPSOs["transBlend"])));
+	transBlendPsoDesc.RTVFormats[0] = mRenderTargets.Get("transBlend")->GetColorViewFormat();
+	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&transBlendPsoDesc, IID_PPV_ARGS(&mPSOs.Add("transBlend"))));
 
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC hbaoPsoDesc = transBlendPsoDesc;
-	hbaoPsoDesc.pRootSignature = mRootSigns["hbao"].Get();
+	hbaoPsoDesc.pRootSignature = mRootSigns.Get("hbao").Get();
 	hbaoPsoDesc.PS =
 	{
 		reinterpret_cast<BYTE*>(mShaders["hbaoPS"]->GetBufferPointer()),
 		mShaders["hbaoPS"]->GetBufferSize()
 	};
-	hbaoPsoDesc.RTVFormats[0] = mRenderTargets["hbao"]->GetColorViewFormat();
-	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&hbaoPsoDesc, IID_PPV_ARGS(&mPSOs["hbao"])));
+	hbaoPsoDesc.RTVFormats[0] = mRenderTargets.Get("hbao")->GetColorViewFormat();
+	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&hbaoPsoDesc, IID_PPV_ARGS(&mPSOs.Add("hbao"))));
 	*/
 
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC fxaaPsoDesc = opaquePsoDesc;
@@ -1248,7 +1366,7 @@ void SceneGraphApp::BuildPSOs()
 		mInputLayouts["onlyPos"].data(), 
 		(UINT)mInputLayouts["onlyPos"].size() 
 	};
-	fxaaPsoDesc.pRootSignature = mRootSigns["fxaa"].Get();
+	fxaaPsoDesc.pRootSignature = mRootSigns.Get("fxaa").Get();
 	fxaaPsoDesc.VS =
 	{
 		reinterpret_cast<BYTE*>(mShaders["simpleVS"]->GetBufferPointer()),
@@ -1260,17 +1378,17 @@ void SceneGraphApp::BuildPSOs()
 		mShaders["fxaaPS"]->GetBufferSize()
 	};
 	fxaaPsoDesc.DepthStencilState.DepthEnable = false;
-	fxaaPsoDesc.RTVFormats[0] = mRenderTargets["fxaa"]->GetColorViewFormat();
+	fxaaPsoDesc.RTVFormats[0] = mRenderTargets.Get("fxaa")->GetColorViewFormat();
 	fxaaPsoDesc.SampleDesc.Count = 1;
 	fxaaPsoDesc.SampleDesc.Quality = 0;
-	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&fxaaPsoDesc, IID_PPV_ARGS(&mPSOs["fxaa"])));
+	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&fxaaPsoDesc, IID_PPV_ARGS(&mPSOs.Add("fxaa"))));
 
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC shadowPsoDesc = opaquePsoDesc;
 	shadowPsoDesc.InputLayout = {
 		mInputLayouts["onlyPos"].data(),
 		(UINT)mInputLayouts["onlyPos"].size()
 	};
-	shadowPsoDesc.pRootSignature = mRootSigns["shadow"].Get();
+	shadowPsoDesc.pRootSignature = mRootSigns.Get("shadow").Get();
 	shadowPsoDesc.VS = {
 		reinterpret_cast<BYTE*>(mShaders["shadowVS"]->GetBufferPointer()),
 		mShaders["shadowVS"]->GetBufferSize()
@@ -1284,7 +1402,7 @@ void SceneGraphApp::BuildPSOs()
 	shadowPsoDesc.SampleDesc.Count = 1;
 	shadowPsoDesc.SampleDesc.Quality = 0;
 	shadowPsoDesc.DSVFormat = SHADOW_DSV_VIEW_FORMAT;
-	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&shadowPsoDesc, IID_PPV_ARGS(&mPSOs["shadow"])));
+	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&shadowPsoDesc, IID_PPV_ARGS(&mPSOs.Add("shadow"))));
 
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC pointShadowPsoDesc = shadowPsoDesc;
 	pointShadowPsoDesc.VS = {
@@ -1295,16 +1413,59 @@ void SceneGraphApp::BuildPSOs()
 		reinterpret_cast<BYTE*>(mShaders["pointShadowPS"]->GetBufferPointer()),
 		mShaders["pointShadowPS"]->GetBufferSize()
 	};
-	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&pointShadowPsoDesc, IID_PPV_ARGS(&mPSOs["pointShadow"])));
+	ThrowIfFailed(md3dDevice->CreateGraphicsPipelineState(&pointShadowPsoDesc, IID_PPV_ARGS(&mPSOs.Add("pointShadow"))));
+}
+
+void SceneGraphApp::ResolveDrawHandles()
+{
+	auto& handles = mDrawHandles;
+
+	// Render Targets & UABs
+	handles.OpaqueRT = mRenderTargets.GetHandle("opaque");
+	handles.AfterResolveRT = mRenderTargets.GetHandle("afterResolve");
+	handles.FxaaRT = mRenderTargets.GetHandle("fxaa");
+	handles.NCountUAB = mUABs.GetHandle("nCount");
+
+	// Root Signatures & PSOs
+	handles.ShadowRootSign = mRootSigns.GetHandle("shadow");
+	handles.StandardRootSign = mRootSigns.GetHandle("standard");
+	handles.FxaaRootSign = mRootSigns.GetHandle("fxaa");
+	handles.ShadowPSO = mPSOs.GetHandle("shadow");
+	handles.PointShadowPSO = mPSOs.GetHandle("pointShadow");
+	handles.OpaquePSO = mPSOs.GetHandle("opaque");
+	handles.FxaaPSO = mPSOs.GetHandle("fxaa");
+
+	// Root Parameters, tables of absent resources are optional
+	const auto& shadowPI = mRootSignParamIndices.Get("shadow");
+	handles.ShadowParams.DrawC = shadowPI.Get("drawC");
+	handles.ShadowParams.PassCB = shadowPI.Get("passCB");
+	handles.ShadowParams.ObjectSR = shadowPI.Get("objectSR");
+	handles.ShadowParams.InstanceSR = shadowPI.Get("instanceSR");
+
+	const auto& standardPI = mRootSignParamIndices.Get("standard");
+	handles.StandardParams.DrawC = standardPI.Get("drawC");
+	handles.StandardParams.MaterialCB = standardPI.Get("materialCB");
+	handles.StandardParams.PassCB = standardPI.Get("passCB");
+	handles.StandardParams.ObjectSR = standardPI.Get("objectSR");
+	handles.StandardParams.InstanceSR = standardPI.Get("instanceSR");
+	handles.StandardParams.NCountUA = standardPI.Get("ncountUA");
+	handles.StandardParams.ZBufferSR = standardPI.Get("zbufferSR");
+	handles.StandardParams.TexSR = standardPI.GetOr("texSR", NO_ROOT_PARAM);
+	handles.StandardParams.SpotShadowSR = standardPI.GetOr("spotShadowSR", NO_ROOT_PARAM);
+	handles.StandardParams.DirShadowSR = standardPI.GetOr("dirShadowSR", NO_ROOT_PARAM);
+	handles.StandardParams.PointShadowSR = standardPI.GetOr("pointShadowSR", NO_ROOT_PARAM);
+
+	const auto& fxaaPI = mRootSignParamIndices.Get("fxaa");
+	handles.FxaaParams.PassCB = fxaaPI.Get("passCB");
+	handles.FxaaParams.TexSR = fxaaPI.Get("texSR");
 }
 
 void SceneGraphApp::LoadTextures()
 {
-	CD3DX12_CPU_DESCRIPTOR_HANDLE handle(mTexCPUHandleStart);
-	for (UINT i = 0; i < Texture::GetTotalNum(); i++) {
-		auto tex = Texture::FindByID(i);
+	for (auto tex : Texture::GetRegistry()) {
+		CD3DX12_CPU_DESCRIPTOR_HANDLE handle(mTexCPUHandleStart);
+		handle.Offset(tex->GetSlotIndex(), mCbvSrvUavDescriptorSize);
 		tex->LoadAndCreateSRV(md3dDevice, mCommandList, handle);
-		handle.Offset(mCbvSrvUavDescriptorSize);
 	}
 }
 
@@ -1313,14 +1474,6 @@ void SceneGraphApp::BuildPassConstants()
 	mPassConstants = std::make_unique<PassConstants>();
 }
 
-void SceneGraphApp::BuildPassConstantBuffers()
-{
-	mPassConstantsBuffers = std::make_unique<UploadBuffer<PassConstants::Content>>(
-		md3dDevice.Get(), 
-		PassConstants::getTotalNum(), true
-	);
-}
-
 void SceneGraphApp::UpdateLightsInPassConstantBuffers()
 {
 	// Check light num
@@ -1338,15 +1491,19 @@ void SceneGraphApp::UpdateLightsInPassConstantBuffers()
 	// direction lights
 	content.LightPerTypeNum.x = static_cast<UINT32>(mDirLights.size());
 
-	// point lights
-	for (unsigned int i = 0; i < mPointLights.size(); i++)
-		content.PointLights[i] = mPointLights[i].ToContent();
-	content.LightPerTypeNum.y = static_cast<UINT32>(mPointLights.size());
+	// point lights, only visible ones are packed
+	UINT32 lightNum = 0;
+	for (auto& pointLight : mPointLights)
+		if (pointLight.Visible)
+			content.PointLights[lightNum++] = pointLight.ToContent();
+	content.LightPerTypeNum.y = lightNum;
 
 	// spot lights
-	for (unsigned int i = 0; i < mSpotLights.size(); i++)
-		content.SpotLights[i] = mSpotLights[i].ToContent();
-	content.LightPerTypeNum.z = static_cast<UINT32>(mSpotLights.size());
+	lightNum = 0;
+	for (auto& spotLight : mSpotLights)
+		if (spotLight.Visible)
+			content.SpotLights[lightNum++] = spotLight.ToContent();
+	content.LightPerTypeNum.z = lightNum;
 
 	// area lights
 	for (unsigned int i = 0; i < mRectLights.size(); i++)
@@ -1496,8 +1653,8 @@ void SceneGraphApp::BuildManualMaterials()
 	defaultMtl->mBaseColor = { 0.972f, 0.960f, 0.915f, 1.0f }; // silver
 	defaultMtl->mMetalness = 1.0f;
 	defaultMtl->mRoughness = 0.5f;
-	defaultMtl->mLTCMatTexID = Texture::FindByName("ggx_ltc_mat")->GetID();
-	defaultMtl->mLTCAmpTexID = Texture::FindByName("ggx_ltc_amp")->GetID();
+	defaultMtl->mLTCMatTexID = Texture::FindByName("ggx_ltc_mat")->GetSlotIndex();
+	defaultMtl->mLTCAmpTexID = Texture::FindByName("ggx_ltc_amp")->GetSlotIndex();
 	mMaterials.push_back(defaultMtl);
 	Material::SetDefaultMaterialID(defaultMtl->GetID());
 
@@ -1548,10 +1705,9 @@ void SceneGraphApp::BuildAndUpdateMaterialConstantBuffers()
 	);
 	
 	// Update Buffers
-	for (UINT id = 0; id < Material::GetTotalNum(); id++) {
-		auto mtl = Material::FindObjectByID(id);
+	for (auto mtl : Material::GetRegistry()) {
 		mMaterialConstantsBuffers->CopyData(
-			id,
+			mtl->GetSlotIndex(),
 			mtl->ToContent()
 		);
 	}
@@ -1739,10 +1895,34 @@ void SceneGraphApp::BuildRenderItems()
 
 void SceneGraphApp::BuildObjectConstantBuffers()
 {
-	mObjectConstantsBuffers = std::make_unique<UploadBuffer<Object::Content>>(
-		md3dDevice.Get(), 
-		Object::GetTotalNum(), true
+	for (auto& frame : mFrameResources)
+		BuildObjectConstantBuffer(*frame, Object::GetTotalNum());
+
+	// The dirty state of the first update is consumed while building the scene bvh,
+	// upload every object once to every frame resource
+	mRootObject->Traverse([this](Object& obj) {
+		MarkObjectChanged(obj.GetID());
+		return VisitResult::Continue;
+	});
+}
+
+void SceneGraphApp::BuildObjectConstantBuffer(FrameResource& frame, UINT slotNum)
+{
+	// Read as a structured buffer, elements must not be padded
+	frame.ObjectConstantsBuffer = std::make_unique<UploadBuffer<Object::Content>>(
+		md3dDevice.Get(),
+		MathHelper::Max(slotNum, 1u), false
 	);
+	frame.ObjectSlotNum = MathHelper::Max(slotNum, 1u);
+}
+
+void SceneGraphApp::MarkObjectChanged(UINT objectID)
+{
+	UINT slot = SlotIndex(objectID);
+	if (slot >= mObjectIDsBySlot.size())
+		mObjectIDsBySlot.resize(slot + 1, INVALID_OBJECT_ID);
+	mObjectIDsBySlot[slot] = objectID;
+	mObjectChanges.MarkChanged(slot);
 }
 
 void SceneGraphApp::InitHbao()
@@ -1753,12 +1933,6 @@ void SceneGraphApp::InitHbao()
 	// Init constants
 	auto& content = mHbaoConstants->content;
 	// TODO now is empty
-
-	// Create buffer
-	mHbaoConstantsBuffers = std::make_unique<UploadBuffer<HbaoConstants::Content>>(
-		md3dDevice.Get(), 
-		HbaoConstants::getTotalNum(), true
-	);
 }
 
 void SceneGraphApp::InitFxaa()
@@ -1783,12 +1957,6 @@ void SceneGraphApp::InitFxaa()
 	content.ConsoleEdgeThreshold = consoleEdgeThreshold;
 	content.ConsoleEdgeThresholdMin = consoleEdgeThresholdMin;
 	content.Console360ConstDir = { 0.0f, 0.0f, 0.0f, 0.0f };
-
-	// Create buffer
-	mFxaaConstantsBuffers = std::make_unique<UploadBuffer<FxaaConstants::Content>>(
-		md3dDevice.Get(), 
-		FxaaConstants::getTotalNum(), true
-	);
 }
 
 void SceneGraphApp::ResizeScreenUAVSRV()
@@ -1802,13 +1970,13 @@ void SceneGraphApp::ResizeScreenUAVSRV()
 		desc.Height = mClientHeight;
 		desc.DepthOrArraySize = 1;
 		desc.MipLevels = 1;
-		desc.Format = mUABs["nCount"]->GetViewFormat();
+		desc.Format = mUABs.Get("nCount")->GetViewFormat();
 		desc.SampleDesc.Count = 1;
 		desc.SampleDesc.Quality = 0;
 		desc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
 		desc.Flags = D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
 
-		mUABs["nCount"]->Resize(md3dDevice, &desc);
+		mUABs.Get("nCount")->Resize(md3dDevice, &desc);
 	}
 
 	// ZBuffer SRV
@@ -1857,46 +2025,40 @@ void SceneGraphApp::ResizeRenderTargets()
 	opaqueDesc.Height = mClientHeight;
 	opaqueDesc.DepthOrArraySize = 1;
 	opaqueDesc.MipLevels = 1;
-	opaqueDesc.Format = mRenderTargets["opaque"]->GetColorViewFormat();
+	opaqueDesc.Format = mRenderTargets.Get("opaque")->GetColorViewFormat();
 	opaqueDesc.SampleDesc.Count = m4xMsaaState ? 4 : 1;
 	opaqueDesc.SampleDesc.Quality = m4xMsaaState ? m4xMsaaQuality-1 : 0;
 	opaqueDesc.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN;
 	opaqueDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
 
 	D3D12_RESOURCE_DESC opaqueDSDesc = opaqueDesc;
-	opaqueDSDesc.Format = mRenderTargets["opaque"]->GetDepthStencilResourceFormat();
+	opaqueDSDesc.Format = mRenderTargets.Get("opaque")->GetDepthStencilResourceFormat();
     opaqueDSDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
 
-	mRenderTargets["opaque"]->Resize(
-		md3dDevice,
-		&opaqueDesc,
-		&opaqueDSDesc
-	);
-
 	/*
 	// Transparent Rendering
 	D3D12_RESOURCE_DESC transDesc = opaqueDesc;
-	transDesc.Format = mRenderTargets["trans"]->GetColorViewFormat();
+	transDesc.Format = mRenderTargets.Get("trans")->GetColorViewFormat();
 
-	mRenderTargets["trans"]->Resize(
+	mRenderTargets.Get("trans")->Resize(
 		md3dDevice,
 		&transDesc
 	);
 
 	// Transparent Blending
 	D3D12_RESOURCE_DESC transBlendDesc = opaqueDesc;
-	transBlendDesc.Format = mRenderTargets["transBlend"]->GetColorViewFormat();
+	transBlendDesc.Format = mRenderTargets.Get("transBlend")->GetColorViewFormat();
 
-	mRenderTargets["transBlend"]->Resize(
+	mRenderTargets.Get("transBlend")->Resize(
 		md3dDevice,
 		&transBlendDesc
 	);
 
 	// HBAO
 	D3D12_RESOURCE_DESC hbaoDesc = transBlendDesc;
-	hbaoDesc.Format = mRenderTargets["hbao"]->GetColorViewFormat();
+	hbaoDesc.Format = mRenderTargets.Get("hbao")->GetColorViewFormat();
 
-	mRenderTargets["hbao"]->Resize(
+	mRenderTargets.Get("hbao")->Resize(
 		md3dDevice,
 		&hbaoDesc
 	);
@@ -1904,28 +2066,77 @@ void SceneGraphApp::ResizeRenderTargets()
 
 	// After Resolve
 	D3D12_RESOURCE_DESC afterResolveDesc = opaqueDesc;
-	afterResolveDesc.Format = mRenderTargets["afterResolve"]->GetColorViewFormat();
+	afterResolveDesc.Format = mRenderTargets.Get("afterResolve")->GetColorViewFormat();
 	afterResolveDesc.SampleDesc.Count = 1;
 	afterResolveDesc.SampleDesc.Quality = 0;
 
-	mRenderTargets["afterResolve"]->Resize(
-		md3dDevice,
-		&afterResolveDesc
-	);
-
 	// Fxaa
 	D3D12_RESOURCE_DESC fxaaDesc = afterResolveDesc;
-	fxaaDesc.Format = mRenderTargets["fxaa"]->GetColorViewFormat();
+	fxaaDesc.Format = mRenderTargets.Get("fxaa")->GetColorViewFormat();
 
 	D3D12_RESOURCE_DESC fxaaDSDesc = opaqueDSDesc;
-	fxaaDSDesc.Format = mRenderTargets["fxaa"]->GetDepthStencilResourceFormat();
+	fxaaDSDesc.Format = mRenderTargets.Get("fxaa")->GetDepthStencilResourceFormat();
 	fxaaDSDesc.SampleDesc.Count = 1;
     fxaaDSDesc.SampleDesc.Quality = 0;
 
-	mRenderTargets["fxaa"]->Resize(
+	// Lifetimes in the passes of a frame with the current settings, the graph is
+	// only compiled here, its resources are not touched
+	BuildRenderGraph();
+	const SceneResources& targets = mSceneResources;
+	const UINT TARGET_NUM = 5;
+	UINT graphResources[TARGET_NUM] = {
+		targets.OpaqueColor, targets.OpaqueDepth, targets.AfterResolve, targets.FxaaColor, targets.FxaaDepth
+	};
+	D3D12_RESOURCE_DESC* descs[TARGET_NUM] = {
+		&opaqueDesc, &opaqueDSDesc, &afterResolveDesc, &fxaaDesc, &fxaaDSDesc
+	};
+
+	// Pack the targets alive in different passes into the same memory
+	mRenderTargetPacker.Clear();
+	for (UINT i = 0; i < TARGET_NUM; i++) {
+		D3D12_RESOURCE_ALLOCATION_INFO info = md3dDevice->GetResourceAllocationInfo(0, 1, descs[i]);
+		UINT firstPass = mRenderGraph.GetFirstPass(graphResources[i]);
+		UINT lastPass = mRenderGraph.GetLastPass(graphResources[i]);
+		if (firstPass == INVALID_GRAPH_ID) {
+			// Unused with these settings, shares memory with anything
+			firstPass = 1;
+			lastPass = 0;
+		}
+		mRenderTargetPacker.AddResource(info.SizeInBytes, info.Alignment, firstPass, lastPass);
+	}
+	mRenderTargetPacker.Pack();
+
+	D3D12_HEAP_DESC heapDesc = {};
+	heapDesc.SizeInBytes = mRenderTargetPacker.GetHeapSize();
+	heapDesc.Properties = CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT);
+	heapDesc.Alignment = m4xMsaaState ?
+		D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+	heapDesc.Flags = D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+	ThrowIfFailed(md3dDevice->CreateHeap(
+		&heapDesc,
+		IID_PPV_ARGS(mRenderTargetHeap.ReleaseAndGetAddressOf())
+	));
+
+	// Place Render Targets
+	ID3D12Heap* heap = mRenderTargetHeap.Get();
+	auto& packer = mRenderTargetPacker;
+	mRenderTargets.Get("opaque")->Resize(
+		md3dDevice,
+		&opaqueDesc,
+		&opaqueDSDesc,
+		heap, packer.GetOffset(0), packer.GetOffset(1)
+	);
+	mRenderTargets.Get("afterResolve")->Resize(
+		md3dDevice,
+		&afterResolveDesc,
+		nullptr,
+		heap, packer.GetOffset(2)
+	);
+	mRenderTargets.Get("fxaa")->Resize(
 		md3dDevice,
 		&fxaaDesc,
-		&fxaaDSDesc
+		&fxaaDSDesc,
+		heap, packer.GetOffset(3), packer.GetOffset(4)
 	);
 
 	// Swap Chain
@@ -2016,7 +2227,8 @@ void SceneGraphApp::OnMsaaStateChange()
 
 void SceneGraphApp::OnFxaaStateChange()
 {
-	// Do nothing.
+	// Targets are placed by their lifetimes, which change with FXAA
+	OnResize();
 }
 
 void SceneGraphApp::OnResize()
@@ -2033,6 +2245,26 @@ void SceneGraphApp::OnResize()
 	ResizeShadowRenderTargets();
 	ResizeFxaa();
 
+	// Put new resources in the states the render graph expects them to rest in between frames
+	std::vector<CD3DX12_RESOURCE_BARRIER> restBarriers;
+	restBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
+		mZBufferResource.Get(),
+		D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
+	));
+	auto restShadowMap = [&restBarriers](ID3D12Resource* resource) {
+		restBarriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(
+			resource,
+			D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
+		));
+	};
+	for (auto& light : mDirLights)
+		restShadowMap(light.ShadowRT->GetColorResource());
+	for (auto& light : mSpotLights)
+		restShadowMap(light.ShadowRT->GetColorResource());
+	for (auto& light : mPointLights)
+		restShadowMap(light.ShadowRT->GetColorResource());
+	mCommandList->ResourceBarrier(static_cast<UINT>(restBarriers.size()), restBarriers.data());
+
 	// Execute the resize commands.
 	ThrowIfFailed(mCommandList->Close());
 	ID3D12CommandList* cmdsLists[] = { mCommandList.Get() };
@@ -2051,6 +2283,13 @@ void SceneGraphApp::Update(const GameTimer& gt)
 {
 	// Notice: Be careful, matrix need transpose.
 
+	// Move to the next frame resource, waiting only if the GPU still reads it
+	UINT frameIndex = mFrameRing->BeginFrame();
+	mCurrFrameResource = mFrameResources[frameIndex].get();
+	// Descriptors of the last frame recorded into this frame resource are free again
+	mCBVSRVUAVHeap->BeginFrame(frameIndex);
+	mUploadRing->BeginFrame(frameIndex);
+
 	float screenWidthHeightAspect = static_cast<float>(mClientWidth) / static_cast<float>(mClientHeight);
 
 	// Update Dir Lights' Box
@@ -2072,6 +2311,12 @@ void SceneGraphApp::Update(const GameTimer& gt)
 		);
 	}
 
+	// Visible Light Determination
+	CullLights(
+		mCamera.GetViewMatrix() * mCamera.GetOrthoProjMatrix(screenWidthHeightAspect)
+	);
+	UpdateLightsInPassConstantBuffers();
+
 	// Update Pass Constants
 	{
 		auto& content = mPassConstants->content;
@@ -2105,7 +2350,10 @@ void SceneGraphApp::Update(const GameTimer& gt)
 
 	// Upload Pass Constant
 	{
-		mPassConstantsBuffers->CopyData(
+		mCurrFrameResource->PassConstantsBuffer = mUploadRing->AllocArray<PassConstants::Content>(
+			PassConstants::getTotalNum(), true
+		);
+		mCurrFrameResource->PassConstantsBuffer.CopyData(
 			mPassConstants->getID(),
 			mPassConstants->content
 		);
@@ -2113,22 +2361,25 @@ void SceneGraphApp::Update(const GameTimer& gt)
 
 	// Upload Shadow Pass Constant
 	{
+		mCurrFrameResource->ShadowPassConstantsBuffer = mUploadRing->AllocArray<ShadowPassConstants::Content>(
+			ShadowPassConstants::getTotalNum(), true
+		);
 		for (auto& dirLight : mDirLights) {
-			mShadowPassConstantsBuffers->CopyData(
+			mCurrFrameResource->ShadowPassConstantsBuffer.CopyData(
 				dirLight.PassConstants->getID(),
 				dirLight.PassConstants->content
 			);
 		}
 		for (auto& pointLight : mPointLights) {
 			for (UINT i = 0; i < 6; i++) {
-				mShadowPassConstantsBuffers->CopyData(
+				mCurrFrameResource->ShadowPassConstantsBuffer.CopyData(
 					pointLight.PassConstantsArray[i]->getID(),
 					pointLight.PassConstantsArray[i]->content
 				);
 			}
 		}
 		for (auto& spotLight : mSpotLights) {
-			mShadowPassConstantsBuffers->CopyData(
+			mCurrFrameResource->ShadowPassConstantsBuffer.CopyData(
 				spotLight.PassConstants->getID(),
 				spotLight.PassConstants->content
 			);
@@ -2137,24 +2388,67 @@ void SceneGraphApp::Update(const GameTimer& gt)
 
 	// Upload Object Constant
 	{
-		auto buffer = mObjectConstantsBuffers.get();
-		std::function<void(std::shared_ptr<Object>)> iterFunc;
-		iterFunc = [buffer, &iterFunc](std::shared_ptr<Object> root) {
-			buffer->CopyData(
-				root->GetID(),
-				root->ToContent()
-			);
-			for (auto& child : root->GetChilds())
-				iterFunc(child);
-		};
+		Object::UpdateGlobalModelMats(mJobSystem.get());
+		mRecomputedObjectIDs.clear();
+		Object::GetRecomputedObjects(mRecomputedObjectIDs);
+
+		// Refit only the BVH leaves of moved objects, objects new to it wait for a rebuild
+		if (!mRecomputedObjectIDs.empty()) {
+			mSceneBvh.Update(mRecomputedObjectIDs, [](UINT id, BoundingBox& bounds) {
+				Object* obj = Object::FindObjectByID(id);
+				if (!obj || !obj->HasBounds())
+					return false;
+				bounds = obj->GetWorldBounds();
+				return true;
+			});
+		}
 
-		mRootObject->UpdateGlobalModelMatRecursively();
-		iterFunc(mRootObject);
+		// Only objects whose matrices were recomputed, in one copy per run of slots
+		for (UINT id : mRecomputedObjectIDs)
+			MarkObjectChanged(id);
+
+		// Objects created after the buffer of this frame resource was built have slots
+		// beyond it. The GPU is done with this frame resource, replace its buffer with
+		// a larger one; the others grow when they come round. A new buffer holds
+		// nothing yet, so every object is uploaded again.
+		UINT slotNum = static_cast<UINT>(mObjectIDsBySlot.size());
+		if (slotNum > mCurrFrameResource->ObjectSlotNum) {
+			BuildObjectConstantBuffer(*mCurrFrameResource, MathHelper::Max(slotNum, mCurrFrameResource->ObjectSlotNum * 2));
+			for (UINT slot = 0; slot < slotNum; slot++)
+				if (mObjectIDsBySlot[slot] != INVALID_OBJECT_ID)
+					mObjectChanges.MarkChanged(slot);
+		}
+		UINT writtenNum = mObjectChanges.Flush([this](UINT firstSlot, UINT slotNum) {
+			mObjectContents.resize(slotNum);
+			for (UINT i = 0; i < slotNum; i++) {
+				Object* obj = Object::FindObjectByID(mObjectIDsBySlot[firstSlot + i]);
+				mObjectContents[i] = obj ? obj->ToContent() : Object::Content();
+			}
+			mCurrFrameResource->ObjectConstantsBuffer->CopyData(firstSlot, mObjectContents.data(), slotNum);
+		});
+		mObjectUploadBytes = static_cast<UINT64>(writtenNum) * sizeof(Object::Content);
 	}
 
+	// Frustum Culling
+	CullRenderItems(
+		mCamera.GetViewMatrix() * mCamera.GetOrthoProjMatrix(screenWidthHeightAspect),
+		mVisibleOpaqueRenderItemQueue
+	);
+	mCulledNum = static_cast<UINT>(mOpaqueRenderItemQueue.size() - mVisibleOpaqueRenderItemQueue.size());
+	CullOccludedRenderItems(
+		mCamera.GetViewMatrix() * mCamera.GetOrthoProjMatrix(screenWidthHeightAspect)
+	);
+	CullShadowCasters();
+	SelectLods(mCamera.GetViewMatrix(), mCamera.GetOrthoProjMatrix(screenWidthHeightAspect));
+	SortRenderQueues();
+	BuildInstanceBatches();
+
 	// Upload Hbao Constant
 	{
-		mHbaoConstantsBuffers->CopyData(
+		mCurrFrameResource->HbaoConstantsBuffer = mUploadRing->AllocArray<HbaoConstants::Content>(
+			HbaoConstants::getTotalNum(), true
+		);
+		mCurrFrameResource->HbaoConstantsBuffer.CopyData(
 			mHbaoConstants->getID(),
 			mHbaoConstants->content
 		);
@@ -2162,13 +2456,261 @@ void SceneGraphApp::Update(const GameTimer& gt)
 
 	// Upload Fxaa Constant
 	{
-		mFxaaConstantsBuffers->CopyData(
+		mCurrFrameResource->FxaaConstantsBuffer = mUploadRing->AllocArray<FxaaConstants::Content>(
+			FxaaConstants::getTotalNum(), true
+		);
+		mCurrFrameResource->FxaaConstantsBuffer.CopyData(
 			mFxaaConstants->getID(),
 			mFxaaConstants->content
 		);
 	}
 }
 
+void SceneGraphApp::CullRenderItems(FXMMATRIX viewProj, std::vector<std::shared_ptr<RenderItem>>& queue)
+{
+	Frustum frustum(viewProj);
+
+	// Items without bounds aren't in the BVH and are always drawn
+	queue.clear();
+	for (auto& renderItem : mOpaqueRenderItemQueue) {
+		Object* obj = Object::FindObjectByID(renderItem->ObjectID);
+		if (!obj || !obj->HasBounds())
+			queue.push_back(renderItem);
+	}
+	mSceneBvh.QueryFrustum(frustum, [&queue](UINT objectID) {
+		Object* obj = Object::FindObjectByID(objectID);
+		if (!obj)
+			return;
+		for (auto& renderItem : obj->GetRenderItems())
+			queue.push_back(renderItem);
+	});
+}
+
+void XM_CALLCONV SceneGraphApp::SelectLods(FXMMATRIX view, CXMMATRIX proj)
+{
+	// Size on screen of a unit radius at view depth 1, perspective projections divide by depth
+	float projScale = XMVectorGetY(proj.r[1]);
+	bool perspective = XMVectorGetW(proj.r[3]) != 1.0f;
+	auto Threshold = [](UINT lod) {
+		return LOD_SCREEN_SIZE * powf(0.5f, static_cast<float>(lod) - 1.0f);
+	};
+
+	// Shadow views draw items outside the camera frustum too, so every item gets a level
+	for (auto& renderItem : mOpaqueRenderItemQueue) {
+		Object* obj = Object::FindObjectByID(renderItem->ObjectID);
+		Mesh* mesh = Mesh::FindObjectByID(renderItem->MeshID);
+		if (!obj || !obj->HasBounds() || !mesh) {
+			renderItem->Lod = 0;
+			continue;
+		}
+		BoundingSphere sphere = obj->GetWorldBoundingSphere();
+		float size = sphere.Radius * projScale;
+		if (perspective) {
+			float depth = XMVectorGetZ(XMVector3TransformCoord(XMLoadFloat3(&sphere.Center), view));
+			size = depth > sphere.Radius ? size / depth : FLT_MAX;
+		}
+
+		// Move one level at a time only once the size is clearly past the switch
+		UINT lodNum = mesh->GetLodNum();
+		UINT lod = MathHelper::Min(renderItem->Lod, lodNum - 1);
+		while (lod > 0 && size > Threshold(lod) * (1.0f + LOD_HYSTERESIS))
+			lod--;
+		while (lod + 1 < lodNum && size < Threshold(lod + 1) * (1.0f - LOD_HYSTERESIS))
+			lod++;
+		renderItem->Lod = lod;
+	}
+
+	mLodItemNums.fill(0);
+	for (auto& renderItem : mVisibleOpaqueRenderItemQueue)
+		mLodItemNums[MathHelper::Min(renderItem->Lod, MAX_LOD_NUM - 1)]++;
+}
+
+void SceneGraphApp::CullOccludedRenderItems(FXMMATRIX viewProj)
+{
+	// Rasterize the occluders that survived frustum culling
+	mOcclusionCuller.Begin(viewProj);
+	for (auto& renderItem : mVisibleOpaqueRenderItemQueue) {
+		if (!renderItem->Occluder)
+			continue;
+		Object* obj = Object::FindObjectByID(renderItem->ObjectID);
+		Mesh* mesh = Mesh::FindObjectByID(renderItem->MeshID);
+		if (!obj || !mesh || !mesh->GetVertexData() || !mesh->GetIndexData())
+			continue;
+		SubMesh submesh = mesh->GetSubMesh(renderItem->SubMeshID);
+		if (submesh.primitiveTopology != D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST)
+			continue;
+
+		Span<const BYTE> verts(static_cast<const BYTE*>(mesh->GetVertexData()), mesh->GetVertexBufferByteSize());
+		if (mesh->GetIndexFormat() == DXGI_FORMAT_R16_UINT) {
+			Span<const UINT16> indices(static_cast<const UINT16*>(mesh->GetIndexData()) + submesh.startIndexLoc, submesh.indexCount);
+			mOcclusionCuller.AddOccluder(verts, mesh->GetVertexByteStride(), indices, submesh.baseVertexLoc, obj->GetGlobalModelMat());
+		}
+		else {
+			Span<const UINT32> indices(static_cast<const UINT32*>(mesh->GetIndexData()) + submesh.startIndexLoc, submesh.indexCount);
+			mOcclusionCuller.AddOccluder(verts, mesh->GetVertexByteStride(), indices, submesh.baseVertexLoc, obj->GetGlobalModelMat());
+		}
+	}
+	mOcclusionCuller.Rasterize(mJobSystem.get());
+
+	// Test every item in parallel, then compact the queue in order
+	auto& queue = mVisibleOpaqueRenderItemQueue;
+	mOcclusionVisibles.resize(queue.size());
+	mJobSystem->ParallelFor(static_cast<UINT>(queue.size()), OCCLUSION_TEST_GRAIN_SIZE, [&](UINT begin, UINT end) {
+		for (UINT i = begin; i < end; i++) {
+			Object* obj = Object::FindObjectByID(queue[i]->ObjectID);
+			mOcclusionVisibles[i] = !obj || !obj->HasBounds() || mOcclusionCuller.IsVisible(obj->GetWorldBounds());
+		}
+	});
+	UINT visibleNum = 0;
+	for (UINT i = 0; i < queue.size(); i++)
+		if (mOcclusionVisibles[i])
+			queue[visibleNum++] = std::move(queue[i]);
+	mOccludedNum = static_cast<UINT>(queue.size()) - visibleNum;
+	queue.resize(visibleNum);
+}
+
+void SceneGraphApp::CullLights(FXMMATRIX viewProj)
+{
+	Frustum frustum(viewProj);
+	for (auto& pointLight : mPointLights)
+		pointLight.Visible = frustum.Intersects(pointLight.CalBoundingSphere());
+	for (auto& spotLight : mSpotLights)
+		spotLight.Visible = frustum.Intersects(spotLight.CalBoundingSphere());
+}
+
+void SceneGraphApp::CullShadowCasters()
+{
+	// Casters outside a shadow view would be clipped by the rasterizer anyway
+	for (auto& dirLight : mDirLights)
+		CullRenderItems(dirLight.CalLightViewMat() * dirLight.CalLightProjMat(), dirLight.ShadowCasters);
+	for (auto& spotLight : mSpotLights) {
+		if (!spotLight.Visible) {
+			spotLight.ShadowCasters.clear();
+			continue;
+		}
+		CullRenderItems(spotLight.CalLightViewMat() * spotLight.CalLightProjMat(), spotLight.ShadowCasters);
+	}
+	for (auto& pointLight : mPointLights) {
+		if (!pointLight.Visible) {
+			for (auto& shadowCasters : pointLight.ShadowCastersArray)
+				shadowCasters.clear();
+			continue;
+		}
+		auto viewMats = pointLight.CalLightViewMats();
+		XMMATRIX projMat = pointLight.CalLightProjMat();
+		for (UINT i = 0; i < PointLight::RTVNum; i++)
+			CullRenderItems(viewMats[i] * projMat, pointLight.ShadowCastersArray[i]);
+	}
+}
+
+void SceneGraphApp::SortRenderQueues()
+{
+	mUnsortedStateChangeNum = RenderQueueSorter::CountStateChanges(mVisibleOpaqueRenderItemQueue);
+	mQueueSorter.Sort(mVisibleOpaqueRenderItemQueue, mCamera.GetViewMatrix());
+	mSortedStateChangeNum = RenderQueueSorter::CountStateChanges(mVisibleOpaqueRenderItemQueue);
+
+	for (auto& dirLight : mDirLights)
+		mQueueSorter.Sort(dirLight.ShadowCasters, dirLight.CalLightViewMat());
+	for (auto& spotLight : mSpotLights)
+		mQueueSorter.Sort(spotLight.ShadowCasters, spotLight.CalLightViewMat());
+	for (auto& pointLight : mPointLights) {
+		auto viewMats = pointLight.CalLightViewMats();
+		for (UINT i = 0; i < PointLight::RTVNum; i++)
+			mQueueSorter.Sort(pointLight.ShadowCastersArray[i], viewMats[i]);
+	}
+}
+
+void SceneGraphApp::BuildInstanceBatches()
+{
+	auto GetLodNum = [](UINT meshID) {
+		Mesh* mesh = Mesh::FindObjectByID(meshID);
+		return mesh ? mesh->GetLodNum() : 0u;
+	};
+	mInstanceBatcher.Clear();
+	mInstanceBatcher.Batch(mVisibleOpaqueRenderItemQueue, 0, GetLodNum, mOpaqueBatches);
+	for (auto& dirLight : mDirLights)
+		mInstanceBatcher.Batch(dirLight.ShadowCasters, SHADOW_LOD_BIAS, GetLodNum, dirLight.ShadowBatches);
+	for (auto& spotLight : mSpotLights)
+		mInstanceBatcher.Batch(spotLight.ShadowCasters, SHADOW_LOD_BIAS, GetLodNum, spotLight.ShadowBatches);
+	for (auto& pointLight : mPointLights)
+		for (UINT i = 0; i < PointLight::RTVNum; i++)
+			mInstanceBatcher.Batch(pointLight.ShadowCastersArray[i], SHADOW_LOD_BIAS, GetLodNum, pointLight.ShadowBatchesArray[i]);
+
+	// Sized for this frame's instances, however many views draw them
+	const auto& instances = mInstanceBatcher.GetInstances();
+	UINT instanceNum = static_cast<UINT>(instances.size());
+	mCurrFrameResource->InstanceBuffer = mUploadRing->AllocArray<UINT>(instanceNum, false);
+	mCurrFrameResource->InstanceBuffer.CopyData(0, instances.data(), instanceNum);
+}
+
+std::wstring SceneGraphApp::GetFrameStatsText()
+{
+	std::wstring text;
+	text += L"   threads: " + std::to_wstring(mJobSystem->GetThreadNum());
+	text += L"   recomputed nodes: " + std::to_wstring(Object::GetTransformStore().GetRecomputedNum());
+	text += L"   visible: " + std::to_wstring(mVisibleOpaqueRenderItemQueue.size());
+	text += L"   culled: " + std::to_wstring(mCulledNum);
+	text += L"   occluded: " + std::to_wstring(mOccludedNum);
+	text += L"   frame waits: " + std::to_wstring(mFrameRing->GetWaitNum());
+	text += L"   object upload: " + std::to_wstring(mObjectUploadBytes) + L" bytes";
+	text += L"   bvh rebuilds: " + std::to_wstring(mSceneBvh.GetRebuildNum());
+	text += L"   state changes: " + std::to_wstring(mUnsortedStateChangeNum)
+		+ L" -> " + std::to_wstring(mSortedStateChangeNum);
+	text += L"   instanced draws: " + std::to_wstring(mOpaqueBatches.size());
+	text += L"   command lists: " + std::to_wstring(mCommandListNum);
+	text += L"   render targets: " + std::to_wstring(mRenderTargetPacker.GetHeapSize() >> 20)
+		+ L" MB (" + std::to_wstring(mRenderTargetPacker.GetUnaliasedSize() >> 20) + L" MB unaliased)";
+	text += L"   descriptors: " + std::to_wstring(mCBVSRVUAVHeap->GetPersistent().GetFreeNum()) + L" free, "
+		+ std::to_wstring(mCBVSRVUAVHeap->GetRing().GetUsedNum()) + L" transient";
+	text += L"   upload ring: " + std::to_wstring(mUploadRing->GetUsedSize() >> 10) + L" / "
+		+ std::to_wstring(mUploadRing->GetSize() >> 10) + L" KB";
+	text += L"   barriers: " + std::to_wstring(mRenderGraph.GetBarrierNum())
+		+ L" (" + std::to_wstring(mRenderGraph.GetCulledNum()) + L" passes culled)";
+	text += L"   api calls: " + std::to_wstring(mIssuedCallNum)
+		+ L" (" + std::to_wstring(mSkippedCallNum) + L" dropped)";
+	text += L"   lods:";
+	for (UINT lodItemNum : mLodItemNums)
+		text += L" " + std::to_wstring(lodItemNum);
+
+	UINT lightNum = 0;
+	for (auto& pointLight : mPointLights)
+		lightNum += pointLight.Visible;
+	for (auto& spotLight : mSpotLights)
+		lightNum += spotLight.Visible;
+	text += L"   visible lights: " + std::to_wstring(lightNum)
+		+ L" of " + std::to_wstring(mPointLights.size() + mSpotLights.size());
+
+	// Instanced shadow draws per view, against drawing every opaque item in every view
+	UINT shadowDrawNum = 0;
+	UINT shadowViewNum = 0;
+	std::wstring shadowText;
+	for (UINT i = 0; i < mDirLights.size(); i++) {
+		UINT drawNum = static_cast<UINT>(mDirLights[i].ShadowBatches.size());
+		shadowText += L"   dir shadow " + std::to_wstring(i) + L": " + std::to_wstring(drawNum);
+		shadowDrawNum += drawNum;
+		shadowViewNum++;
+	}
+	for (UINT i = 0; i < mSpotLights.size(); i++) {
+		UINT drawNum = static_cast<UINT>(mSpotLights[i].ShadowBatches.size());
+		shadowText += L"   spot shadow " + std::to_wstring(i) + L": " + std::to_wstring(drawNum);
+		shadowDrawNum += drawNum;
+		shadowViewNum++;
+	}
+	for (UINT i = 0; i < mPointLights.size(); i++) {
+		shadowText += L"   point shadow " + std::to_wstring(i) + L":";
+		for (UINT face = 0; face < PointLight::RTVNum; face++) {
+			UINT drawNum = static_cast<UINT>(mPointLights[i].ShadowBatchesArray[face].size());
+			shadowText += (face ? L"/" : L" ") + std::to_wstring(drawNum);
+			shadowDrawNum += drawNum;
+			shadowViewNum++;
+		}
+	}
+	text += L"   shadow draws: " + std::to_wstring(shadowDrawNum)
+		+ L" of " + std::to_wstring(shadowViewNum * mOpaqueRenderItemQueue.size());
+	text += shadowText;
+	return text;
+}
+
 std::vector<CD3DX12_STATIC_SAMPLER_DESC> SceneGraphApp::GetStaticSamplers()
 {
 	const CD3DX12_STATIC_SAMPLER_DESC bilinearWrap(
@@ -2197,5 +2739,7 @@ void SceneGraphApp::UpdateFXAAState(bool newState) {
     if(mUseFXAA != newState)
     {
         mUseFXAA = newState;
+
+        OnFxaaStateChange();
     }
 }
@@ -9,13 +9,29 @@
 #include "Light.h"
 #include "RenderItem.h"
 #include "Camera.h"
-#include "StaticDescriptorHeap.h"
+#include "DescriptorHeap.h"
 #include "RenderTarget.h"
 #include "UnorderedAccessBuffer.h"
 #include "Texture.h"
 #include "Material.h"
 #include "Mesh.h"
 #include "FbxLoader.h"
+#include "JobSystem.h"
+#include "Frustum.h"
+#include "Bvh.h"
+#include "OcclusionCuller.h"
+#include "InstanceBatcher.h"
+#include "RenderQueueSorter.h"
+#include "D3D12CommandEncoder.h"
+#include "ChangeList.h"
+#include "D3D12FrameFence.h"
+#include "FrameResource.h"
+#include "D3D12PassRecorder.h"
+#include "D3D12RenderGraph.h"
+#include "HeapPacker.h"
+#include "Registry.h"
+
+const UINT NO_ROOT_PARAM = -1;
 
 class SceneGraphApp : public D3DApp
 {
@@ -26,6 +42,7 @@ public:
 	virtual bool Initialize()override;
 
 	// Initialize
+	void BuildFrameResources();
 
 	// Init Scene
 	// Init Scene's Meshs
@@ -35,10 +52,11 @@ public:
 	void LoadScene();
 	void BuildObjects();
 	void BuildManualObjects();
-	void BuildRenderItemQueueRecursively(std::shared_ptr<Object> root);
+	void BuildRenderItemQueue(Object& root);
+	void BuildSceneBvh();
+	void BuildOccluders();
 	// Init Scene's others
 	void BuildLights();
-	void BuildLightShadowConstantBuffers();
 
 	// Init DirectX
 	void BuildUABs();
@@ -50,17 +68,19 @@ public:
 	void BuildRootSignature();
 	void BuildShaders();
 	void BuildPSOs();
+	void ResolveDrawHandles();
 
 	// Init Scene Resources
 	void LoadTextures();
 	void BuildPassConstants();
-	void BuildPassConstantBuffers();
 	void UpdateLightsInPassConstantBuffers();
 	// void BuildGeos();
 	void BuildAndUpdateMaterialConstantBuffers();
 	
 	// Init Render Item Resources
 	void BuildObjectConstantBuffers();
+	void BuildObjectConstantBuffer(FrameResource& frame, UINT slotNum);
+	void MarkObjectChanged(UINT objectID);
 
 	// Init Postprocess Resources
 	void InitHbao();
@@ -79,6 +99,24 @@ private:
 	virtual void OnResize()override;
 	virtual void Update(const GameTimer& gt)override;
 	virtual void Draw(const GameTimer& gt)override;
+	void BuildRenderGraph();
+	void DrawScene(GraphicsCommandEncoder& encoder);
+	// Fill queue with the opaque items inside the view frustum, using mSceneBvh
+	void CullRenderItems(DirectX::FXMMATRIX viewProj, std::vector<std::shared_ptr<RenderItem>>& queue);
+	// Remove items hidden behind occluders from mVisibleOpaqueRenderItemQueue
+	void CullOccludedRenderItems(DirectX::FXMMATRIX viewProj);
+	// Mark point and spot lights whose lit volume is outside the view frustum
+	void CullLights(DirectX::FXMMATRIX viewProj);
+	// Fill every visible shadow view's ShadowCasters with the items inside its frustum
+	void CullShadowCasters();
+	// Pick the LOD of every opaque item from the size of its bounds on screen
+	void XM_CALLCONV SelectLods(DirectX::FXMMATRIX view, DirectX::CXMMATRIX proj);
+	// Sort the visible queue and every shadow view's casters front to back by state
+	void SortRenderQueues();
+	// Group the visible queue and every shadow view's casters into instanced draws
+	// and upload their instances
+	void BuildInstanceBatches();
+	virtual std::wstring GetFrameStatsText()override;
 
 	virtual std::vector<CD3DX12_STATIC_SAMPLER_DESC> GetStaticSamplers();
 
@@ -105,18 +143,24 @@ private:
 	// Camera
 	Camera mCamera;
 
+	// Jobs
+	std::unique_ptr<JobSystem> mJobSystem = nullptr;
+
 	// Descriptor Heaps
-	std::unique_ptr<StaticDescriptorHeap> mDSVHeap = nullptr;
-	std::unique_ptr<StaticDescriptorHeap> mRTVHeap = nullptr;
-	std::unique_ptr<StaticDescriptorHeap> mCBVSRVUAVHeap = nullptr;
-	std::unique_ptr<StaticDescriptorHeap> mCBVSRVUAVCPUHeap = nullptr;
+	std::unique_ptr<DescriptorHeap> mDSVHeap = nullptr;
+	std::unique_ptr<DescriptorHeap> mRTVHeap = nullptr;
+	std::unique_ptr<DescriptorHeap> mCBVSRVUAVHeap = nullptr;
+	std::unique_ptr<DescriptorHeap> mCBVSRVUAVCPUHeap = nullptr;
 
 	// Render Targets
-	std::unordered_map<std::string, std::shared_ptr<SingleRenderTarget>> mRenderTargets;
+	Registry<std::shared_ptr<SingleRenderTarget>> mRenderTargets;
 	std::unique_ptr<SwapChainRenderTarget> mSwapChain;
+	// Screen targets used within a frame, placed so the ones alive in different passes share memory
+	Microsoft::WRL::ComPtr<ID3D12Heap> mRenderTargetHeap;
+	HeapPacker mRenderTargetPacker;
 
 	// Unordered Access Buffers
-	std::unordered_map<std::string, std::unique_ptr<UnorderedAccessBuffer>> mUABs;
+	Registry<std::unique_ptr<UnorderedAccessBuffer>> mUABs;
 
 	// ZBuffer SRV
 	DXGI_FORMAT mZBufferResourceFormat = DXGI_FORMAT_R32_TYPELESS;
@@ -129,14 +173,45 @@ private:
 	std::unordered_map<std::string, std::vector<D3D12_INPUT_ELEMENT_DESC>> mInputLayouts;
 
 	// Root Signature
-	std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D12RootSignature>> mRootSigns;
-	std::unordered_map<std::string, std::unordered_map<std::string, UINT>> mRootSignParamIndices;
+	Registry<Microsoft::WRL::ComPtr<ID3D12RootSignature>> mRootSigns;
+	Registry<Registry<UINT>> mRootSignParamIndices;
 
 	// Shaders
 	std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3DBlob>> mShaders;
 
 	// PSOs
-	std::unordered_map<std::string, Microsoft::WRL::ComPtr<ID3D12PipelineState>> mPSOs;
+	Registry<Microsoft::WRL::ComPtr<ID3D12PipelineState>> mPSOs;
+
+	// Handles and root parameter indices Draw uses, resolved once at build time
+	struct RootParams {
+		UINT DrawC = NO_ROOT_PARAM;
+		UINT MaterialCB = NO_ROOT_PARAM;
+		UINT PassCB = NO_ROOT_PARAM;
+		UINT ObjectSR = NO_ROOT_PARAM;
+		UINT InstanceSR = NO_ROOT_PARAM;
+		UINT NCountUA = NO_ROOT_PARAM;
+		UINT ZBufferSR = NO_ROOT_PARAM;
+		UINT TexSR = NO_ROOT_PARAM;
+		UINT SpotShadowSR = NO_ROOT_PARAM;
+		UINT DirShadowSR = NO_ROOT_PARAM;
+		UINT PointShadowSR = NO_ROOT_PARAM;
+	};
+	struct DrawHandles {
+		UINT OpaqueRT;
+		UINT AfterResolveRT;
+		UINT FxaaRT;
+		UINT NCountUAB;
+		UINT ShadowRootSign;
+		UINT StandardRootSign;
+		UINT FxaaRootSign;
+		UINT ShadowPSO;
+		UINT PointShadowPSO;
+		UINT OpaquePSO;
+		UINT FxaaPSO;
+		RootParams ShadowParams;
+		RootParams StandardParams;
+		RootParams FxaaParams;
+	} mDrawHandles;
 
 	// Objects
 	std::shared_ptr<Object> mRootObject;
@@ -181,14 +256,60 @@ private:
 
 	// Render Items
 	std::vector<std::shared_ptr<RenderItem>> mOpaqueRenderItemQueue;
+	std::vector<std::shared_ptr<RenderItem>> mVisibleOpaqueRenderItemQueue; // rebuilt every frame
+	UINT mCulledNum = 0;
+	std::array<UINT, MAX_LOD_NUM> mLodItemNums = {}; // visible items at every LOD
+	RenderQueueSorter mQueueSorter;
+	UINT mUnsortedStateChangeNum = 0; // of the visible queue, before and after sorting
+	UINT mSortedStateChangeNum = 0;
+	InstanceBatcher mInstanceBatcher;
+	UINT mIssuedCallNum = 0; // command list calls of the last frame, and redundant ones dropped
+	UINT mSkippedCallNum = 0;
+	std::vector<InstanceBatch> mOpaqueBatches; // of mVisibleOpaqueRenderItemQueue
+
+	// Objects of the opaque queue
+	Bvh mSceneBvh;
+	std::vector<UINT> mRecomputedObjectIDs; // scratch
+	OcclusionCuller mOcclusionCuller;
+	std::vector<UINT8> mOcclusionVisibles; // per item of the visible queue, reused every frame
+	UINT mOccludedNum = 0;
 	std::vector<std::shared_ptr<RenderItem>> mTransRenderItemQueue;
 	std::shared_ptr<RenderItem> mBackgroundRenderItem = nullptr;
 
+	// Frame Resources, the per-frame buffers live in them
+	std::unique_ptr<FrameFence> mFrameFence;
+	std::unique_ptr<FrameRing> mFrameRing;
+	std::unique_ptr<UploadRing> mUploadRing; // per-frame constants and instances
+	std::vector<std::unique_ptr<FrameResource>> mFrameResources;
+	FrameResource* mCurrFrameResource = nullptr;
+
+	// Passes are recorded into several command lists in parallel
+	std::unique_ptr<D3D12CommandListProvider> mCommandListProvider;
+	std::unique_ptr<GraphicsPassRecorder> mPassRecorder;
+	UINT mCommandListNum = 0; // of the last frame
+
+	// Reads and writes of the passes, rebuilt every frame to derive barriers
+	D3D12RenderGraph mRenderGraph;
+	std::vector<UINT> mShadowGraphPasses; // by light, dir then spot then point lights
+	struct ScenePasses {
+		UINT Opaque;
+		UINT CopyZBuffer;
+		UINT Resolve;
+		UINT Fxaa;
+		UINT Present;
+	} mScenePasses;
+	struct SceneResources {
+		UINT OpaqueColor;
+		UINT OpaqueDepth;
+		UINT AfterResolve;
+		UINT FxaaColor;
+		UINT FxaaDepth;
+	} mSceneResources; // transient
+
 	// Constant Buffers
 	std::unique_ptr<UploadBuffer<Material::Content>> mMaterialConstantsBuffers;
-	std::unique_ptr<UploadBuffer<Object::Content>> mObjectConstantsBuffers;
-	std::unique_ptr<UploadBuffer<PassConstants::Content>> mPassConstantsBuffers;
-	std::unique_ptr<UploadBuffer<HbaoConstants::Content>> mHbaoConstantsBuffers;
-	std::unique_ptr<UploadBuffer<FxaaConstants::Content>> mFxaaConstantsBuffers;
-	std::unique_ptr<UploadBuffer<ShadowPassConstants::Content>> mShadowPassConstantsBuffers;
+	ChangeList mObjectChanges; // object slots not yet uploaded to every frame resource
+	std::vector<UINT> mObjectIDsBySlot;
+	std::vector<Object::Content> mObjectContents; // staging of one range
+	UINT64 mObjectUploadBytes = 0; // of the last frame
 };
@@ -24,72 +24,22 @@ void TransResourceState(
 	commandList->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
 }
 
-void TransRT2SR(
-	ComPtr<ID3D12GraphicsCommandList> commandList,
-	std::vector<ID3D12Resource*> resources
-) {
-	std::vector<D3D12_RESOURCE_STATES> renderTargetStates(resources.size(), D3D12_RESOURCE_STATE_RENDER_TARGET);
-	std::vector<D3D12_RESOURCE_STATES> pixelResourceStates(resources.size(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	TransResourceState(
-		commandList,
-		resources,
-		renderTargetStates,
-		pixelResourceStates
-	);
-}
-
-void TransSR2RT(
-	ComPtr<ID3D12GraphicsCommandList> commandList,
-	std::vector<ID3D12Resource*> resources
-) {
-	std::vector<D3D12_RESOURCE_STATES> renderTargetStates(resources.size(), D3D12_RESOURCE_STATE_RENDER_TARGET);
-	std::vector<D3D12_RESOURCE_STATES> pixelResourceStates(resources.size(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
-	TransResourceState(
-		commandList,
-		resources,
-		pixelResourceStates,
-		renderTargetStates
-	);
-}
-
-
-void CopyResource(
-	ComPtr<ID3D12GraphicsCommandList> commandList,
-	ID3D12Resource* dst,
-	D3D12_RESOURCE_STATES dstFromState, D3D12_RESOURCE_STATES dstToState,
-	ID3D12Resource* src,
-	D3D12_RESOURCE_STATES srcFromState, D3D12_RESOURCE_STATES srcToState
-) {
-	TransResourceState(
-		commandList,
-		{ src, dst },
-		{ srcFromState, dstFromState },
-		{ D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_COPY_DEST }
-	);
-
-	commandList->CopyResource(dst, src);
-
-	TransResourceState(
-		commandList,
-		{ src, dst },
-		{ D3D12_RESOURCE_STATE_COPY_SOURCE, D3D12_RESOURCE_STATE_COPY_DEST },
-		{ srcToState, dstToState }
-	);
-};
-
-
 struct ShadowPassRenderParams
 {
 	ComPtr<ID3D12GraphicsCommandList> commandList;
+	GraphicsCommandEncoder* encoder; // state setting goes through here
 	UINT RTVSize;
 
 	UINT passCBRootParamIndex = -1;
 	D3D12_GPU_VIRTUAL_ADDRESS passCBBaseAddr;
 	UINT64 passCBByteSize;
 
-	UINT objCBRootParamIndex = -1;
-	D3D12_GPU_VIRTUAL_ADDRESS objCBBaseAddr;
-	UINT64 objCBByteSize;
+	UINT drawCRootParamIndex = -1;
+
+	UINT objSRRootParamIndex = -1;
+	D3D12_GPU_VIRTUAL_ADDRESS objSRAddr;
+	UINT instSRRootParamIndex = -1;
+	D3D12_GPU_VIRTUAL_ADDRESS instSRAddr;
 
 	UINT mtlCBRootParamIndex = -1;
 	D3D12_GPU_VIRTUAL_ADDRESS mtlCBBaseAddr;
@@ -98,42 +48,51 @@ struct ShadowPassRenderParams
 
 void DrawRenderItems(
 	const ShadowPassRenderParams& rps,
-	const std::vector<std::shared_ptr<RenderItem>>& renderQueue
+	const std::vector<InstanceBatch>& batches
 )
 {
-	for(auto renderItem: renderQueue)
+	auto encoder = rps.encoder;
+
+	// Assign Object Data
+	if (rps.objSRRootParamIndex != -1) {
+		encoder->SetGraphicsRootShaderResourceView(rps.objSRRootParamIndex, rps.objSRAddr);
+		encoder->SetGraphicsRootShaderResourceView(rps.instSRRootParamIndex, rps.instSRAddr);
+	}
+
+	UINT meshID = INVALID_SLOT_HANDLE;
+	Mesh* mesh = nullptr;
+	for(auto& batch: batches)
 	{
-		// Set IA
-		Mesh* mesh = Mesh::FindObjectByID(renderItem->MeshID);
-		SubMesh submesh = mesh->GetSubMesh(renderItem->SubMeshID);
-		D3D12_VERTEX_BUFFER_VIEW VBVs[1] = {
-			mesh->GetVertexBufferView()
-		};
-		rps.commandList->IASetVertexBuffers(0, 1, VBVs);
-		rps.commandList->IASetIndexBuffer(&mesh->GetIndexBufferView());
-		rps.commandList->IASetPrimitiveTopology(submesh.primitiveTopology);
+		// Set IA, the encoder drops what is already set
+		if (batch.MeshID != meshID) {
+			meshID = batch.MeshID;
+			mesh = Mesh::FindObjectByID(meshID);
+			encoder->IASetVertexBuffer(mesh->GetVertexBufferView());
+			encoder->IASetIndexBuffer(mesh->GetIndexBufferView());
+		}
+		SubMesh submesh = mesh->GetSubMesh(batch.SubMeshID, batch.Lod);
+		encoder->IASetPrimitiveTopology(submesh.primitiveTopology);
 
 		// Assign Material Constants Buffer
 		if (rps.mtlCBRootParamIndex != -1) {
-			UINT mtlID = renderItem->MaterialID;
-			rps.commandList->SetGraphicsRootConstantBufferView(
+			UINT mtlIndex = SlotIndex(batch.MaterialID);
+			encoder->SetGraphicsRootConstantBufferView(
 				rps.mtlCBRootParamIndex,
-				rps.mtlCBBaseAddr + mtlID * rps.mtlCBByteSize
+				rps.mtlCBBaseAddr + mtlIndex * rps.mtlCBByteSize
 			);
 		}
 
-		// Assign Object Constants Buffer
-		if (rps.objCBRootParamIndex != -1) {
-			rps.commandList->SetGraphicsRootConstantBufferView(
-				rps.objCBRootParamIndex, 
-				rps.objCBBaseAddr + renderItem->ObjectID * rps.objCBByteSize
+		// Assign First Instance
+		if (rps.drawCRootParamIndex != -1) {
+			encoder->SetGraphicsRoot32BitConstant(
+				rps.drawCRootParamIndex, batch.InstanceBase, 0
 			);
 		}
 
 		// Draw Call
-		rps.commandList->DrawIndexedInstanced(
+		encoder->DrawIndexedInstanced(
 			submesh.indexCount, 
-			1,
+			batch.InstanceNum,
 			submesh.startIndexLoc,
 			submesh.baseVertexLoc,
 			0
@@ -147,7 +106,7 @@ void DrawPass(
 	UINT passCBID,
 	RenderTarget* colorRenderTarget,
 	RenderTarget* depthRenderTarget,
-	const std::vector<std::shared_ptr<RenderItem>>& renderQueue,
+	const std::vector<InstanceBatch>& batches,
 
 	bool clearColorRT=true, 
 	bool clearDepthRT=true,
@@ -156,7 +115,7 @@ void DrawPass(
 {
 	// Assign Pass Constants
 	if (passCBID != -1) {
-		rps.commandList->SetGraphicsRootConstantBufferView(
+		rps.encoder->SetGraphicsRootConstantBufferView(
 			rps.passCBRootParamIndex, 
 			rps.passCBBaseAddr + passCBID * rps.passCBByteSize
 		);
@@ -191,255 +150,382 @@ void DrawPass(
 	}
 
 	// Draw Render Items
-	DrawRenderItems(rps, renderQueue);
+	DrawRenderItems(rps, batches);
 }
 
-void SceneGraphApp::Draw(const GameTimer& gt)
+void SceneGraphApp::BuildRenderGraph()
 {
-	// CommandList Start Recoding
-	{
-		// Reuse the memory associated with command recording.
-		// We can only reset when the associated command lists have finished execution on the GPU.
-		ThrowIfFailed(mDirectCmdListAlloc->Reset());
+	const GraphState RT = GRAPH_STATE_RENDER_TARGET;
+	const GraphState SR = GRAPH_STATE_PIXEL_SHADER_RESOURCE;
+	const GraphState DEPTH = GRAPH_STATE_DEPTH_WRITE;
+
+	auto& graph = mRenderGraph;
+	graph.Clear();
+
+	// Resources, in the states they rest in between frames.
+	// Shadow maps rest as shader resources, so only drawing them transitions.
+	UINT lightNum = static_cast<UINT>(mDirLights.size() + mSpotLights.size() + mPointLights.size());
+	UINT firstShadowMap = 0;
+	for (auto& light : mDirLights)
+		graph.ImportResource(light.ShadowRT->GetColorResource(), SR);
+	for (auto& light : mSpotLights)
+		graph.ImportResource(light.ShadowRT->GetColorResource(), SR);
+	for (auto& light : mPointLights)
+		graph.ImportResource(light.ShadowRT->GetColorResource(), SR);
+	// Screen targets are transient, all are imported so their ids do not change with settings
+	auto& targets = mSceneResources;
+	targets.OpaqueColor = graph.ImportTransient(mRenderTargets[mDrawHandles.OpaqueRT]->GetColorResource(), RT);
+	targets.OpaqueDepth = graph.ImportTransient(mRenderTargets[mDrawHandles.OpaqueRT]->GetDepthStencilResource(), DEPTH);
+	targets.AfterResolve = graph.ImportTransient(mRenderTargets[mDrawHandles.AfterResolveRT]->GetColorResource(), RT);
+	targets.FxaaColor = graph.ImportTransient(mRenderTargets[mDrawHandles.FxaaRT]->GetColorResource(), RT);
+	targets.FxaaDepth = graph.ImportTransient(mRenderTargets[mDrawHandles.FxaaRT]->GetDepthStencilResource(), DEPTH);
+	UINT zbuffer = graph.ImportResource(mZBufferResource.Get(), SR);
+	UINT backBuffer = graph.ImportResource(mSwapChain->GetColorResource(), GRAPH_STATE_PRESENT);
+	graph.MarkOutput(backBuffer);
+	graph.MarkOutput(zbuffer); // read by the next frame
+
+	// Shadow Passes, invisible lights keep the shadow map of an earlier frame
+	mShadowGraphPasses.assign(lightNum, INVALID_GRAPH_ID);
+	UINT shadowMap = firstShadowMap;
+	auto addShadowPass = [&](bool visible) {
+		if (visible) {
+			mShadowGraphPasses[shadowMap - firstShadowMap] = graph.AddPass("Shadow");
+			graph.Write(shadowMap, RT);
+		}
+		shadowMap++;
+	};
+	for (size_t i = 0; i < mDirLights.size(); i++)
+		addShadowPass(true);
+	for (auto& light : mSpotLights)
+		addShadowPass(light.Visible);
+	for (auto& light : mPointLights)
+		addShadowPass(light.Visible);
+
+	// Opaque
+	mScenePasses.Opaque = graph.AddPass("Opaque");
+	for (UINT i = 0; i < lightNum; i++)
+		graph.Read(firstShadowMap + i, SR);
+	graph.Read(zbuffer, SR);
+	graph.Write(targets.OpaqueColor, RT);
+	graph.Write(targets.OpaqueDepth, DEPTH);
+
+	// Copy ZBuffer for reference
+	mScenePasses.CopyZBuffer = graph.AddPass("Copy ZBuffer");
+	graph.Read(targets.OpaqueDepth, GRAPH_STATE_COPY_SOURCE);
+	graph.Write(zbuffer, GRAPH_STATE_COPY_DEST);
 
-		// A command list can be reset after it has been added to the command queue via ExecuteCommandList.
-		// Reusing the command list reuses memory.
-		ThrowIfFailed(mCommandList->Reset(mDirectCmdListAlloc.Get(), nullptr));
+	// Resolve
+	UINT color = targets.OpaqueColor;
+	mScenePasses.Resolve = INVALID_GRAPH_ID;
+	if (m4xMsaaState) {
+		mScenePasses.Resolve = graph.AddPass("Resolve MSAA");
+		graph.Read(color, GRAPH_STATE_RESOLVE_SOURCE);
+		graph.Write(targets.AfterResolve, GRAPH_STATE_RESOLVE_DEST);
+		color = targets.AfterResolve;
 	}
 
-	// Set Descriptor Heaps
-	{
-		ID3D12DescriptorHeap* descHeaps[] = { mCBVSRVUAVHeap->GetHeap() };
-		mCommandList->SetDescriptorHeaps(1, descHeaps);
+	// FXAA
+	mScenePasses.Fxaa = INVALID_GRAPH_ID;
+	if (mUseFXAA) {
+		mScenePasses.Fxaa = graph.AddPass("FXAA Postprocess");
+		graph.Read(color, SR);
+		graph.Write(targets.FxaaColor, RT);
+		graph.Write(targets.FxaaDepth, DEPTH);
+		color = targets.FxaaColor;
 	}
 
-	// Refresh Frame Shared Data
-	{
-		mCommandList->ClearUnorderedAccessViewUint(
-			mUABs["nCount"]->GetGPUHandle(), 
-			mUABs["nCount"]->GetCPUHandle_CPUHeap(),
-			mUABs["nCount"]->GetResource(),
-			(UINT*)mUABs["nCount"]->GetClearValue(),
-			0, nullptr
-		);
-	}
+	// Copy to BackBuffer
+	mScenePasses.Present = graph.AddPass("Copy to BackBuffer");
+	graph.Read(color, GRAPH_STATE_COPY_SOURCE);
+	graph.Write(backBuffer, GRAPH_STATE_COPY_DEST);
 
-	// Set Viewports & ScissorRects
-	{
-		// Set the viewport and scissor rect.  This needs to be reset whenever the command list is reset.
-		mCommandList->RSSetViewports(1, &mShadowScreenViewport);
-		mCommandList->RSSetScissorRects(1, &mShadowScissorRect);
-	}
+	graph.Compile();
+}
 
-	// Draw Shadows
-	{
-		PIXScopedEvent(mCommandList.Get(), PIX_BLACK, "Draw Shadows");
+void SceneGraphApp::Draw(const GameTimer& gt)
+{
+	// Lists are recorded with the allocators of this frame resource
+	mCommandListProvider->SetAllocators(&mCurrFrameResource->CmdListAllocs);
+
+	// Derive the barriers of the frame before recording any pass
+	BuildRenderGraph();
 
-		auto& signPI = mRootSignParamIndices["shadow"];
+	// Draw Shadows, a pass per light.
+	// Passes record on worker threads, look up shared state here.
+	{
+		const RootParams& params = mDrawHandles.ShadowParams;
 
 		// Build Render Params
-		ShadowPassRenderParams rps;
-		rps.commandList = mCommandList;
-		rps.RTVSize = mCbvSrvUavDescriptorSize;
+		ShadowPassRenderParams shadowRps;
+		shadowRps.RTVSize = mCbvSrvUavDescriptorSize;
 
-		rps.passCBRootParamIndex = signPI["passCB"];
-		rps.passCBBaseAddr = mShadowPassConstantsBuffers->Resource()->GetGPUVirtualAddress();
-		rps.passCBByteSize = mShadowPassConstantsBuffers->getElementByteSize();
+		shadowRps.passCBRootParamIndex = params.PassCB;
+		shadowRps.passCBBaseAddr = mCurrFrameResource->ShadowPassConstantsBuffer.GPU;
+		shadowRps.passCBByteSize = mCurrFrameResource->ShadowPassConstantsBuffer.ElementByteSize;
 
-		rps.objCBRootParamIndex = signPI["objectCB"];
-		rps.objCBBaseAddr = mObjectConstantsBuffers->Resource()->GetGPUVirtualAddress();
-		rps.objCBByteSize = mObjectConstantsBuffers->getElementByteSize();
+		shadowRps.drawCRootParamIndex = params.DrawC;
 
-		// Set Root Signature
-		mCommandList->SetGraphicsRootSignature(mRootSigns["shadow"].Get());
+		shadowRps.objSRRootParamIndex = params.ObjectSR;
+		shadowRps.objSRAddr = mCurrFrameResource->ObjectConstantsBuffer->Resource()->GetGPUVirtualAddress();
+		shadowRps.instSRRootParamIndex = params.InstanceSR;
+		shadowRps.instSRAddr = mCurrFrameResource->InstanceBuffer.GPU;
+
+		ID3D12RootSignature* rootSign = mRootSigns[mDrawHandles.ShadowRootSign].Get();
+		ID3D12PipelineState* shadowPSO = mPSOs[mDrawHandles.ShadowPSO].Get();
+		ID3D12PipelineState* pointShadowPSO = mPSOs[mDrawHandles.PointShadowPSO].Get();
 
-		// Set PSOs
-		mCommandList->SetPipelineState(mPSOs["shadow"].Get());
+		// Set everything a shadow pass depends on, return its render params
+		auto beginShadowPass = [this, shadowRps, rootSign](GraphicsCommandEncoder& encoder, ID3D12PipelineState* pso, UINT graphPass) {
+			ShadowPassRenderParams rps = shadowRps;
+			rps.commandList = encoder.GetCommandList();
+			rps.encoder = &encoder;
 
+			// Barriers
+			mRenderGraph.RecordBarriers(encoder.GetCommandList(), mRenderGraph.GetBarriers(graphPass));
+
+			// Set Viewports & ScissorRects
+			rps.commandList->RSSetViewports(1, &mShadowScreenViewport);
+			rps.commandList->RSSetScissorRects(1, &mShadowScissorRect);
+
+			// Set Root Signature & PSO
+			encoder.SetGraphicsRootSignature(rootSign);
+			encoder.SetPipelineState(pso);
+			return rps;
+		};
+
+		// Passes the graph culled or never added are skipped
+		UINT lightIndex = 0;
+		auto isDrawn = [this](UINT graphPass) {
+			return graphPass != INVALID_GRAPH_ID && !mRenderGraph.IsCulled(graphPass);
+		};
 
 		// Direction Lights
-		{
-			PIXScopedEvent(mCommandList.Get(), PIX_BLACK, "Dir Shadows");
-			for (int i = 0; i < mDirLights.size(); i++) {
-				auto& dirLight = mDirLights[i];
-				PIXScopedEvent(mCommandList.Get(), PIX_BLACK, "Dir Shadow %i", i);
+		for (int i = 0; i < mDirLights.size(); i++) {
+			auto& dirLight = mDirLights[i];
+			UINT graphPass = mShadowGraphPasses[lightIndex++];
+			if (!isDrawn(graphPass))
+				continue;
+			mPassRecorder->AddPass([&dirLight, i, beginShadowPass, shadowPSO, graphPass](GraphicsCommandEncoder& encoder) {
+				PIXScopedEvent(encoder.GetCommandList(), PIX_BLACK, "Dir Shadow %i", i);
+				ShadowPassRenderParams rps = beginShadowPass(encoder, shadowPSO, graphPass);
 				DrawPass(
 					rps,
 					dirLight.PassConstants->getID(),
 					dirLight.ShadowRT.get(),
 					dirLight.ShadowRT.get(),
-					mOpaqueRenderItemQueue
+					dirLight.ShadowBatches
 				);
-			}
+			}, static_cast<UINT>(dirLight.ShadowBatches.size()) + 1);
 		}
 
 		// Spot Lights
-		{
-			PIXScopedEvent(mCommandList.Get(), PIX_BLACK, "Spot Shadows");
-			for (int i = 0; i < mSpotLights.size(); i++) {
-				auto& spotLight = mSpotLights[i];
-				PIXScopedEvent(mCommandList.Get(), PIX_BLACK, "Spot Light %i", i);
+		for (int i = 0; i < mSpotLights.size(); i++) {
+			auto& spotLight = mSpotLights[i];
+			UINT graphPass = mShadowGraphPasses[lightIndex++];
+			if (!isDrawn(graphPass))
+				continue;
+			mPassRecorder->AddPass([&spotLight, i, beginShadowPass, shadowPSO, graphPass](GraphicsCommandEncoder& encoder) {
+				PIXScopedEvent(encoder.GetCommandList(), PIX_BLACK, "Spot Shadow %i", i);
+				ShadowPassRenderParams rps = beginShadowPass(encoder, shadowPSO, graphPass);
 				DrawPass(
 					rps,
 					spotLight.PassConstants->getID(),
 					spotLight.ShadowRT.get(),
 					spotLight.ShadowRT.get(),
-					mOpaqueRenderItemQueue
+					spotLight.ShadowBatches
 				);
-			}
+			}, static_cast<UINT>(spotLight.ShadowBatches.size()) + 1);
 		}
 
-		// Point Lights
-		{
-			PIXScopedEvent(mCommandList.Get(), PIX_BLACK, "Point Shadows");
-			// Set PSOs
-			mCommandList->SetPipelineState(mPSOs["pointShadow"].Get());
-
-			// Draw
-			int li = 0;
-			for (auto& pointLight : mPointLights) {
-				PIXScopedEvent(mCommandList.Get(), PIX_BLACK, "Point Shadow %i", li);
-				CD3DX12_CPU_DESCRIPTOR_HANDLE RTVCPUHandle(pointLight.ShadowRT->GetRTVCPUHandle());
-				auto DSVCPUHandle = pointLight.ShadowRT->GetDSVCPUHandle();
-
+		// Point Lights, all faces in one pass
+		for (int li = 0; li < mPointLights.size(); li++) {
+			auto& pointLight = mPointLights[li];
+			UINT graphPass = mShadowGraphPasses[lightIndex++];
+			if (!isDrawn(graphPass))
+				continue;
+			UINT cost = 1;
+			for (int i = 0; i < PointLight::RTVNum; i++)
+				cost += static_cast<UINT>(pointLight.ShadowBatchesArray[i].size());
+			mPassRecorder->AddPass([&pointLight, li, beginShadowPass, pointShadowPSO, graphPass](GraphicsCommandEncoder& encoder) {
+				PIXScopedEvent(encoder.GetCommandList(), PIX_BLACK, "Point Shadow %i", li);
+				ShadowPassRenderParams rps = beginShadowPass(encoder, pointShadowPSO, graphPass);
 				for (int i = 0; i < PointLight::RTVNum; i++) {
-					PIXScopedEvent(mCommandList.Get(), PIX_BLACK, "Point Shadow Face %i", i);
+					PIXScopedEvent(encoder.GetCommandList(), PIX_BLACK, "Point Shadow Face %i", i);
 
 					DrawPass(
 						rps,
 						pointLight.PassConstantsArray[i]->getID(),
 						pointLight.ShadowRT.get(),
 						pointLight.ShadowRT.get(),
-						mOpaqueRenderItemQueue,
+						pointLight.ShadowBatchesArray[i],
 						true, true,
 						i
 					);
 				}
-				li++;
-			}
+			}, cost);
 		}
 	}
 
+	// Draw Scene & Postprocess, one pass since every step reads the one before
+	mPassRecorder->AddPass([this](GraphicsCommandEncoder& encoder) {
+		DrawScene(encoder);
+	}, static_cast<UINT>(mOpaqueBatches.size()) + 1);
+
+	// Record Passes & Execute CommandLists
+	{
+		mCommandListNum = mPassRecorder->Execute(mJobSystem->GetThreadNum());
+		mIssuedCallNum = mPassRecorder->GetIssuedNum();
+		mSkippedCallNum = mPassRecorder->GetSkippedNum();
+	}
+
+	// Swap Chain
+	{
+		// swap the back and front buffers
+		mSwapChain->Swap();
+	}
+
+	// Mark the end of the frame, its frame resource is reused once the GPU gets here
+	mFrameRing->EndFrame();
+}
+
+void SceneGraphApp::DrawScene(GraphicsCommandEncoder& encoder)
+{
+	ComPtr<ID3D12GraphicsCommandList> commandList = encoder.GetCommandList();
+
+	// Set Descriptor Heaps
+	{
+		ID3D12DescriptorHeap* descHeaps[] = { mCBVSRVUAVHeap->GetHeap() };
+		commandList->SetDescriptorHeaps(1, descHeaps);
+	}
+
+	// Refresh Frame Shared Data
+	auto& nCount = mUABs[mDrawHandles.NCountUAB];
+	{
+		commandList->ClearUnorderedAccessViewUint(
+			nCount->GetGPUHandle(), 
+			nCount->GetCPUHandle_CPUHeap(),
+			nCount->GetResource(),
+			(UINT*)nCount->GetClearValue(),
+			0, nullptr
+		);
+	}
+
 	// Set Viewports & ScissorRects
 	{
 		// Set the viewport and scissor rect.  This needs to be reset whenever the command list is reset.
-		mCommandList->RSSetViewports(1, &mScreenViewport);
-		mCommandList->RSSetScissorRects(1, &mScissorRect);
+		commandList->RSSetViewports(1, &mScreenViewport);
+		commandList->RSSetScissorRects(1, &mScissorRect);
 	}
 
 	// Vars for convenience. Note, do not alloc or free for these vars, only referece.
 	RenderTarget* nowColorRenderTarget = nullptr;
 	RenderTarget* nowDSRenderTarget = nullptr;
 
-	// Switch shadow resources' states to pixel shader resource
-	std::vector<ID3D12Resource*> shadowResources;
-	for (const auto& light : mDirLights)
-		shadowResources.push_back(light.ShadowRT->GetColorResource());
-	for (const auto& light : mPointLights)
-		shadowResources.push_back(light.ShadowRT->GetColorResource());
-	for (const auto& light : mSpotLights)
-		shadowResources.push_back(light.ShadowRT->GetColorResource());
-	TransRT2SR(mCommandList, shadowResources);
+	// Shadow maps to shader resources
+	mRenderGraph.RecordBarriers(commandList.Get(), mRenderGraph.GetBarriers(mScenePasses.Opaque));
 
 	// Draw Scene
 	{
-		PIXScopedEvent(mCommandList.Get(), PIX_BLACK, "Draw Scenes");
+		PIXScopedEvent(commandList.Get(), PIX_BLACK, "Draw Scenes");
 
-		auto& signPI = mRootSignParamIndices["standard"]; // root sign param indices
+		const RootParams& params = mDrawHandles.StandardParams;
 
 		// Build Render Params
 		ShadowPassRenderParams rps;
-		rps.commandList = mCommandList;
+		rps.commandList = commandList;
+		rps.encoder = &encoder;
 		rps.RTVSize = mCbvSrvUavDescriptorSize;
 
-		rps.passCBRootParamIndex = signPI["passCB"];
-		rps.passCBBaseAddr = mPassConstantsBuffers->Resource()->GetGPUVirtualAddress();
-		rps.passCBByteSize = mPassConstantsBuffers->getElementByteSize();
+		rps.passCBRootParamIndex = params.PassCB;
+		rps.passCBBaseAddr = mCurrFrameResource->PassConstantsBuffer.GPU;
+		rps.passCBByteSize = mCurrFrameResource->PassConstantsBuffer.ElementByteSize;
 
-		rps.objCBRootParamIndex = signPI["objectCB"];
-		rps.objCBBaseAddr = mObjectConstantsBuffers->Resource()->GetGPUVirtualAddress();
-		rps.objCBByteSize = mObjectConstantsBuffers->getElementByteSize();
+		rps.drawCRootParamIndex = params.DrawC;
 
-		rps.mtlCBRootParamIndex = signPI["materialCB"];
+		rps.objSRRootParamIndex = params.ObjectSR;
+		rps.objSRAddr = mCurrFrameResource->ObjectConstantsBuffer->Resource()->GetGPUVirtualAddress();
+		rps.instSRRootParamIndex = params.InstanceSR;
+		rps.instSRAddr = mCurrFrameResource->InstanceBuffer.GPU;
+
+		rps.mtlCBRootParamIndex = params.MaterialCB;
 		rps.mtlCBBaseAddr = mMaterialConstantsBuffers->Resource()->GetGPUVirtualAddress();
 		rps.mtlCBByteSize = mMaterialConstantsBuffers->getElementByteSize();
 
 		// Set Root Signature
-		mCommandList->SetGraphicsRootSignature(mRootSigns["standard"].Get());
+		encoder.SetGraphicsRootSignature(mRootSigns[mDrawHandles.StandardRootSign].Get());
 
 		// Assign Textures
 		{
-			PIXScopedEvent(mCommandList.Get(), PIX_BLACK, "Assign Textures");
+			PIXScopedEvent(commandList.Get(), PIX_BLACK, "Assign Textures");
 
 			// Assign File Textures
-			if (signPI.find("texSR") != signPI.end()) {
-				mCommandList->SetGraphicsRootDescriptorTable(
-					signPI["texSR"], mTexGPUHandleStart
+			if (params.TexSR != NO_ROOT_PARAM) {
+				commandList->SetGraphicsRootDescriptorTable(
+					params.TexSR, mTexGPUHandleStart
 				);
 			}
 
 			// Assign Light Shadow Textures
-			if (signPI.find("spotShadowSR") != signPI.end()) {
-				mCommandList->SetGraphicsRootDescriptorTable(
-					signPI["spotShadowSR"], mSpotShadowTexGPUHandleStart
+			if (params.SpotShadowSR != NO_ROOT_PARAM) {
+				commandList->SetGraphicsRootDescriptorTable(
+					params.SpotShadowSR, mSpotShadowTexGPUHandleStart
 				);
 			}
-			if (signPI.find("dirShadowSR") != signPI.end()) {
-				mCommandList->SetGraphicsRootDescriptorTable(
-					signPI["dirShadowSR"], mDirShadowTexGPUHandleStart
+			if (params.DirShadowSR != NO_ROOT_PARAM) {
+				commandList->SetGraphicsRootDescriptorTable(
+					params.DirShadowSR, mDirShadowTexGPUHandleStart
 				);
 			}
-			if (signPI.find("pointShadowSR") != signPI.end()) {
-				mCommandList->SetGraphicsRootDescriptorTable(
-					signPI["pointShadowSR"], mPointShadowTexGPUHandleStart
+			if (params.PointShadowSR != NO_ROOT_PARAM) {
+				commandList->SetGraphicsRootDescriptorTable(
+					params.PointShadowSR, mPointShadowTexGPUHandleStart
 				);
 			}
 		}
 
 		// Assign UAV
-		mCommandList->SetGraphicsRootDescriptorTable(
-			signPI["ncountUA"], mUABs["nCount"]->GetGPUHandle()
+		commandList->SetGraphicsRootDescriptorTable(
+			params.NCountUA, nCount->GetGPUHandle()
 		);
 
 		// Assign ZBuffer for reference
-		mCommandList->SetGraphicsRootDescriptorTable(
-			signPI["zbufferSR"], mZBufferSRVGPUHandle
+		commandList->SetGraphicsRootDescriptorTable(
+			params.ZBufferSR, mZBufferSRVGPUHandle
 		);
 
 		// Set PSO
-		mCommandList->SetPipelineState(mPSOs["opaque"].Get());
+		encoder.SetPipelineState(mPSOs[mDrawHandles.OpaquePSO].Get());
 
 		// Opaque
-		nowColorRenderTarget = mRenderTargets["opaque"].get();
-		nowDSRenderTarget = mRenderTargets["opaque"].get();
+		nowColorRenderTarget = mRenderTargets[mDrawHandles.OpaqueRT].get();
+		nowDSRenderTarget = mRenderTargets[mDrawHandles.OpaqueRT].get();
 		{
-			PIXScopedEvent(mCommandList.Get(), PIX_BLACK, "Draw Opaque");
+			PIXScopedEvent(commandList.Get(), PIX_BLACK, "Draw Opaque");
 			DrawPass(
 				rps,
 				mPassConstants->getID(),
-				mRenderTargets["opaque"].get(),
-				mRenderTargets["opaque"].get(),
-				mOpaqueRenderItemQueue
+				nowColorRenderTarget,
+				nowDSRenderTarget,
+				mOpaqueBatches
 			);
 		}
 
 		// Copy ZBuffer for reference
-		CopyResource(mCommandList,
+		mRenderGraph.RecordBarriers(commandList.Get(), mRenderGraph.GetBarriers(mScenePasses.CopyZBuffer));
+		commandList->CopyResource(
 			mZBufferResource.Get(),
-			D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
-			mRenderTargets["opaque"]->GetDepthStencilResource(),
-			D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_DEPTH_WRITE
+			nowDSRenderTarget->GetDepthStencilResource()
 		);
 
 		/* Transparent does not work now
 
 		// Set PSO
-		mCommandList->SetPipelineState(mPSOs["trans"].Get());
+		commandList->SetPipelineState(mPSOs.Get("trans").Get());
 
 		// Transparent
-		nowColorRenderTarget = mRenderTargets["trans"].get();
+		nowColorRenderTarget = mRenderTargets.Get("trans").get();
 		{
-			PIXScopedEvent(mCommandList.Get(), PIX_BLACK, "Draw transparent");
+			PIXScopedEvent(commandList.Get(), PIX_BLACK, "Draw transparent");
 			DrawPass(
 				rps,
 				-1,
@@ -452,38 +538,35 @@ void SceneGraphApp::Draw(const GameTimer& gt)
 		*/
 	}
 
-	// Switch shadow resources' states back to render targets
-	TransSR2RT(mCommandList, shadowResources);
-
 	/* HBAO not work now
 	// HBAO
 	bool hasHBAO = false; // DEBUG
-	nowColorRenderTarget = mRenderTargets["hbao"].get();
+	nowColorRenderTarget = mRenderTargets.Get("hbao").get();
 	if(hasHBAO)
 	{
-		auto& signPI = mRootSignParamIndices["hbao"]; // root sign param indices
+		auto& signPI = mRootSignParamIndices.Get("hbao"); // root sign param indices
 
 		// Trans Previous RenderTarget to Shader Resource
 		TransResourceState(
-			mCommandList,
-			{ mRenderTargets["opaque"]->GetColorResource() },
+			commandList,
+			{ mRenderTargets.Get("opaque")->GetColorResource() },
 			{ D3D12_RESOURCE_STATE_RENDER_TARGET },	
 			{ D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE }
 		);
 
 		// Specify the buffers we are going to render to.
-		mCommandList->OMSetRenderTargets(
+		commandList->OMSetRenderTargets(
 			1, &nowColorRenderTarget->GetRTVCPUHandle(), 
 			true, &nowDSRenderTarget->GetDSVCPUHandle()
 		);
 
 		// Clear the back buffer and depth buffer.
-		mCommandList->ClearRenderTargetView(
+		commandList->ClearRenderTargetView(
 			nowColorRenderTarget->GetRTVCPUHandle(), 
 			nowColorRenderTarget->GetColorClearValue(), 
 			0, nullptr
 		);
-		mCommandList->ClearDepthStencilView(
+		commandList->ClearDepthStencilView(
 			nowDSRenderTarget->GetDSVCPUHandle(), 
 			D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 
 			nowDSRenderTarget->GetDepthClearValue(),  
@@ -492,26 +575,24 @@ void SceneGraphApp::Draw(const GameTimer& gt)
 		);
 
 		// Set Root Signature
-		mCommandList->SetGraphicsRootSignature(mRootSigns["hbao"].Get());
+		commandList->SetGraphicsRootSignature(mRootSigns.Get("hbao").Get());
 
 		// Assign CBV
-		auto hbaoCBGPUAddr = mHbaoConstantsBuffers->Resource()->GetGPUVirtualAddress();
-		UINT64 hbaoCBElementByteSize = mHbaoConstantsBuffers->getElementByteSize();
-		mCommandList->SetGraphicsRootConstantBufferView(
-			signPI["hbaoCB"], hbaoCBGPUAddr + mHbaoConstants->getID() * hbaoCBElementByteSize
+		commandList->SetGraphicsRootConstantBufferView(
+			signPI.Get("hbaoCB"), mCurrFrameResource->HbaoConstantsBuffer.GetGPUAddress(mHbaoConstants->getID())
 		);
 
 		// Assign SRV
-		mCommandList->SetGraphicsRootDescriptorTable(
-			signPI["depthSRV"], mZBufferSRVGPUHandle
+		commandList->SetGraphicsRootDescriptorTable(
+			signPI.Get("depthSRV"), mZBufferSRVGPUHandle
 		);
-		mCommandList->SetGraphicsRootDescriptorTable(
-			signPI["colorSRV"], mRenderTargets["opaque"]->GetSRVGPUHandle()
+		commandList->SetGraphicsRootDescriptorTable(
+			signPI.Get("colorSRV"), mRenderTargets.Get("opaque")->GetSRVGPUHandle()
 		);
 
 		// Draw Render Items
 		auto& renderItem = mBackgroundRenderItem;
-		mCommandList->SetPipelineState(mPSOs["hbao"].Get());
+		commandList->SetPipelineState(mPSOs.Get("hbao").Get());
 
 		// Set IA
 		Mesh* mesh = Mesh::FindObjectByID(renderItem->MeshID);
@@ -519,12 +600,12 @@ void SceneGraphApp::Draw(const GameTimer& gt)
 		D3D12_VERTEX_BUFFER_VIEW VBVs[1] = {
 			mesh->GetVertexBufferView()
 		};
-		mCommandList->IASetVertexBuffers(0, 1, VBVs);
-		mCommandList->IASetIndexBuffer(&mesh->GetIndexBufferView());
-		mCommandList->IASetPrimitiveTopology(submesh.primitiveTopology);
+		commandList->IASetVertexBuffers(0, 1, VBVs);
+		commandList->IASetIndexBuffer(&mesh->GetIndexBufferView());
+		commandList->IASetPrimitiveTopology(submesh.primitiveTopology);
 
 		// Draw Call
-		mCommandList->DrawIndexedInstanced(
+		commandList->DrawIndexedInstanced(
 			submesh.indexCount, 
 			1,
 			submesh.startIndexLoc,
@@ -534,8 +615,8 @@ void SceneGraphApp::Draw(const GameTimer& gt)
 
 		// Turn Back
 		TransResourceState(
-			mCommandList,
-			{ mRenderTargets["opaque"]->GetColorResource() },
+			commandList,
+			{ mRenderTargets.Get("opaque")->GetColorResource() },
 			{ D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE },
 			{ D3D12_RESOURCE_STATE_RENDER_TARGET}
 		);
@@ -544,30 +625,30 @@ void SceneGraphApp::Draw(const GameTimer& gt)
 
 	/* Transparent does not work now
 	// Transparent Blend
-	nowColorRenderTarget = mRenderTargets["transBlend"].get();
+	nowColorRenderTarget = mRenderTargets.Get("transBlend").get();
 	{
 		// Trans Previous RenderTarget to Shader Resource
-		auto& prevRenderTarget = hasHBAO ? mRenderTargets["hbao"] : mRenderTargets["opaque"];
+		auto& prevRenderTarget = hasHBAO ? mRenderTargets.Get("hbao") : mRenderTargets.Get("opaque");
 		TransResourceState(
-			mCommandList,
-			{ prevRenderTarget->GetColorResource(), mRenderTargets["trans"]->GetColorResource() },
+			commandList,
+			{ prevRenderTarget->GetColorResource(), mRenderTargets.Get("trans")->GetColorResource() },
 			{ D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_RENDER_TARGET },
 			{ D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE }
 		);
 
 		// Specify the buffers we are going to render to.
-		mCommandList->OMSetRenderTargets(
+		commandList->OMSetRenderTargets(
 			1, &nowColorRenderTarget->GetRTVCPUHandle(), 
 			true, &nowDSRenderTarget->GetDSVCPUHandle()
 		);
 
 		// Clear the back buffer and depth buffer.
-		mCommandList->ClearRenderTargetView(
+		commandList->ClearRenderTargetView(
 			nowColorRenderTarget->GetRTVCPUHandle(), 
 			nowColorRenderTarget->GetColorClearValue(), 
 			0, nullptr
 		);
-		mCommandList->ClearDepthStencilView(
+		commandList->ClearDepthStencilView(
 			nowDSRenderTarget->GetDSVCPUHandle(), 
 			D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 
 			nowDSRenderTarget->GetDepthClearValue(),  
@@ -576,24 +657,24 @@ void SceneGraphApp::Draw(const GameTimer& gt)
 		);
 
 		// Set Root Signature
-		mCommandList->SetGraphicsRootSignature(mRootSigns["transBlend"].Get());
+		commandList->SetGraphicsRootSignature(mRootSigns.Get("transBlend").Get());
 
 		// Assign SRV
-		mCommandList->SetGraphicsRootDescriptorTable(
+		commandList->SetGraphicsRootDescriptorTable(
 			0, prevRenderTarget->GetSRVGPUHandle()
 		);
-		mCommandList->SetGraphicsRootDescriptorTable(
-			1, mRenderTargets["trans"]->GetSRVGPUHandle()
+		commandList->SetGraphicsRootDescriptorTable(
+			1, mRenderTargets.Get("trans")->GetSRVGPUHandle()
 		);
 
 		// Assign UAV
-		mCommandList->SetGraphicsRootDescriptorTable(
-			2, mUABs["nCount"]->GetGPUHandle()
+		commandList->SetGraphicsRootDescriptorTable(
+			2, mUABs.Get("nCount")->GetGPUHandle()
 		);
 
 		// Draw Render Items
 		auto& renderItem = mBackgroundRenderItem;
-		mCommandList->SetPipelineState(mPSOs["transBlend"].Get());
+		commandList->SetPipelineState(mPSOs.Get("transBlend").Get());
 
 		// Set IA
 		Mesh* mesh = Mesh::FindObjectByID(renderItem->MeshID);
@@ -601,12 +682,12 @@ void SceneGraphApp::Draw(const GameTimer& gt)
 		D3D12_VERTEX_BUFFER_VIEW VBVs[1] = {
 			mesh->GetVertexBufferView()
 		};
-		mCommandList->IASetVertexBuffers(0, 1, VBVs);
-		mCommandList->IASetIndexBuffer(&mesh->GetIndexBufferView());
-		mCommandList->IASetPrimitiveTopology(submesh.primitiveTopology);
+		commandList->IASetVertexBuffers(0, 1, VBVs);
+		commandList->IASetIndexBuffer(&mesh->GetIndexBufferView());
+		commandList->IASetPrimitiveTopology(submesh.primitiveTopology);
 
 		// Draw Call
-		mCommandList->DrawIndexedInstanced(
+		commandList->DrawIndexedInstanced(
 			submesh.indexCount, 
 			1,
 			submesh.startIndexLoc,
@@ -616,8 +697,8 @@ void SceneGraphApp::Draw(const GameTimer& gt)
 
 		// Trans Back to Render Targets
 		TransResourceState(
-			mCommandList,
-			{ prevRenderTarget->GetColorResource(), mRenderTargets["trans"]->GetColorResource() },
+			commandList,
+			{ prevRenderTarget->GetColorResource(), mRenderTargets.Get("trans")->GetColorResource() },
 			{ D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE },
 			{ D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_RENDER_TARGET }
 		);
@@ -626,106 +707,78 @@ void SceneGraphApp::Draw(const GameTimer& gt)
 
 	// Resolve
 	if (m4xMsaaState) {
-		PIXScopedEvent(mCommandList.Get(), PIX_BLACK, "Resolve MSAA");
+		PIXScopedEvent(commandList.Get(), PIX_BLACK, "Resolve MSAA");
 
-		TransResourceState(
-			mCommandList,
-			{ nowColorRenderTarget->GetColorResource(), mRenderTargets["afterResolve"]->GetColorResource() },
-			{ D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_RENDER_TARGET },
-			{ D3D12_RESOURCE_STATE_RESOLVE_SOURCE, D3D12_RESOURCE_STATE_RESOLVE_DEST }
-		);
-		mCommandList->ResolveSubresource(
-			mRenderTargets["afterResolve"]->GetColorResource(), 0, 
+		RenderTarget* afterResolve = mRenderTargets[mDrawHandles.AfterResolveRT].get();
+		mRenderGraph.RecordBarriers(commandList.Get(), mRenderGraph.GetBarriers(mScenePasses.Resolve));
+		commandList->ResolveSubresource(
+			afterResolve->GetColorResource(), 0, 
 			nowColorRenderTarget->GetColorResource(), 0, 
-			mRenderTargets["afterResolve"]->GetColorViewFormat()
-		);
-		TransResourceState(
-			mCommandList,
-			{ nowColorRenderTarget->GetColorResource(), mRenderTargets["afterResolve"]->GetColorResource() },
-			{ D3D12_RESOURCE_STATE_RESOLVE_SOURCE, D3D12_RESOURCE_STATE_RESOLVE_DEST },
-			{ D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_RENDER_TARGET }
+			afterResolve->GetColorViewFormat()
 		);
 
-		nowColorRenderTarget = mRenderTargets["afterResolve"].get();
+		nowColorRenderTarget = afterResolve;
 	}
 
 	// FXAA
 	if (mUseFXAA) {
-		PIXScopedEvent(mCommandList.Get(), PIX_BLACK, "FXAA Postprocess");
+		PIXScopedEvent(commandList.Get(), PIX_BLACK, "FXAA Postprocess");
 
 		auto prevColorRenderTarget = nowColorRenderTarget;
-		nowColorRenderTarget = mRenderTargets["fxaa"].get();
-		nowDSRenderTarget = mRenderTargets["fxaa"].get();
+		nowColorRenderTarget = mRenderTargets[mDrawHandles.FxaaRT].get();
+		nowDSRenderTarget = nowColorRenderTarget;
 
 		// Turn to Shader Resource
-		TransRT2SR(mCommandList, { prevColorRenderTarget->GetColorResource() });
+		mRenderGraph.RecordBarriers(commandList.Get(), mRenderGraph.GetBarriers(mScenePasses.Fxaa));
 
 		// Set Root Signature
-		mCommandList->SetGraphicsRootSignature(mRootSigns["fxaa"].Get());
-		auto& signPI = mRootSignParamIndices["fxaa"];
+		encoder.SetGraphicsRootSignature(mRootSigns[mDrawHandles.FxaaRootSign].Get());
+		const RootParams& params = mDrawHandles.FxaaParams;
 
 		// Set PSO
-		mCommandList->SetPipelineState(mPSOs["fxaa"].Get());
+		encoder.SetPipelineState(mPSOs[mDrawHandles.FxaaPSO].Get());
 
 		// Assign SRV
-		mCommandList->SetGraphicsRootDescriptorTable(
-			signPI["texSR"], prevColorRenderTarget->GetSRVGPUHandle()
+		commandList->SetGraphicsRootDescriptorTable(
+			params.TexSR, prevColorRenderTarget->GetSRVGPUHandle()
 		);
 
 		// Build Render Params
 		ShadowPassRenderParams rps;
-		rps.commandList = mCommandList;
+		rps.commandList = commandList;
+		rps.encoder = &encoder;
 		rps.RTVSize = mCbvSrvUavDescriptorSize;
 
-		rps.passCBRootParamIndex = signPI["passCB"];
-		rps.passCBBaseAddr = mFxaaConstantsBuffers->Resource()->GetGPUVirtualAddress();
-		rps.passCBByteSize = mFxaaConstantsBuffers->getElementByteSize();
+		rps.passCBRootParamIndex = params.PassCB;
+		rps.passCBBaseAddr = mCurrFrameResource->FxaaConstantsBuffer.GPU;
+		rps.passCBByteSize = mCurrFrameResource->FxaaConstantsBuffer.ElementByteSize;
 
 		// Draw
+		InstanceBatch batch;
+		batch.MeshID = mBackgroundRenderItem->MeshID;
+		batch.SubMeshID = mBackgroundRenderItem->SubMeshID;
+		batch.Lod = 0;
+		batch.MaterialID = mBackgroundRenderItem->MaterialID;
+		batch.InstanceBase = 0;
+		batch.InstanceNum = 1;
 		DrawPass(
 			rps,
 			mFxaaConstants->getID(),
 			nowColorRenderTarget,
 			nowDSRenderTarget,
-			{mBackgroundRenderItem}
+			{ batch }
 		);
-
-		// Trans back
-		TransSR2RT(mCommandList, {prevColorRenderTarget->GetColorResource()});
 	}
 
 	// Copy to BackBuffer
 	{
-		CopyResource(
-			mCommandList,
+		mRenderGraph.RecordBarriers(commandList.Get(), mRenderGraph.GetBarriers(mScenePasses.Present));
+		commandList->CopyResource(
 			mSwapChain->GetColorResource(),
-			D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_PRESENT,
-			nowColorRenderTarget->GetColorResource(),
-			D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_RENDER_TARGET
+			nowColorRenderTarget->GetColorResource()
 		);
 	}
 
-	// CommandList End Recording
-	{
-		// Done recording commands.
-		ThrowIfFailed(mCommandList->Close());
-	}
-
-	// Execute CommandList
-	{
-		// Add the command list to the queue for execution.
-		ID3D12CommandList* cmdsLists[] = { mCommandList.Get() };
-		mCommandQueue->ExecuteCommandLists(_countof(cmdsLists), cmdsLists);
-	}
-
-	// Swap Chain
-	{
-		// swap the back and front buffers
-		mSwapChain->Swap();
-	}
-
-	// Wait until frame commands are complete.  This waiting is inefficient and is
-	// done for simplicity.  Later we will show how to organize our rendering code
-	// so we do not have to wait per frame.
-	FlushCommandQueue();
+	// Everything back to the states it rests in
+	mRenderGraph.RecordBarriers(commandList.Get(), mRenderGraph.GetFinalBarriers());
 }
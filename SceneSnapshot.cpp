@@ -0,0 +1,428 @@
+#include "SceneSnapshot.h"
+#include <fstream>
+
+using namespace DirectX;
+
+static_assert(SNAPSHOT_INDEX_FORMAT_R16 == DXGI_FORMAT_R16_UINT, "Snapshot index format mismatch");
+static_assert(SNAPSHOT_INDEX_FORMAT_R32 == DXGI_FORMAT_R32_UINT, "Snapshot index format mismatch");
+
+namespace {
+	const UINT64 SNAPSHOT_ALIGNMENT = 16;
+
+	UINT64 AlignUp(UINT64 value) {
+		return (value + SNAPSHOT_ALIGNMENT - 1) & ~(SNAPSHOT_ALIGNMENT - 1);
+	}
+
+	// 0 if the file does not exist
+	UINT64 GetLastWriteTime(const char* filename) {
+		WIN32_FILE_ATTRIBUTE_DATA data;
+		if (!GetFileAttributesExA(filename, GetFileExInfoStandard, &data))
+			return 0;
+		return (static_cast<UINT64>(data.ftLastWriteTime.dwHighDateTime) << 32)
+			| data.ftLastWriteTime.dwLowDateTime;
+	}
+
+	// Zero terminated strings packed in one block
+	class StringTable
+	{
+	public:
+		UINT32 Add(const std::string& str) {
+			UINT32 offset = static_cast<UINT32>(mData.size());
+			mData.insert(mData.end(), str.begin(), str.end());
+			mData.push_back('\0');
+			return offset;
+		}
+		UINT32 Add(const std::wstring& str) {
+			// Keep wide characters aligned
+			while (mData.size() % sizeof(wchar_t) != 0)
+				mData.push_back('\0');
+			UINT32 offset = static_cast<UINT32>(mData.size());
+			const char* begin = reinterpret_cast<const char*>(str.data());
+			mData.insert(mData.end(), begin, begin + str.size() * sizeof(wchar_t));
+			mData.insert(mData.end(), sizeof(wchar_t), '\0');
+			return offset;
+		}
+		const std::vector<char>& GetData()const { return mData; }
+
+	private:
+		std::vector<char> mData;
+	};
+
+	// Read-only view of a whole file
+	class MappedFile
+	{
+	public:
+		~MappedFile() {
+			if (mView)
+				UnmapViewOfFile(mView);
+			if (mMapping)
+				CloseHandle(mMapping);
+			if (mFile != INVALID_HANDLE_VALUE)
+				CloseHandle(mFile);
+		}
+
+		bool Open(const char* filename) {
+			mFile = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, nullptr,
+				OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+			if (mFile == INVALID_HANDLE_VALUE)
+				return false;
+
+			LARGE_INTEGER size;
+			if (!GetFileSizeEx(mFile, &size) || size.QuadPart == 0)
+				return false;
+			mSize = static_cast<UINT64>(size.QuadPart);
+
+			mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (!mMapping)
+				return false;
+			mView = MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+			return mView != nullptr;
+		}
+
+		const BYTE* GetData()const { return static_cast<const BYTE*>(mView); }
+		UINT64 GetSize()const { return mSize; }
+
+	private:
+		HANDLE mFile = INVALID_HANDLE_VALUE;
+		HANDLE mMapping = nullptr;
+		void* mView = nullptr;
+		UINT64 mSize = 0;
+	};
+
+	template<typename T>
+	void AppendTable(std::vector<char>& file, UINT64& offset, const std::vector<T>& table) {
+		file.resize(AlignUp(file.size()), '\0');
+		offset = file.size();
+		const char* begin = reinterpret_cast<const char*>(table.data());
+		file.insert(file.end(), begin, begin + table.size() * sizeof(T));
+	}
+
+	// Only valid after ValidateSnapshot
+	template<typename T>
+	const T* GetTable(const MappedFile& file, UINT64 offset) {
+		return reinterpret_cast<const T*>(file.GetData() + offset);
+	}
+}
+
+bool SceneSnapshot::Save(
+	const char* filename, const char* sourceFilename,
+	std::shared_ptr<Object> root, const std::vector<std::shared_ptr<Texture>>& texs)
+{
+	std::vector<SnapshotObject> objects;
+	std::vector<SnapshotMesh> meshs;
+	std::vector<SnapshotSubMesh> submeshs;
+	std::vector<SnapshotMaterial> materials;
+	std::vector<SnapshotTexture> textures;
+	std::vector<SnapshotRenderItem> items;
+	StringTable strings;
+	std::vector<char> payload;
+
+	// Map IDs to table indices
+	std::unordered_map<UINT, UINT32> meshIndices;
+	std::unordered_map<UINT, UINT32> mtlIndices;
+	std::unordered_map<UINT, UINT32> texIndices; // keyed by slot index
+
+	// Textures
+	for (auto tex : texs) {
+		SnapshotTexture record;
+		std::wstring filepath = tex->GetFilePath();
+		record.Name = strings.Add(tex->GetName());
+		record.FilePath = strings.Add(filepath);
+		record.FilePathLength = static_cast<UINT32>(filepath.size());
+		texIndices[tex->GetSlotIndex()] = static_cast<UINT32>(textures.size());
+		textures.push_back(record);
+	}
+	auto addTextureRef = [&](UINT32 texID) {
+		if (texID == -1)
+			return SNAPSHOT_INVALID_INDEX;
+		auto it = texIndices.find(texID);
+		if (it != texIndices.end())
+			return it->second;
+		for (auto tex : Texture::GetRegistry()) {
+			if (tex->GetSlotIndex() == texID)
+				return SNAPSHOT_TEXTURE_BY_NAME | strings.Add(tex->GetName());
+		}
+		return SNAPSHOT_INVALID_INDEX;
+	};
+
+	auto addMaterial = [&](UINT mtlID) {
+		if (mtlID == Material::GetDefaultMaterialID())
+			return SNAPSHOT_INVALID_INDEX;
+		auto it = mtlIndices.find(mtlID);
+		if (it != mtlIndices.end())
+			return it->second;
+		Material* mtl = Material::FindObjectByID(mtlID);
+		if (!mtl)
+			throw "Invalid material id";
+
+		SnapshotMaterial record;
+		record.Name = strings.Add(mtl->GetName());
+		record.BaseColor = mtl->mBaseColor;
+		record.Metalness = mtl->mMetalness;
+		record.IOR = mtl->mIOR;
+		record.Roughness = mtl->mRoughness;
+		record.LTCMatTex = addTextureRef(mtl->mLTCMatTexID);
+		record.LTCAmpTex = addTextureRef(mtl->mLTCAmpTexID);
+		record.BaseColorTex = addTextureRef(mtl->mBaseColorTexID);
+
+		UINT32 index = static_cast<UINT32>(materials.size());
+		mtlIndices[mtlID] = index;
+		materials.push_back(record);
+		return index;
+	};
+
+	auto addMesh = [&](UINT meshID) {
+		auto it = meshIndices.find(meshID);
+		if (it != meshIndices.end())
+			return it->second;
+		Mesh* mesh = Mesh::FindObjectByID(meshID);
+		if (!mesh)
+			throw "Invalid mesh id";
+
+		SnapshotMesh record = {};
+		record.Name = strings.Add(mesh->GetName());
+		record.SubMeshBegin = static_cast<UINT32>(submeshs.size());
+		record.SubMeshNum = mesh->GetSubMeshNum();
+		record.LodNum = mesh->GetLodNum();
+		record.VertexByteStride = mesh->GetVertexByteStride();
+		record.VertexByteSize = mesh->GetVertexBufferByteSize();
+		record.IndexFormat = mesh->GetIndexFormat();
+		record.IndexByteSize = mesh->GetIndexBufferByteSize();
+
+		const char* vertData = static_cast<const char*>(mesh->GetVertexData());
+		payload.resize(AlignUp(payload.size()), '\0');
+		record.VertexOffset = payload.size();
+		payload.insert(payload.end(), vertData, vertData + record.VertexByteSize);
+
+		const char* indexData = static_cast<const char*>(mesh->GetIndexData());
+		payload.resize(AlignUp(payload.size()), '\0');
+		record.IndexOffset = payload.size();
+		payload.insert(payload.end(), indexData, indexData + record.IndexByteSize);
+
+		for (UINT lod = 0; lod < record.LodNum; lod++) {
+			for (UINT i = 0; i < record.SubMeshNum; i++) {
+				SubMesh submesh = mesh->GetSubMesh(i, lod);
+				SnapshotSubMesh submeshRecord;
+				submeshRecord.IndexCount = submesh.indexCount;
+				submeshRecord.StartIndexLoc = submesh.startIndexLoc;
+				submeshRecord.BaseVertexLoc = submesh.baseVertexLoc;
+				submeshRecord.PrimitiveTopology = submesh.primitiveTopology;
+				submeshRecord.MaterialID = submesh.materialID;
+				submeshRecord.Bounds = submesh.bounds;
+				submeshRecord.BoundingSphere = submesh.boundingSphere;
+				submeshRecord.LodError = mesh->GetLodError(lod);
+				submeshs.push_back(submeshRecord);
+			}
+		}
+
+		UINT32 index = static_cast<UINT32>(meshs.size());
+		meshIndices[meshID] = index;
+		meshs.push_back(record);
+		return index;
+	};
+
+	// Objects, in pre-order
+	std::vector<UINT32> parentStack;
+	root->Traverse(
+		[&](Object& obj) {
+			SnapshotObject record;
+			record.Name = strings.Add(obj.GetName());
+			record.Parent = parentStack.empty() ? SNAPSHOT_INVALID_INDEX : parentStack.back();
+			record.Translation = obj.GetTranslation();
+			record.Rotation = obj.GetRotation();
+			record.Scale = obj.GetScale();
+			record.RenderItemBegin = static_cast<UINT32>(items.size());
+			record.RenderItemNum = static_cast<UINT32>(obj.GetRenderItems().size());
+
+			for (auto& item : obj.GetRenderItems()) {
+				SnapshotRenderItem itemRecord;
+				itemRecord.Mesh = addMesh(item->MeshID);
+				itemRecord.SubMesh = item->SubMeshID;
+				itemRecord.Material = addMaterial(item->MaterialID);
+				itemRecord.PSO = strings.Add(item->PSO);
+				items.push_back(itemRecord);
+			}
+
+			parentStack.push_back(static_cast<UINT32>(objects.size()));
+			objects.push_back(record);
+			return VisitResult::Continue;
+		},
+		[&](Object&) {
+			parentStack.pop_back();
+			return VisitResult::Continue;
+		}
+	);
+
+	// Assemble
+	SnapshotHeader header = {};
+	header.Magic = SNAPSHOT_MAGIC;
+	header.Version = SNAPSHOT_VERSION;
+	header.SourceWriteTime = GetLastWriteTime(sourceFilename);
+	header.ObjectNum = static_cast<UINT32>(objects.size());
+	header.MeshNum = static_cast<UINT32>(meshs.size());
+	header.SubMeshNum = static_cast<UINT32>(submeshs.size());
+	header.MaterialNum = static_cast<UINT32>(materials.size());
+	header.TextureNum = static_cast<UINT32>(textures.size());
+	header.RenderItemNum = static_cast<UINT32>(items.size());
+
+	std::vector<char> file(sizeof(SnapshotHeader), '\0');
+	AppendTable(file, header.ObjectOffset, objects);
+	AppendTable(file, header.MeshOffset, meshs);
+	AppendTable(file, header.SubMeshOffset, submeshs);
+	AppendTable(file, header.MaterialOffset, materials);
+	AppendTable(file, header.TextureOffset, textures);
+	AppendTable(file, header.RenderItemOffset, items);
+	AppendTable(file, header.StringOffset, strings.GetData());
+	header.StringSize = strings.GetData().size();
+	AppendTable(file, header.PayloadOffset, payload);
+	header.PayloadSize = payload.size();
+	header.FileSize = file.size();
+	memcpy(file.data(), &header, sizeof(SnapshotHeader));
+
+	std::ofstream fout(filename, std::ios::binary | std::ios::trunc);
+	if (!fout)
+		return false;
+	fout.write(file.data(), file.size());
+	return static_cast<bool>(fout);
+}
+
+std::shared_ptr<Object> SceneSnapshot::Load(const char* filename, const char* sourceFilename)
+{
+	mMeshs.clear();
+	mMaterials.clear();
+	mTextures.clear();
+
+	auto file = std::make_shared<MappedFile>();
+	if (!file->Open(filename))
+		return nullptr;
+
+	// Nothing below reads outside the file once it passed validation
+	if (!ValidateSnapshot(file->GetData(), file->GetSize()))
+		return nullptr;
+	const SnapshotHeader& header = *reinterpret_cast<const SnapshotHeader*>(file->GetData());
+	// A snapshot shipped without its source is always accepted
+	UINT64 sourceWriteTime = GetLastWriteTime(sourceFilename);
+	if (sourceWriteTime != 0 && sourceWriteTime != header.SourceWriteTime)
+		return nullptr;
+
+	auto objects = GetTable<SnapshotObject>(*file, header.ObjectOffset);
+	auto meshs = GetTable<SnapshotMesh>(*file, header.MeshOffset);
+	auto submeshs = GetTable<SnapshotSubMesh>(*file, header.SubMeshOffset);
+	auto materials = GetTable<SnapshotMaterial>(*file, header.MaterialOffset);
+	auto textures = GetTable<SnapshotTexture>(*file, header.TextureOffset);
+	auto items = GetTable<SnapshotRenderItem>(*file, header.RenderItemOffset);
+	const char* strings = reinterpret_cast<const char*>(file->GetData() + header.StringOffset);
+	const BYTE* payload = file->GetData() + header.PayloadOffset;
+
+	// Textures
+	for (UINT32 i = 0; i < header.TextureNum; i++) {
+		const SnapshotTexture& record = textures[i];
+		auto tex = std::make_shared<Texture>(strings + record.Name);
+		tex->SetFilePath(std::wstring(
+			reinterpret_cast<const wchar_t*>(strings + record.FilePath),
+			record.FilePathLength
+		));
+		mTextures.push_back(tex);
+	}
+	auto resolveTextureRef = [&](UINT32 ref) {
+		if (ref == SNAPSHOT_INVALID_INDEX)
+			return static_cast<UINT32>(-1);
+		if (ref & SNAPSHOT_TEXTURE_BY_NAME) {
+			Texture* tex = Texture::FindByName(strings + (ref & ~SNAPSHOT_TEXTURE_BY_NAME));
+			return tex ? tex->GetSlotIndex() : static_cast<UINT32>(-1);
+		}
+		return mTextures[ref]->GetSlotIndex();
+	};
+
+	// Materials
+	for (UINT32 i = 0; i < header.MaterialNum; i++) {
+		const SnapshotMaterial& record = materials[i];
+		auto mtl = std::make_shared<Material>(strings + record.Name);
+		mtl->mBaseColor = record.BaseColor;
+		mtl->mMetalness = record.Metalness;
+		mtl->mIOR = record.IOR;
+		mtl->mRoughness = record.Roughness;
+		mtl->mLTCMatTexID = resolveTextureRef(record.LTCMatTex);
+		mtl->mLTCAmpTexID = resolveTextureRef(record.LTCAmpTex);
+		mtl->mBaseColorTexID = resolveTextureRef(record.BaseColorTex);
+		mMaterials.push_back(mtl);
+	}
+
+	// Meshs, the payload stays in the mapped file
+	std::shared_ptr<const void> keepAlive = file;
+	for (UINT32 i = 0; i < header.MeshNum; i++) {
+		const SnapshotMesh& record = meshs[i];
+		auto mesh = std::make_shared<Mesh>(strings + record.Name);
+		mesh->SetBufferView(
+			payload + record.VertexOffset, record.VertexByteSize, record.VertexByteStride,
+			payload + record.IndexOffset, record.IndexByteSize,
+			static_cast<DXGI_FORMAT>(record.IndexFormat),
+			keepAlive
+		);
+		for (UINT32 lod = 0; lod < record.LodNum; lod++) {
+			MeshLod meshLod;
+			for (UINT32 j = 0; j < record.SubMeshNum; j++) {
+				const SnapshotSubMesh& submeshRecord = submeshs[record.SubMeshBegin + lod * record.SubMeshNum + j];
+				SubMesh submesh;
+				submesh.indexCount = submeshRecord.IndexCount;
+				submesh.startIndexLoc = submeshRecord.StartIndexLoc;
+				submesh.baseVertexLoc = submeshRecord.BaseVertexLoc;
+				submesh.primitiveTopology = static_cast<D3D_PRIMITIVE_TOPOLOGY>(submeshRecord.PrimitiveTopology);
+				submesh.materialID = submeshRecord.MaterialID;
+				submesh.bounds = submeshRecord.Bounds;
+				submesh.boundingSphere = submeshRecord.BoundingSphere;
+				if (lod == 0)
+					mesh->AddSubMesh(submesh);
+				else
+					meshLod.SubMeshs.push_back(submesh);
+				meshLod.Error = submeshRecord.LodError;
+			}
+			if (lod > 0)
+				mesh->AddLod(meshLod);
+		}
+		mMeshs.push_back(mesh);
+	}
+
+	// Objects
+	std::vector<std::shared_ptr<Object>> objs;
+	objs.reserve(header.ObjectNum);
+	for (UINT32 i = 0; i < header.ObjectNum; i++) {
+		const SnapshotObject& record = objects[i];
+		auto obj = std::make_shared<Object>(strings + record.Name);
+		obj->SetTranslation(record.Translation.x, record.Translation.y, record.Translation.z);
+		obj->SetRotation(record.Rotation.x, record.Rotation.y, record.Rotation.z);
+		obj->SetScale(record.Scale.x, record.Scale.y, record.Scale.z);
+		if (record.Parent != SNAPSHOT_INVALID_INDEX)
+			Object::Link(objs[record.Parent], obj);
+
+		for (UINT32 j = 0; j < record.RenderItemNum; j++) {
+			const SnapshotRenderItem& itemRecord = items[record.RenderItemBegin + j];
+			auto renderItem = std::make_shared<RenderItem>();
+			renderItem->MeshID = mMeshs[itemRecord.Mesh]->GetID();
+			renderItem->SubMeshID = itemRecord.SubMesh;
+			renderItem->MaterialID = itemRecord.Material == SNAPSHOT_INVALID_INDEX
+				? Material::GetDefaultMaterialID()
+				: mMaterials[itemRecord.Material]->GetID();
+			renderItem->PSO = strings + itemRecord.PSO;
+			Object::Link(obj, renderItem);
+		}
+		objs.push_back(obj);
+	}
+
+	return objs[0];
+}
+
+std::vector<std::shared_ptr<Mesh>> SceneSnapshot::GetMeshs()
+{
+	return mMeshs;
+}
+
+std::vector<std::shared_ptr<Material>> SceneSnapshot::GetMaterials()
+{
+	return mMaterials;
+}
+
+std::vector<std::shared_ptr<Texture>> SceneSnapshot::GetTextures()
+{
+	return mTextures;
+}
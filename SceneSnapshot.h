@@ -0,0 +1,34 @@
+#pragma once
+#include "Common/d3dUtil.h"
+
+#include "SnapshotFormat.h"
+
+#include "Material.h"
+#include "Mesh.h"
+#include "Object.h"
+#include "RenderItem.h"
+#include "Texture.h"
+
+class SceneSnapshot
+{
+public:
+	// Write the hierarchy under root and every mesh and material it references.
+	// texs are embedded, other textures used by the materials are referenced by name.
+	// sourceFilename is the file the scene was loaded from, used to detect stale snapshots.
+	// Return false if the file can not be written.
+	static bool Save(
+		const char* filename, const char* sourceFilename,
+		std::shared_ptr<Object> root, const std::vector<std::shared_ptr<Texture>>& texs);
+
+	// Return nullptr if the snapshot is missing, of another version, older than sourceFilename
+	// or fails ValidateSnapshot.
+	std::shared_ptr<Object> Load(const char* filename, const char* sourceFilename);
+	std::vector<std::shared_ptr<Mesh>> GetMeshs();
+	std::vector<std::shared_ptr<Material>> GetMaterials();
+	std::vector<std::shared_ptr<Texture>> GetTextures();
+
+private:
+	std::vector<std::shared_ptr<Mesh>> mMeshs;
+	std::vector<std::shared_ptr<Material>> mMaterials;
+	std::vector<std::shared_ptr<Texture>> mTextures;
+};
@@ -0,0 +1,115 @@
+#pragma once
+#include <vector>
+
+#include "PlatformTypes.h"
+
+// Generational slot map.
+// A handle packs a slot index (low SLOT_INDEX_BITS) and the generation of that slot.
+// Erasing bumps the generation, so stale handles are rejected by Find,
+// and the slot is reused by the next Insert.
+// Values are kept dense (swap-and-pop on erase) for fast iteration.
+// Note: We left UINT32_MAX as an invalid handle.
+const UINT INVALID_SLOT_HANDLE = -1;
+const UINT SLOT_INDEX_BITS = 20;
+const UINT SLOT_INDEX_MASK = (1u << SLOT_INDEX_BITS) - 1;
+const UINT SLOT_GENERATION_MASK = (1u << (32 - SLOT_INDEX_BITS)) - 1;
+
+// Slot index of a handle, stable for the lifetime of the entry.
+// Usable as an index into per-slot GPU arrays.
+inline UINT SlotIndex(UINT handle) { return handle & SLOT_INDEX_MASK; }
+
+template<typename T>
+class SlotMap
+{
+public:
+	UINT Insert(const T& value) {
+		UINT slotIndex;
+		if (mFreeSlots.empty()) {
+			slotIndex = static_cast<UINT>(mSlots.size());
+			if (slotIndex > SLOT_INDEX_MASK)
+				throw "No enough space in SlotMap";
+			mSlots.push_back(Slot());
+		}
+		else {
+			slotIndex = mFreeSlots.back();
+			mFreeSlots.pop_back();
+		}
+
+		Slot& slot = mSlots[slotIndex];
+		slot.DenseIndex = static_cast<UINT>(mValues.size());
+		mValues.push_back(value);
+		mDenseSlots.push_back(slotIndex);
+		return MakeHandle(slotIndex, slot.Generation);
+	}
+
+	bool Erase(UINT handle) {
+		if (!Contains(handle))
+			return false;
+
+		Slot& slot = mSlots[SlotIndex(handle)];
+		UINT denseIndex = slot.DenseIndex;
+		UINT lastIndex = static_cast<UINT>(mValues.size()) - 1;
+		if (denseIndex != lastIndex) {
+			mValues[denseIndex] = mValues[lastIndex];
+			mDenseSlots[denseIndex] = mDenseSlots[lastIndex];
+			mSlots[mDenseSlots[denseIndex]].DenseIndex = denseIndex;
+		}
+		mValues.pop_back();
+		mDenseSlots.pop_back();
+
+		// All-ones would make an invalid handle for the last slot
+		slot.Generation = (slot.Generation + 1) & SLOT_GENERATION_MASK;
+		if (MakeHandle(SlotIndex(handle), slot.Generation) == INVALID_SLOT_HANDLE)
+			slot.Generation = 0;
+		slot.DenseIndex = INVALID_SLOT_HANDLE;
+		mFreeSlots.push_back(SlotIndex(handle));
+		return true;
+	}
+
+	bool Contains(UINT handle)const {
+		UINT slotIndex = SlotIndex(handle);
+		if (handle == INVALID_SLOT_HANDLE || slotIndex >= mSlots.size())
+			return false;
+		const Slot& slot = mSlots[slotIndex];
+		return slot.DenseIndex != INVALID_SLOT_HANDLE && slot.Generation == (handle >> SLOT_INDEX_BITS);
+	}
+
+	// nullptr for invalid or stale handles
+	T* Find(UINT handle) {
+		if (!Contains(handle))
+			return nullptr;
+		return &mValues[mSlots[SlotIndex(handle)].DenseIndex];
+	}
+	const T* Find(UINT handle)const {
+		if (!Contains(handle))
+			return nullptr;
+		return &mValues[mSlots[SlotIndex(handle)].DenseIndex];
+	}
+
+	// Number of live entries
+	UINT Size()const { return static_cast<UINT>(mValues.size()); }
+	// Number of slots ever used, all slot indices are below it
+	UINT Capacity()const { return static_cast<UINT>(mSlots.size()); }
+
+	// Dense iteration over live values, order changes on erase
+	typename std::vector<T>::iterator begin() { return mValues.begin(); }
+	typename std::vector<T>::iterator end() { return mValues.end(); }
+	typename std::vector<T>::const_iterator begin()const { return mValues.begin(); }
+	typename std::vector<T>::const_iterator end()const { return mValues.end(); }
+
+private:
+	struct Slot {
+		UINT DenseIndex = INVALID_SLOT_HANDLE;
+		UINT Generation = 0;
+	};
+
+	static UINT MakeHandle(UINT slotIndex, UINT generation) {
+		return (generation << SLOT_INDEX_BITS) | slotIndex;
+	}
+
+	std::vector<Slot> mSlots;
+	std::vector<UINT> mFreeSlots;
+
+	std::vector<T> mValues;
+	std::vector<UINT> mDenseSlots; // slot index of each value
+};
@@ -0,0 +1,141 @@
+#include "SnapshotFormat.h"
+
+namespace {
+	// [offset, offset + size) lies in [0, limit), without overflowing
+	bool FitsIn(UINT64 offset, UINT64 size, UINT64 limit) {
+		return offset <= limit && size <= limit - offset;
+	}
+
+	template<typename T>
+	const T* GetTable(const BYTE* data, UINT64 size, UINT64 offset, UINT32 num) {
+		if (offset % alignof(T) != 0 || !FitsIn(offset, static_cast<UINT64>(num) * sizeof(T), size))
+			return nullptr;
+		return reinterpret_cast<const T*>(data + offset);
+	}
+}
+
+bool ValidateSnapshot(const BYTE* data, UINT64 size)
+{
+	if (size < sizeof(SnapshotHeader))
+		return false;
+	const SnapshotHeader& header = *reinterpret_cast<const SnapshotHeader*>(data);
+	if (header.Magic != SNAPSHOT_MAGIC || header.Version != SNAPSHOT_VERSION)
+		return false;
+	if (header.FileSize != size || header.ObjectNum == 0)
+		return false;
+
+	// Tables
+	auto objects = GetTable<SnapshotObject>(data, size, header.ObjectOffset, header.ObjectNum);
+	auto meshs = GetTable<SnapshotMesh>(data, size, header.MeshOffset, header.MeshNum);
+	auto submeshs = GetTable<SnapshotSubMesh>(data, size, header.SubMeshOffset, header.SubMeshNum);
+	auto materials = GetTable<SnapshotMaterial>(data, size, header.MaterialOffset, header.MaterialNum);
+	auto textures = GetTable<SnapshotTexture>(data, size, header.TextureOffset, header.TextureNum);
+	auto items = GetTable<SnapshotRenderItem>(data, size, header.RenderItemOffset, header.RenderItemNum);
+	if (!objects || !meshs || !submeshs || !materials || !textures || !items)
+		return false;
+	if (!FitsIn(header.StringOffset, header.StringSize, size)
+		|| !FitsIn(header.PayloadOffset, header.PayloadSize, size))
+		return false;
+
+	// Strings, the table ends with a terminator,
+	// so every offset inside it is a terminated string.
+	const char* strings = reinterpret_cast<const char*>(data + header.StringOffset);
+	if (header.StringSize > 0 && strings[header.StringSize - 1] != '\0')
+		return false;
+	auto validString = [&](UINT32 offset) {
+		return offset < header.StringSize;
+	};
+	auto validTextureRef = [&](UINT32 ref) {
+		if (ref == SNAPSHOT_INVALID_INDEX)
+			return true;
+		if (ref & SNAPSHOT_TEXTURE_BY_NAME)
+			return validString(ref & ~SNAPSHOT_TEXTURE_BY_NAME);
+		return ref < header.TextureNum;
+	};
+
+	// Textures, file paths are wide strings of known length
+	for (UINT32 i = 0; i < header.TextureNum; i++) {
+		const SnapshotTexture& record = textures[i];
+		if (!validString(record.Name))
+			return false;
+		if ((header.StringOffset + record.FilePath) % sizeof(wchar_t) != 0
+			|| !FitsIn(record.FilePath, static_cast<UINT64>(record.FilePathLength) * sizeof(wchar_t), header.StringSize))
+			return false;
+	}
+
+	// Materials
+	for (UINT32 i = 0; i < header.MaterialNum; i++) {
+		const SnapshotMaterial& record = materials[i];
+		if (!validString(record.Name) || !validTextureRef(record.LTCMatTex)
+			|| !validTextureRef(record.LTCAmpTex) || !validTextureRef(record.BaseColorTex))
+			return false;
+	}
+
+	// Meshs, their payload and submeshs
+	const BYTE* payload = data + header.PayloadOffset;
+	for (UINT32 i = 0; i < header.MeshNum; i++) {
+		const SnapshotMesh& record = meshs[i];
+		if (!validString(record.Name) || record.LodNum == 0)
+			return false;
+		if (record.IndexFormat != SNAPSHOT_INDEX_FORMAT_R16 && record.IndexFormat != SNAPSHOT_INDEX_FORMAT_R32)
+			return false;
+		UINT32 indexSize = record.IndexFormat == SNAPSHOT_INDEX_FORMAT_R16 ? 2 : 4;
+
+		// Positions are read as XMFLOAT3 at the start of every vertex
+		if (record.VertexByteStride < sizeof(DirectX::XMFLOAT3) || record.VertexByteStride % sizeof(float) != 0)
+			return false;
+		if ((header.PayloadOffset + record.VertexOffset) % sizeof(float) != 0
+			|| !FitsIn(record.VertexOffset, record.VertexByteSize, header.PayloadSize))
+			return false;
+		if ((header.PayloadOffset + record.IndexOffset) % indexSize != 0
+			|| record.IndexByteSize % indexSize != 0
+			|| !FitsIn(record.IndexOffset, record.IndexByteSize, header.PayloadSize))
+			return false;
+
+		if (!FitsIn(record.SubMeshBegin, static_cast<UINT64>(record.LodNum) * record.SubMeshNum, header.SubMeshNum))
+			return false;
+		UINT32 vertNum = record.VertexByteSize / record.VertexByteStride;
+		UINT32 indexNum = record.IndexByteSize / indexSize;
+		const BYTE* indices = payload + record.IndexOffset;
+		for (UINT32 j = 0; j < record.LodNum * record.SubMeshNum; j++) {
+			const SnapshotSubMesh& submesh = submeshs[record.SubMeshBegin + j];
+			if (!FitsIn(submesh.StartIndexLoc, submesh.IndexCount, indexNum))
+				return false;
+			// Every index, offset by the base vertex, addresses a vertex of the mesh
+			if (submesh.BaseVertexLoc > vertNum)
+				return false;
+			UINT32 maxIndex = vertNum - submesh.BaseVertexLoc;
+			for (UINT32 k = submesh.StartIndexLoc; k < submesh.StartIndexLoc + submesh.IndexCount; k++) {
+				UINT32 index = indexSize == 2
+					? reinterpret_cast<const UINT16*>(indices)[k]
+					: reinterpret_cast<const UINT32*>(indices)[k];
+				if (index >= maxIndex)
+					return false;
+			}
+		}
+	}
+
+	// Objects, a parent precedes its children and only the first object is a root
+	for (UINT32 i = 0; i < header.ObjectNum; i++) {
+		const SnapshotObject& record = objects[i];
+		if (!validString(record.Name))
+			return false;
+		if (i == 0 ? record.Parent != SNAPSHOT_INVALID_INDEX : record.Parent >= i)
+			return false;
+		if (!FitsIn(record.RenderItemBegin, record.RenderItemNum, header.RenderItemNum))
+			return false;
+	}
+
+	// Render items
+	for (UINT32 i = 0; i < header.RenderItemNum; i++) {
+		const SnapshotRenderItem& record = items[i];
+		if (record.Mesh >= header.MeshNum || record.SubMesh >= meshs[record.Mesh].SubMeshNum)
+			return false;
+		if (record.Material != SNAPSHOT_INVALID_INDEX && record.Material >= header.MaterialNum)
+			return false;
+		if (!validString(record.PSO))
+			return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+
+#include "PlatformTypes.h"
+
+// Binary image of a loaded scene.
+// The file is mapped into memory on load, and vertex/index payloads are
+// handed to meshes without being copied. Layout:
+//   SnapshotHeader
+//   object, mesh, submesh, material, texture and render item tables
+//   string table
+//   payload (vertex and index data, 16-byte aligned)
+// Objects are stored in pre-order, so a parent always precedes its children.
+const UINT32 SNAPSHOT_MAGIC = 0x4E534753; // "SGSN"
+const UINT32 SNAPSHOT_VERSION = 3;
+const UINT32 SNAPSHOT_INVALID_INDEX = -1;
+// Texture references with this bit set hold a string offset,
+// and are resolved by name against textures that exist outside the snapshot.
+const UINT32 SNAPSHOT_TEXTURE_BY_NAME = 0x80000000;
+// Index formats, the values of DXGI_FORMAT_R16_UINT and DXGI_FORMAT_R32_UINT
+const UINT32 SNAPSHOT_INDEX_FORMAT_R16 = 57;
+const UINT32 SNAPSHOT_INDEX_FORMAT_R32 = 42;
+
+struct SnapshotHeader {
+	UINT32 Magic;
+	UINT32 Version;
+	UINT64 SourceWriteTime; // last write time of the file the scene came from
+	UINT64 FileSize;
+
+	UINT32 ObjectNum;
+	UINT32 MeshNum;
+	UINT32 SubMeshNum;
+	UINT32 MaterialNum;
+	UINT32 TextureNum;
+	UINT32 RenderItemNum;
+
+	UINT64 ObjectOffset;
+	UINT64 MeshOffset;
+	UINT64 SubMeshOffset;
+	UINT64 MaterialOffset;
+	UINT64 TextureOffset;
+	UINT64 RenderItemOffset;
+	UINT64 StringOffset;
+	UINT64 StringSize;
+	UINT64 PayloadOffset;
+	UINT64 PayloadSize;
+};
+
+struct SnapshotObject {
+	UINT32 Name; // string offset
+	UINT32 Parent; // object index
+	DirectX::XMFLOAT3 Translation;
+	DirectX::XMFLOAT3 Rotation; // in radians
+	DirectX::XMFLOAT3 Scale;
+	UINT32 RenderItemBegin;
+	UINT32 RenderItemNum;
+};
+
+struct SnapshotMesh {
+	UINT32 Name;
+	UINT32 SubMeshBegin; // SubMeshNum submeshs for every LOD, level by level
+	UINT32 SubMeshNum;
+	UINT32 VertexByteStride;
+	UINT32 VertexByteSize;
+	UINT32 IndexFormat;
+	UINT32 IndexByteSize;
+	UINT32 LodNum;
+	UINT64 VertexOffset; // relative to payload
+	UINT64 IndexOffset;
+};
+
+struct SnapshotSubMesh {
+	UINT32 IndexCount;
+	UINT32 StartIndexLoc;
+	UINT32 BaseVertexLoc;
+	UINT32 PrimitiveTopology;
+	UINT32 MaterialID; // local to the owning node, see SubMesh
+	DirectX::BoundingBox Bounds;
+	DirectX::BoundingSphere BoundingSphere;
+	FLOAT LodError; // of the level the submesh belongs to
+};
+
+struct SnapshotMaterial {
+	UINT32 Name;
+	DirectX::XMFLOAT4 BaseColor;
+	FLOAT Metalness;
+	FLOAT IOR;
+	FLOAT Roughness;
+	// Texture index, SNAPSHOT_TEXTURE_BY_NAME | string offset, or invalid
+	UINT32 LTCMatTex;
+	UINT32 LTCAmpTex;
+	UINT32 BaseColorTex;
+};
+
+struct SnapshotTexture {
+	UINT32 Name;
+	UINT32 FilePath; // string offset of wchar_t characters
+	UINT32 FilePathLength; // in characters
+};
+
+struct SnapshotRenderItem {
+	UINT32 Mesh; // mesh index
+	UINT32 SubMesh;
+	UINT32 Material; // material index, invalid means the default material
+	UINT32 PSO; // string offset
+};
+
+// Check that everything the loader reads from a snapshot of size bytes
+// lies inside it: table ranges, cross-table indices, string offsets,
+// payload ranges and the vertex indices of every submesh.
+// The source write time is not checked.
+bool ValidateSnapshot(const BYTE* data, UINT64 size);
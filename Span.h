@@ -0,0 +1,32 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+#include <type_traits>
+
+// Non-owning view of a contiguous range.
+// Lets containers hand out their elements without copying them.
+template<typename T>
+class Span
+{
+public:
+	Span() {}
+	Span(T* data, size_t size)
+		: mData(data), mSize(size) {}
+	template<typename Alloc>
+	Span(const std::vector<typename std::remove_const<T>::type, Alloc>& vec)
+		: mData(vec.data()), mSize(vec.size()) {}
+	template<typename Alloc>
+	Span(std::vector<typename std::remove_const<T>::type, Alloc>& vec)
+		: mData(vec.data()), mSize(vec.size()) {}
+
+	T* begin()const { return mData; }
+	T* end()const { return mData + mSize; }
+	T* data()const { return mData; }
+	size_t size()const { return mSize; }
+	bool empty()const { return mSize == 0; }
+	T& operator[](size_t i)const { return mData[i]; }
+
+private:
+	T* mData = nullptr;
+	size_t mSize = 0;
+};
@@ -0,0 +1,43 @@
+#include "BenchTimer.h"
+#include "BatchTransform.h"
+
+#include <cstdlib>
+#include <vector>
+
+using namespace DirectX;
+
+// Local matrix construction per path, 1M objects, matrices and normal matrices
+int main()
+{
+	const UINT COUNT = 1000000;
+	const int REPEAT_NUM = 10;
+
+	std::vector<XMFLOAT3> translations(COUNT), rotations(COUNT), scales(COUNT);
+	srand(1);
+	for (UINT i = 0; i < COUNT; i++) {
+		float f = (float)rand() / (float)RAND_MAX;
+		translations[i] = { f * 100.0f, f * 50.0f, -f * 20.0f };
+		rotations[i] = { f * 6.0f, f * 3.0f - 1.5f, f * 12.0f };
+		scales[i] = { 0.5f + f, 1.0f, 2.0f - f };
+	}
+	std::vector<XMFLOAT4X4> mats(COUNT), normalMats(COUNT);
+
+	std::vector<BatchTransform::Path> paths = { BatchTransform::Path::Scalar, BatchTransform::Path::SSE };
+	if (BatchTransform::GetBestPath() == BatchTransform::Path::AVX2)
+		paths.push_back(BatchTransform::Path::AVX2);
+
+	std::printf("%u objects, best of %d runs\n", COUNT, REPEAT_NUM);
+	double scalarMs = 0.0;
+	for (auto path : paths) {
+		double ms = BenchBestMs(REPEAT_NUM, [&]() {
+			BatchTransform::BuildLocalMats(path, COUNT, nullptr,
+				translations.data(), rotations.data(), scales.data(),
+				mats.data(), normalMats.data());
+		});
+		if (path == BatchTransform::Path::Scalar)
+			scalarMs = ms;
+		std::printf("%-8s %8.2f ms %6.2f ns/object %5.2fx\n",
+			BatchTransform::GetPathName(path), ms, ms * 1e6 / COUNT, scalarMs / ms);
+	}
+	return 0;
+}
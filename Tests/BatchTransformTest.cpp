@@ -0,0 +1,117 @@
+#include "TestFramework.h"
+#include "BatchTransform.h"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace DirectX;
+
+namespace {
+	struct Inputs {
+		std::vector<XMFLOAT3> Translations;
+		std::vector<XMFLOAT3> Rotations;
+		std::vector<XMFLOAT3> Scales;
+	};
+
+	float RandRange(float a, float b) {
+		return a + (b - a) * (float)rand() / (float)RAND_MAX;
+	}
+
+	// Includes angles far outside [-pi, pi] and negative scales
+	Inputs MakeInputs(UINT count) {
+		srand(7);
+		Inputs inputs;
+		for (UINT i = 0; i < count; i++) {
+			inputs.Translations.push_back({ RandRange(-100.0f, 100.0f), RandRange(-100.0f, 100.0f), RandRange(-100.0f, 100.0f) });
+			inputs.Rotations.push_back({ RandRange(-20.0f, 20.0f), RandRange(-20.0f, 20.0f), RandRange(-20.0f, 20.0f) });
+			inputs.Scales.push_back({ RandRange(0.1f, 3.0f), RandRange(-3.0f, -0.1f), RandRange(0.1f, 3.0f) });
+		}
+		return inputs;
+	}
+
+	void Build(BatchTransform::Path path, const Inputs& inputs, UINT count, const UINT* indices,
+		std::vector<XMFLOAT4X4>& mats, std::vector<XMFLOAT4X4>& normalMats) {
+		mats.assign(count, XMFLOAT4X4());
+		normalMats.assign(count, XMFLOAT4X4());
+		BatchTransform::BuildLocalMats(path, count, indices,
+			inputs.Translations.data(), inputs.Rotations.data(), inputs.Scales.data(),
+			mats.data(), normalMats.data());
+	}
+
+	float MaxDiff(const std::vector<XMFLOAT4X4>& a, const std::vector<XMFLOAT4X4>& b) {
+		float maxDiff = 0.0f;
+		for (size_t i = 0; i < a.size(); i++)
+			for (int r = 0; r < 4; r++)
+				for (int c = 0; c < 4; c++)
+					maxDiff = std::fmax(maxDiff, std::fabs(a[i].m[r][c] - b[i].m[r][c]));
+		return maxDiff;
+	}
+
+	bool SupportAVX2() {
+		return BatchTransform::GetBestPath() == BatchTransform::Path::AVX2;
+	}
+}
+
+// 37 is not a multiple of either lane width, so the padded tail is covered
+const UINT COUNT = 37;
+
+TEST(SSEMatchesScalar)
+{
+	Inputs inputs = MakeInputs(COUNT);
+	std::vector<XMFLOAT4X4> scalarMats, scalarNormalMats, sseMats, sseNormalMats;
+	Build(BatchTransform::Path::Scalar, inputs, COUNT, nullptr, scalarMats, scalarNormalMats);
+	Build(BatchTransform::Path::SSE, inputs, COUNT, nullptr, sseMats, sseNormalMats);
+	CHECK(MaxDiff(scalarMats, sseMats) < 1e-3f);
+	CHECK(MaxDiff(scalarNormalMats, sseNormalMats) < 1e-3f);
+}
+
+TEST(AVX2MatchesSSEBitForBit)
+{
+	if (!SupportAVX2()) {
+		std::printf("  AVX2 not supported, skipped\n");
+		return;
+	}
+	Inputs inputs = MakeInputs(COUNT);
+	std::vector<XMFLOAT4X4> sseMats, sseNormalMats, avxMats, avxNormalMats;
+	Build(BatchTransform::Path::SSE, inputs, COUNT, nullptr, sseMats, sseNormalMats);
+	Build(BatchTransform::Path::AVX2, inputs, COUNT, nullptr, avxMats, avxNormalMats);
+	CHECK(std::memcmp(sseMats.data(), avxMats.data(), COUNT * sizeof(XMFLOAT4X4)) == 0);
+	CHECK(std::memcmp(sseNormalMats.data(), avxNormalMats.data(), COUNT * sizeof(XMFLOAT4X4)) == 0);
+}
+
+TEST(IndicesSelectInputs)
+{
+	Inputs inputs = MakeInputs(COUNT);
+	std::vector<UINT> indices;
+	for (UINT i = 0; i < COUNT; i++)
+		indices.push_back((i * 7) % COUNT);
+
+	std::vector<XMFLOAT4X4> mats, normalMats, indexedMats, indexedNormalMats;
+	Build(BatchTransform::GetBestPath(), inputs, COUNT, nullptr, mats, normalMats);
+	Build(BatchTransform::GetBestPath(), inputs, COUNT, indices.data(), indexedMats, indexedNormalMats);
+	for (UINT i = 0; i < COUNT; i++) {
+		CHECK(std::memcmp(&indexedMats[i], &mats[indices[i]], sizeof(XMFLOAT4X4)) == 0);
+		CHECK(std::memcmp(&indexedNormalMats[i], &normalMats[indices[i]], sizeof(XMFLOAT4X4)) == 0);
+	}
+}
+
+TEST(NormalMatIsInverseTranspose)
+{
+	Inputs inputs = MakeInputs(COUNT);
+	std::vector<XMFLOAT4X4> mats, normalMats;
+	Build(BatchTransform::GetBestPath(), inputs, COUNT, nullptr, mats, normalMats);
+	for (UINT i = 0; i < COUNT; i++) {
+		// Upper 3x3 of mat * transpose(normalMat) is the identity
+		for (int r = 0; r < 3; r++)
+			for (int c = 0; c < 3; c++) {
+				float dot = 0.0f;
+				for (int k = 0; k < 3; k++)
+					dot += mats[i].m[r][k] * normalMats[i].m[c][k];
+				CHECK(std::fabs(dot - (r == c ? 1.0f : 0.0f)) < 1e-4f);
+			}
+		CHECK_EQ(mats[i]._41, inputs.Translations[i].x);
+		CHECK_EQ(normalMats[i]._41, 0.0f);
+	}
+}
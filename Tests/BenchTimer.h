@@ -0,0 +1,32 @@
+#pragma once
+#include <chrono>
+#include <cstdio>
+
+// Wall clock timing for the benchmark executables
+class BenchTimer
+{
+public:
+	BenchTimer() : mStart(std::chrono::steady_clock::now()) {}
+	void Reset() { mStart = std::chrono::steady_clock::now(); }
+	double GetMs()const {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - mStart).count();
+	}
+
+private:
+	std::chrono::steady_clock::time_point mStart;
+};
+
+// Best of repeatNum runs of func, in milliseconds
+template<typename Func>
+double BenchBestMs(int repeatNum, Func&& func)
+{
+	double best = 1e30;
+	for (int i = 0; i < repeatNum; i++) {
+		BenchTimer timer;
+		func();
+		double ms = timer.GetMs();
+		if (ms < best)
+			best = ms;
+	}
+	return best;
+}
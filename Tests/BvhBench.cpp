@@ -0,0 +1,83 @@
+#include "BenchTimer.h"
+#include "Bvh.h"
+
+#include <cmath>
+#include <cstdlib>
+
+using namespace DirectX;
+
+namespace {
+	float RandRange(float a, float b) {
+		return a + (b - a) * (float)rand() / (float)RAND_MAX;
+	}
+
+	BoundingBox RandomBox(float range) {
+		return BoundingBox(
+			XMFLOAT3(RandRange(-range, range), RandRange(-range, range), RandRange(-range, range)),
+			XMFLOAT3(RandRange(0.1f, 1.0f), RandRange(0.1f, 1.0f), RandRange(0.1f, 1.0f)));
+	}
+
+	// Objects spread over a cube whose side grows with the count, so density stays the same
+	void Run(UINT count)
+	{
+		const int REPEAT_NUM = count >= 1000000 ? 5 : 20;
+		const float range = 0.5f * std::cbrt((float)count) * 4.0f;
+
+		srand(count);
+		std::vector<UINT> ids(count);
+		std::vector<BoundingBox> bounds(count);
+		for (UINT i = 0; i < count; i++) {
+			ids[i] = i;
+			bounds[i] = RandomBox(range);
+		}
+
+		Bvh bvh;
+		double buildMs = BenchBestMs(REPEAT_NUM, [&]() { bvh.Build(ids, bounds); });
+
+		// 1% of the objects jitter in place, the usual frame
+		std::vector<UINT> moved;
+		for (UINT i = 0; i < count; i += 100)
+			moved.push_back(i);
+		int frame = 0;
+		auto GetBounds = [&](UINT id, BoundingBox& box) {
+			box = bounds[id];
+			box.Center.x += (frame & 1) ? 0.05f : -0.05f;
+			return true;
+		};
+		double refitMs = BenchBestMs(REPEAT_NUM, [&]() { frame++; bvh.Update(moved, GetBounds); });
+
+		// Everything moves, the worst case of an incremental refit
+		double refitAllMs = BenchBestMs(REPEAT_NUM, [&]() { frame++; bvh.Update(ids, GetBounds); });
+
+		// Camera at the center looking down +z, on the unmoved objects
+		bvh.Build(ids, bounds);
+		XMMATRIX view = XMMatrixLookToLH(XMVectorZero(), XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		XMMATRIX proj = XMMatrixPerspectiveFovLH(0.25f * 3.14159265f, 16.0f / 9.0f, 0.1f, range);
+		Frustum frustum(view * proj);
+		UINT hitNum = 0;
+		double queryMs = BenchBestMs(REPEAT_NUM, [&]() {
+			hitNum = 0;
+			bvh.QueryFrustum(frustum, [&hitNum](UINT) { hitNum++; });
+		});
+		UINT bruteNum = 0;
+		double bruteMs = BenchBestMs(REPEAT_NUM, [&]() {
+			bruteNum = 0;
+			for (auto& box : bounds)
+				bruteNum += frustum.Intersects(box);
+		});
+
+		std::printf("%u objects, %u nodes\n", count, bvh.GetNodeNum());
+		std::printf("  build                %9.3f ms\n", buildMs);
+		std::printf("  refit 1%% moved       %9.3f ms\n", refitMs);
+		std::printf("  refit all moved      %9.3f ms\n", refitAllMs);
+		std::printf("  frustum query        %9.3f ms, %u hits\n", queryMs, hitNum);
+		std::printf("  frustum brute force  %9.3f ms, %u hits\n", bruteMs, bruteNum);
+	}
+}
+
+int main()
+{
+	Run(100000);
+	Run(1000000);
+	return 0;
+}
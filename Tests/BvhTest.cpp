@@ -0,0 +1,182 @@
+#include "TestFramework.h"
+#include "Bvh.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+using namespace DirectX;
+
+namespace {
+	float RandRange(float a, float b) {
+		return a + (b - a) * (float)rand() / (float)RAND_MAX;
+	}
+
+	// Objects scattered over a cube, IDs carry a generation like registry handles
+	struct Scene {
+		std::vector<UINT> IDs;
+		std::vector<BoundingBox> Bounds;
+		std::vector<bool> Alive;
+
+		Scene(UINT count, unsigned seed) {
+			srand(seed);
+			for (UINT i = 0; i < count; i++) {
+				IDs.push_back(((i % 3) << SLOT_INDEX_BITS) | (i * 2));
+				Bounds.push_back(RandomBox(100.0f));
+				Alive.push_back(true);
+			}
+		}
+		static BoundingBox RandomBox(float range) {
+			return BoundingBox(
+				XMFLOAT3(RandRange(-range, range), RandRange(-range, range), RandRange(-range, range)),
+				XMFLOAT3(RandRange(0.1f, 2.0f), RandRange(0.1f, 2.0f), RandRange(0.1f, 2.0f)));
+		}
+		UINT FindIndex(UINT id)const {
+			return static_cast<UINT>(std::find(IDs.begin(), IDs.end(), id) - IDs.begin());
+		}
+		void Update(Bvh& bvh, const std::vector<UINT>& changedIDs)const {
+			bvh.Update(changedIDs, [this](UINT id, BoundingBox& bounds) {
+				UINT i = FindIndex(id);
+				if (i == IDs.size() || !Alive[i])
+					return false;
+				bounds = Bounds[i];
+				return true;
+			});
+		}
+
+		std::vector<UINT> QueryBruteForce(const BoundingSphere& sphere)const {
+			std::vector<UINT> ids;
+			for (UINT i = 0; i < IDs.size(); i++)
+				if (Alive[i] && sphere.Intersects(Bounds[i]))
+					ids.push_back(IDs[i]);
+			std::sort(ids.begin(), ids.end());
+			return ids;
+		}
+	};
+
+	std::vector<UINT> Query(const Bvh& bvh, const BoundingSphere& sphere) {
+		std::vector<UINT> ids;
+		bvh.QuerySphere(sphere, [&ids](UINT id) { ids.push_back(id); });
+		std::sort(ids.begin(), ids.end());
+		return ids;
+	}
+
+	bool QueriesMatch(const Bvh& bvh, const Scene& scene) {
+		for (int i = 0; i < 50; i++) {
+			BoundingSphere sphere(XMFLOAT3(RandRange(-100.0f, 100.0f), RandRange(-100.0f, 100.0f), RandRange(-100.0f, 100.0f)),
+				RandRange(1.0f, 40.0f));
+			if (Query(bvh, sphere) != scene.QueryBruteForce(sphere))
+				return false;
+		}
+		return true;
+	}
+}
+
+TEST(QueriesMatchBruteForce)
+{
+	Scene scene(5000, 1);
+	Bvh bvh;
+	bvh.Build(scene.IDs, scene.Bounds);
+	CHECK_EQ(bvh.GetObjectNum(), 5000u);
+	CHECK(QueriesMatch(bvh, scene));
+}
+
+TEST(RefitFollowsMovedObjects)
+{
+	Scene scene(5000, 2);
+	Bvh bvh;
+	bvh.Build(scene.IDs, scene.Bounds);
+
+	// A few objects jump across the scene, only they are handed to Update
+	std::vector<UINT> moved;
+	for (UINT i = 0; i < scene.IDs.size(); i += 37) {
+		scene.Bounds[i] = Scene::RandomBox(100.0f);
+		moved.push_back(scene.IDs[i]);
+	}
+	scene.Update(bvh, moved);
+	CHECK(QueriesMatch(bvh, scene));
+
+	// Each moved object is found at its new place
+	for (UINT i = 0; i < scene.IDs.size(); i += 37) {
+		std::vector<UINT> hits = Query(bvh, BoundingSphere(scene.Bounds[i].Center, 0.01f));
+		CHECK(std::find(hits.begin(), hits.end(), scene.IDs[i]) != hits.end());
+	}
+}
+
+TEST(UnknownAndGoneObjects)
+{
+	Scene scene(1000, 3);
+	Bvh bvh;
+	bvh.Build(scene.IDs, scene.Bounds);
+
+	// Stale generations and never inserted IDs without bounds are ignored
+	UINT stale = scene.IDs[5] + (1u << SLOT_INDEX_BITS) * 7;
+	scene.Update(bvh, { stale, 1u, 0xFFFFFu });
+	CHECK(QueriesMatch(bvh, scene));
+
+	// Gone objects aren't reported anymore
+	scene.Alive[10] = false;
+	scene.Update(bvh, { scene.IDs[10] });
+	BoundingSphere sphere(scene.Bounds[10].Center, 0.01f);
+	std::vector<UINT> hits = Query(bvh, sphere);
+	CHECK(std::find(hits.begin(), hits.end(), scene.IDs[10]) == hits.end());
+	CHECK(QueriesMatch(bvh, scene));
+}
+
+TEST(RebuildKeepsBoundsMovedMeanwhile)
+{
+	Scene scene(20000, 4);
+	Bvh bvh;
+	bvh.Build(scene.IDs, scene.Bounds);
+
+	// Shuffle everything so the refitted tree degrades and a rebuild starts
+	for (UINT i = 0; i < scene.IDs.size(); i++)
+		scene.Bounds[i] = Scene::RandomBox(100.0f);
+	scene.Update(bvh, scene.IDs);
+	CHECK(bvh.GetCostRatio() > 1.5f);
+
+	// Objects keep moving while it is built
+	auto start = std::chrono::steady_clock::now();
+	while (bvh.GetRebuildNum() == 0 && std::chrono::steady_clock::now() - start < std::chrono::seconds(30)) {
+		std::vector<UINT> moved;
+		for (UINT i = rand() % 100; i < scene.IDs.size(); i += 100) {
+			scene.Bounds[i] = Scene::RandomBox(100.0f);
+			moved.push_back(scene.IDs[i]);
+		}
+		scene.Update(bvh, moved);
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	CHECK_EQ(bvh.GetRebuildNum(), 1u);
+	CHECK(QueriesMatch(bvh, scene));
+}
+
+TEST(ObjectsSeenAfterBuildAreFoundThenInserted)
+{
+	Scene scene(4000, 5);
+	std::vector<UINT> builtIDs(scene.IDs.begin(), scene.IDs.begin() + 3000);
+	std::vector<BoundingBox> builtBounds(scene.Bounds.begin(), scene.Bounds.begin() + 3000);
+	Bvh bvh;
+	bvh.Build(builtIDs, builtBounds);
+
+	// The rest is created later, they are found before any rebuild has finished
+	std::vector<UINT> created(scene.IDs.begin() + 3000, scene.IDs.end());
+	scene.Update(bvh, created);
+	CHECK_EQ(bvh.GetPendingNum(), 1000u);
+	CHECK(QueriesMatch(bvh, scene));
+
+	// One of them is gone, before or after the rebuild inserted it
+	scene.Alive[3500] = false;
+	scene.Update(bvh, { scene.IDs[3500] });
+	CHECK(QueriesMatch(bvh, scene));
+
+	auto start = std::chrono::steady_clock::now();
+	while (bvh.GetRebuildNum() == 0 && std::chrono::steady_clock::now() - start < std::chrono::seconds(30)) {
+		scene.Update(bvh, {});
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	CHECK_EQ(bvh.GetRebuildNum(), 1u);
+	CHECK_EQ(bvh.GetPendingNum(), 0u);
+	CHECK(bvh.GetObjectNum() >= 3999u);
+	CHECK(QueriesMatch(bvh, scene));
+}
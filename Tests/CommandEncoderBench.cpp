@@ -0,0 +1,116 @@
+#include "BenchTimer.h"
+#include "CommandEncoder.h"
+
+#include <vector>
+
+// Cost of the filtering itself, and how many calls a typical pass drops.
+// The command list only counts calls, so the numbers are encoder overhead per call,
+// not the driver time the dropped calls save.
+namespace {
+	struct PipelineState { int Tag; };
+	struct RootSignature { int Tag; };
+	struct VertexBufferView { UINT64 BufferLocation; UINT SizeInBytes; UINT StrideInBytes; };
+	struct IndexBufferView { UINT64 BufferLocation; UINT SizeInBytes; UINT Format; };
+
+	class CountingCommandList
+	{
+	public:
+		void SetPipelineState(PipelineState*) { CallNum++; }
+		void SetGraphicsRootSignature(RootSignature*) { CallNum++; }
+		void IASetVertexBuffers(UINT, UINT, const VertexBufferView*) { CallNum++; }
+		void IASetIndexBuffer(const IndexBufferView*) { CallNum++; }
+		void IASetPrimitiveTopology(int) { CallNum++; }
+		void SetGraphicsRootConstantBufferView(UINT, UINT64) { CallNum++; }
+		void SetGraphicsRootShaderResourceView(UINT, UINT64) { CallNum++; }
+		void SetGraphicsRoot32BitConstant(UINT, UINT, UINT) { CallNum++; }
+		void DrawIndexedInstanced(UINT, UINT, UINT, INT, UINT) { CallNum++; }
+		// volatile, so the direct calls aren't folded away
+		volatile UINT64 CallNum = 0;
+	};
+
+	struct Api {
+		typedef CountingCommandList CommandList;
+		typedef ::PipelineState PipelineState;
+		typedef ::RootSignature RootSignature;
+		typedef ::VertexBufferView VertexBufferView;
+		typedef ::IndexBufferView IndexBufferView;
+		typedef int PrimitiveTopology;
+		typedef UINT64 GpuVirtualAddress;
+		static const int UNDEFINED_TOPOLOGY = 0;
+	};
+
+	// One batch of DrawPass: mesh buffers, topology, material, first instance, draw
+	struct Batch {
+		UINT Mesh;
+		UINT Material;
+		UINT InstanceBase;
+	};
+
+	// Encoder or command list, both have the same calls
+	template<typename Target>
+	void Record(Target& target, const std::vector<Batch>& batches,
+		const std::vector<VertexBufferView>& vbs, const std::vector<IndexBufferView>& ibs,
+		PipelineState* pso, RootSignature* rootSign, void (*setVB)(Target&, const VertexBufferView&), void (*setIB)(Target&, const IndexBufferView&))
+	{
+		target.SetPipelineState(pso);
+		target.SetGraphicsRootSignature(rootSign);
+		target.SetGraphicsRootConstantBufferView(0, 0x1000);
+		target.SetGraphicsRootShaderResourceView(3, 0x2000);
+		for (auto& batch : batches) {
+			setVB(target, vbs[batch.Mesh]);
+			setIB(target, ibs[batch.Mesh]);
+			target.IASetPrimitiveTopology(1);
+			target.SetGraphicsRootConstantBufferView(1, 0x10000 + batch.Material * 256);
+			target.SetGraphicsRoot32BitConstant(2, batch.InstanceBase, 0);
+			target.DrawIndexedInstanced(36, 1, 0, 0, 0);
+		}
+	}
+}
+
+int main()
+{
+	const UINT BATCH_NUM = 100000;
+	const UINT MESH_NUM = 64;
+	const UINT MATERIAL_NUM = 16;
+	const int REPEAT_NUM = 20;
+
+	std::vector<VertexBufferView> vbs(MESH_NUM);
+	std::vector<IndexBufferView> ibs(MESH_NUM);
+	for (UINT m = 0; m < MESH_NUM; m++) {
+		vbs[m] = { 0x100000ull * (m + 1), 4096, 32 };
+		ibs[m] = { 0x800000ull * (m + 1), 1024, 57 };
+	}
+	PipelineState pso = { 1 };
+	RootSignature rootSign = { 1 };
+
+	// Sorted by mesh then material, like the sorted opaque queue
+	std::vector<Batch> batches(BATCH_NUM);
+	for (UINT i = 0; i < BATCH_NUM; i++)
+		batches[i] = { i * MESH_NUM / BATCH_NUM, (i / 7) % MATERIAL_NUM, i };
+
+	CountingCommandList direct;
+	double directMs = BenchBestMs(REPEAT_NUM, [&]() {
+		Record<CountingCommandList>(direct, batches, vbs, ibs, &pso, &rootSign,
+			[](CountingCommandList& list, const VertexBufferView& view) { list.IASetVertexBuffers(0, 1, &view); },
+			[](CountingCommandList& list, const IndexBufferView& view) { list.IASetIndexBuffer(&view); });
+	});
+	UINT64 directCallNum = direct.CallNum / REPEAT_NUM;
+
+	CountingCommandList filtered;
+	UINT issuedNum = 0, skippedNum = 0;
+	double encoderMs = BenchBestMs(REPEAT_NUM, [&]() {
+		CommandEncoder<Api> encoder(&filtered);
+		Record<CommandEncoder<Api>>(encoder, batches, vbs, ibs, &pso, &rootSign,
+			[](CommandEncoder<Api>& e, const VertexBufferView& view) { e.IASetVertexBuffer(view); },
+			[](CommandEncoder<Api>& e, const IndexBufferView& view) { e.IASetIndexBuffer(view); });
+		issuedNum = encoder.GetIssuedNum();
+		skippedNum = encoder.GetSkippedNum();
+	});
+
+	std::printf("%u draws over %u meshes and %u materials\n", BATCH_NUM, MESH_NUM, MATERIAL_NUM);
+	std::printf("  direct   %8.3f ms, %llu calls\n", directMs, (unsigned long long)directCallNum);
+	std::printf("  encoder  %8.3f ms, %u calls forwarded, %u dropped (%.0f%%)\n",
+		encoderMs, issuedNum, skippedNum, 100.0 * skippedNum / (issuedNum + skippedNum));
+	std::printf("  overhead %8.2f ns per call\n", (encoderMs - directMs) * 1e6 / (issuedNum + skippedNum));
+	return 0;
+}
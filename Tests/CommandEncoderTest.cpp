@@ -0,0 +1,173 @@
+#include "TestFramework.h"
+#include "CommandEncoder.h"
+#include "MockCommandList.h"
+
+typedef CommandEncoder<MockEncoderApi> Encoder;
+typedef std::vector<std::string> Calls;
+
+TEST(PipelineStateIsFiltered)
+{
+	MockCommandList list;
+	Encoder encoder(&list);
+	MockPipelineState a = { 1 }, b = { 2 };
+	encoder.SetPipelineState(&a);
+	encoder.SetPipelineState(&a);
+	encoder.SetPipelineState(&b);
+	encoder.SetPipelineState(&a);
+	CHECK(list.Calls == Calls({ "PSO 1", "PSO 2", "PSO 1" }));
+	CHECK_EQ(encoder.GetIssuedNum(), 3u);
+	CHECK_EQ(encoder.GetSkippedNum(), 1u);
+}
+
+TEST(RootSignatureChangeInvalidatesRootArgs)
+{
+	MockCommandList list;
+	Encoder encoder(&list);
+	MockRootSignature a = { 1 }, b = { 2 };
+	encoder.SetGraphicsRootSignature(&a);
+	encoder.SetGraphicsRootConstantBufferView(0, 256);
+	encoder.SetGraphicsRootShaderResourceView(1, 512);
+	encoder.SetGraphicsRoot32BitConstant(2, 7, 0);
+
+	// Same signature again keeps the arguments
+	encoder.SetGraphicsRootSignature(&a);
+	encoder.SetGraphicsRootConstantBufferView(0, 256);
+	encoder.SetGraphicsRootShaderResourceView(1, 512);
+	encoder.SetGraphicsRoot32BitConstant(2, 7, 0);
+	CHECK_EQ(list.Calls.size(), 4u);
+
+	// Another signature leaves them undefined, all are set again
+	encoder.SetGraphicsRootSignature(&b);
+	encoder.SetGraphicsRootConstantBufferView(0, 256);
+	encoder.SetGraphicsRootShaderResourceView(1, 512);
+	encoder.SetGraphicsRoot32BitConstant(2, 7, 0);
+	CHECK(list.Calls == Calls({
+		"RootSign 1", "RootCBV 0 256", "RootSRV 1 512", "RootConst 2 7 0",
+		"RootSign 2", "RootCBV 0 256", "RootSRV 1 512", "RootConst 2 7 0" }));
+}
+
+TEST(VertexBufferComparesEveryField)
+{
+	MockCommandList list;
+	Encoder encoder(&list);
+	MockVertexBufferView view = { 4096, 1024, 32 };
+	encoder.IASetVertexBuffer(view);
+	encoder.IASetVertexBuffer(view);
+	MockVertexBufferView otherSize = { 4096, 2048, 32 };
+	MockVertexBufferView otherStride = { 4096, 2048, 16 };
+	MockVertexBufferView otherLocation = { 8192, 2048, 16 };
+	encoder.IASetVertexBuffer(otherSize);
+	encoder.IASetVertexBuffer(otherStride);
+	encoder.IASetVertexBuffer(otherLocation);
+	encoder.IASetVertexBuffer(otherLocation);
+	CHECK_EQ(list.Calls.size(), 4u);
+	CHECK_EQ(list.Calls[0], std::string("VB 0 1 4096"));
+	CHECK_EQ(encoder.GetSkippedNum(), 2u);
+}
+
+TEST(IndexBufferComparesEveryField)
+{
+	MockCommandList list;
+	Encoder encoder(&list);
+	MockIndexBufferView view = { 4096, 1024, 57 };
+	MockIndexBufferView otherFormat = { 4096, 1024, 42 };
+	MockIndexBufferView otherSize = { 4096, 512, 42 };
+	encoder.IASetIndexBuffer(view);
+	encoder.IASetIndexBuffer(view);
+	encoder.IASetIndexBuffer(otherFormat);
+	encoder.IASetIndexBuffer(otherSize);
+	encoder.IASetIndexBuffer(otherSize);
+	CHECK_EQ(list.Calls.size(), 3u);
+	CHECK_EQ(encoder.GetSkippedNum(), 2u);
+}
+
+TEST(TopologyIsFiltered)
+{
+	MockCommandList list;
+	Encoder encoder(&list);
+	encoder.IASetPrimitiveTopology(MOCK_TOPOLOGY_TRIANGLELIST);
+	encoder.IASetPrimitiveTopology(MOCK_TOPOLOGY_TRIANGLELIST);
+	encoder.IASetPrimitiveTopology(MOCK_TOPOLOGY_LINELIST);
+	CHECK(list.Calls == Calls({ "Topology 1", "Topology 2" }));
+}
+
+TEST(RootViewsAreFilteredPerIndex)
+{
+	MockCommandList list;
+	Encoder encoder(&list);
+	encoder.SetGraphicsRootConstantBufferView(0, 256);
+	encoder.SetGraphicsRootConstantBufferView(1, 256);
+	encoder.SetGraphicsRootConstantBufferView(0, 256);
+	encoder.SetGraphicsRootConstantBufferView(0, 512);
+	encoder.SetGraphicsRootShaderResourceView(3, 1024);
+	encoder.SetGraphicsRootShaderResourceView(3, 1024);
+	CHECK(list.Calls == Calls({ "RootCBV 0 256", "RootCBV 1 256", "RootCBV 0 512", "RootSRV 3 1024" }));
+
+	// Indices beyond the remembered ones are always forwarded
+	encoder.SetGraphicsRootConstantBufferView(ENCODER_ROOT_PARAM_NUM, 256);
+	encoder.SetGraphicsRootConstantBufferView(ENCODER_ROOT_PARAM_NUM, 256);
+	CHECK_EQ(list.Calls.size(), 6u);
+}
+
+TEST(ConstantsAtOtherOffsetsAreForwardedAndForgetOffsetZero)
+{
+	MockCommandList list;
+	Encoder encoder(&list);
+	encoder.SetGraphicsRoot32BitConstant(4, 10, 0);
+	encoder.SetGraphicsRoot32BitConstant(4, 10, 0);
+	CHECK_EQ(list.Calls.size(), 1u);
+
+	// offset != 0 is never filtered
+	encoder.SetGraphicsRoot32BitConstant(4, 20, 1);
+	encoder.SetGraphicsRoot32BitConstant(4, 20, 1);
+	CHECK_EQ(list.Calls.size(), 3u);
+
+	// and the value at offset 0 isn't trusted afterwards
+	encoder.SetGraphicsRoot32BitConstant(4, 10, 0);
+	encoder.SetGraphicsRoot32BitConstant(4, 10, 0);
+	CHECK(list.Calls == Calls({ "RootConst 4 10 0", "RootConst 4 20 1", "RootConst 4 20 1", "RootConst 4 10 0" }));
+	CHECK_EQ(encoder.GetIssuedNum(), 4u);
+	CHECK_EQ(encoder.GetSkippedNum(), 2u);
+
+	// Other parameters keep their value
+	encoder.SetGraphicsRoot32BitConstant(5, 1, 0);
+	encoder.SetGraphicsRoot32BitConstant(4, 20, 2);
+	encoder.SetGraphicsRoot32BitConstant(5, 1, 0);
+	CHECK_EQ(list.Calls.size(), 6u);
+}
+
+TEST(DrawsAreNeverFiltered)
+{
+	MockCommandList list;
+	Encoder encoder(&list);
+	encoder.DrawIndexedInstanced(36, 2, 0, 0, 0);
+	encoder.DrawIndexedInstanced(36, 2, 0, 0, 0);
+	CHECK(list.Calls == Calls({ "Draw 36 2 0 0 0", "Draw 36 2 0 0 0" }));
+	CHECK_EQ(encoder.GetIssuedNum(), 2u);
+}
+
+TEST(InvalidateForwardsEverythingAgain)
+{
+	MockCommandList list;
+	Encoder encoder(&list);
+	MockPipelineState pso = { 1 };
+	MockRootSignature rootSign = { 1 };
+	MockVertexBufferView vb = { 4096, 1024, 32 };
+	MockIndexBufferView ib = { 8192, 512, 57 };
+	auto SetAll = [&]() {
+		encoder.SetPipelineState(&pso);
+		encoder.SetGraphicsRootSignature(&rootSign);
+		encoder.IASetVertexBuffer(vb);
+		encoder.IASetIndexBuffer(ib);
+		encoder.IASetPrimitiveTopology(MOCK_TOPOLOGY_TRIANGLELIST);
+		encoder.SetGraphicsRootConstantBufferView(0, 256);
+		encoder.SetGraphicsRoot32BitConstant(1, 3, 0);
+	};
+	SetAll();
+	SetAll();
+	CHECK_EQ(list.Calls.size(), 7u);
+	encoder.Invalidate();
+	SetAll();
+	CHECK_EQ(list.Calls.size(), 14u);
+	CHECK_EQ(encoder.GetSkippedNum(), 7u);
+}
@@ -0,0 +1,133 @@
+#include "TestFramework.h"
+#include "DescriptorAllocator.h"
+#include "FrameRing.h"
+#include "MockFrameFence.h"
+
+#include <algorithm>
+#include <random>
+
+namespace {
+	struct Range {
+		UINT Start;
+		UINT Num;
+	};
+	bool Overlap(const Range& a, const Range& b) {
+		return a.Start < b.Start + b.Num && b.Start < a.Start + a.Num;
+	}
+}
+
+TEST(FreeListRandomAllocFreeReturnsToOneRange)
+{
+	const UINT START = 100, NUM = 1000;
+	std::mt19937 rng(1);
+	DescriptorFreeList list(START, NUM);
+	std::vector<Range> live;
+	for (int step = 0; step < 20000; step++) {
+		if (live.empty() || rng() % 2 == 0) {
+			UINT num = 1 + rng() % 16;
+			if (num > list.GetLargestFreeNum()) {
+				CHECK_THROWS(list.Alloc(num));
+				continue;
+			}
+			Range range = { list.Alloc(num), num };
+			CHECK(range.Start >= START && range.Start + num <= START + NUM);
+			for (const Range& other : live)
+				CHECK(!Overlap(range, other));
+			live.push_back(range);
+		}
+		else {
+			size_t i = rng() % live.size();
+			list.Free(live[i].Start, live[i].Num);
+			live[i] = live.back();
+			live.pop_back();
+		}
+	}
+
+	// Free the rest in random order, the neighbours merge back into one range
+	std::shuffle(live.begin(), live.end(), rng);
+	for (const Range& range : live)
+		list.Free(range.Start, range.Num);
+	CHECK_EQ(list.GetFreeNum(), NUM);
+	CHECK_EQ(list.GetFreeRangeNum(), 1u);
+	CHECK_EQ(list.GetLargestFreeNum(), NUM);
+	CHECK_EQ(list.Alloc(NUM), START);
+}
+
+TEST(FreeListRejectsDoubleFreeAndOutOfRange)
+{
+	DescriptorFreeList list(10, 20);
+	UINT a = list.Alloc(4);
+	UINT b = list.Alloc(4);
+	list.Free(a, 4);
+	CHECK_THROWS(list.Free(a, 4));
+	CHECK_THROWS(list.Free(a + 2, 4)); // half already free
+	CHECK_THROWS(list.Free(9, 1));
+	CHECK_THROWS(list.Free(29, 2));
+	CHECK_THROWS(list.Alloc(0));
+	CHECK_THROWS(list.Alloc(17)); // 16 free after b
+	list.Free(b, 4);
+	CHECK_EQ(list.GetFreeNum(), 20u);
+	CHECK_EQ(list.GetFreeRangeNum(), 1u);
+}
+
+TEST(RingWithThreeFramesInFlight)
+{
+	const UINT FRAME_NUM = 3;
+	const UINT START = 50, NUM = 64;
+	std::mt19937 rng(2);
+	MockFrameFence fence;
+	FrameRing frames(&fence, FRAME_NUM);
+	DescriptorRing ring(START, NUM, FRAME_NUM);
+
+	// Ranges of the frames the GPU may still read, by frame resource
+	std::vector<std::vector<Range>> inFlight(FRAME_NUM);
+	for (UINT frame = 1; frame <= 1000; frame++) {
+		UINT frameIndex = frames.BeginFrame();
+		ring.BeginFrame(frameIndex);
+		inFlight[frameIndex].clear();
+
+		// At most 15 a frame, three frames and a skipped end fit in 64
+		UINT allocNum = rng() % 4;
+		for (UINT i = 0; i < allocNum; i++) {
+			UINT num = 1 + rng() % 5;
+			Range range = { ring.Alloc(num), num };
+			CHECK(range.Start >= START && range.Start + num <= START + NUM);
+			for (auto& ranges : inFlight)
+				for (const Range& other : ranges)
+					CHECK(!Overlap(range, other));
+			inFlight[frameIndex].push_back(range);
+		}
+		CHECK(ring.GetUsedNum() <= NUM);
+		frames.EndFrame();
+
+		// The GPU runs two frames behind
+		if (frame > FRAME_NUM - 1)
+			fence.Complete(frame - (FRAME_NUM - 1));
+	}
+	CHECK_EQ(frames.GetWaitNum(), 0u);
+}
+
+TEST(RingReleasesAFrameWhenItsResourceIsBegunAgain)
+{
+	DescriptorRing ring(0, 10, 2);
+	ring.BeginFrame(0);
+	CHECK_EQ(ring.Alloc(6), 0u);
+	ring.BeginFrame(1);
+	CHECK_EQ(ring.Alloc(4), 6u);
+	CHECK_THROWS(ring.Alloc(1)); // frames 0 and 1 hold all ten
+
+	// Frame resource 0 again: its six are free, the range skips nothing
+	ring.BeginFrame(0);
+	CHECK_EQ(ring.GetUsedNum(), 4u);
+	CHECK_EQ(ring.Alloc(6), 0u);
+	CHECK_THROWS(ring.Alloc(1));
+
+	// Contiguous ranges skip the slots left at the end
+	ring.BeginFrame(1);
+	CHECK_EQ(ring.Alloc(3), 6u);
+	ring.BeginFrame(0);
+	CHECK_EQ(ring.Alloc(2), 0u); // 9 is skipped
+	CHECK_THROWS(ring.Alloc(0));
+	CHECK_THROWS(ring.Alloc(11));
+	CHECK_THROWS(ring.BeginFrame(2));
+}
@@ -0,0 +1,94 @@
+#include "TestFramework.h"
+#include "FrameRing.h"
+#include "MockFrameFence.h"
+
+namespace {
+	// A GPU that makes no progress until the CPU waits, then finishes everything submitted
+	class DrainingFrameFence : public MockFrameFence
+	{
+	public:
+		void WaitFor(UINT64 value) override {
+			MockFrameFence::WaitFor(value);
+			Complete(GetSignaledValue());
+		}
+	};
+}
+
+TEST(NeedsOneFrame)
+{
+	MockFrameFence fence;
+	CHECK_THROWS(FrameRing(&fence, 0));
+}
+
+TEST(CyclesFrameIndices)
+{
+	MockFrameFence fence;
+	FrameRing ring(&fence, 3);
+	for (UINT i = 0; i < 7; i++) {
+		CHECK_EQ(ring.BeginFrame(), i % 3);
+		ring.EndFrame();
+		CHECK_EQ(ring.GetFenceValue(i % 3), static_cast<UINT64>(i + 1));
+		fence.Complete(i + 1);
+	}
+	CHECK_EQ(ring.GetWaitNum(), 0u);
+}
+
+TEST(GpuTwoFramesBehindNeverWaits)
+{
+	const UINT FRAME_NUM = 3;
+	MockFrameFence fence;
+	FrameRing ring(&fence, FRAME_NUM);
+	for (UINT frame = 1; frame <= 100; frame++) {
+		ring.BeginFrame();
+		ring.EndFrame();
+		// The GPU finishes frame n - 2 while the CPU records frame n
+		if (frame > FRAME_NUM - 1)
+			fence.Complete(frame - (FRAME_NUM - 1));
+	}
+	CHECK_EQ(ring.GetWaitNum(), 0u);
+	CHECK_EQ(fence.GetWaitNum(), 0u);
+	CHECK_EQ(fence.GetSignaledValue(), 100u);
+}
+
+TEST(StalledGpuWaitsOncePerLap)
+{
+	const UINT FRAME_NUM = 3;
+	DrainingFrameFence fence;
+	FrameRing ring(&fence, FRAME_NUM);
+
+	// The first lap uses fresh frame resources
+	for (UINT frame = 1; frame <= FRAME_NUM; frame++) {
+		ring.BeginFrame();
+		ring.EndFrame();
+	}
+	CHECK_EQ(ring.GetWaitNum(), 0u);
+
+	// Every later lap waits for its first frame, which drains the GPU for the rest of it
+	const UINT LAP_NUM = 10;
+	for (UINT lap = 1; lap <= LAP_NUM; lap++) {
+		for (UINT i = 0; i < FRAME_NUM; i++) {
+			ring.BeginFrame();
+			CHECK_EQ(ring.GetWaitNum(), lap);
+			ring.EndFrame();
+		}
+	}
+	CHECK_EQ(fence.GetWaitNum(), LAP_NUM);
+}
+
+TEST(WaitsForTheFrameLastUsingTheResource)
+{
+	MockFrameFence fence;
+	FrameRing ring(&fence, 2);
+	ring.BeginFrame();
+	ring.EndFrame(); // value 1 in resource 0
+	ring.BeginFrame();
+	ring.EndFrame(); // value 2 in resource 1
+
+	// Nothing completed, reusing resource 0 waits for 1 only
+	CHECK_EQ(ring.BeginFrame(), 0u);
+	CHECK_EQ(fence.GetCompletedValue(), 1u);
+	ring.EndFrame();
+	CHECK_EQ(ring.BeginFrame(), 1u);
+	CHECK_EQ(fence.GetCompletedValue(), 2u);
+	CHECK_EQ(ring.GetWaitNum(), 2u);
+}
@@ -0,0 +1,123 @@
+#include "TestFramework.h"
+#include "HeapPacker.h"
+
+#include <random>
+
+namespace {
+	const UINT64 KB = 1024;
+
+	bool MemoryOverlaps(const HeapPacker& packer, UINT a, UINT b, const std::vector<UINT64>& sizes) {
+		UINT64 beginA = packer.GetOffset(a), beginB = packer.GetOffset(b);
+		return beginA < beginB + sizes[b] && beginB < beginA + sizes[a];
+	}
+}
+
+TEST(OverlappingLifetimesGetDisjointMemory)
+{
+	HeapPacker packer;
+	UINT a = packer.AddResource(64 * KB, 64 * KB, 0, 2);
+	UINT b = packer.AddResource(64 * KB, 64 * KB, 2, 3); // shares pass 2 with a
+	UINT c = packer.AddResource(64 * KB, 64 * KB, 3, 4); // disjoint from a
+	CHECK_EQ(packer.Pack(), 128 * KB);
+	CHECK_EQ(packer.GetOffset(a), 0u);
+	CHECK_EQ(packer.GetOffset(b), 64 * KB);
+	CHECK_EQ(packer.GetOffset(c), 0u); // reuses the memory of a
+	CHECK_EQ(packer.GetUnaliasedSize(), 192 * KB);
+}
+
+TEST(SmallResourceFillsAnAlignedGap)
+{
+	HeapPacker packer;
+	// Alive in pass 0 only, leaves a hole in the middle for the later resources
+	UINT hole = packer.AddResource(256 * KB, 64 * KB, 0, 0);
+	UINT low = packer.AddResource(192 * KB, 64 * KB, 0, 1);
+	UINT high = packer.AddResource(128 * KB, 64 * KB, 1, 1);
+	// Needs 4 MB alignment, and offset 0 is taken
+	UINT msaa = packer.AddResource(64 * KB, 4096 * KB, 1, 1);
+	// Fits between low and high, after aligning up
+	UINT small = packer.AddResource(32 * KB, 64 * KB, 1, 1);
+	packer.Pack();
+
+	CHECK_EQ(packer.GetOffset(hole), 0u);
+	CHECK_EQ(packer.GetOffset(low), 256 * KB);
+	CHECK_EQ(packer.GetOffset(high), 0u);
+	CHECK_EQ(packer.GetOffset(small), 128 * KB);
+	CHECK_EQ(packer.GetOffset(msaa), 4096 * KB);
+	CHECK_EQ(packer.GetHeapSize(), 4160 * KB);
+	for (UINT i = 0; i < 5; i++)
+		CHECK_EQ(packer.GetOffset(i) % (i == msaa ? 4096 * KB : 64 * KB), 0u);
+}
+
+TEST(UnusedResourcesShareWithAnything)
+{
+	HeapPacker packer;
+	UINT a = packer.AddResource(64 * KB, 64 * KB, 0, 5);
+	UINT b = packer.AddResource(64 * KB, 64 * KB, 0, 5);
+	UINT unused = packer.AddResource(128 * KB, 64 * KB, 1, 0); // last < first
+	CHECK_EQ(packer.Pack(), 128 * KB);
+	CHECK_EQ(packer.GetOffset(unused), 0u);
+	CHECK(packer.GetOffset(a) != packer.GetOffset(b));
+}
+
+TEST(RandomPacksNeverAliasLiveResources)
+{
+	std::mt19937 rng(3);
+	HeapPacker packer;
+	std::vector<UINT64> sizes;
+	std::vector<UINT> firsts, lasts;
+	for (int round = 0; round < 200; round++) {
+		packer.Clear();
+		sizes.clear(); firsts.clear(); lasts.clear();
+		UINT num = 1 + rng() % 12;
+		for (UINT i = 0; i < num; i++) {
+			UINT64 size = (1 + rng() % 64) * KB;
+			UINT64 alignment = rng() % 4 == 0 ? 4096 * KB : 64 * KB;
+			UINT first = rng() % 8, last = first + rng() % 4;
+			if (rng() % 8 == 0)
+				last = first - 1; // unused
+			packer.AddResource(size, alignment, first, last);
+			sizes.push_back(size); firsts.push_back(first); lasts.push_back(last);
+		}
+		UINT64 heapSize = packer.Pack();
+		for (UINT i = 0; i < num; i++) {
+			CHECK(packer.GetOffset(i) + sizes[i] <= heapSize);
+			for (UINT j = i + 1; j < num; j++) {
+				bool used = firsts[i] <= lasts[i] && firsts[j] <= lasts[j];
+				bool alive = used && firsts[i] <= lasts[j] && firsts[j] <= lasts[i];
+				if (alive)
+					CHECK(!MemoryOverlaps(packer, i, j, sizes));
+			}
+		}
+	}
+}
+
+TEST(PackingIsDeterministic)
+{
+	// Equal sizes are placed in the order added
+	HeapPacker packer;
+	for (UINT i = 0; i < 4; i++)
+		packer.AddResource(64 * KB, 64 * KB, 0, 0);
+	packer.Pack();
+	for (UINT i = 0; i < 4; i++)
+		CHECK_EQ(packer.GetOffset(i), i * 64 * KB);
+
+	// Packing the same resources again gives the same offsets
+	std::mt19937 rng(5);
+	HeapPacker first, second;
+	for (UINT i = 0; i < 20; i++) {
+		UINT64 size = (1 + rng() % 4) * 64 * KB;
+		UINT pass = rng() % 6;
+		first.AddResource(size, 64 * KB, pass, pass + 1);
+		second.AddResource(size, 64 * KB, pass, pass + 1);
+	}
+	CHECK_EQ(first.Pack(), second.Pack());
+	CHECK_EQ(first.Pack(), second.GetHeapSize());
+	for (UINT i = 0; i < 20; i++)
+		CHECK_EQ(first.GetOffset(i), second.GetOffset(i));
+}
+
+TEST(ZeroAlignmentThrows)
+{
+	HeapPacker packer;
+	CHECK_THROWS(packer.AddResource(64 * KB, 0, 0, 0));
+}
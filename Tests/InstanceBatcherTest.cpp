@@ -0,0 +1,167 @@
+#include "TestFramework.h"
+#include "InstanceBatcher.h"
+
+namespace {
+	// The fields InstanceBatcher reads from a RenderItem
+	struct Item {
+		UINT MeshID;
+		UINT SubMeshID;
+		UINT MaterialID;
+		UINT ObjectID;
+		UINT Lod;
+	};
+	typedef std::vector<std::shared_ptr<Item>> Queue;
+
+	std::shared_ptr<Item> MakeItem(UINT mesh, UINT submesh, UINT material, UINT object, UINT lod = 0) {
+		return std::make_shared<Item>(Item{ mesh, submesh, material, object, lod });
+	}
+
+	// Mesh 0 has 3 LODs, mesh 1 has none, other meshes don't exist
+	UINT GetLodNum(UINT meshID) {
+		return meshID == 0 ? 3 : (meshID == 1 ? 1 : 0);
+	}
+
+	std::vector<UINT> GetBatchInstances(const InstanceBatcher& batcher, const InstanceBatch& batch) {
+		const auto& instances = batcher.GetInstances();
+		return std::vector<UINT>(instances.begin() + batch.InstanceBase, instances.begin() + batch.InstanceBase + batch.InstanceNum);
+	}
+}
+
+TEST(ItemsGroupByMeshSubMeshLodAndMaterial)
+{
+	Queue queue = {
+		MakeItem(0, 0, 7, 10),
+		MakeItem(0, 0, 7, 11),
+		MakeItem(0, 1, 7, 12),    // other submesh
+		MakeItem(0, 0, 8, 13),    // other material
+		MakeItem(0, 0, 7, 14, 1), // other LOD
+		MakeItem(1, 0, 7, 15),    // other mesh
+		MakeItem(0, 0, 7, 16),
+	};
+	InstanceBatcher batcher;
+	std::vector<InstanceBatch> batches;
+	batcher.Batch(queue, 0, GetLodNum, batches);
+
+	// In the order their first item appears
+	CHECK_EQ(batches.size(), 5u);
+	CHECK_EQ(batches[0].InstanceNum, 3u);
+	CHECK(batches[1].SubMeshID == 1 && batches[1].InstanceNum == 1);
+	CHECK(batches[2].MaterialID == 8 && batches[2].InstanceNum == 1);
+	CHECK(batches[3].Lod == 1 && batches[3].InstanceNum == 1);
+	CHECK(batches[4].MeshID == 1 && batches[4].InstanceNum == 1);
+	CHECK_EQ(batcher.GetInstances().size(), queue.size());
+}
+
+TEST(LodBiasIsClamped)
+{
+	Queue queue = {
+		MakeItem(0, 0, 0, 1, 0),
+		MakeItem(0, 0, 0, 2, 1),
+		MakeItem(0, 0, 0, 3, 2),
+		MakeItem(1, 0, 0, 4, 0),
+		MakeItem(0, 0, 0, 5, 5), // beyond the last LOD already
+	};
+	InstanceBatcher batcher;
+	std::vector<InstanceBatch> batches;
+
+	batcher.Batch(queue, 1, GetLodNum, batches);
+	CHECK_EQ(batches.size(), 3u);
+	CHECK(batches[0].Lod == 1 && batches[0].InstanceNum == 1);
+	CHECK(batches[1].Lod == 2 && batches[1].InstanceNum == 3);
+	CHECK(batches[2].MeshID == 1 && batches[2].Lod == 0);
+
+	// A huge bias doesn't wrap around
+	batcher.Batch(queue, UINT(-1) - 1, GetLodNum, batches);
+	CHECK_EQ(batches.size(), 2u);
+	CHECK_EQ(batches[0].Lod, 2u);
+}
+
+TEST(UnknownMeshThrows)
+{
+	Queue queue = { MakeItem(0, 0, 0, 1), MakeItem(9, 0, 0, 2) };
+	InstanceBatcher batcher;
+	std::vector<InstanceBatch> batches;
+	CHECK_THROWS(batcher.Batch(queue, 0, GetLodNum, batches));
+}
+
+TEST(InstancesKeepQueueOrderInsideABatch)
+{
+	// Sorted queues stay sorted inside each batch, e.g. front to back
+	Queue queue = {
+		MakeItem(0, 0, 0, 5),
+		MakeItem(1, 0, 0, 9),
+		MakeItem(0, 0, 0, 3),
+		MakeItem(1, 0, 0, 1),
+		MakeItem(0, 0, 0, 7),
+	};
+	InstanceBatcher batcher;
+	std::vector<InstanceBatch> batches;
+	batcher.Batch(queue, 0, GetLodNum, batches);
+	CHECK_EQ(batches.size(), 2u);
+	CHECK(GetBatchInstances(batcher, batches[0]) == std::vector<UINT>({ 5, 3, 7 }));
+	CHECK(GetBatchInstances(batcher, batches[1]) == std::vector<UINT>({ 9, 1 }));
+}
+
+TEST(InstancesAreObjectSlotIndices)
+{
+	UINT handle = (3u << SLOT_INDEX_BITS) | 42;
+	Queue queue = { MakeItem(0, 0, 0, handle) };
+	InstanceBatcher batcher;
+	std::vector<InstanceBatch> batches;
+	batcher.Batch(queue, 0, GetLodNum, batches);
+	CHECK_EQ(batcher.GetInstances()[0], 42u);
+}
+
+TEST(RangesAreContiguousAcrossBatchCalls)
+{
+	// The main view and two shadow views share one instance array
+	Queue view = { MakeItem(0, 0, 0, 1), MakeItem(1, 0, 0, 2), MakeItem(0, 0, 0, 3) };
+	Queue shadow0 = { MakeItem(1, 0, 0, 4), MakeItem(0, 0, 0, 5) };
+	Queue shadow1 = { MakeItem(0, 0, 0, 6), MakeItem(0, 0, 0, 7), MakeItem(0, 1, 0, 8) };
+	InstanceBatcher batcher;
+	std::vector<InstanceBatch> viewBatches, shadow0Batches, shadow1Batches, emptyBatches;
+	batcher.Clear();
+	batcher.Batch(view, 0, GetLodNum, viewBatches);
+	batcher.Batch(shadow0, 1, GetLodNum, shadow0Batches);
+	batcher.Batch(Queue(), 1, GetLodNum, emptyBatches);
+	batcher.Batch(shadow1, 1, GetLodNum, shadow1Batches);
+	CHECK(emptyBatches.empty());
+
+	// Every batch starts where the previous one ended, with nothing left over
+	UINT next = 0;
+	for (auto* batches : { &viewBatches, &shadow0Batches, &shadow1Batches }) {
+		for (auto& batch : *batches) {
+			CHECK_EQ(batch.InstanceBase, next);
+			next += batch.InstanceNum;
+		}
+	}
+	CHECK_EQ(next, static_cast<UINT>(batcher.GetInstances().size()));
+	CHECK_EQ(next, 8u);
+	CHECK(GetBatchInstances(batcher, shadow1Batches[0]) == std::vector<UINT>({ 6, 7 }));
+
+	// Clear starts the next frame at 0
+	batcher.Clear();
+	batcher.Batch(shadow0, 0, GetLodNum, shadow0Batches);
+	CHECK_EQ(shadow0Batches[0].InstanceBase, 0u);
+	CHECK_EQ(batcher.GetInstances().size(), 2u);
+}
+
+TEST(ManyDistinctKeysEachGetOneBatch)
+{
+	// More keys than the smallest table, with submeshes and materials that collide
+	// when hashed, every key appearing twice
+	const UINT KEY_NUM = 300;
+	Queue queue;
+	for (UINT pass = 0; pass < 2; pass++)
+		for (UINT k = 0; k < KEY_NUM; k++)
+			queue.push_back(MakeItem(0, k % 31, k / 31 * 31, pass * KEY_NUM + k));
+	InstanceBatcher batcher;
+	std::vector<InstanceBatch> batches;
+	batcher.Batch(queue, 0, GetLodNum, batches);
+
+	CHECK_EQ(batches.size(), KEY_NUM);
+	for (UINT k = 0; k < KEY_NUM; k++) {
+		CHECK(batches[k].SubMeshID == k % 31 && batches[k].MaterialID == k / 31 * 31);
+		CHECK(GetBatchInstances(batcher, batches[k]) == std::vector<UINT>({ k, KEY_NUM + k }));
+	}
+}
@@ -0,0 +1,61 @@
+#include "BenchTimer.h"
+#include "MeshSimplifier.h"
+
+#include <cmath>
+#include <DirectXMath.h>
+
+using namespace DirectX;
+
+namespace {
+	// Position, normal and UV, the vertex layout of the FBX meshes
+	struct Vertex {
+		XMFLOAT3 Pos;
+		XMFLOAT3 Normal;
+		XMFLOAT2 UV;
+	};
+
+	// Height field with some bumps, a surface that doesn't simplify for free
+	void BuildTerrain(UINT size, std::vector<Vertex>& verts, std::vector<UINT>& indices) {
+		for (UINT z = 0; z <= size; z++) {
+			for (UINT x = 0; x <= size; x++) {
+				float height = 2.0f * sinf(x * 0.11f) * cosf(z * 0.07f) + 0.3f * sinf(x * 0.9f + z * 0.5f);
+				verts.push_back({ XMFLOAT3((float)x, height, (float)z), XMFLOAT3(0.0f, 1.0f, 0.0f),
+					XMFLOAT2((float)x / size, (float)z / size) });
+			}
+		}
+		for (UINT z = 0; z < size; z++) {
+			for (UINT x = 0; x < size; x++) {
+				UINT v = z * (size + 1) + x;
+				indices.insert(indices.end(), { v, v + size + 1, v + 1, v + 1, v + size + 1, v + size + 2 });
+			}
+		}
+	}
+
+	void Run(UINT size)
+	{
+		std::vector<Vertex> verts;
+		std::vector<UINT> indices;
+		BuildTerrain(size, verts, indices);
+		UINT triNum = static_cast<UINT>(indices.size() / 3);
+		std::printf("%u triangles\n", triNum);
+
+		// The four levels Mesh::BuildLods asks for
+		for (UINT level = 1; level <= 4; level++) {
+			float error = 0.0f;
+			size_t resultNum = 0;
+			double ms = BenchBestMs(3, [&]() {
+				resultNum = MeshSimplifier::Simplify(reinterpret_cast<const BYTE*>(verts.data()), static_cast<UINT>(verts.size()),
+					sizeof(Vertex), indices, static_cast<UINT>(indices.size()) >> level, &error).size() / 3;
+			});
+			std::printf("  1/%-2u %8zu triangles %9.2f ms, %6.2f M input triangles/s, error %.4f\n",
+				1u << level, resultNum, ms, triNum / ms / 1000.0, error);
+		}
+	}
+}
+
+int main()
+{
+	Run(128);
+	Run(256);
+	return 0;
+}
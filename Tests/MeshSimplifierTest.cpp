@@ -0,0 +1,175 @@
+#include "TestFramework.h"
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <DirectXMath.h>
+
+using namespace DirectX;
+
+namespace {
+	struct Vertex {
+		XMFLOAT3 Pos;
+		XMFLOAT2 UV;
+	};
+
+	// Closed unit sphere, rings share their first and last vertex so there is no seam
+	void BuildSphere(UINT ringNum, UINT segmentNum, std::vector<Vertex>& verts, std::vector<UINT>& indices) {
+		verts.push_back({ XMFLOAT3(0.0f, 1.0f, 0.0f), XMFLOAT2(0.0f, 0.0f) });
+		for (UINT r = 1; r < ringNum; r++) {
+			float phi = XM_PI * r / ringNum;
+			for (UINT s = 0; s < segmentNum; s++) {
+				float theta = XM_2PI * s / segmentNum;
+				verts.push_back({ XMFLOAT3(sinf(phi) * cosf(theta), cosf(phi), sinf(phi) * sinf(theta)), XMFLOAT2(0.0f, 0.0f) });
+			}
+		}
+		UINT south = static_cast<UINT>(verts.size());
+		verts.push_back({ XMFLOAT3(0.0f, -1.0f, 0.0f), XMFLOAT2(0.0f, 0.0f) });
+
+		auto Ring = [segmentNum](UINT r, UINT s) { return 1 + (r - 1) * segmentNum + s % segmentNum; };
+		for (UINT s = 0; s < segmentNum; s++) {
+			indices.insert(indices.end(), { 0, Ring(1, s + 1), Ring(1, s) });
+			indices.insert(indices.end(), { south, Ring(ringNum - 1, s), Ring(ringNum - 1, s + 1) });
+		}
+		for (UINT r = 1; r + 1 < ringNum; r++) {
+			for (UINT s = 0; s < segmentNum; s++) {
+				indices.insert(indices.end(), { Ring(r, s), Ring(r, s + 1), Ring(r + 1, s) });
+				indices.insert(indices.end(), { Ring(r, s + 1), Ring(r + 1, s + 1), Ring(r + 1, s) });
+			}
+		}
+	}
+
+	// Square grid on the xz plane, UVs follow the position
+	void BuildGrid(UINT size, std::vector<Vertex>& verts, std::vector<UINT>& indices) {
+		for (UINT z = 0; z <= size; z++)
+			for (UINT x = 0; x <= size; x++)
+				verts.push_back({ XMFLOAT3((float)x, 0.0f, (float)z), XMFLOAT2((float)x / size, (float)z / size) });
+		for (UINT z = 0; z < size; z++) {
+			for (UINT x = 0; x < size; x++) {
+				UINT v = z * (size + 1) + x;
+				indices.insert(indices.end(), { v, v + size + 1, v + 1, v + 1, v + size + 1, v + size + 2 });
+			}
+		}
+	}
+
+	std::vector<UINT> Simplify(const std::vector<Vertex>& verts, const std::vector<UINT>& indices, UINT target, float& error) {
+		return MeshSimplifier::Simplify(reinterpret_cast<const BYTE*>(verts.data()), static_cast<UINT>(verts.size()),
+			sizeof(Vertex), indices, target, &error);
+	}
+
+	float DistanceToTriangle(FXMVECTOR p, FXMVECTOR a, FXMVECTOR b, GXMVECTOR c) {
+		// Inside the prism over the triangle the plane distance, otherwise the closest edge
+		XMVECTOR n = XMVector3Normalize(XMVector3Cross(XMVectorSubtract(b, a), XMVectorSubtract(c, a)));
+		XMVECTOR corners[3] = { a, b, c };
+		bool inside = true;
+		for (int i = 0; i < 3; i++) {
+			XMVECTOR edge = XMVectorSubtract(corners[(i + 1) % 3], corners[i]);
+			if (XMVectorGetX(XMVector3Dot(XMVector3Cross(edge, XMVectorSubtract(p, corners[i])), n)) < 0.0f)
+				inside = false;
+		}
+		if (inside)
+			return fabsf(XMVectorGetX(XMVector3Dot(XMVectorSubtract(p, a), n)));
+		float best = FLT_MAX;
+		for (int i = 0; i < 3; i++) {
+			XMVECTOR edge = XMVectorSubtract(corners[(i + 1) % 3], corners[i]);
+			float t = XMVectorGetX(XMVector3Dot(XMVectorSubtract(p, corners[i]), edge)) / XMVectorGetX(XMVector3Dot(edge, edge));
+			t = std::min(std::max(t, 0.0f), 1.0f);
+			XMVECTOR closest = XMVectorAdd(corners[i], XMVectorScale(edge, t));
+			best = std::min(best, XMVectorGetX(XMVector3Length(XMVectorSubtract(p, closest))));
+		}
+		return best;
+	}
+
+	// Largest distance of an original vertex to the simplified surface
+	float MeasureError(const std::vector<Vertex>& verts, const std::vector<UINT>& indices) {
+		float error = 0.0f;
+		for (auto& v : verts) {
+			XMVECTOR p = XMLoadFloat3(&v.Pos);
+			float best = FLT_MAX;
+			for (size_t i = 0; i < indices.size(); i += 3)
+				best = std::min(best, DistanceToTriangle(p,
+					XMLoadFloat3(&verts[indices[i]].Pos), XMLoadFloat3(&verts[indices[i + 1]].Pos), XMLoadFloat3(&verts[indices[i + 2]].Pos)));
+			error = std::max(error, best);
+		}
+		return error;
+	}
+}
+
+TEST(SphereLodErrorGrowsWithinBounds)
+{
+	std::vector<Vertex> verts;
+	std::vector<UINT> indices;
+	BuildSphere(24, 48, verts, indices);
+	UINT indexNum = static_cast<UINT>(indices.size());
+
+	// Each LOD halves the index count of the full mesh, like Mesh::BuildLods
+	float prevReported = 0.0f;
+	float prevMeasured = 0.0f;
+	for (UINT level = 1; level <= 4; level++) {
+		float reported;
+		std::vector<UINT> lod = Simplify(verts, indices, indexNum >> level, reported);
+		CHECK(lod.size() <= (indexNum >> level));
+		CHECK(lod.size() % 3 == 0);
+		CHECK(*std::max_element(lod.begin(), lod.end()) < verts.size());
+
+		// Coarser levels are further from the surface, and the reported error tracks it.
+		// It is an RMS over the planes of a vertex, so it may stay below the largest distance.
+		float measured = MeasureError(verts, lod);
+		CHECK(reported >= prevReported);
+		CHECK(measured >= prevMeasured);
+		CHECK(measured <= 4.0f * reported + 1e-4f);
+		// The sphere is still a sphere: 1/16 of 2k triangles stays within a tenth of the radius
+		CHECK(measured < 0.1f);
+		prevReported = reported;
+		prevMeasured = measured;
+	}
+}
+
+TEST(FlatGridKeepsItsBorder)
+{
+	std::vector<Vertex> verts;
+	std::vector<UINT> indices;
+	BuildGrid(16, verts, indices);
+
+	float reported;
+	std::vector<UINT> lod = Simplify(verts, indices, static_cast<UINT>(indices.size()) / 8, reported);
+	CHECK(lod.size() < indices.size());
+	CHECK(reported < 1e-4f);
+	CHECK(MeasureError(verts, lod) < 1e-4f);
+
+	// Area is unchanged, so no triangle left the square or folded over
+	float area = 0.0f;
+	for (size_t i = 0; i < lod.size(); i += 3) {
+		XMVECTOR a = XMLoadFloat3(&verts[lod[i]].Pos);
+		XMVECTOR n = XMVector3Cross(XMVectorSubtract(XMLoadFloat3(&verts[lod[i + 1]].Pos), a), XMVectorSubtract(XMLoadFloat3(&verts[lod[i + 2]].Pos), a));
+		area += 0.5f * XMVectorGetY(n);
+	}
+	CHECK(fabsf(area - 256.0f) < 1e-3f);
+}
+
+TEST(SeamsAreLocked)
+{
+	// Two grids sharing their middle column by position only, like a UV seam
+	std::vector<Vertex> verts;
+	std::vector<UINT> indices;
+	BuildGrid(8, verts, indices);
+	UINT offset = static_cast<UINT>(verts.size());
+	for (UINT i = 0; i < offset; i++) {
+		Vertex v = verts[i];
+		v.Pos.x += 8.0f;
+		v.UV.x += 2.0f;
+		verts.push_back(v);
+	}
+	UINT gridIndexNum = static_cast<UINT>(indices.size());
+	for (UINT i = 0; i < gridIndexNum; i++)
+		indices.push_back(indices[i] + offset);
+
+	float reported;
+	std::vector<UINT> lod = Simplify(verts, indices, 0, reported);
+	// Every seam vertex (x == 8) is still used
+	for (UINT z = 0; z <= 8; z++) {
+		UINT left = z * 9 + 8, right = offset + z * 9;
+		CHECK(std::find(lod.begin(), lod.end(), left) != lod.end());
+		CHECK(std::find(lod.begin(), lod.end(), right) != lod.end());
+	}
+}
@@ -0,0 +1,62 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include "PlatformTypes.h"
+
+// Stand-ins for the D3D12 types the command encoder passes through
+struct MockPipelineState { int Tag; };
+struct MockRootSignature { int Tag; };
+struct MockVertexBufferView {
+	UINT64 BufferLocation;
+	UINT SizeInBytes;
+	UINT StrideInBytes;
+};
+struct MockIndexBufferView {
+	UINT64 BufferLocation;
+	UINT SizeInBytes;
+	UINT Format;
+};
+enum MockTopology { MOCK_TOPOLOGY_UNDEFINED, MOCK_TOPOLOGY_TRIANGLELIST, MOCK_TOPOLOGY_LINELIST };
+
+// Records every call as a line of text, e.g. "RootCBV 2 4096"
+class MockCommandList
+{
+public:
+	void SetPipelineState(MockPipelineState* pso) { Record("PSO", pso ? pso->Tag : -1); }
+	void SetGraphicsRootSignature(MockRootSignature* rootSign) { Record("RootSign", rootSign ? rootSign->Tag : -1); }
+	void IASetVertexBuffers(UINT slot, UINT num, const MockVertexBufferView* views) {
+		Record("VB", slot, num, views[0].BufferLocation);
+	}
+	void IASetIndexBuffer(const MockIndexBufferView* view) { Record("IB", view->BufferLocation); }
+	void IASetPrimitiveTopology(MockTopology topology) { Record("Topology", topology); }
+	void SetGraphicsRootConstantBufferView(UINT index, UINT64 addr) { Record("RootCBV", index, addr); }
+	void SetGraphicsRootShaderResourceView(UINT index, UINT64 addr) { Record("RootSRV", index, addr); }
+	void SetGraphicsRoot32BitConstant(UINT index, UINT value, UINT offset) { Record("RootConst", index, value, offset); }
+	void DrawIndexedInstanced(UINT indexCount, UINT instanceCount, UINT startIndex, INT baseVertex, UINT startInstance) {
+		Record("Draw", indexCount, instanceCount, startIndex, baseVertex, startInstance);
+	}
+
+	std::vector<std::string> Calls;
+
+private:
+	template<typename... Args>
+	void Record(const char* name, Args... args) {
+		std::string call = name;
+		long long values[] = { static_cast<long long>(args)... };
+		for (long long value : values)
+			call += " " + std::to_string(value);
+		Calls.push_back(call);
+	}
+};
+
+struct MockEncoderApi {
+	typedef MockCommandList CommandList;
+	typedef MockPipelineState PipelineState;
+	typedef MockRootSignature RootSignature;
+	typedef MockVertexBufferView VertexBufferView;
+	typedef MockIndexBufferView IndexBufferView;
+	typedef MockTopology PrimitiveTopology;
+	typedef UINT64 GpuVirtualAddress;
+	static const MockTopology UNDEFINED_TOPOLOGY = MOCK_TOPOLOGY_UNDEFINED;
+};
@@ -0,0 +1,44 @@
+#pragma once
+#include <vector>
+
+#include "PassRecorder.h"
+#include "MockCommandList.h"
+
+// Hands out MockCommandLists and keeps the lists of every submission
+class MockCommandListProvider : public CommandListProvider<MockCommandList>
+{
+public:
+	explicit MockCommandListProvider(UINT maxListNum)
+		: mCommandLists(maxListNum), mOpens(maxListNum, 0) {
+	}
+
+	UINT GetMaxListNum()const override { return static_cast<UINT>(mCommandLists.size()); }
+	MockCommandList* BeginList(UINT index) override {
+		if (mOpens[index])
+			throw "List already open.";
+		mOpens[index] = 1;
+		mCommandLists[index].Calls.clear();
+		return &mCommandLists[index];
+	}
+	void EndList(MockCommandList* commandList) override {
+		UINT index = static_cast<UINT>(commandList - mCommandLists.data());
+		if (!mOpens[index])
+			throw "List not open.";
+		mOpens[index] = 0;
+	}
+	void Submit(MockCommandList* const* commandLists, UINT num) override {
+		for (UINT i = 0; i < num; i++) {
+			UINT index = static_cast<UINT>(commandLists[i] - mCommandLists.data());
+			if (mOpens[index])
+				throw "Submitting an open list.";
+		}
+		Submissions.emplace_back(commandLists, commandLists + num);
+	}
+
+	// Lists of every Submit call, in order
+	std::vector<std::vector<MockCommandList*>> Submissions;
+
+private:
+	std::vector<MockCommandList> mCommandLists;
+	std::vector<UINT8> mOpens; // not vector<bool>, lists are begun from several threads
+};
@@ -0,0 +1,31 @@
+#pragma once
+#include <algorithm>
+
+#include "FrameRing.h"
+
+// Fence without a GPU, to drive the frame ring on the CPU.
+// Signaled values complete only through Complete, or when waited for.
+class MockFrameFence : public FrameFence
+{
+public:
+	UINT64 Signal() override { return ++mSignaledValue; }
+	UINT64 GetCompletedValue()const override { return mCompletedValue; }
+	void WaitFor(UINT64 value) override {
+		if (value > mSignaledValue)
+			throw "Waiting for a value never signaled.";
+		mWaitNum++;
+		Complete(value);
+	}
+
+	// The simulated GPU finishes the work up to value
+	void Complete(UINT64 value) {
+		mCompletedValue = std::max(mCompletedValue, std::min(value, mSignaledValue));
+	}
+	UINT64 GetSignaledValue()const { return mSignaledValue; }
+	UINT GetWaitNum()const { return mWaitNum; }
+
+private:
+	UINT64 mSignaledValue = 0;
+	UINT64 mCompletedValue = 0;
+	UINT mWaitNum = 0;
+};
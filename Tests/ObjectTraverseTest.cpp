@@ -0,0 +1,170 @@
+#include "TestFramework.h"
+#include "Object.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// Every allocation of the process goes through here, counting is switched on
+// only around the code under test.
+namespace {
+	std::atomic<bool> sCounting(false);
+	std::atomic<size_t> sAllocNum(0);
+	std::atomic<size_t> sAllocBytes(0);
+
+	void* CountedAlloc(size_t size) {
+		if (sCounting) {
+			sAllocNum++;
+			sAllocBytes += size;
+		}
+		void* p = std::malloc(size ? size : 1);
+		if (!p)
+			throw std::bad_alloc();
+		return p;
+	}
+}
+
+void* operator new(size_t size) { return CountedAlloc(size); }
+void* operator new[](size_t size) { return CountedAlloc(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+namespace {
+	void BeginCounting() {
+		sAllocNum = 0;
+		sAllocBytes = 0;
+		sCounting = true;
+	}
+	void EndCounting() {
+		sCounting = false;
+	}
+}
+
+namespace {
+	struct Scene {
+		std::shared_ptr<Object> Root;
+		std::vector<std::shared_ptr<Object>> Objects;
+		UINT RenderItemNum = 0;
+	};
+
+	// 3 levels, 10 x 10 x 10 objects, two render items on every leaf
+	Scene BuildScene() {
+		Scene scene;
+		scene.Root = std::make_shared<Object>("root");
+		for (UINT i = 0; i < 10; i++) {
+			auto a = std::make_shared<Object>("a");
+			Object::Link(scene.Root, a);
+			scene.Objects.push_back(a);
+			for (UINT j = 0; j < 10; j++) {
+				auto b = std::make_shared<Object>("b");
+				Object::Link(a, b);
+				scene.Objects.push_back(b);
+				for (UINT k = 0; k < 10; k++) {
+					auto c = std::make_shared<Object>("c");
+					Object::Link(b, c);
+					c->SetTranslation((float)i, (float)j, (float)k);
+					scene.Objects.push_back(c);
+					for (UINT n = 0; n < 2; n++) {
+						auto item = std::make_shared<RenderItem>();
+						item->MeshID = INVALID_OBJECT_ID;
+						item->SubMeshID = 0;
+						Object::Link(c, item);
+						scene.RenderItemNum++;
+					}
+				}
+			}
+		}
+		return scene;
+	}
+}
+
+TEST(CounterSeesAllocations)
+{
+	BeginCounting();
+	std::vector<int>* vec = new std::vector<int>(16);
+	EndCounting();
+	delete vec;
+	CHECK_EQ(sAllocNum.load(), 2u);
+	CHECK_EQ(sAllocBytes.load(), sizeof(std::vector<int>) + 16 * sizeof(int));
+}
+
+TEST(FrameTraversalsDontAllocate)
+{
+	Scene scene = BuildScene();
+	UINT objectNum = static_cast<UINT>(scene.Objects.size()) + 1;
+
+	// Per-frame outputs keep their capacity between frames, as the app's queues do
+	std::vector<RenderItem*> queue;
+	std::vector<UINT> changedObjects;
+	queue.reserve(scene.RenderItemNum);
+	changedObjects.reserve(objectNum);
+
+	UINT visitedNum = 0, postVisitedNum = 0, culledVisitNum = 0;
+	auto frame = [&]() {
+		queue.clear();
+		changedObjects.clear();
+
+		// Transform update and the change list of the object constants
+		scene.Objects[1]->SetRotation(0.1f, 0.2f, 0.3f);
+		Object::UpdateGlobalModelMats();
+		Object::GetRecomputedObjects(changedObjects);
+
+		// Render item queue, a stateful visitor
+		visitedNum = 0;
+		scene.Root->Traverse([&](Object& obj) {
+			visitedNum++;
+			for (auto& item : obj.GetRenderItems())
+				queue.push_back(item.get());
+			return VisitResult::Continue;
+		});
+
+		// Culling, skips the subtrees of half of the first level
+		culledVisitNum = 0;
+		UINT firstLevel = 0;
+		scene.Root->Traverse([&](Object& obj) {
+			culledVisitNum++;
+			auto childs = obj.GetChilds();
+			bool isFirstLevel = &obj != scene.Root.get() && !childs.empty() && !childs[0]->GetChilds().empty();
+			if (isFirstLevel && firstLevel++ % 2 == 1)
+				return VisitResult::SkipChildren;
+			return VisitResult::Continue;
+		});
+
+		// Pre and post visitors together, and an early stop
+		postVisitedNum = 0;
+		UINT depth = 0, maxDepth = 0;
+		scene.Root->Traverse(
+			[&](Object&) { maxDepth = std::max(maxDepth, ++depth); return VisitResult::Continue; },
+			[&](Object&) { depth--; postVisitedNum++; return VisitResult::Continue; }
+		);
+		UINT stopAfter = 50;
+		bool finished = scene.Root->TraversePostOrder([&](Object&) {
+			return --stopAfter == 0 ? VisitResult::Stop : VisitResult::Continue;
+		});
+		CHECK(!finished);
+		CHECK_EQ(maxDepth, 4u);
+	};
+
+	// The first frame may grow the store's scratch arrays
+	frame();
+
+	BeginCounting();
+	frame();
+	frame();
+	EndCounting();
+
+	std::printf("  %zu allocations, %zu bytes in two frames\n", sAllocNum.load(), sAllocBytes.load());
+	CHECK_EQ(sAllocNum.load(), 0u);
+	CHECK_EQ(sAllocBytes.load(), 0u);
+
+	CHECK_EQ(visitedNum, objectNum);
+	CHECK_EQ(postVisitedNum, objectNum);
+	CHECK_EQ(static_cast<UINT>(queue.size()), scene.RenderItemNum);
+	// Root, 10 first level objects and the subtrees of 5 of them
+	CHECK_EQ(culledVisitNum, 1u + 10u + 5u * 110u);
+	// The moved object and its 10 children
+	CHECK_EQ(static_cast<UINT>(changedObjects.size()), 11u);
+}
@@ -0,0 +1,80 @@
+#include "BenchTimer.h"
+#include "ObjectContent.h"
+#include "TransformStore.h"
+
+#include <cstring>
+#include <vector>
+
+using namespace DirectX;
+
+namespace {
+	// The element the object buffer held before: transposed model and normal matrices
+	struct FullContent {
+		XMFLOAT4X4 ModelMat;
+		XMFLOAT4X4 NormalModelMat;
+	};
+
+	const UINT OBJECT_NUM = 100000;
+	const int REPEAT_NUM = 20;
+
+	// Pack every object into staging, then copy it into the buffer in one run,
+	// as SceneGraphApp does for one run of changed slots.
+	template<typename Content, typename Pack>
+	double Upload(const std::vector<UINT>& nodes, std::vector<Content>& staging, std::vector<BYTE>& buffer, Pack&& pack)
+	{
+		return BenchBestMs(REPEAT_NUM, [&]() {
+			for (UINT i = 0; i < OBJECT_NUM; i++)
+				staging[i] = pack(nodes[i]);
+			std::memcpy(buffer.data(), staging.data(), OBJECT_NUM * sizeof(Content));
+		});
+	}
+
+	void Report(const char* name, size_t bytesPerObject, double ms)
+	{
+		double mb = static_cast<double>(bytesPerObject) * OBJECT_NUM / (1024.0 * 1024.0);
+		std::printf("  %-8s %4zu bytes per object, %6.2f MB, %8.3f ms, %6.2f GB/s\n",
+			name, bytesPerObject, mb, ms, mb / 1024.0 / (ms / 1000.0));
+	}
+}
+
+// Per-frame cost of uploading every object: the 3x4 ObjectContent against the two 4x4
+// matrices it replaced. The destination is ordinary memory; an upload heap is
+// write-combined, where the copy is bound by the bytes written even more.
+int main()
+{
+	TransformStore store;
+	std::vector<UINT> nodes(OBJECT_NUM);
+	for (UINT i = 0; i < OBJECT_NUM; i++) {
+		nodes[i] = store.CreateNode();
+		store.SetTranslation(nodes[i], (float)(i % 97), (float)(i % 13), (float)(i % 31));
+		store.SetRotation(nodes[i], 0.01f * (i % 11), 0.02f * (i % 7), 0.0f);
+		store.SetScale(nodes[i], 1.0f, 1.0f + 0.1f * (i % 3), 1.0f);
+	}
+	store.Update();
+
+	std::vector<BYTE> buffer(OBJECT_NUM * sizeof(FullContent));
+
+	std::vector<ObjectContent> contents(OBJECT_NUM);
+	double packedMs = Upload(nodes, contents, buffer, [&](UINT node) {
+		return PackObjectContent(store.GetWorldMat(node));
+	});
+
+	// The store no longer keeps normal matrices, inverting them here would time the
+	// inverse instead of the upload
+	std::vector<XMFLOAT4X4> normalMats(OBJECT_NUM);
+	for (UINT i = 0; i < OBJECT_NUM; i++)
+		XMStoreFloat4x4(&normalMats[nodes[i]], XMMatrixTranspose(MathHelper::GenNormalMat(store.GetWorldMat(nodes[i]))));
+
+	std::vector<FullContent> fullContents(OBJECT_NUM);
+	double fullMs = Upload(nodes, fullContents, buffer, [&](UINT node) {
+		FullContent content;
+		XMStoreFloat4x4(&content.ModelMat, XMMatrixTranspose(store.GetWorldMat(node)));
+		content.NormalModelMat = normalMats[node];
+		return content;
+	});
+
+	std::printf("%u objects, all changed, best of %d runs\n", OBJECT_NUM, REPEAT_NUM);
+	Report("3x4", sizeof(ObjectContent), packedMs);
+	Report("2x 4x4", sizeof(FullContent), fullMs);
+	return 0;
+}
@@ -0,0 +1,75 @@
+#include "BenchTimer.h"
+#include "OcclusionCuller.h"
+
+#include <cstdlib>
+#include <thread>
+
+using namespace DirectX;
+
+namespace {
+	const UINT OCCLUDER_NUM = 200;
+	const UINT TRIANGLES_PER_OCCLUDER = 50;
+	const UINT OCCLUDEE_NUM = 100000;
+
+	float RandRange(float a, float b) {
+		return a + (b - a) * (float)rand() / (float)RAND_MAX;
+	}
+}
+
+// A street of occluders in front of many small boxes, the culler at its default 256x128.
+// Each occluder is a strip of triangles with positions only (stride 12).
+int main()
+{
+	const int REPEAT_NUM = 20;
+
+	srand(7);
+	std::vector<XMFLOAT3> verts;
+	std::vector<UINT32> indices;
+	std::vector<XMFLOAT4X4> worlds(OCCLUDER_NUM);
+	for (UINT i = 0; i <= TRIANGLES_PER_OCCLUDER / 2; i++) {
+		float x = -1.0f + 2.0f * i / (TRIANGLES_PER_OCCLUDER / 2);
+		verts.push_back(XMFLOAT3(x, -1.0f, 0.0f));
+		verts.push_back(XMFLOAT3(x, +1.0f, 0.0f));
+	}
+	for (UINT i = 0; i < TRIANGLES_PER_OCCLUDER / 2; i++) {
+		UINT v = 2 * i;
+		UINT32 quad[6] = { v, v + 1, v + 3, v, v + 3, v + 2 };
+		indices.insert(indices.end(), quad, quad + 6);
+	}
+	for (auto& world : worlds)
+		XMStoreFloat4x4(&world, XMMatrixScaling(RandRange(1.0f, 4.0f), RandRange(1.0f, 4.0f), 1.0f)
+			* XMMatrixTranslation(RandRange(-40.0f, 40.0f), RandRange(-10.0f, 10.0f), RandRange(10.0f, 40.0f)));
+
+	std::vector<BoundingBox> boxes(OCCLUDEE_NUM);
+	for (auto& box : boxes)
+		box = BoundingBox(XMFLOAT3(RandRange(-80.0f, 80.0f), RandRange(-20.0f, 20.0f), RandRange(20.0f, 90.0f)), XMFLOAT3(0.5f, 0.5f, 0.5f));
+
+	XMMATRIX view = XMMatrixLookToLH(XMVectorZero(), XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+	XMMATRIX viewProj = view * XMMatrixPerspectiveFovLH(0.25f * XM_PI, 2.0f, 0.1f, 100.0f);
+	Span<const BYTE> vertBytes(reinterpret_cast<const BYTE*>(verts.data()), verts.size() * sizeof(XMFLOAT3));
+
+	OcclusionCuller culler;
+	auto AddOccluders = [&]() {
+		culler.Begin(viewProj);
+		for (auto& world : worlds)
+			culler.AddOccluder(vertBytes, sizeof(XMFLOAT3), indices, 0, XMLoadFloat4x4(&world));
+	};
+	double addMs = BenchBestMs(REPEAT_NUM, AddOccluders);
+	double serialMs = BenchBestMs(REPEAT_NUM, [&]() { AddOccluders(); culler.Rasterize(); }) - addMs;
+	JobSystem jobSystem;
+	double parallelMs = BenchBestMs(REPEAT_NUM, [&]() { AddOccluders(); culler.Rasterize(&jobSystem); }) - addMs;
+
+	UINT visibleNum = 0;
+	double testMs = BenchBestMs(REPEAT_NUM, [&]() {
+		visibleNum = 0;
+		for (auto& box : boxes)
+			visibleNum += culler.IsVisible(box);
+	});
+
+	std::printf("%ux%u depth, %u occluder triangles binned\n", culler.GetWidth(), culler.GetHeight(), culler.GetTriangleNum());
+	std::printf("  transform + bin       %8.3f ms\n", addMs);
+	std::printf("  rasterize, 1 thread   %8.3f ms\n", serialMs);
+	std::printf("  rasterize, %2u threads %8.3f ms\n", std::thread::hardware_concurrency(), parallelMs);
+	std::printf("  test %u boxes     %8.3f ms, %u visible\n", OCCLUDEE_NUM, testMs, visibleNum);
+	return 0;
+}
@@ -0,0 +1,146 @@
+#include "TestFramework.h"
+#include "OcclusionCuller.h"
+
+#include <cstdlib>
+
+using namespace DirectX;
+
+namespace {
+	// Position first, like the mesh vertices
+	struct Vertex {
+		XMFLOAT3 Pos;
+		XMFLOAT3 Normal;
+	};
+
+	// Square of side 2 * halfSize at depth z, facing the camera
+	std::vector<Vertex> MakeQuad(float halfSize, float z) {
+		return {
+			{ XMFLOAT3(-halfSize, -halfSize, z), XMFLOAT3(0.0f, 0.0f, -1.0f) },
+			{ XMFLOAT3(-halfSize, +halfSize, z), XMFLOAT3(0.0f, 0.0f, -1.0f) },
+			{ XMFLOAT3(+halfSize, +halfSize, z), XMFLOAT3(0.0f, 0.0f, -1.0f) },
+			{ XMFLOAT3(+halfSize, -halfSize, z), XMFLOAT3(0.0f, 0.0f, -1.0f) },
+		};
+	}
+	const std::vector<UINT16> QUAD_INDICES = { 0, 1, 2, 0, 2, 3 };
+
+	Span<const BYTE> AsBytes(const std::vector<Vertex>& verts) {
+		return Span<const BYTE>(reinterpret_cast<const BYTE*>(verts.data()), verts.size() * sizeof(Vertex));
+	}
+
+	// Camera at the origin looking down +z
+	XMMATRIX GetViewProj() {
+		XMMATRIX view = XMMatrixLookToLH(XMVectorZero(), XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f));
+		return view * XMMatrixPerspectiveFovLH(0.5f * XM_PI, 2.0f, 0.1f, 100.0f);
+	}
+
+	BoundingBox MakeBox(float x, float y, float z, float extent) {
+		return BoundingBox(XMFLOAT3(x, y, z), XMFLOAT3(extent, extent, extent));
+	}
+}
+
+TEST(EmptyBufferHidesNothing)
+{
+	OcclusionCuller culler;
+	culler.Begin(GetViewProj());
+	culler.Rasterize();
+	CHECK(culler.IsVisible(MakeBox(0.0f, 0.0f, 50.0f, 1.0f)));
+	CHECK_EQ(culler.GetDepth(0, 0), 1.0f);
+}
+
+TEST(OccluderHidesBoxesBehindIt)
+{
+	std::vector<Vertex> quad = MakeQuad(2.0f, 5.0f);
+	OcclusionCuller culler;
+	culler.Begin(GetViewProj());
+	culler.AddOccluder(AsBytes(quad), sizeof(Vertex), QUAD_INDICES, 0, XMMatrixIdentity());
+	culler.Rasterize();
+	CHECK_EQ(culler.GetTriangleNum(), 2u);
+
+	// Center pixel is covered, the corner isn't
+	CHECK(culler.GetDepth(culler.GetWidth() / 2, culler.GetHeight() / 2) < 1.0f);
+	CHECK_EQ(culler.GetDepth(0, 0), 1.0f);
+
+	CHECK(!culler.IsVisible(MakeBox(0.0f, 0.0f, 10.0f, 0.5f)));  // behind
+	CHECK(culler.IsVisible(MakeBox(0.0f, 0.0f, 3.0f, 0.5f)));    // in front
+	CHECK(culler.IsVisible(MakeBox(8.0f, 0.0f, 10.0f, 0.5f)));   // behind, beside the occluder
+	CHECK(culler.IsVisible(MakeBox(4.0f, 0.0f, 10.0f, 1.0f)));   // partly behind
+	CHECK(culler.IsVisible(MakeBox(0.0f, 0.0f, 5.0f, 0.5f)));    // through the occluder
+	CHECK(culler.IsVisible(MakeBox(0.0f, 0.0f, 0.0f, 1.0f)));    // crossing the near plane
+	CHECK(!culler.IsVisible(MakeBox(100.0f, 0.0f, 10.0f, 1.0f))); // off-screen
+}
+
+TEST(WorldMatrixMovesOccluder)
+{
+	std::vector<Vertex> quad = MakeQuad(2.0f, 0.0f);
+	OcclusionCuller culler;
+	culler.Begin(GetViewProj());
+	culler.AddOccluder(AsBytes(quad), sizeof(Vertex), QUAD_INDICES, 0, XMMatrixTranslation(8.0f, 0.0f, 5.0f));
+	culler.Rasterize();
+	CHECK(culler.IsVisible(MakeBox(0.0f, 0.0f, 10.0f, 0.5f)));
+	CHECK(!culler.IsVisible(MakeBox(16.0f, 0.0f, 10.0f, 0.5f)));
+}
+
+TEST(IndexFormatsAndBaseVertex)
+{
+	// The quad after four vertices of another submesh
+	std::vector<Vertex> verts = MakeQuad(100.0f, 50.0f);
+	std::vector<Vertex> quad = MakeQuad(2.0f, 5.0f);
+	verts.insert(verts.end(), quad.begin(), quad.end());
+	std::vector<UINT32> indices32(QUAD_INDICES.begin(), QUAD_INDICES.end());
+
+	OcclusionCuller culler16, culler32;
+	culler16.Begin(GetViewProj());
+	culler16.AddOccluder(AsBytes(verts), sizeof(Vertex), QUAD_INDICES, 4, XMMatrixIdentity());
+	culler16.Rasterize();
+	culler32.Begin(GetViewProj());
+	culler32.AddOccluder(AsBytes(verts), sizeof(Vertex), indices32, 4, XMMatrixIdentity());
+	culler32.Rasterize();
+
+	for (UINT y = 0; y < culler16.GetHeight(); y++)
+		for (UINT x = 0; x < culler16.GetWidth(); x++)
+			CHECK_EQ(culler16.GetDepth(x, y), culler32.GetDepth(x, y));
+	CHECK(!culler16.IsVisible(MakeBox(0.0f, 0.0f, 10.0f, 0.5f)));
+	CHECK(culler16.IsVisible(MakeBox(8.0f, 0.0f, 10.0f, 0.5f)));
+}
+
+TEST(OutOfRangeIndicesAreDropped)
+{
+	std::vector<Vertex> quad = MakeQuad(2.0f, 5.0f);
+	std::vector<UINT16> indices = { 0, 1, 4, 0, 2, 3 };
+	OcclusionCuller culler;
+	culler.Begin(GetViewProj());
+	culler.AddOccluder(AsBytes(quad), sizeof(Vertex), indices, 0, XMMatrixIdentity());
+	CHECK_EQ(culler.GetTriangleNum(), 1u);
+	culler.AddOccluder(AsBytes(quad), sizeof(Vertex), QUAD_INDICES, 1, XMMatrixIdentity());
+	CHECK_EQ(culler.GetTriangleNum(), 2u);
+	// Positions of the last vertex would be cut off
+	culler.AddOccluder(Span<const BYTE>(AsBytes(quad).data(), 3 * sizeof(Vertex) + 8), sizeof(Vertex), QUAD_INDICES, 0, XMMatrixIdentity());
+	CHECK_EQ(culler.GetTriangleNum(), 3u);
+}
+
+TEST(ParallelRasterizeMatchesSerial)
+{
+	srand(5);
+	std::vector<Vertex> verts;
+	std::vector<UINT16> indices;
+	for (UINT i = 0; i < 3000; i++) {
+		Vertex v;
+		v.Pos = XMFLOAT3((rand() % 2000) / 100.0f - 10.0f, (rand() % 1000) / 100.0f - 5.0f, 2.0f + (rand() % 2000) / 100.0f);
+		v.Normal = XMFLOAT3(0.0f, 0.0f, -1.0f);
+		verts.push_back(v);
+		indices.push_back(static_cast<UINT16>(i));
+	}
+
+	JobSystem jobSystem(4);
+	OcclusionCuller serial, parallel;
+	serial.Begin(GetViewProj());
+	serial.AddOccluder(AsBytes(verts), sizeof(Vertex), indices, 0, XMMatrixIdentity());
+	serial.Rasterize();
+	parallel.Begin(GetViewProj());
+	parallel.AddOccluder(AsBytes(verts), sizeof(Vertex), indices, 0, XMMatrixIdentity());
+	parallel.Rasterize(&jobSystem);
+
+	for (UINT y = 0; y < serial.GetHeight(); y++)
+		for (UINT x = 0; x < serial.GetWidth(); x++)
+			CHECK_EQ(serial.GetDepth(x, y), parallel.GetDepth(x, y));
+}
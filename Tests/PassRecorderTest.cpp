@@ -0,0 +1,141 @@
+#include "TestFramework.h"
+#include "PassRecorder.h"
+#include "MockCommandListProvider.h"
+
+#include <random>
+
+typedef PassRecorder<MockEncoderApi> Recorder;
+
+namespace {
+	// Every pass draws its own index, so the submitted calls show the pass order
+	void AddPasses(Recorder& recorder, UINT passNum, MockPipelineState* pso) {
+		for (UINT p = 0; p < passNum; p++) {
+			recorder.AddPass([p, pso](Recorder::Encoder& encoder) {
+				encoder.SetPipelineState(pso);
+				encoder.DrawIndexedInstanced(p, 1, 0, 0, 0);
+			}, 1 + p % 5);
+		}
+	}
+
+	// Draws of the last submission, in list order
+	std::vector<UINT> SubmittedDraws(const MockCommandListProvider& provider) {
+		std::vector<UINT> draws;
+		for (MockCommandList* list : provider.Submissions.back()) {
+			for (auto& call : list->Calls) {
+				if (call.compare(0, 5, "Draw ") == 0)
+					draws.push_back(static_cast<UINT>(std::stoul(call.substr(5))));
+			}
+		}
+		return draws;
+	}
+}
+
+TEST(PartitionGroupsAreContiguousNonEmptyAndCoverAllPasses)
+{
+	std::mt19937 rng(7);
+	std::vector<UINT> costs, groupStarts;
+	for (int round = 0; round < 500; round++) {
+		UINT passNum = 1 + rng() % 40;
+		costs.resize(passNum);
+		for (UINT& cost : costs)
+			cost = rng() % 4 == 0 ? 0 : rng() % 100; // zero-cost passes too
+		UINT groupNum = 1 + rng() % passNum;
+
+		Recorder::Partition(costs, groupNum, groupStarts);
+		CHECK_EQ(groupStarts.size(), groupNum + 1);
+		CHECK_EQ(groupStarts.front(), 0u);
+		CHECK_EQ(groupStarts.back(), passNum);
+		for (UINT g = 0; g < groupNum; g++)
+			CHECK(groupStarts[g] < groupStarts[g + 1]);
+	}
+}
+
+TEST(PartitionBalancesCost)
+{
+	std::mt19937 rng(11);
+	std::vector<UINT> costs, groupStarts;
+	for (int round = 0; round < 500; round++) {
+		UINT passNum = 8 + rng() % 200;
+		costs.resize(passNum);
+		UINT64 totalCost = 0;
+		UINT maxCost = 0;
+		for (UINT& cost : costs) {
+			cost = 1 + rng() % 50;
+			totalCost += cost;
+			maxCost = std::max(maxCost, cost);
+		}
+		UINT groupNum = 1 + rng() % 8;
+
+		// Every group stays within one pass of its share
+		Recorder::Partition(costs, groupNum, groupStarts);
+		for (UINT g = 0; g < groupNum; g++) {
+			UINT64 groupCost = 0;
+			for (UINT p = groupStarts[g]; p < groupStarts[g + 1]; p++)
+				groupCost += costs[p];
+			CHECK(groupCost <= totalCost / groupNum + maxCost);
+		}
+	}
+
+	// Equal costs split evenly
+	costs.assign(12, 3);
+	Recorder::Partition(costs, 4, groupStarts);
+	CHECK(groupStarts == std::vector<UINT>({ 0, 3, 6, 9, 12 }));
+}
+
+TEST(PartitionRejectsInvalidGroupNum)
+{
+	std::vector<UINT> costs(3, 1), groupStarts;
+	CHECK_THROWS(Recorder::Partition(costs, 0, groupStarts));
+	CHECK_THROWS(Recorder::Partition(costs, 4, groupStarts));
+}
+
+TEST(ExecuteSubmitsListsInPassOrder)
+{
+	MockPipelineState pso = { 1 };
+	MockCommandListProvider provider(4);
+	Recorder recorder(&provider);
+	AddPasses(recorder, 10, &pso);
+	CHECK_EQ(recorder.Execute(8), 4u); // capped by the provider
+
+	CHECK_EQ(provider.Submissions.size(), 1u);
+	CHECK_EQ(provider.Submissions[0].size(), 4u);
+	std::vector<UINT> draws = SubmittedDraws(provider);
+	CHECK_EQ(draws.size(), 10u);
+	for (UINT p = 0; p < draws.size(); p++)
+		CHECK_EQ(draws[p], p);
+
+	// Each list starts with a fresh encoder, the PSO is set once per list
+	CHECK_EQ(recorder.GetIssuedNum(), 10u + 4u);
+	CHECK_EQ(recorder.GetSkippedNum(), 10u - 4u);
+}
+
+TEST(ExecuteInParallelKeepsPassOrder)
+{
+	JobSystem jobSystem(4);
+	MockPipelineState pso = { 1 };
+	MockCommandListProvider provider(8);
+	Recorder recorder(&provider, &jobSystem);
+	for (int frame = 0; frame < 20; frame++) {
+		AddPasses(recorder, 50, &pso);
+		CHECK_EQ(recorder.Execute(jobSystem.GetThreadNum()), std::min(jobSystem.GetThreadNum(), 8u));
+		std::vector<UINT> draws = SubmittedDraws(provider);
+		CHECK_EQ(draws.size(), 50u);
+		for (UINT p = 0; p < draws.size(); p++)
+			CHECK_EQ(draws[p], p);
+	}
+	CHECK_EQ(provider.Submissions.size(), 20u);
+}
+
+TEST(ExecuteWithoutPassesSubmitsNothing)
+{
+	MockCommandListProvider provider(4);
+	Recorder recorder(&provider);
+	CHECK_EQ(recorder.Execute(4), 0u);
+	CHECK(provider.Submissions.empty());
+
+	// Fewer passes than lists use one list per pass
+	MockPipelineState pso = { 1 };
+	AddPasses(recorder, 2, &pso);
+	CHECK_EQ(recorder.Execute(4), 2u);
+	CHECK_EQ(provider.Submissions.back().size(), 2u);
+}
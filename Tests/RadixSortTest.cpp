@@ -0,0 +1,110 @@
+#include "TestFramework.h"
+#include "RadixSort.h"
+#include "RenderQueueSorter.h"
+
+#include <algorithm>
+#include <random>
+
+namespace {
+	// Reference: stable sort of the indices by key
+	void StableSort(std::vector<UINT64>& keys, std::vector<UINT>& values) {
+		std::vector<UINT> order(keys.size());
+		for (UINT i = 0; i < order.size(); i++)
+			order[i] = i;
+		std::stable_sort(order.begin(), order.end(), [&keys](UINT a, UINT b) { return keys[a] < keys[b]; });
+		std::vector<UINT64> sortedKeys;
+		std::vector<UINT> sortedValues;
+		for (UINT i : order) {
+			sortedKeys.push_back(keys[i]);
+			sortedValues.push_back(values[i]);
+		}
+		keys.swap(sortedKeys);
+		values.swap(sortedValues);
+	}
+
+	void CheckMatchesStableSort(std::vector<UINT64> keys) {
+		std::vector<UINT> values(keys.size());
+		for (UINT i = 0; i < values.size(); i++)
+			values[i] = i;
+		std::vector<UINT64> expectedKeys = keys;
+		std::vector<UINT> expectedValues = values;
+		StableSort(expectedKeys, expectedValues);
+
+		std::vector<UINT> counts;
+		std::vector<UINT64> tempKeys;
+		std::vector<UINT> tempValues;
+		RadixSort(keys, values, counts, tempKeys, tempValues);
+		CHECK(keys == expectedKeys);
+		CHECK(values == expectedValues);
+	}
+}
+
+TEST(RandomKeysMatchStableSort)
+{
+	std::mt19937_64 rng(1);
+	std::vector<UINT64> keys(10000);
+	for (auto& key : keys)
+		key = rng();
+	CheckMatchesStableSort(keys);
+}
+
+TEST(EqualKeysKeepTheirOrder)
+{
+	// Few distinct keys, and digits shared by all keys whose passes are skipped
+	std::mt19937_64 rng(2);
+	std::vector<UINT64> keys(5000);
+	for (auto& key : keys)
+		key = (0xABull << 56) | ((rng() % 4) << 20) | 0x77;
+	CheckMatchesStableSort(keys);
+	CheckMatchesStableSort(std::vector<UINT64>(100, 42));
+}
+
+TEST(SmallAndMismatchedInputs)
+{
+	CheckMatchesStableSort({});
+	CheckMatchesStableSort({ 5 });
+	CheckMatchesStableSort({ 5, 3 });
+
+	std::vector<UINT64> keys = { 1, 2 };
+	std::vector<UINT> values = { 0 };
+	std::vector<UINT> counts;
+	std::vector<UINT64> tempKeys;
+	std::vector<UINT> tempValues;
+	CHECK_THROWS(RadixSort(keys, values, counts, tempKeys, tempValues));
+}
+
+TEST(ScratchIsReused)
+{
+	std::vector<UINT64> keys = { 3, 1, 2, 0 };
+	std::vector<UINT> values = { 0, 1, 2, 3 };
+	std::vector<UINT> counts;
+	std::vector<UINT64> tempKeys;
+	std::vector<UINT> tempValues;
+	RadixSort(keys, values, counts, tempKeys, tempValues);
+
+	// The second sort of the same size doesn't allocate: every buffer keeps its storage
+	const void* buffers[] = { keys.data(), tempKeys.data(), values.data(), tempValues.data(), counts.data() };
+	keys = { 9, 8, 7, 6 };
+	RadixSort(keys, values, counts, tempKeys, tempValues);
+	const void* keyBuffers[] = { keys.data(), tempKeys.data() };
+	const void* valueBuffers[] = { values.data(), tempValues.data() };
+	CHECK(std::find(buffers, buffers + 2, keyBuffers[0]) != buffers + 2);
+	CHECK(std::find(buffers, buffers + 2, keyBuffers[1]) != buffers + 2);
+	CHECK(std::find(buffers + 2, buffers + 4, valueBuffers[0]) != buffers + 4);
+	CHECK(std::find(buffers + 2, buffers + 4, valueBuffers[1]) != buffers + 4);
+	CHECK_EQ(counts.data(), buffers[4]);
+	CHECK(keys == std::vector<UINT64>({ 6, 7, 8, 9 }));
+}
+
+TEST(OpaqueKeysGroupStateThenDepth)
+{
+	// Same state sorts by depth, state outranks depth, transparent sorts back to front first
+	UINT64 a = RenderQueueSorter::MakeKey(SORT_PASS_OPAQUE, 1, 100);
+	UINT64 b = RenderQueueSorter::MakeKey(SORT_PASS_OPAQUE, 1, 200);
+	UINT64 c = RenderQueueSorter::MakeKey(SORT_PASS_OPAQUE, 2, 0);
+	CHECK(a < b && b < c);
+	UINT64 near = RenderQueueSorter::MakeKey(SORT_PASS_TRANSPARENT, 1, 100);
+	UINT64 far = RenderQueueSorter::MakeKey(SORT_PASS_TRANSPARENT, 2, 200);
+	CHECK(far < near);
+	CHECK(c < far);
+}
@@ -0,0 +1,40 @@
+#include "TestFramework.h"
+#include "Registry.h"
+
+TEST(HandlesAreDenseAndStable)
+{
+	Registry<int> registry;
+	registry.Add("a") = 1;
+	registry.Add("b") = 2;
+	UINT a = registry.GetHandle("a");
+	CHECK_EQ(a, 0u);
+	CHECK_EQ(registry.GetHandle("b"), 1u);
+
+	// Adding an existing name replaces nothing but the value
+	registry.Add("a") = 3;
+	CHECK_EQ(registry.GetNum(), 2u);
+	CHECK_EQ(registry[a], 3);
+	CHECK_EQ(registry.GetName(a), std::string("a"));
+}
+
+TEST(UnknownNameAlwaysThrows)
+{
+	// Not only with REGISTRY_CHECKS, the tests build in release
+	Registry<int> registry;
+	registry.Add("a");
+	CHECK_THROWS(registry.GetHandle("b"));
+	CHECK_THROWS(registry.Get("b"));
+	const Registry<int>& constRegistry = registry;
+	CHECK_THROWS(constRegistry.Get("b"));
+	CHECK_EQ(registry.GetNum(), 1u);
+}
+
+TEST(FindAndGetOrDoNotThrow)
+{
+	Registry<int> registry;
+	registry.Add("a") = 5;
+	CHECK_EQ(registry.Find("b"), INVALID_REGISTRY_HANDLE);
+	CHECK_EQ(registry.GetOr("b", 7), 7);
+	CHECK_EQ(registry.GetOr("a", 7), 5);
+	CHECK_EQ(registry.GetNum(), 1u);
+}
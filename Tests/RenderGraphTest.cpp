@@ -0,0 +1,232 @@
+#include "TestFramework.h"
+#include "RenderGraph.h"
+
+namespace {
+	const GraphState RT = GRAPH_STATE_RENDER_TARGET;
+	const GraphState SR = GRAPH_STATE_PIXEL_SHADER_RESOURCE;
+	const GraphState DEPTH = GRAPH_STATE_DEPTH_WRITE;
+	const GraphState COPY_SRC = GRAPH_STATE_COPY_SOURCE;
+	const GraphState COPY_DST = GRAPH_STATE_COPY_DEST;
+	const GraphState PRESENT = GRAPH_STATE_PRESENT;
+
+	GraphBarrier Transition(UINT resource, GraphState before, GraphState after) {
+		return { resource, before, after, false };
+	}
+	GraphBarrier Aliasing(UINT resource) {
+		return { resource, GRAPH_STATE_COMMON, GRAPH_STATE_COMMON, true };
+	}
+
+	// States of aliasing barriers are unused and not compared
+	bool Equal(Span<const GraphBarrier> barriers, const std::vector<GraphBarrier>& expected) {
+		if (barriers.size() != expected.size())
+			return false;
+		for (size_t i = 0; i < barriers.size(); i++) {
+			const GraphBarrier& a = barriers[i];
+			const GraphBarrier& b = expected[i];
+			if (a.Resource != b.Resource || a.Aliasing != b.Aliasing)
+				return false;
+			if (!a.Aliasing && (a.Before != b.Before || a.After != b.After))
+				return false;
+		}
+		return true;
+	}
+}
+
+TEST(ShadowMapGoesToRenderTargetAndBack)
+{
+	RenderGraph graph;
+	UINT shadowMap = graph.ImportResource(SR);
+	UINT backBuffer = graph.ImportResource(PRESENT);
+	graph.MarkOutput(backBuffer);
+
+	UINT shadow = graph.AddPass("Shadow");
+	graph.Write(shadowMap, RT);
+	UINT opaque = graph.AddPass("Opaque");
+	graph.Read(shadowMap, SR);
+	graph.Write(backBuffer, RT);
+	graph.Compile();
+
+	CHECK(Equal(graph.GetBarriers(shadow), { Transition(shadowMap, SR, RT) }));
+	CHECK(Equal(graph.GetBarriers(opaque), {
+		Transition(shadowMap, RT, SR),
+		Transition(backBuffer, PRESENT, RT) }));
+	// The shadow map is at rest already
+	CHECK(Equal(graph.GetFinalBarriers(), { Transition(backBuffer, RT, PRESENT) }));
+	CHECK_EQ(graph.GetBarrierNum(), 4u);
+}
+
+TEST(ConsecutiveReadsShareOneTransition)
+{
+	RenderGraph graph;
+	UINT color = graph.ImportResource(RT);
+	UINT a = graph.ImportResource(COPY_DST);
+	UINT b = graph.ImportResource(RT);
+	graph.MarkOutput(a);
+	graph.MarkOutput(b);
+
+	UINT draw = graph.AddPass("Draw");
+	graph.Write(color, RT);
+	UINT copy = graph.AddPass("Copy");
+	graph.Read(color, COPY_SRC);
+	graph.Write(a, COPY_DST);
+	UINT sample = graph.AddPass("Sample");
+	graph.Read(color, SR);
+	graph.Write(b, RT);
+	graph.Compile();
+
+	CHECK(Equal(graph.GetBarriers(draw), {}));
+	// Both reads of the run in one state
+	CHECK(Equal(graph.GetBarriers(copy), { Transition(color, RT, COPY_SRC | SR) }));
+	CHECK(Equal(graph.GetBarriers(sample), {}));
+	CHECK(Equal(graph.GetFinalBarriers(), { Transition(color, COPY_SRC | SR, RT) }));
+}
+
+TEST(ReadsAfterAWriteStartANewRun)
+{
+	RenderGraph graph;
+	UINT color = graph.ImportResource(RT);
+	UINT out1 = graph.ImportResource(RT);
+	UINT out = graph.ImportResource(RT);
+	graph.MarkOutput(out1);
+	graph.MarkOutput(out);
+
+	graph.AddPass("Draw");
+	graph.Write(color, RT);
+	UINT read1 = graph.AddPass("Read 1");
+	graph.Read(color, SR);
+	graph.Write(out1, RT);
+	UINT redraw = graph.AddPass("Redraw");
+	graph.Write(color, RT);
+	UINT read2 = graph.AddPass("Read 2");
+	graph.Read(color, COPY_SRC);
+	graph.Write(out, RT);
+	graph.Compile();
+
+	CHECK(Equal(graph.GetBarriers(read1), { Transition(color, RT, SR) }));
+	CHECK(Equal(graph.GetBarriers(redraw), { Transition(color, SR, RT) }));
+	CHECK(Equal(graph.GetBarriers(read2), { Transition(color, RT, COPY_SRC) }));
+}
+
+TEST(PassesWhoseWritesAreUnusedAreCulled)
+{
+	RenderGraph graph;
+	UINT shadowMap = graph.ImportResource(SR);
+	UINT temp = graph.ImportResource(RT);
+	UINT unused = graph.ImportResource(RT);
+	UINT backBuffer = graph.ImportResource(PRESENT);
+	graph.MarkOutput(backBuffer);
+
+	// Feeds only the culled pass below
+	UINT shadow = graph.AddPass("Shadow");
+	graph.Write(shadowMap, RT);
+	UINT blur = graph.AddPass("Blur");
+	graph.Read(shadowMap, SR);
+	graph.Write(unused, RT);
+	// Overwritten before anyone reads it
+	UINT early = graph.AddPass("Early");
+	graph.Write(temp, RT);
+	UINT late = graph.AddPass("Late");
+	graph.Write(temp, RT);
+	UINT present = graph.AddPass("Present");
+	graph.Read(temp, COPY_SRC);
+	graph.Write(backBuffer, COPY_DST);
+	// Writes nothing, kept for its side effects
+	UINT marker = graph.AddPass("Marker");
+	graph.Read(temp, COPY_SRC);
+	graph.Compile();
+
+	CHECK(graph.IsCulled(shadow));
+	CHECK(graph.IsCulled(blur));
+	CHECK(graph.IsCulled(early));
+	CHECK(!graph.IsCulled(late));
+	CHECK(!graph.IsCulled(present));
+	CHECK(!graph.IsCulled(marker));
+	CHECK_EQ(graph.GetCulledNum(), 3u);
+
+	CHECK(Equal(graph.GetBarriers(shadow), {}));
+	CHECK(Equal(graph.GetBarriers(blur), {}));
+	CHECK(Equal(graph.GetBarriers(early), {}));
+	CHECK_EQ(graph.GetFirstPass(shadowMap), INVALID_GRAPH_ID);
+	CHECK_EQ(graph.GetFirstPass(temp), late);
+	CHECK_EQ(graph.GetLastPass(temp), marker);
+	CHECK(Equal(graph.GetFinalBarriers(), {
+		Transition(temp, COPY_SRC, RT),
+		Transition(backBuffer, COPY_DST, PRESENT) }));
+}
+
+TEST(TransientRetiresBeforeTheNextTakesItsMemoryOver)
+{
+	RenderGraph graph;
+	UINT first = graph.ImportTransient(RT);
+	UINT depth = graph.ImportTransient(DEPTH);
+	UINT second = graph.ImportTransient(RT);
+	UINT backBuffer = graph.ImportResource(PRESENT);
+	graph.MarkOutput(backBuffer);
+
+	UINT draw = graph.AddPass("Draw");
+	graph.Write(first, RT);
+	graph.Write(depth, DEPTH);
+	UINT post = graph.AddPass("Post");
+	graph.Read(first, SR);
+	graph.Write(second, RT);
+	UINT present = graph.AddPass("Present");
+	graph.Read(second, COPY_SRC);
+	graph.Write(backBuffer, COPY_DST);
+	graph.Compile();
+
+	// Transients are discarded before their first pass
+	CHECK(Equal(graph.GetBarriers(draw), { Aliasing(first), Aliasing(depth) }));
+	CHECK(Equal(graph.GetBarriers(post), {
+		Aliasing(second),
+		Transition(first, RT, SR) }));
+	// first is done, it goes back to rest before anything else happens in the pass
+	CHECK(Equal(graph.GetBarriers(present), {
+		Transition(first, SR, RT),
+		Transition(second, RT, COPY_SRC),
+		Transition(backBuffer, PRESENT, COPY_DST) }));
+	CHECK(Equal(graph.GetFinalBarriers(), {
+		Transition(second, COPY_SRC, RT),
+		Transition(backBuffer, COPY_DST, PRESENT) }));
+	CHECK_EQ(graph.GetFirstPass(depth), draw);
+	CHECK_EQ(graph.GetLastPass(depth), draw);
+}
+
+TEST(FinalBarriersReturnEveryResourceToRest)
+{
+	RenderGraph graph;
+	UINT zbuffer = graph.ImportResource(SR);
+	UINT depth = graph.ImportResource(DEPTH);
+	graph.MarkOutput(zbuffer);
+
+	graph.AddPass("Opaque");
+	graph.Read(zbuffer, SR);
+	graph.Write(depth, DEPTH);
+	UINT copy = graph.AddPass("Copy ZBuffer");
+	graph.Read(depth, COPY_SRC);
+	graph.Write(zbuffer, COPY_DST);
+	graph.Compile();
+
+	CHECK(Equal(graph.GetBarriers(copy), {
+		Transition(depth, DEPTH, COPY_SRC),
+		Transition(zbuffer, SR, COPY_DST) }));
+	// In resource order
+	CHECK(Equal(graph.GetFinalBarriers(), {
+		Transition(zbuffer, COPY_DST, SR),
+		Transition(depth, COPY_SRC, DEPTH) }));
+
+	graph.Clear();
+	CHECK_EQ(graph.GetPassNum(), 0u);
+	CHECK_EQ(graph.GetResourceNum(), 0u);
+}
+
+TEST(InvalidAccessesThrow)
+{
+	RenderGraph graph;
+	UINT r = graph.ImportResource(RT);
+	CHECK_THROWS(graph.Read(r, SR)); // no pass yet
+	graph.AddPass("Pass");
+	CHECK_THROWS(graph.Read(r + 1, SR));
+	graph.Write(r, RT);
+	CHECK_THROWS(graph.Read(r, SR));
+	graph.Read(r, RT); // read-modify-write in one state
+}
@@ -0,0 +1,53 @@
+#include "BenchTimer.h"
+#include "FbxLoader.h"
+#include "SceneSnapshot.h"
+
+#include <cstdio>
+#include <string>
+
+// Startup scene load, the two paths of SceneGraphApp::LoadScene:
+//   cold, no snapshot yet: FBX import with LOD generation, then writing the snapshot
+//   warm: mapping and loading the snapshot
+// Mesh upload is left out, it is the same for both paths.
+// The snapshot file stays in the OS file cache between runs,
+// so warm numbers don't include reading it from disk.
+// Usage: SceneLoadBench [scene.fbx], bear.fbx by default
+int main(int argc, char** argv)
+{
+	const char* fbxFile = argc > 1 ? argv[1] : "bear.fbx";
+	std::string snapshotFile = std::string(fbxFile) + ".bench.sgsnap";
+	const int COLD_REPEAT_NUM = 3;
+	const int WARM_REPEAT_NUM = 10;
+
+	// What BuildManualTextures and BuildManualMaterials provide before LoadScene
+	auto ltcMat = std::make_shared<Texture>("ggx_ltc_mat");
+	auto ltcAmp = std::make_shared<Texture>("ggx_ltc_amp");
+	auto defaultMtl = std::make_shared<Material>("default");
+	Material::SetDefaultMaterialID(defaultMtl->GetID());
+
+	double coldMs = BenchBestMs(COLD_REPEAT_NUM, [&]() {
+		std::remove(snapshotFile.c_str());
+		FbxLoader loader;
+		auto root = loader.Load(fbxFile);
+		if (!root || !SceneSnapshot::Save(snapshotFile.c_str(), fbxFile, root, loader.GetTextures()))
+			throw "Failed to load the scene or write its snapshot";
+	});
+
+	double firstWarmMs = 0.0;
+	double warmMs = BenchBestMs(WARM_REPEAT_NUM, [&]() {
+		BenchTimer timer;
+		SceneSnapshot snapshot;
+		if (!snapshot.Load(snapshotFile.c_str(), fbxFile))
+			throw "Failed to load the snapshot";
+		if (firstWarmMs == 0.0)
+			firstWarmMs = timer.GetMs();
+	});
+	std::remove(snapshotFile.c_str());
+
+	std::printf("%s\n", fbxFile);
+	std::printf("  cold (FBX + save snapshot) %9.2f ms, best of %d\n", coldMs, COLD_REPEAT_NUM);
+	std::printf("  warm, first snapshot load  %9.2f ms\n", firstWarmMs);
+	std::printf("  warm (snapshot)            %9.2f ms, best of %d, %.1fx faster than cold\n",
+		warmMs, WARM_REPEAT_NUM, coldMs / warmMs);
+	return 0;
+}
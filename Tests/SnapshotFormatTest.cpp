@@ -0,0 +1,236 @@
+#include "TestFramework.h"
+#include "SnapshotFormat.h"
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+namespace {
+	// Small valid snapshot laid out like SceneSnapshot::Save:
+	// a root with one child, one mesh of 4 vertices and 2 LODs of one submesh,
+	// one material referencing an embedded and a by-name texture.
+	class SnapshotImage
+	{
+	public:
+		SnapshotImage() {
+			std::vector<SnapshotObject> objects(2);
+			objects[0] = { AddString("root"), SNAPSHOT_INVALID_INDEX, {}, {}, { 1.0f, 1.0f, 1.0f }, 0, 0 };
+			objects[1] = { AddString("child"), 0, {}, {}, { 1.0f, 1.0f, 1.0f }, 0, 2 };
+
+			std::vector<SnapshotRenderItem> items(2);
+			items[0] = { 0, 0, 0, AddString("opaque") };
+			items[1] = { 0, 0, SNAPSHOT_INVALID_INDEX, AddString("opaque") };
+
+			std::vector<SnapshotTexture> textures(1);
+			textures[0].Name = AddString("brick");
+			textures[0].FilePath = AddWideString(L"brick.dds");
+			textures[0].FilePathLength = 9;
+
+			std::vector<SnapshotMaterial> materials(1);
+			materials[0] = {};
+			materials[0].Name = AddString("mtl");
+			materials[0].LTCMatTex = SNAPSHOT_TEXTURE_BY_NAME | AddString("ltcMat");
+			materials[0].LTCAmpTex = SNAPSHOT_INVALID_INDEX;
+			materials[0].BaseColorTex = 0;
+
+			// Vertices are a position and a normal
+			std::vector<float> verts(4 * 6, 0.0f);
+			std::vector<UINT16> indices = { 0, 1, 2, 0, 2, 3, 0, 1, 2 };
+			std::vector<SnapshotMesh> meshs(1);
+			meshs[0] = {};
+			meshs[0].Name = AddString("quad");
+			meshs[0].SubMeshBegin = 0;
+			meshs[0].SubMeshNum = 1;
+			meshs[0].LodNum = 2;
+			meshs[0].VertexByteStride = 6 * sizeof(float);
+			meshs[0].VertexByteSize = static_cast<UINT32>(verts.size() * sizeof(float));
+			meshs[0].IndexFormat = SNAPSHOT_INDEX_FORMAT_R16;
+			meshs[0].IndexByteSize = static_cast<UINT32>(indices.size() * sizeof(UINT16));
+			std::vector<BYTE> payload;
+			meshs[0].VertexOffset = Append(payload, verts);
+			meshs[0].IndexOffset = Append(payload, indices);
+
+			std::vector<SnapshotSubMesh> submeshs(2);
+			submeshs[0] = {};
+			submeshs[0].IndexCount = 6;
+			submeshs[1] = {};
+			submeshs[1].IndexCount = 3;
+			submeshs[1].StartIndexLoc = 6;
+
+			SnapshotHeader header = {};
+			header.Magic = SNAPSHOT_MAGIC;
+			header.Version = SNAPSHOT_VERSION;
+			header.ObjectNum = 2;
+			header.MeshNum = 1;
+			header.SubMeshNum = 2;
+			header.MaterialNum = 1;
+			header.TextureNum = 1;
+			header.RenderItemNum = 2;
+
+			mData.assign(sizeof(SnapshotHeader), 0);
+			header.ObjectOffset = Append(mData, objects);
+			header.MeshOffset = Append(mData, meshs);
+			header.SubMeshOffset = Append(mData, submeshs);
+			header.MaterialOffset = Append(mData, materials);
+			header.TextureOffset = Append(mData, textures);
+			header.RenderItemOffset = Append(mData, items);
+			header.StringOffset = Append(mData, mStrings);
+			header.StringSize = mStrings.size();
+			header.PayloadOffset = Append(mData, payload);
+			header.PayloadSize = payload.size();
+			header.FileSize = mData.size();
+			std::memcpy(mData.data(), &header, sizeof(header));
+		}
+
+		bool Validate()const {
+			return ValidateSnapshot(mData.data(), mData.size());
+		}
+		bool ValidateTruncated(UINT64 size)const {
+			// FileSize is patched, so only the tables decide
+			std::vector<BYTE> data(mData.begin(), mData.begin() + size);
+			reinterpret_cast<SnapshotHeader*>(data.data())->FileSize = size;
+			return ValidateSnapshot(data.data(), size);
+		}
+
+		SnapshotHeader& Header() { return *reinterpret_cast<SnapshotHeader*>(mData.data()); }
+		template<typename T>
+		T& Record(UINT64 offset, UINT32 i) { return reinterpret_cast<T*>(mData.data() + offset)[i]; }
+		SnapshotObject& Object(UINT32 i) { return Record<SnapshotObject>(Header().ObjectOffset, i); }
+		SnapshotMesh& Mesh() { return Record<SnapshotMesh>(Header().MeshOffset, 0); }
+		SnapshotSubMesh& SubMesh(UINT32 i) { return Record<SnapshotSubMesh>(Header().SubMeshOffset, i); }
+		SnapshotMaterial& Material() { return Record<SnapshotMaterial>(Header().MaterialOffset, 0); }
+		SnapshotTexture& Texture() { return Record<SnapshotTexture>(Header().TextureOffset, 0); }
+		SnapshotRenderItem& Item(UINT32 i) { return Record<SnapshotRenderItem>(Header().RenderItemOffset, i); }
+		UINT16& Index(UINT32 i) { return Record<UINT16>(Header().PayloadOffset + Mesh().IndexOffset, i); }
+		char& StringByte(UINT64 i) { return Record<char>(Header().StringOffset, static_cast<UINT32>(i)); }
+		UINT64 GetSize()const { return mData.size(); }
+
+	private:
+		UINT32 AddString(const std::string& str) {
+			UINT32 offset = static_cast<UINT32>(mStrings.size());
+			mStrings.insert(mStrings.end(), str.begin(), str.end());
+			mStrings.push_back('\0');
+			return offset;
+		}
+		UINT32 AddWideString(const std::wstring& str) {
+			while (mStrings.size() % sizeof(wchar_t) != 0)
+				mStrings.push_back('\0');
+			UINT32 offset = static_cast<UINT32>(mStrings.size());
+			const char* begin = reinterpret_cast<const char*>(str.data());
+			mStrings.insert(mStrings.end(), begin, begin + (str.size() + 1) * sizeof(wchar_t));
+			return offset;
+		}
+		template<typename T>
+		static UINT64 Append(std::vector<BYTE>& data, const std::vector<T>& table) {
+			data.resize((data.size() + 15) & ~size_t(15), 0);
+			UINT64 offset = data.size();
+			const BYTE* begin = reinterpret_cast<const BYTE*>(table.data());
+			data.insert(data.end(), begin, begin + table.size() * sizeof(T));
+			return offset;
+		}
+
+		std::vector<BYTE> mData;
+		std::vector<char> mStrings;
+	};
+}
+
+TEST(ValidSnapshotPasses)
+{
+	SnapshotImage image;
+	CHECK(image.Validate());
+}
+
+TEST(HeaderChecks)
+{
+	SnapshotImage image;
+	CHECK(!ValidateSnapshot(nullptr, 0));
+	CHECK(!ValidateSnapshot(reinterpret_cast<const BYTE*>(&image.Header()), sizeof(SnapshotHeader) - 1));
+	{ SnapshotImage bad; bad.Header().Magic++; CHECK(!bad.Validate()); }
+	{ SnapshotImage bad; bad.Header().Version++; CHECK(!bad.Validate()); }
+	{ SnapshotImage bad; bad.Header().FileSize--; CHECK(!bad.Validate()); }
+	{ SnapshotImage bad; bad.Header().ObjectNum = 0; bad.Header().RenderItemNum = 0; CHECK(!bad.Validate()); }
+}
+
+TEST(TruncatedFileFails)
+{
+	SnapshotImage image;
+	// Every cut loses the payload end, the strings or a table
+	for (UINT64 size = sizeof(SnapshotHeader); size < image.GetSize(); size++)
+		CHECK(!image.ValidateTruncated(size));
+}
+
+TEST(TableRangesAreChecked)
+{
+	{ SnapshotImage bad; bad.Header().ObjectNum = 0x10000000; CHECK(!bad.Validate()); }
+	{ SnapshotImage bad; bad.Header().SubMeshOffset = ~0ull - 8; CHECK(!bad.Validate()); }
+	{ SnapshotImage bad; bad.Header().RenderItemOffset += 1; CHECK(!bad.Validate()); }
+	{ SnapshotImage bad; bad.Header().StringSize = ~0ull; CHECK(!bad.Validate()); }
+	{ SnapshotImage bad; bad.Header().PayloadOffset = bad.GetSize(); CHECK(!bad.Validate()); }
+}
+
+TEST(ObjectParentsAreChecked)
+{
+	{ SnapshotImage bad; bad.Object(0).Parent = 1; CHECK(!bad.Validate()); }
+	// Parents must precede children
+	{ SnapshotImage bad; bad.Object(1).Parent = 1; CHECK(!bad.Validate()); }
+	{ SnapshotImage bad; bad.Object(1).Parent = 7; CHECK(!bad.Validate()); }
+	// A second root would be dropped by the loader
+	{ SnapshotImage bad; bad.Object(1).Parent = SNAPSHOT_INVALID_INDEX; CHECK(!bad.Validate()); }
+	{ SnapshotImage bad; bad.Object(1).RenderItemNum = 3; CHECK(!bad.Validate()); }
+	{ SnapshotImage bad; bad.Object(1).RenderItemBegin = 0xFFFFFFFF; CHECK(!bad.Validate()); }
+}
+
+TEST(RenderItemIndicesAreChecked)
+{
+	{ SnapshotImage bad; bad.Item(0).Mesh = 1; CHECK(!bad.Validate()); }
+	{ SnapshotImage bad; bad.Item(0).SubMesh = 1; CHECK(!bad.Validate()); }
+	{ SnapshotImage bad; bad.Item(0).Material = 1; CHECK(!bad.Validate()); }
+	{ SnapshotImage bad; bad.Item(1).PSO = 0xFFFF; CHECK(!bad.Validate()); }
+}
+
+TEST(SubMeshRangesAreChecked)
+{
+	// SubMeshBegin + lod * SubMeshNum + j must stay in the table
+	{ SnapshotImage bad; bad.Mesh().LodNum = 3; CHECK(!bad.Validate()); }
+	{ SnapshotImage bad; bad.Mesh().SubMeshBegin = 1; CHECK(!bad.Validate()); }
+	{ SnapshotImage bad; bad.Mesh().LodNum = 0x80000000; bad.Mesh().SubMeshNum = 2; CHECK(!bad.Validate()); }
+	{ SnapshotImage bad; bad.Mesh().LodNum = 0; CHECK(!bad.Validate()); }
+	// Index ranges of the submeshs
+	{ SnapshotImage bad; bad.SubMesh(1).IndexCount = 4; CHECK(!bad.Validate()); }
+	{ SnapshotImage bad; bad.SubMesh(0).StartIndexLoc = 0xFFFFFFFF; CHECK(!bad.Validate()); }
+	// Indices must address the vertices of the mesh
+	{ SnapshotImage bad; bad.Index(4) = 4; CHECK(!bad.Validate()); }
+	{ SnapshotImage bad; bad.SubMesh(1).BaseVertexLoc = 2; CHECK(!bad.Validate()); }
+	{ SnapshotImage bad; bad.SubMesh(1).BaseVertexLoc = 1; CHECK(bad.Validate()); }
+}
+
+TEST(PayloadRangesAreChecked)
+{
+	{ SnapshotImage bad; bad.Mesh().VertexByteSize += 4; bad.Mesh().VertexOffset = bad.Header().PayloadSize - 8; CHECK(!bad.Validate()); }
+	{ SnapshotImage bad; bad.Mesh().IndexOffset = ~0ull - 4; CHECK(!bad.Validate()); }
+	{ SnapshotImage bad; bad.Mesh().IndexByteSize += 2; bad.Mesh().IndexOffset = bad.Header().PayloadSize - 16; CHECK(!bad.Validate()); }
+	{ SnapshotImage bad; bad.Mesh().IndexOffset += 1; CHECK(!bad.Validate()); }
+	{ SnapshotImage bad; bad.Mesh().IndexByteSize -= 1; CHECK(!bad.Validate()); }
+	{ SnapshotImage bad; bad.Mesh().IndexFormat = 0; CHECK(!bad.Validate()); }
+	{ SnapshotImage bad; bad.Mesh().VertexByteStride = 8; CHECK(!bad.Validate()); }
+}
+
+TEST(StringsAreChecked)
+{
+	{ SnapshotImage bad; bad.Object(0).Name = static_cast<UINT32>(bad.Header().StringSize); CHECK(!bad.Validate()); }
+	{ SnapshotImage bad; bad.Mesh().Name = 0xFFFFFFFF; CHECK(!bad.Validate()); }
+	// The table must end with a terminator, or the last string runs off its end
+	{ SnapshotImage bad; bad.StringByte(bad.Header().StringSize - 1) = 'x'; CHECK(!bad.Validate()); }
+	// Wide file paths, range and alignment
+	{ SnapshotImage bad; bad.Texture().FilePathLength = 0x7FFFFFFF; CHECK(!bad.Validate()); }
+	{ SnapshotImage bad; bad.Texture().FilePath += 1; CHECK(!bad.Validate()); }
+}
+
+TEST(TextureRefsAreChecked)
+{
+	{ SnapshotImage bad; bad.Material().BaseColorTex = 1; CHECK(!bad.Validate()); }
+	{ SnapshotImage bad; bad.Material().LTCMatTex = SNAPSHOT_TEXTURE_BY_NAME | 0xFFFFF; CHECK(!bad.Validate()); }
+	{ SnapshotImage bad; bad.Material().LTCAmpTex = SNAPSHOT_TEXTURE_BY_NAME; CHECK(bad.Validate()); }
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+// Minimal unit test registry, each test executable links TestMain.cpp.
+// TEST(Name) { CHECK(...); } registers a test, a failed CHECK reports and
+// ends the test, the executable returns non-zero if any test failed.
+namespace TestFramework {
+	struct TestCase {
+		const char* Name;
+		std::function<void()> Func;
+	};
+	struct Failure {};
+
+	inline std::vector<TestCase>& GetTests() {
+		static std::vector<TestCase> tests;
+		return tests;
+	}
+	struct Registrar {
+		Registrar(const char* name, std::function<void()> func) {
+			GetTests().push_back({ name, func });
+		}
+	};
+	inline void Fail(const char* file, int line, const char* expr) {
+		std::printf("  %s(%d): CHECK failed: %s\n", file, line, expr);
+		throw Failure();
+	}
+}
+
+#define TEST(name) \
+	static void Test_##name(); \
+	static TestFramework::Registrar sRegistrar_##name(#name, Test_##name); \
+	static void Test_##name()
+
+#define CHECK(expr) \
+	do { if (!(expr)) TestFramework::Fail(__FILE__, __LINE__, #expr); } while (0)
+
+#define CHECK_EQ(a, b) CHECK((a) == (b))
+
+// The repo throws string literals
+#define CHECK_THROWS(expr) \
+	do { \
+		bool thrown = false; \
+		try { expr; } catch (const char*) { thrown = true; } \
+		if (!thrown) TestFramework::Fail(__FILE__, __LINE__, "throws: " #expr); \
+	} while (0)
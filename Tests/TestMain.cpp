@@ -0,0 +1,29 @@
+#include "TestFramework.h"
+
+int main(int argc, char** argv)
+{
+	// Optional filter: run tests whose name contains argv[1]
+	const char* filter = argc > 1 ? argv[1] : nullptr;
+
+	int failedNum = 0;
+	int runNum = 0;
+	for (const auto& test : TestFramework::GetTests()) {
+		if (filter && !std::strstr(test.Name, filter))
+			continue;
+		runNum++;
+		try {
+			test.Func();
+			std::printf("[ OK ] %s\n", test.Name);
+		}
+		catch (const TestFramework::Failure&) {
+			std::printf("[FAIL] %s\n", test.Name);
+			failedNum++;
+		}
+		catch (const char* msg) {
+			std::printf("[FAIL] %s: threw \"%s\"\n", test.Name, msg);
+			failedNum++;
+		}
+	}
+	std::printf("%d of %d tests passed\n", runNum - failedNum, runNum);
+	return failedNum == 0 ? 0 : 1;
+}
@@ -0,0 +1,107 @@
+#include "BenchTimer.h"
+#include "TransformStore.h"
+
+#include <memory>
+#include <vector>
+
+using namespace DirectX;
+
+namespace {
+	// The per-object recursive update TransformStore replaced:
+	// shared_ptr children, local matrix from XMMatrix products, depth-first walk.
+	struct WalkNode {
+		XMFLOAT3 Translation = { 0.0f, 0.0f, 0.0f };
+		XMFLOAT3 Rotation = { 0.0f, 0.0f, 0.0f };
+		XMFLOAT3 Scale = { 1.0f, 1.0f, 1.0f };
+		XMFLOAT4X4 GlobalModelMat;
+		std::vector<std::shared_ptr<WalkNode>> Childs;
+
+		XMMATRIX CalLocalModelMat()const {
+			XMMATRIX mat = XMMatrixScaling(Scale.x, Scale.y, Scale.z);
+			mat *= XMMatrixRotationX(Rotation.x);
+			mat *= XMMatrixRotationY(Rotation.y);
+			mat *= XMMatrixRotationZ(Rotation.z);
+			mat *= XMMatrixTranslation(Translation.x, Translation.y, Translation.z);
+			return mat;
+		}
+		void XM_CALLCONV UpdateRecursively(CXMMATRIX parentMat) {
+			XMMATRIX globalMat = CalLocalModelMat() * parentMat;
+			XMStoreFloat4x4(&GlobalModelMat, globalMat);
+			for (auto& child : Childs)
+				child->UpdateRecursively(globalMat);
+		}
+	};
+
+	// Node i > 0 is a child of (i - 1) / FANOUT
+	const UINT FANOUT = 4;
+
+	XMFLOAT3 GetTranslation(UINT i) { return { (float)(i % 17), (float)(i % 5), 1.0f }; }
+	XMFLOAT3 GetRotation(UINT i) { return { 0.01f * (i % 13), 0.02f * (i % 7), 0.03f * (i % 3) }; }
+
+	void Run(UINT count)
+	{
+		const int REPEAT_NUM = count >= 1000000 ? 5 : 20;
+
+		std::vector<std::shared_ptr<WalkNode>> walkNodes(count);
+		for (UINT i = 0; i < count; i++) {
+			walkNodes[i] = std::make_shared<WalkNode>();
+			walkNodes[i]->Translation = GetTranslation(i);
+			walkNodes[i]->Rotation = GetRotation(i);
+			if (i > 0)
+				walkNodes[(i - 1) / FANOUT]->Childs.push_back(walkNodes[i]);
+		}
+
+		TransformStore store;
+		std::vector<UINT> nodes(count);
+		for (UINT i = 0; i < count; i++) {
+			nodes[i] = store.CreateNode();
+			XMFLOAT3 t = GetTranslation(i), r = GetRotation(i);
+			store.SetTranslation(nodes[i], t.x, t.y, t.z);
+			store.SetRotation(nodes[i], r.x, r.y, r.z);
+			if (i > 0)
+				store.SetParent(nodes[i], nodes[(i - 1) / FANOUT]);
+		}
+		store.Update();
+
+		// The walk has no dirty tracking, every frame is a full update
+		double walkMs = BenchBestMs(REPEAT_NUM, [&]() {
+			walkNodes[0]->UpdateRecursively(XMMatrixIdentity());
+		});
+		double fullMs = BenchBestMs(REPEAT_NUM, [&]() {
+			store.SetTranslation(nodes[0], 0.0f, 0.0f, 0.0f);
+			store.Update();
+		});
+		// 1% of the nodes move, all in the lower half, where most objects are leaves
+		double partialMs = BenchBestMs(REPEAT_NUM, [&]() {
+			for (UINT i = count / 2; i < count; i += 50) {
+				XMFLOAT3 t = GetTranslation(i);
+				store.SetTranslation(nodes[i], t.x, t.y, t.z);
+			}
+			store.Update();
+		});
+
+		// 1% of the nodes, all leaves, despawn and respawn under the same parent
+		double churnMs = BenchBestMs(REPEAT_NUM, [&]() {
+			for (UINT i = count - count / 100; i < count; i++) {
+				store.DestroyNode(nodes[i]);
+				nodes[i] = store.CreateNode();
+				store.SetParent(nodes[i], nodes[(i - 1) / FANOUT]);
+			}
+			store.Update();
+		});
+
+		std::printf("%8u nodes: recursive walk %9.3f ms, store full %9.3f ms (%5.2fx), store 1%% moved %9.3f ms (%5.2fx), 1%% respawned %9.3f ms\n",
+			count, walkMs, fullMs, walkMs / fullMs, partialMs, walkMs / partialMs, churnMs);
+	}
+}
+
+// World matrix propagation, TransformStore against the recursive walk it replaced.
+// Serial update, see TransformStoreScalingBench for threads.
+int main()
+{
+	std::printf("%u-ary hierarchy, best of several runs\n", FANOUT);
+	Run(1000);
+	Run(100000);
+	Run(1000000);
+	return 0;
+}
@@ -0,0 +1,68 @@
+#include "BenchTimer.h"
+#include "TransformStore.h"
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+using namespace DirectX;
+
+namespace {
+	const UINT COUNT = 1000000;
+
+	// parentOf(i) returns the parent of node i, or INVALID_NODE_ID for roots
+	template<typename ParentFunc>
+	void Run(const char* name, ParentFunc parentOf)
+	{
+		const int REPEAT_NUM = 5;
+
+		TransformStore store;
+		std::vector<UINT> nodes(COUNT);
+		for (UINT i = 0; i < COUNT; i++) {
+			nodes[i] = store.CreateNode();
+			store.SetTranslation(nodes[i], (float)(i % 17), 0.0f, 1.0f);
+			store.SetRotation(nodes[i], 0.01f * (i % 13), 0.02f * (i % 7), 0.0f);
+			store.MergeLocalBounds(nodes[i],
+				BoundingBox(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(1.0f, 1.0f, 1.0f)),
+				BoundingSphere(XMFLOAT3(0.0f, 0.0f, 0.0f), 1.8f));
+			UINT parent = parentOf(i);
+			if (parent != INVALID_NODE_ID)
+				store.SetParent(nodes[i], nodes[parent]);
+		}
+		store.Update();
+
+		// Dirtying the roots recomputes everything
+		auto update = [&](JobSystem* jobSystem) {
+			for (UINT i = 0; i < COUNT && parentOf(i) == INVALID_NODE_ID; i++)
+				store.SetTranslation(nodes[i], (float)(i % 17), 0.0f, 1.0f);
+			store.Update(jobSystem);
+		};
+
+		double serialMs = BenchBestMs(REPEAT_NUM, [&]() { update(nullptr); });
+		std::printf("%s, %u nodes\n  serial    %8.2f ms\n", name, COUNT, serialMs);
+
+		// Powers of two, then all hardware threads
+		UINT maxThreadNum = std::max(std::thread::hardware_concurrency(), 1u);
+		std::vector<UINT> threadNums;
+		for (UINT threadNum = 1; threadNum < maxThreadNum; threadNum *= 2)
+			threadNums.push_back(threadNum);
+		threadNums.push_back(maxThreadNum);
+
+		for (UINT threadNum : threadNums) {
+			JobSystem jobSystem(threadNum);
+			double ms = BenchBestMs(REPEAT_NUM, [&]() { update(&jobSystem); });
+			std::printf("  %2u threads %8.2f ms %5.2fx\n", threadNum, ms, serialMs / ms);
+		}
+	}
+}
+
+// Full TransformStore update over 1..N threads.
+// Wide: 16 roots with all other nodes as their children, one big level.
+// Deep: 256 levels of 3906 nodes, each level only as wide as a few jobs.
+int main()
+{
+	Run("Wide", [](UINT i) { return i < 16 ? INVALID_NODE_ID : i % 16; });
+	const UINT LEVEL_WIDTH = COUNT / 256;
+	Run("Deep", [=](UINT i) { return i < LEVEL_WIDTH ? INVALID_NODE_ID : i - LEVEL_WIDTH; });
+	return 0;
+}
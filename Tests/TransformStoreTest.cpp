@@ -0,0 +1,191 @@
+#include "TestFramework.h"
+#include "TransformStore.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace {
+	float RandRange(float a, float b) {
+		return a + (b - a) * (float)rand() / (float)RAND_MAX;
+	}
+
+	// Random forest, parents are picked among earlier nodes so
+	// levels are deep and uneven. Every node has bounds.
+	std::vector<UINT> BuildRandom(TransformStore& store, UINT count, unsigned seed) {
+		srand(seed);
+		std::vector<UINT> nodes;
+		for (UINT i = 0; i < count; i++) {
+			UINT node = store.CreateNode();
+			store.SetTranslation(node, RandRange(-10.0f, 10.0f), RandRange(-10.0f, 10.0f), RandRange(-10.0f, 10.0f));
+			store.SetRotation(node, RandRange(-3.0f, 3.0f), RandRange(-3.0f, 3.0f), RandRange(-3.0f, 3.0f));
+			store.SetScale(node, RandRange(0.5f, 1.5f), RandRange(0.5f, 1.5f), RandRange(0.5f, 1.5f));
+			store.MergeLocalBounds(node,
+				BoundingBox(XMFLOAT3(RandRange(-1.0f, 1.0f), 0.0f, 0.0f), XMFLOAT3(1.0f, 2.0f, 0.5f)),
+				BoundingSphere(XMFLOAT3(0.0f, 0.0f, 0.0f), 2.5f));
+			if (i > 0 && rand() % 8 != 0)
+				store.SetParent(node, nodes[rand() % i]);
+			nodes.push_back(node);
+		}
+		return nodes;
+	}
+
+	template<typename T>
+	bool SameBits(const T& a, const T& b) {
+		return std::memcmp(&a, &b, sizeof(T)) == 0;
+	}
+
+	bool SameResults(const TransformStore& a, const TransformStore& b, const std::vector<UINT>& nodes) {
+		for (UINT node : nodes) {
+			XMFLOAT4X4 worldA, worldB;
+			XMStoreFloat4x4(&worldA, a.GetWorldMat(node));
+			XMStoreFloat4x4(&worldB, b.GetWorldMat(node));
+			if (!SameBits(worldA, worldB))
+				return false;
+			if (!SameBits(a.GetWorldBounds(node), b.GetWorldBounds(node)))
+				return false;
+			if (!SameBits(a.GetWorldBoundingSphere(node), b.GetWorldBoundingSphere(node)))
+				return false;
+		}
+		return true;
+	}
+
+	std::vector<UINT> SortedRecomputed(const TransformStore& store) {
+		std::vector<UINT> nodes = store.GetRecomputedNodes();
+		std::sort(nodes.begin(), nodes.end());
+		return nodes;
+	}
+}
+
+TEST(ChildWorldIsLocalTimesParent)
+{
+	TransformStore store;
+	UINT parent = store.CreateNode();
+	UINT child = store.CreateNode();
+	store.SetParent(child, parent);
+	store.SetTranslation(parent, 1.0f, 2.0f, 3.0f);
+	store.SetRotation(parent, 0.0f, 1.0f, 0.0f);
+	store.SetTranslation(child, 0.0f, 0.0f, 5.0f);
+	store.SetScale(child, 2.0f, 2.0f, 2.0f);
+	store.Update();
+
+	XMFLOAT4X4 expected, actual;
+	XMStoreFloat4x4(&expected, store.CalLocalMat(child) * store.GetWorldMat(parent));
+	XMStoreFloat4x4(&actual, store.GetWorldMat(child));
+	for (int r = 0; r < 4; r++)
+		for (int c = 0; c < 4; c++)
+			CHECK(std::fabs(expected.m[r][c] - actual.m[r][c]) < 1e-5f);
+	CHECK_EQ(store.GetRecomputedNum(), 2u);
+}
+
+TEST(OnlyDirtySubtreeIsRecomputed)
+{
+	TransformStore store;
+	UINT root = store.CreateNode();
+	UINT a = store.CreateNode();
+	UINT b = store.CreateNode();
+	UINT aChild = store.CreateNode();
+	store.SetParent(a, root);
+	store.SetParent(b, root);
+	store.SetParent(aChild, a);
+	store.Update();
+	CHECK_EQ(store.GetRecomputedNum(), 4u);
+
+	store.Update();
+	CHECK_EQ(store.GetRecomputedNum(), 0u);
+
+	store.SetTranslation(a, 1.0f, 0.0f, 0.0f);
+	store.Update();
+	std::vector<UINT> expected = { a, aChild };
+	std::sort(expected.begin(), expected.end());
+	CHECK(SortedRecomputed(store) == expected);
+}
+
+TEST(CycleThrows)
+{
+	TransformStore store;
+	UINT a = store.CreateNode();
+	UINT b = store.CreateNode();
+	store.SetParent(b, a);
+	CHECK_THROWS(store.SetParent(a, b));
+	CHECK_THROWS(store.SetParent(a, a));
+}
+
+TEST(DestroyedParentOrphansChildren)
+{
+	TransformStore store;
+	UINT parent = store.CreateNode();
+	UINT child = store.CreateNode();
+	store.SetParent(child, parent);
+	store.SetTranslation(parent, 5.0f, 0.0f, 0.0f);
+	store.Update();
+	XMFLOAT4X4 world;
+	XMStoreFloat4x4(&world, store.GetWorldMat(child));
+	CHECK_EQ(world._41, 5.0f);
+
+	store.DestroyNode(parent);
+	store.Update();
+	CHECK_EQ(store.GetParent(child), INVALID_NODE_ID);
+	XMStoreFloat4x4(&world, store.GetWorldMat(child));
+	CHECK_EQ(world._41, 0.0f);
+	CHECK_EQ(store.GetNodeNum(), 1u);
+}
+
+TEST(DestroyOnlyOrphansCurrentChildren)
+{
+	TransformStore store;
+	UINT parent = store.CreateNode();
+	UINT other = store.CreateNode();
+	UINT children[3];
+	for (UINT& child : children) {
+		child = store.CreateNode();
+		store.SetParent(child, parent);
+	}
+	// Moving the middle child keeps the others linked
+	store.SetParent(children[1], other);
+
+	store.DestroyNode(parent);
+	CHECK_EQ(store.GetParent(children[0]), INVALID_NODE_ID);
+	CHECK_EQ(store.GetParent(children[1]), other);
+	CHECK_EQ(store.GetParent(children[2]), INVALID_NODE_ID);
+
+	// A reused handle starts without children
+	UINT reused = store.CreateNode();
+	CHECK_EQ(reused, parent);
+	store.DestroyNode(reused);
+	CHECK_EQ(store.GetParent(children[1]), other);
+
+	store.DestroyNode(other);
+	store.Update();
+	CHECK_EQ(store.GetParent(children[1]), INVALID_NODE_ID);
+	CHECK_EQ(store.GetNodeNum(), 3u);
+}
+
+TEST(ParallelUpdateMatchesSerialBitForBit)
+{
+	const UINT COUNT = 20000;
+	TransformStore serial, parallel;
+	std::vector<UINT> nodes = BuildRandom(serial, COUNT, 3);
+	CHECK(BuildRandom(parallel, COUNT, 3) == nodes);
+
+	JobSystem jobSystem(4);
+	serial.Update();
+	parallel.Update(&jobSystem);
+	CHECK_EQ(serial.GetRecomputedNum(), COUNT);
+	CHECK_EQ(parallel.GetRecomputedNum(), COUNT);
+	CHECK(SameResults(serial, parallel, nodes));
+
+	// Partial update, a few scattered nodes and their subtrees
+	for (UINT i = 0; i < COUNT; i += 97) {
+		serial.SetRotation(nodes[i], 0.1f * i, 0.0f, 0.0f);
+		parallel.SetRotation(nodes[i], 0.1f * i, 0.0f, 0.0f);
+	}
+	serial.Update();
+	parallel.Update(&jobSystem);
+	CHECK(serial.GetRecomputedNum() < COUNT);
+	CHECK(SortedRecomputed(serial) == SortedRecomputed(parallel));
+	CHECK(SameResults(serial, parallel, nodes));
+}
@@ -0,0 +1,125 @@
+#include "TestFramework.h"
+#include "UploadRingAllocator.h"
+
+namespace {
+	UINT64 Alloc(UploadRingAllocator& ring, UINT64 size, UINT64 alignment = 1) {
+		UINT64 offset = 0;
+		if (!ring.TryAlloc(size, alignment, offset))
+			throw "Allocation failed.";
+		return offset;
+	}
+}
+
+TEST(AllocationsAreAlignedAndPacked)
+{
+	UploadRingAllocator ring(4096, 3);
+	ring.BeginFrame(0);
+	CHECK_EQ(Alloc(ring, 100, 256), 0u);
+	CHECK_EQ(Alloc(ring, 4, 4), 100u);
+	CHECK_EQ(Alloc(ring, 1, 256), 256u);
+	CHECK_EQ(Alloc(ring, 64, 16), 272u);
+	CHECK_EQ(ring.GetUsedSize(), 336u);
+
+	UINT64 offset;
+	CHECK_THROWS(ring.TryAlloc(16, 0, offset));
+	CHECK(!ring.TryAlloc(4097, 1, offset));
+}
+
+TEST(SkipsTheBytesLeftAtTheEnd)
+{
+	UploadRingAllocator ring(1024, 2);
+	ring.BeginFrame(0);
+	CHECK_EQ(Alloc(ring, 900), 0u);
+	ring.BeginFrame(1);
+	ring.BeginFrame(0); // frame 0 finished
+	CHECK_EQ(ring.GetUsedSize(), 0u);
+
+	// 124 bytes left at the end, 200 don't fit there
+	CHECK_EQ(Alloc(ring, 200), 0u);
+	CHECK_EQ(ring.GetUsedSize(), 324u);
+	// Alignment padding that crosses the end skips too
+	CHECK_EQ(Alloc(ring, 100, 256), 256u);
+}
+
+TEST(WrapsAroundOverManyFrames)
+{
+	const UINT64 SIZE = 1000;
+	const UINT FRAME_NUM = 3;
+	UploadRingAllocator ring(SIZE, FRAME_NUM);
+	UINT64 lastOffset = 0;
+	UINT wrapNum = 0;
+	for (UINT frame = 0; frame < 300; frame++) {
+		ring.BeginFrame(frame % FRAME_NUM);
+		for (UINT i = 0; i < 3; i++) {
+			UINT64 offset = Alloc(ring, 48, 16);
+			CHECK_EQ(offset % 16, 0u);
+			CHECK(offset + 48 <= SIZE);
+			if (offset < lastOffset)
+				wrapNum++;
+			lastOffset = offset;
+		}
+		// Three frames of three allocations, plus padding, never fill 1000 bytes
+		CHECK(ring.GetUsedSize() <= FRAME_NUM * 3 * 48 + FRAME_NUM * 16 + 48);
+	}
+	CHECK(wrapNum >= 300 * 3 * 48 / SIZE - 1);
+}
+
+TEST(FailsWhenFramesInFlightHoldTooMuch)
+{
+	UploadRingAllocator ring(1024, 2);
+	ring.BeginFrame(0);
+	Alloc(ring, 600);
+	ring.BeginFrame(1);
+	Alloc(ring, 400);
+
+	// Frame 0 may still be read
+	UINT64 offset = 12345;
+	CHECK(!ring.TryAlloc(100, 1, offset));
+	CHECK_EQ(offset, 12345u);
+	CHECK_EQ(ring.GetUsedSize(), 1000u);
+	// What is left fits
+	CHECK_EQ(Alloc(ring, 24), 1000u);
+	CHECK(!ring.TryAlloc(1, 1, offset));
+}
+
+TEST(FrameIsReclaimedAfterFrameNumFrames)
+{
+	const UINT FRAME_NUM = 3;
+	UploadRingAllocator ring(1024, FRAME_NUM);
+	ring.BeginFrame(0);
+	Alloc(ring, 512);
+	ring.BeginFrame(1);
+	Alloc(ring, 256);
+	ring.BeginFrame(2);
+	CHECK_EQ(ring.GetUsedSize(), 768u);
+
+	// Frame 0's resource comes back: its 512 bytes are free, frame 1's are not
+	ring.BeginFrame(0);
+	CHECK_EQ(ring.GetUsedSize(), 256u);
+	ring.BeginFrame(1);
+	CHECK_EQ(ring.GetUsedSize(), 0u);
+	CHECK_THROWS(ring.BeginFrame(FRAME_NUM));
+}
+
+TEST(ResetForgetsEverythingForALargerBuffer)
+{
+	UploadRingAllocator ring(1024, 2);
+	ring.BeginFrame(0);
+	Alloc(ring, 800);
+	ring.BeginFrame(1);
+	UINT64 offset;
+	CHECK(!ring.TryAlloc(500, 1, offset));
+
+	// Grow: the old buffer keeps the old allocations, the new one starts empty
+	ring.Reset(2048);
+	CHECK_EQ(ring.GetSize(), 2048u);
+	CHECK_EQ(ring.GetUsedSize(), 0u);
+	CHECK_EQ(Alloc(ring, 500), 0u);
+
+	// Frame ends recorded for the old buffer don't release bytes of the new one
+	ring.BeginFrame(0);
+	CHECK_EQ(ring.GetUsedSize(), 500u);
+	ring.BeginFrame(1);
+	CHECK_EQ(ring.GetUsedSize(), 0u);
+	CHECK_THROWS(ring.Reset(0));
+}
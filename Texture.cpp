@@ -1,8 +1,7 @@
 #include "Texture.h"
 #include "Common/DDSTextureLoader.h"
 
-UINT Texture::sIDCount = 0;
-std::vector<Texture*> Texture::sIDMap;
+SlotMap<Texture*> Texture::sRegistry;
 
 using namespace DirectX;
 using Microsoft::WRL::ComPtr;
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Common/d3dUtil.h"
+#include "SlotMap.h"
 
 // TODO move this to somewhere
 const std::wstring TEXTURE_PATH_HEAD = L"Resources/Textures/";
@@ -11,31 +12,33 @@ public:
 	Texture(const std::string& name)
 		: mName(name)
 	{
-		mID = sIDCount; 
-		sIDCount++;
-		sIDMap.push_back(this);
+		mID = sRegistry.Insert(this);
 	}
 	~Texture() {
-		sIDMap[mID] = nullptr;
+		sRegistry.Erase(mID);
 	}
 
 	std::string GetName()const { return mName; }
 	UINT GetID()const { return mID; }
-	static UINT GetTotalNum() { return sIDCount; }
+	// Index in the texture descriptor table
+	UINT GetSlotIndex()const { return SlotIndex(mID); }
+	// Upper bound of slot indices
+	static UINT GetTotalNum() { return sRegistry.Capacity(); }
 	static Texture* FindByID(UINT id) {
-		if (id >= sIDMap.size())
-			return nullptr;
-		return sIDMap[id];
+		auto item = sRegistry.Find(id);
+		return item ? *item : nullptr;
 	}
 	static Texture* FindByName(std::string name) {
-		for (auto item : sIDMap) {
+		for (auto item : sRegistry) {
 			if (item->GetName() == name)
 				return item;
 		}
 		return nullptr;
 	}
+	static const SlotMap<Texture*>& GetRegistry() { return sRegistry; }
 
 	void SetFilePath(std::wstring filepath) { mFilePath = filepath; }
+	std::wstring GetFilePath()const { return mFilePath; }
 
 	void LoadAndCreateSRV(
 		Microsoft::WRL::ComPtr<ID3D12Device> device, 
@@ -46,8 +49,7 @@ public:
 private:
 	// Note: We left UINT32_MAX as an invalid ID.
 	UINT mID;
-	static UINT sIDCount;
-	static std::vector<Texture*> sIDMap;
+	static SlotMap<Texture*> sRegistry;
 
 	std::string mName;
 
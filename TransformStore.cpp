@@ -0,0 +1,325 @@
+#include "TransformStore.h"
+#include <algorithm>
+#include <atomic>
+
+using namespace DirectX;
+
+namespace {
+	const BoundingBox EMPTY_BOUNDS(XMFLOAT3(0.0f, 0.0f, 0.0f), XMFLOAT3(-1.0f, -1.0f, -1.0f));
+}
+
+UINT TransformStore::CreateNode()
+{
+	UINT node;
+	if (mFreeNodes.empty()) {
+		node = static_cast<UINT>(mNodeIndices.size());
+		mNodeIndices.push_back(INVALID_NODE_ID);
+		mNodeParents.push_back(INVALID_NODE_ID);
+		mFirstChildren.push_back(INVALID_NODE_ID);
+		mNextSiblings.push_back(INVALID_NODE_ID);
+		mPrevSiblings.push_back(INVALID_NODE_ID);
+	}
+	else {
+		node = mFreeNodes.back();
+		mFreeNodes.pop_back();
+	}
+
+	// New nodes are roots, appending keeps parents before children.
+	mNodeIndices[node] = static_cast<UINT>(mNodes.size());
+	mNodeParents[node] = INVALID_NODE_ID;
+	mNodes.push_back(node);
+	mParentIndices.push_back(INVALID_NODE_ID);
+	mTranslations.push_back({ 0.0f, 0.0f, 0.0f });
+	mRotations.push_back({ 0.0f, 0.0f, 0.0f });
+	mScales.push_back({ 1.0f, 1.0f, 1.0f });
+	mWorldMats.push_back(MathHelper::Identity4x4());
+	mLocalBounds.push_back(EMPTY_BOUNDS);
+	mLocalSpheres.push_back(BoundingSphere());
+	mWorldBounds.push_back(EMPTY_BOUNDS);
+	mWorldSpheres.push_back(BoundingSphere());
+	mWorldMaxScales.push_back(1.0f);
+	mDirtyFlags.push_back(0);
+	MarkDirty(mNodeIndices[node]);
+
+	// Roots must stay in depth 0.
+	mOrderDirty = true;
+	return node;
+}
+
+void TransformStore::DestroyNode(UINT node)
+{
+	// Orphaned children become roots
+	UINT child = mFirstChildren[node];
+	while (child != INVALID_NODE_ID) {
+		UINT next = mNextSiblings[child];
+		mNodeParents[child] = INVALID_NODE_ID;
+		mNextSiblings[child] = INVALID_NODE_ID;
+		mPrevSiblings[child] = INVALID_NODE_ID;
+		MarkDirty(mNodeIndices[child]);
+		child = next;
+	}
+	mFirstChildren[node] = INVALID_NODE_ID;
+	Unlink(node);
+
+	// Dense slot is dropped in next Rebuild
+	mNodes[mNodeIndices[node]] = INVALID_NODE_ID;
+	mNodeIndices[node] = INVALID_NODE_ID;
+	mFreeNodes.push_back(node);
+	mOrderDirty = true;
+}
+
+void TransformStore::SetParent(UINT node, UINT parent)
+{
+	for (UINT p = parent; p != INVALID_NODE_ID; p = mNodeParents[p])
+		if (p == node)
+			throw "Transform hierarchy can't contain cycle";
+
+	Unlink(node);
+	mNodeParents[node] = parent;
+	if (parent != INVALID_NODE_ID) {
+		mNextSiblings[node] = mFirstChildren[parent];
+		if (mFirstChildren[parent] != INVALID_NODE_ID)
+			mPrevSiblings[mFirstChildren[parent]] = node;
+		mFirstChildren[parent] = node;
+	}
+	MarkDirty(mNodeIndices[node]);
+	mOrderDirty = true;
+}
+
+void TransformStore::Unlink(UINT node)
+{
+	UINT parent = mNodeParents[node];
+	if (parent == INVALID_NODE_ID)
+		return;
+	UINT prev = mPrevSiblings[node];
+	UINT next = mNextSiblings[node];
+	if (prev == INVALID_NODE_ID)
+		mFirstChildren[parent] = next;
+	else
+		mNextSiblings[prev] = next;
+	if (next != INVALID_NODE_ID)
+		mPrevSiblings[next] = prev;
+	mNodeParents[node] = INVALID_NODE_ID;
+	mNextSiblings[node] = INVALID_NODE_ID;
+	mPrevSiblings[node] = INVALID_NODE_ID;
+}
+
+void TransformStore::MergeLocalBounds(UINT node, const BoundingBox& box, const BoundingSphere& sphere)
+{
+	UINT index = mNodeIndices[node];
+	if (HasBounds(node)) {
+		BoundingBox::CreateMerged(mLocalBounds[index], mLocalBounds[index], box);
+		BoundingSphere::CreateMerged(mLocalSpheres[index], mLocalSpheres[index], sphere);
+	}
+	else {
+		mLocalBounds[index] = box;
+		mLocalSpheres[index] = sphere;
+	}
+	MarkDirty(index);
+}
+
+namespace {
+	// Gather array by order through scratch of the same type.
+	// The old array becomes the scratch of the next gather of that type.
+	template<typename T>
+	void Gather(std::vector<T>& array, std::vector<T>& scratch, const std::vector<UINT>& order)
+	{
+		scratch.resize(order.size());
+		for (UINT i = 0; i < order.size(); i++)
+			scratch[i] = array[order[i]];
+		array.swap(scratch);
+	}
+}
+
+void TransformStore::Rebuild()
+{
+	UINT oldNum = static_cast<UINT>(mNodes.size());
+
+	// Cal depth of every live node
+	std::vector<UINT>& depths = mRebuildDepths;
+	depths.assign(oldNum, INVALID_NODE_ID);
+	UINT maxDepth = 0;
+	std::vector<UINT>& stack = mRebuildStack;
+	for (UINT i = 0; i < oldNum; i++) {
+		if (mNodes[i] == INVALID_NODE_ID || depths[i] != INVALID_NODE_ID)
+			continue;
+
+		// Walk up until a node with known depth or a root
+		UINT index = i;
+		while (true) {
+			stack.push_back(index);
+			UINT parent = mNodeParents[mNodes[index]];
+			if (parent == INVALID_NODE_ID)
+				break;
+			index = mNodeIndices[parent];
+			if (depths[index] != INVALID_NODE_ID)
+				break;
+		}
+
+		UINT top = stack.back();
+		UINT topParent = mNodeParents[mNodes[top]];
+		UINT depth = topParent == INVALID_NODE_ID ? 0 : depths[mNodeIndices[topParent]] + 1;
+		while (!stack.empty()) {
+			depths[stack.back()] = depth++;
+			stack.pop_back();
+		}
+		maxDepth = MathHelper::Max(maxDepth, depth - 1);
+	}
+
+	// Counting sort by depth, stable for nodes in the same depth
+	mLevelStarts.assign(maxDepth + 2, 0);
+	for (UINT i = 0; i < oldNum; i++)
+		if (mNodes[i] != INVALID_NODE_ID)
+			mLevelStarts[depths[i] + 1]++;
+	for (UINT d = 1; d < mLevelStarts.size(); d++)
+		mLevelStarts[d] += mLevelStarts[d - 1];
+
+	UINT newNum = mLevelStarts.back();
+	std::vector<UINT>& depthStarts = mRebuildDepthStarts;
+	depthStarts.assign(mLevelStarts.begin(), mLevelStarts.end());
+	std::vector<UINT>& order = mRebuildOrder;
+	order.resize(newNum);
+	for (UINT i = 0; i < oldNum; i++)
+		if (mNodes[i] != INVALID_NODE_ID)
+			order[depthStarts[depths[i]]++] = i;
+
+	Gather(mNodes, mRebuildUINTs, order);
+	Gather(mTranslations, mRebuildFloat3s, order);
+	Gather(mRotations, mRebuildFloat3s, order);
+	Gather(mScales, mRebuildFloat3s, order);
+	Gather(mWorldMats, mRebuildMats, order);
+	Gather(mLocalBounds, mRebuildBoxes, order);
+	Gather(mLocalSpheres, mRebuildSpheres, order);
+	Gather(mWorldBounds, mRebuildBoxes, order);
+	Gather(mWorldSpheres, mRebuildSpheres, order);
+	Gather(mWorldMaxScales, mRebuildFloats, order);
+	Gather(mDirtyFlags, mRebuildFlags, order);
+
+	mMinDirtyIndex = INVALID_NODE_ID;
+	for (UINT i = 0; i < newNum; i++) {
+		mNodeIndices[mNodes[i]] = i;
+		if (mDirtyFlags[i])
+			mMinDirtyIndex = MathHelper::Min(mMinDirtyIndex, i);
+	}
+
+	mParentIndices.resize(newNum);
+	for (UINT i = 0; i < newNum; i++) {
+		UINT parent = mNodeParents[mNodes[i]];
+		mParentIndices[i] = parent == INVALID_NODE_ID ? INVALID_NODE_ID : mNodeIndices[parent];
+	}
+
+	mOrderDirty = false;
+}
+
+void XM_CALLCONV TransformStore::UpdateWorldBounds(UINT index, FXMMATRIX worldMat)
+{
+	const BoundingBox& localBounds = mLocalBounds[index];
+	if (localBounds.Extents.x < 0.0f)
+		return;
+
+	// Extents of the transformed box are the absolute matrix applied to the local extents
+	XMVECTOR extents = XMLoadFloat3(&localBounds.Extents);
+	XMVECTOR worldExtents = XMVectorMultiply(XMVectorSplatX(extents), XMVectorAbs(worldMat.r[0]));
+	worldExtents = XMVectorMultiplyAdd(XMVectorSplatY(extents), XMVectorAbs(worldMat.r[1]), worldExtents);
+	worldExtents = XMVectorMultiplyAdd(XMVectorSplatZ(extents), XMVectorAbs(worldMat.r[2]), worldExtents);
+	XMStoreFloat3(&mWorldBounds[index].Center, XMVector3Transform(XMLoadFloat3(&localBounds.Center), worldMat));
+	XMStoreFloat3(&mWorldBounds[index].Extents, worldExtents);
+
+	const BoundingSphere& localSphere = mLocalSpheres[index];
+	XMStoreFloat3(&mWorldSpheres[index].Center, XMVector3Transform(XMLoadFloat3(&localSphere.Center), worldMat));
+	mWorldSpheres[index].Radius = localSphere.Radius * mWorldMaxScales[index];
+}
+
+UINT TransformStore::UpdateRange(UINT begin, UINT end)
+{
+	const UINT BATCH_SIZE = 64;
+	UINT batch[BATCH_SIZE];
+	XMFLOAT4X4 localMats[BATCH_SIZE];
+
+	UINT recomputedNum = 0;
+	UINT i = begin;
+	while (i < end) {
+		// Collect a batch of dirty nodes
+		UINT batchNum = 0;
+		for (; i < end && batchNum < BATCH_SIZE; i++) {
+			UINT parentIndex = mParentIndices[i];
+			if (!mDirtyFlags[i]) {
+				if (parentIndex == INVALID_NODE_ID || !mDirtyFlags[parentIndex])
+					continue;
+				mDirtyFlags[i] = 1;
+			}
+			batch[batchNum++] = i;
+		}
+		if (batchNum == 0)
+			break;
+
+		BatchTransform::BuildLocalMats(
+			batchNum, batch,
+			mTranslations.data(), mRotations.data(), mScales.data(),
+			localMats, nullptr
+		);
+
+		for (UINT b = 0; b < batchNum; b++) {
+			UINT index = batch[b];
+			UINT parentIndex = mParentIndices[index];
+			const XMFLOAT3& scale = mScales[index];
+			mWorldMaxScales[index] = MathHelper::Max(fabsf(scale.x), MathHelper::Max(fabsf(scale.y), fabsf(scale.z)));
+			if (parentIndex != INVALID_NODE_ID)
+				mWorldMaxScales[index] *= mWorldMaxScales[parentIndex];
+
+			if (parentIndex == INVALID_NODE_ID) {
+				mWorldMats[index] = localMats[b];
+				UpdateWorldBounds(index, XMLoadFloat4x4(&localMats[b]));
+				continue;
+			}
+
+			XMMATRIX worldMat = XMLoadFloat4x4(&localMats[b]) * XMLoadFloat4x4(&mWorldMats[parentIndex]);
+			XMStoreFloat4x4(&mWorldMats[index], worldMat);
+			UpdateWorldBounds(index, worldMat);
+		}
+		recomputedNum += batchNum;
+	}
+	return recomputedNum;
+}
+
+void TransformStore::Update(JobSystem* jobSystem)
+{
+	if (mOrderDirty)
+		Rebuild();
+
+	mRecomputedNum = 0;
+	mRecomputedNodes.clear();
+	if (mMinDirtyIndex == INVALID_NODE_ID)
+		return;
+
+	// Dirty flags are pushed down to children on the way,
+	// a level only reads the level above it.
+	const UINT GRAIN_SIZE = 512;
+	std::atomic<UINT> recomputedNum(0);
+	for (UINT level = 0; level + 1 < mLevelStarts.size(); level++) {
+		UINT begin = MathHelper::Max(mLevelStarts[level], mMinDirtyIndex);
+		UINT end = mLevelStarts[level + 1];
+		if (begin >= end)
+			continue;
+
+		if (!jobSystem || end - begin <= GRAIN_SIZE) {
+			recomputedNum += UpdateRange(begin, end);
+			continue;
+		}
+		jobSystem->ParallelFor(end - begin, GRAIN_SIZE,
+			[this, begin, &recomputedNum](UINT first, UINT last) {
+				recomputedNum += UpdateRange(begin + first, begin + last);
+			}
+		);
+	}
+	mRecomputedNum = recomputedNum;
+
+	// Dirty flags are left on exactly the recomputed nodes
+	mRecomputedNodes.reserve(mRecomputedNum);
+	for (UINT i = mMinDirtyIndex; i < mDirtyFlags.size(); i++)
+		if (mDirtyFlags[i] && mNodes[i] != INVALID_NODE_ID)
+			mRecomputedNodes.push_back(mNodes[i]);
+
+	std::fill(mDirtyFlags.begin() + mMinDirtyIndex, mDirtyFlags.end(), 0);
+	mMinDirtyIndex = INVALID_NODE_ID;
+}
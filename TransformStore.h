@@ -0,0 +1,153 @@
+#pragma once
+#include <vector>
+#include <DirectXMath.h>
+#include <DirectXCollision.h>
+
+#include "PlatformTypes.h"
+#include "Common/MathHelper.h"
+#include "JobSystem.h"
+#include "BatchTransform.h"
+
+const UINT INVALID_NODE_ID = -1;
+
+// Flat transform hierarchy.
+// Local TRS, parent indices and world matrices live in contiguous arrays
+// sorted by depth (parents always before children),
+// so world matrix propagation is a single linear pass instead of a tree walk.
+// Nodes are referred to by stable handles, which are mapped to dense indices.
+// Only nodes whose TRS or parent changed, and their subtrees, are recomputed.
+// Nodes in the same depth level don't depend on each other,
+// so each level can be updated in parallel.
+// Local matrices are built in batches by BatchTransform.
+class TransformStore
+{
+public:
+	UINT CreateNode();
+	void DestroyNode(UINT node);
+
+	void SetParent(UINT node, UINT parent);
+	UINT GetParent(UINT node)const { return mNodeParents[node]; }
+
+	void SetTranslation(UINT node, float x, float y, float z) {
+		UINT index = mNodeIndices[node];
+		mTranslations[index] = { x, y, z };
+		MarkDirty(index);
+	}
+	void SetRotation(UINT node, float x, float y, float z) {
+		UINT index = mNodeIndices[node];
+		mRotations[index] = { x, y, z };
+		MarkDirty(index);
+	}
+	void SetScale(UINT node, float x, float y, float z) {
+		UINT index = mNodeIndices[node];
+		mScales[index] = { x, y, z };
+		MarkDirty(index);
+	}
+	DirectX::XMFLOAT3 GetTranslation(UINT node)const { return mTranslations[mNodeIndices[node]]; }
+	DirectX::XMFLOAT3 GetRotation(UINT node)const { return mRotations[mNodeIndices[node]]; }
+	DirectX::XMFLOAT3 GetScale(UINT node)const { return mScales[mNodeIndices[node]]; }
+
+	DirectX::XMMATRIX CalLocalMat(UINT node)const {
+		return CalLocalMatByIndex(mNodeIndices[node]);
+	}
+	DirectX::XMMATRIX GetWorldMat(UINT node)const {
+		return DirectX::XMLoadFloat4x4(&mWorldMats[mNodeIndices[node]]);
+	}
+
+	// Grow the node-space bounds of a node, e.g. by the submesh of a render item
+	void MergeLocalBounds(UINT node, const DirectX::BoundingBox& box, const DirectX::BoundingSphere& sphere);
+	// Nodes without render items have no bounds
+	bool HasBounds(UINT node)const { return mLocalBounds[mNodeIndices[node]].Extents.x >= 0.0f; }
+	const DirectX::BoundingBox& GetWorldBounds(UINT node)const {
+		return mWorldBounds[mNodeIndices[node]];
+	}
+	const DirectX::BoundingSphere& GetWorldBoundingSphere(UINT node)const {
+		return mWorldSpheres[mNodeIndices[node]];
+	}
+
+	// Propagate world matrices and bounds for dirty nodes and their subtrees.
+	// Levels are split over jobSystem if given,
+	// the result is identical to the serial update.
+	void Update(JobSystem* jobSystem = nullptr);
+
+	UINT GetNodeNum()const { return static_cast<UINT>(mNodes.size()); }
+	// Number of world matrices recomputed by the last Update.
+	UINT GetRecomputedNum()const { return mRecomputedNum; }
+	// Handles of the nodes recomputed by the last Update, in no particular order
+	const std::vector<UINT>& GetRecomputedNodes()const { return mRecomputedNodes; }
+
+private:
+	DirectX::XMMATRIX CalLocalMatByIndex(UINT index)const {
+		DirectX::XMFLOAT4X4 mat;
+		BatchTransform::BuildLocalMats(
+			1, &index,
+			mTranslations.data(), mRotations.data(), mScales.data(),
+			&mat, nullptr
+		);
+		return DirectX::XMLoadFloat4x4(&mat);
+	}
+
+	// Remove node from the child list of its parent, node becomes a root
+	void Unlink(UINT node);
+
+	void MarkDirty(UINT index) {
+		mDirtyFlags[index] = 1;
+		mMinDirtyIndex = MathHelper::Min(mMinDirtyIndex, index);
+	}
+
+	void XM_CALLCONV UpdateWorldBounds(UINT index, DirectX::FXMMATRIX worldMat);
+
+	// Update nodes in [begin, end), which must lie in one level.
+	// Return the number of recomputed nodes.
+	UINT UpdateRange(UINT begin, UINT end);
+
+	// Re-sort dense arrays by depth and drop destroyed nodes.
+	void Rebuild();
+
+	// Indexed by node handle
+	std::vector<UINT> mNodeIndices; // dense index, INVALID_NODE_ID for freed handles
+	std::vector<UINT> mNodeParents; // parent handle
+	// Children of a node form a doubly linked list of handles
+	std::vector<UINT> mFirstChildren;
+	std::vector<UINT> mNextSiblings;
+	std::vector<UINT> mPrevSiblings;
+	std::vector<UINT> mFreeNodes;
+
+	// Indexed by dense index, sorted by depth
+	std::vector<UINT> mNodes; // node handle, INVALID_NODE_ID for destroyed nodes
+	std::vector<UINT> mParentIndices; // dense index of parent
+	std::vector<DirectX::XMFLOAT3> mTranslations;
+	std::vector<DirectX::XMFLOAT3> mRotations;
+	std::vector<DirectX::XMFLOAT3> mScales;
+	std::vector<DirectX::XMFLOAT4X4> mWorldMats;
+	std::vector<DirectX::BoundingBox> mLocalBounds; // negative extents if empty
+	std::vector<DirectX::BoundingSphere> mLocalSpheres;
+	std::vector<DirectX::BoundingBox> mWorldBounds;
+	std::vector<DirectX::BoundingSphere> mWorldSpheres;
+	// Upper bound of how much the world matrix stretches a length.
+	// Products of non-uniform scales and rotations shear,
+	// so the row lengths of the world matrix can't be used.
+	std::vector<float> mWorldMaxScales;
+	std::vector<UINT8> mDirtyFlags;
+	// Level i occupies [mLevelStarts[i], mLevelStarts[i + 1])
+	std::vector<UINT> mLevelStarts;
+
+	bool mOrderDirty = false;
+	// Nodes before this index are clean
+	UINT mMinDirtyIndex = INVALID_NODE_ID;
+	UINT mRecomputedNum = 0;
+	std::vector<UINT> mRecomputedNodes;
+
+	// Scratch of Rebuild, kept to avoid allocating on every hierarchy change
+	std::vector<UINT> mRebuildDepths;
+	std::vector<UINT> mRebuildStack;
+	std::vector<UINT> mRebuildDepthStarts;
+	std::vector<UINT> mRebuildOrder;
+	std::vector<UINT> mRebuildUINTs;
+	std::vector<DirectX::XMFLOAT3> mRebuildFloat3s;
+	std::vector<DirectX::XMFLOAT4X4> mRebuildMats;
+	std::vector<DirectX::BoundingBox> mRebuildBoxes;
+	std::vector<DirectX::BoundingSphere> mRebuildSpheres;
+	std::vector<float> mRebuildFloats;
+	std::vector<UINT8> mRebuildFlags;
+};
@@ -0,0 +1,65 @@
+#include "UploadRing.h"
+
+UploadRing::UploadRing(ID3D12Device* device, UINT64 size, UINT frameNum)
+	:mDevice(device), mAllocator(size, frameNum), mFrameNum(frameNum)
+{
+	CreateBuffer(size);
+}
+
+UploadRing::~UploadRing()
+{
+	if (mBuffer != nullptr)
+		mBuffer->Unmap(0, nullptr);
+}
+
+void UploadRing::CreateBuffer(UINT64 size)
+{
+	ThrowIfFailed(mDevice->CreateCommittedResource(
+		&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD),
+		D3D12_HEAP_FLAG_NONE,
+		&CD3DX12_RESOURCE_DESC::Buffer(size),
+		D3D12_RESOURCE_STATE_GENERIC_READ,
+		nullptr,
+		IID_PPV_ARGS(&mBuffer)
+	));
+
+	// Stays mapped, the CPU only writes ranges the GPU is done with
+	ThrowIfFailed(mBuffer->Map(0, nullptr, reinterpret_cast<void**>(&mMappedData)));
+}
+
+void UploadRing::BeginFrame(UINT frameIndex)
+{
+	mAllocator.BeginFrame(frameIndex);
+
+	// After frameNum frames, the frame that last used a retired buffer is finished
+	for (auto& retired : mRetiredBuffers)
+		retired.FramesLeft--;
+	mRetiredBuffers.erase(
+		std::remove_if(mRetiredBuffers.begin(), mRetiredBuffers.end(),
+			[](const RetiredBuffer& retired) { return retired.FramesLeft == 0; }),
+		mRetiredBuffers.end()
+	);
+}
+
+UploadAllocation UploadRing::Alloc(UINT64 size, UINT64 alignment)
+{
+	UINT64 offset;
+	if (!mAllocator.TryAlloc(size, alignment, offset)) {
+		// Allocations made so far stay in the old buffer, which the frames in flight still read
+		UINT64 newSize = mAllocator.GetSize() * 2;
+		while (newSize < size)
+			newSize *= 2;
+		mBuffer->Unmap(0, nullptr);
+		mRetiredBuffers.push_back({ mBuffer, mFrameNum });
+		CreateBuffer(newSize);
+		mAllocator.Reset(newSize);
+		mGrowNum++;
+		if (!mAllocator.TryAlloc(size, alignment, offset))
+			throw "Upload ring allocation failed.";
+	}
+
+	UploadAllocation alloc;
+	alloc.CPU = mMappedData + offset;
+	alloc.GPU = mBuffer->GetGPUVirtualAddress() + offset;
+	return alloc;
+}
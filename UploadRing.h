@@ -0,0 +1,89 @@
+#pragma once
+#include "Common/d3dUtil.h"
+#include "UploadRingAllocator.h"
+
+struct UploadAllocation
+{
+	BYTE* CPU = nullptr;
+	D3D12_GPU_VIRTUAL_ADDRESS GPU = 0;
+};
+
+// Elements of one frame in the upload ring
+template<typename T>
+struct UploadArray
+{
+	BYTE* CPU = nullptr;
+	D3D12_GPU_VIRTUAL_ADDRESS GPU = 0;
+	UINT ElementByteSize = 0;
+
+	void CopyData(UINT elementIndex, const T& data) {
+		memcpy(CPU + elementIndex * ElementByteSize, &data, sizeof(T));
+	}
+	// Copy count consecutive elements, in one memcpy unless elements are padded
+	void CopyData(UINT firstElement, const T* data, UINT count) {
+		if (ElementByteSize == sizeof(T)) {
+			memcpy(CPU + firstElement * ElementByteSize, data, sizeof(T) * count);
+			return;
+		}
+		for (UINT i = 0; i < count; i++)
+			CopyData(firstElement + i, data[i]);
+	}
+	D3D12_GPU_VIRTUAL_ADDRESS GetGPUAddress(UINT elementIndex)const {
+		return GPU + elementIndex * ElementByteSize;
+	}
+};
+
+// One persistently mapped upload buffer that constant and structured data of
+// every frame is sub-allocated from.
+// When the frames in flight fill it, a buffer twice as large replaces it;
+// the old one is released once the frames that used it are finished.
+class UploadRing
+{
+public:
+	UploadRing(ID3D12Device* device, UINT64 size, UINT frameNum);
+	UploadRing(const UploadRing&) = delete;
+	UploadRing& operator=(const UploadRing&) = delete;
+	~UploadRing();
+
+	// Call after FrameRing::BeginFrame with the index it returned
+	void BeginFrame(UINT frameIndex);
+	// size bytes valid until the frame resource is reused
+	UploadAllocation Alloc(UINT64 size, UINT64 alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+
+	// count elements, padded to 256 bytes each for constant buffers
+	template<typename T>
+	UploadArray<T> AllocArray(UINT count, bool isConstantBuffer) {
+		UploadArray<T> arr;
+		arr.ElementByteSize = sizeof(T);
+		if (isConstantBuffer)
+			arr.ElementByteSize = d3dUtil::CalcConstantBufferByteSize(sizeof(T));
+		UploadAllocation alloc = Alloc(
+			static_cast<UINT64>(arr.ElementByteSize) * MathHelper::Max(count, 1u),
+			isConstantBuffer ? D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT : D3D12_RAW_UAV_SRV_BYTE_ALIGNMENT
+		);
+		arr.CPU = alloc.CPU;
+		arr.GPU = alloc.GPU;
+		return arr;
+	}
+
+	UINT64 GetSize()const { return mAllocator.GetSize(); }
+	UINT64 GetUsedSize()const { return mAllocator.GetUsedSize(); }
+	UINT GetGrowNum()const { return mGrowNum; }
+
+private:
+	void CreateBuffer(UINT64 size);
+
+	ID3D12Device* mDevice;
+	Microsoft::WRL::ComPtr<ID3D12Resource> mBuffer;
+	BYTE* mMappedData = nullptr;
+	UploadRingAllocator mAllocator;
+	UINT mFrameNum;
+	UINT mGrowNum = 0;
+
+	// Replaced buffers the GPU may still read
+	struct RetiredBuffer {
+		Microsoft::WRL::ComPtr<ID3D12Resource> Buffer;
+		UINT FramesLeft; // BeginFrame calls until the frames that used it are finished
+	};
+	std::vector<RetiredBuffer> mRetiredBuffers;
+};
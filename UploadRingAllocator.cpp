@@ -0,0 +1,56 @@
+#include "UploadRingAllocator.h"
+
+#include <algorithm>
+
+UploadRingAllocator::UploadRingAllocator(UINT64 size, UINT frameNum)
+	:mSize(size), mFrameEnds(frameNum, 0)
+{
+	if (size == 0)
+		throw "Invalid upload ring size.";
+}
+
+void UploadRingAllocator::BeginFrame(UINT frameIndex)
+{
+	if (frameIndex >= mFrameEnds.size())
+		throw "Invalid frame index.";
+	if (mFrameIndex != UINT_MAX)
+		mFrameEnds[mFrameIndex] = mHead;
+
+	// The GPU finished the last frame recorded into this frame resource,
+	// and frames complete in order, so everything allocated up to its end is free
+	mTail = std::max(mTail, mFrameEnds[frameIndex]);
+	mFrameIndex = frameIndex;
+}
+
+bool UploadRingAllocator::TryAlloc(UINT64 size, UINT64 alignment, UINT64& offset)
+{
+	if (alignment == 0)
+		throw "Invalid alignment.";
+	if (size > mSize)
+		return false;
+
+	// Allocations are contiguous, skip the bytes left at the end of the ring
+	UINT64 head = mHead;
+	UINT64 ringOffset = head % mSize;
+	UINT64 alignedOffset = (ringOffset + alignment - 1) / alignment * alignment;
+	if (alignedOffset + size > mSize)
+		head += mSize - ringOffset;
+	else
+		head += alignedOffset - ringOffset;
+	if (head + size - mTail > mSize)
+		return false;
+
+	offset = head % mSize;
+	mHead = head + size;
+	return true;
+}
+
+void UploadRingAllocator::Reset(UINT64 size)
+{
+	if (size == 0)
+		throw "Invalid upload ring size.";
+	mSize = size;
+	mHead = 0;
+	mTail = 0;
+	std::fill(mFrameEnds.begin(), mFrameEnds.end(), 0);
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <climits>
+#include <vector>
+
+#include "PlatformTypes.h"
+
+// Byte offsets of one frame's uploads in a ring buffer.
+// The bytes allocated during a frame are released when its frame resource
+// is begun again, which FrameRing only does once the GPU finished it.
+// Only deals in offsets, so it works without a device.
+class UploadRingAllocator
+{
+public:
+	UploadRingAllocator(UINT64 size, UINT frameNum);
+
+	// Call after FrameRing::BeginFrame with the index it returned
+	void BeginFrame(UINT frameIndex);
+	// Offset of size contiguous bytes aligned to alignment,
+	// false if the frames in flight hold too much to fit them
+	bool TryAlloc(UINT64 size, UINT64 alignment, UINT64& offset);
+	// Forget every allocation and hand out size bytes, for a new buffer
+	void Reset(UINT64 size);
+
+	UINT64 GetSize()const { return mSize; }
+	UINT64 GetUsedSize()const { return mHead - mTail; }
+
+private:
+	UINT64 mSize;
+	// Bytes allocated and released since the last reset, skipped bytes included.
+	// The ring offset of the head is mHead % mSize.
+	UINT64 mHead = 0;
+	UINT64 mTail = 0;
+	std::vector<UINT64> mFrameEnds; // head when each frame resource was last left, by frame resource
+	UINT mFrameIndex = UINT_MAX;
+};
@@ -1,16 +1,17 @@
 #include "Header.hlsli"
 
-VertexOut main( VertexIn vin )
+VertexOut main( VertexIn vin, uint instanceID : SV_InstanceID )
 {
     VertexOut vout;
 
-    float4x4 mvpMat = mul(mul(gModelMat, gViewMat), gProjMat);
+    ObjectData obj = gObjects[gInstanceObjects[gInstanceBase + instanceID]];
+    float4x3 modelMat = obj.modelMat;
 
     float4 posL = float4(vin.posL, 1.0);
-    vout.posW = mul(posL, gModelMat);
+    vout.posW = float4(mul(posL, modelMat), 1.0);
     vout.posH = mul(mul(vout.posW, gViewMat), gProjMat);
-    vout.tangentW = mul(float4(vin.tangentL, 0.0f), gModelMat);
-    vout.normalW = normalize(mul(float4(vin.normalL, 0.0), gNormalModelMat));
+    vout.tangentW = float4(mul(float4(vin.tangentL, 0.0f), modelMat), 0.0f);
+    vout.normalW = float4(normalize(TransformNormal(vin.normalL, modelMat)), 0.0f);
     vout.tex = vin.tex;
     
 	return vout;
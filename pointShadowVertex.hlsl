@@ -1,9 +1,6 @@
 #include "pointShadowHeader.hlsli"
-
-cbuffer cbPerObject : register(b0)
-{
-    float4x4 gModelMat;
-}
+#define OBJECT_DATA_ONLY
+#include "Header.hlsli"
 
 cbuffer cbPerPass : register(b1)
 {
@@ -11,10 +8,11 @@ cbuffer cbPerPass : register(b1)
     float4x4 gProjMat;
 };
 
-VertexOut main( float4 posL : POSITION )
+VertexOut main( float4 posL : POSITION, uint instanceID : SV_InstanceID )
 {
+    float4x3 modelMat = gObjects[gInstanceObjects[gInstanceBase + instanceID]].modelMat;
     VertexOut res;
-    res.posLi = mul(mul(posL, gModelMat), gViewMat);
+    res.posLi = mul(float4(mul(posL, modelMat), 1.0), gViewMat);
     res.posH = mul(res.posLi, gProjMat);
     return res;
 }
\ No newline at end of file
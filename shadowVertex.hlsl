@@ -1,7 +1,5 @@
-cbuffer cbPerObject : register(b0)
-{
-    float4x4 gModelMat;
-}
+#define OBJECT_DATA_ONLY
+#include "Header.hlsli"
 
 cbuffer cbPerPass : register(b1)
 {
@@ -9,7 +7,8 @@ cbuffer cbPerPass : register(b1)
     float4x4 gProjMat;
 };
 
-float4 main( float4 posL : POSITION ) : SV_POSITION
+float4 main( float4 posL : POSITION, uint instanceID : SV_InstanceID ) : SV_POSITION
 {
-    return mul(mul(mul(posL, gModelMat), gViewMat), gProjMat);
+    float4x3 modelMat = gObjects[gInstanceObjects[gInstanceBase + instanceID]].modelMat;
+    return mul(mul(float4(mul(posL, modelMat), 1.0), gViewMat), gProjMat);
 }
\ No newline at end of file